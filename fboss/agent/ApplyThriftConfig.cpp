@@ -76,9 +76,15 @@ void updateFibFromConfig(
     facebook::fboss::RouterID vrf,
     const facebook::fboss::rib::IPv4NetworkToRouteMap& v4NetworkToRoute,
     const facebook::fboss::rib::IPv6NetworkToRouteMap& v6NetworkToRoute,
+    const facebook::fboss::rib::IPv4ChangedPrefixes* v4ChangedPrefixes,
+    const facebook::fboss::rib::IPv6ChangedPrefixes* v6ChangedPrefixes,
     void* cookie) {
   facebook::fboss::rib::ForwardingInformationBaseUpdater fibUpdater(
-      vrf, v4NetworkToRoute, v6NetworkToRoute);
+      vrf,
+      v4NetworkToRoute,
+      v6NetworkToRoute,
+      v4ChangedPrefixes,
+      v6ChangedPrefixes);
 
   auto nextStatePtr =
       static_cast<std::shared_ptr<facebook::fboss::SwitchState>*>(cookie);
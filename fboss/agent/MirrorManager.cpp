@@ -20,24 +20,28 @@ namespace facebook {
 namespace fboss {
 
 void MirrorManager::stateUpdated(const StateDelta& delta) {
-  if (!hasMirrorChanges(delta)) {
+  auto mirrorNames = getMirrorsToResolve(delta);
+  if (mirrorNames.empty()) {
     return;
   }
 
-  auto updateMirrorsFn = [this](const std::shared_ptr<SwitchState>& state) {
-    return resolveMirrors(state);
+  auto updateMirrorsFn = [this, mirrorNames = std::move(mirrorNames)](
+                             const std::shared_ptr<SwitchState>& state) {
+    return resolveMirrors(state, mirrorNames);
   };
-  sw_->updateState("Updating mirrors", updateMirrorsFn);
+  sw_->updateState("Updating mirrors", std::move(updateMirrorsFn));
 }
 
 std::shared_ptr<SwitchState> MirrorManager::resolveMirrors(
-    const std::shared_ptr<SwitchState>& state) {
+    const std::shared_ptr<SwitchState>& state,
+    const std::vector<std::string>& mirrorNames) {
   auto mirrors = state->getMirrors()->clone();
   bool mirrorsUpdated = false;
 
-  for (const auto& mirror : *state->getMirrors()) {
-    if (!mirror->getDestinationIp()) {
-      /* SPAN mirror does not require resolving */
+  for (const auto& name : mirrorNames) {
+    auto mirror = state->getMirrors()->getMirrorIf(name);
+    if (!mirror || !mirror->getDestinationIp()) {
+      /* removed since, or SPAN mirror, which does not require resolving */
       continue;
     }
     const auto destinationIp = mirror->getDestinationIp().value();
@@ -48,6 +52,9 @@ std::shared_ptr<SwitchState> MirrorManager::resolveMirrors(
       XLOG(INFO) << "Mirror: " << updatedMirror->getID() << " updated.";
       mirrors->updateNode(updatedMirror);
       mirrorsUpdated = true;
+      resolvedMirrors_[name] = updatedMirror;
+    } else {
+      resolvedMirrors_[name] = mirror;
     }
   }
   if (!mirrorsUpdated) {
@@ -58,16 +65,54 @@ std::shared_ptr<SwitchState> MirrorManager::resolveMirrors(
   return updatedState;
 }
 
-bool MirrorManager::hasMirrorChanges(const StateDelta& delta) {
-  return (sw_->getState()->getMirrors()->size() > 0) &&
-      (!isEmpty(delta.getRouteTablesDelta()) ||
-       std::any_of(
-           std::begin(delta.getVlansDelta()),
-           std::end(delta.getVlansDelta()),
-           [](const VlanDelta& vlanDelta) {
-             return !isEmpty(vlanDelta.getArpDelta()) ||
-                 !isEmpty(vlanDelta.getNdpDelta());
-           }));
+std::vector<std::string> MirrorManager::getMirrorsToResolve(
+    const StateDelta& delta) {
+  for (const auto& mirrorDelta : delta.getMirrorsDelta()) {
+    if (!mirrorDelta.getNew()) {
+      const auto& name = mirrorDelta.getOld()->getID();
+      resolvedMirrors_.erase(name);
+      v4Manager_->removeMirror(name);
+      v6Manager_->removeMirror(name);
+    }
+  }
+
+  std::vector<std::string> mirrorNames;
+  const auto& mirrors = delta.newState()->getMirrors();
+  if (mirrors->size() == 0) {
+    return mirrorNames;
+  }
+
+  // Resolution uses interface addresses and MACs, so if any interface
+  // changes, resolve everything again
+  const bool intfsChanged = !isEmpty(delta.getIntfsDelta());
+  const bool routesChanged = !isEmpty(delta.getRouteTablesDelta()) ||
+      !isEmpty(delta.getFibsDelta());
+  const bool neighborsChanged = std::any_of(
+      std::begin(delta.getVlansDelta()),
+      std::end(delta.getVlansDelta()),
+      [](const VlanDelta& vlanDelta) {
+        return !isEmpty(vlanDelta.getArpDelta()) ||
+            !isEmpty(vlanDelta.getNdpDelta());
+      });
+
+  for (const auto& mirror : *mirrors) {
+    if (!mirror->getDestinationIp()) {
+      /* SPAN mirror does not require resolving */
+      continue;
+    }
+    auto iter = resolvedMirrors_.find(mirror->getID());
+    bool resolve = intfsChanged || iter == resolvedMirrors_.end() ||
+        iter->second != mirror;
+    if (!resolve && (routesChanged || neighborsChanged)) {
+      resolve = mirror->getDestinationIp()->isV4()
+          ? v4Manager_->needsResolution(delta, mirror)
+          : v6Manager_->needsResolution(delta, mirror);
+    }
+    if (resolve) {
+      mirrorNames.push_back(mirror->getID());
+    }
+  }
+  return mirrorNames;
 }
 
 } // namespace fboss
@@ -7,6 +7,10 @@
 #include "fboss/agent/state/RouteNextHop.h"
 #include "fboss/agent/state/StateDelta.h"
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace facebook {
 namespace fboss {
 
@@ -26,10 +30,20 @@ class MirrorManager : public AutoRegisterStateObserver {
   std::unique_ptr<MirrorManagerV4> v4Manager_;
   std::unique_ptr<MirrorManagerV6> v6Manager_;
 
-  bool hasMirrorChanges(const StateDelta& delta);
+  // The mirrors as they were last resolved, by name. Only accessed from
+  // the update thread.
+  std::unordered_map<std::string, std::shared_ptr<Mirror>> resolvedMirrors_;
+
+  /*
+   * The names of the mirrors whose resolution delta may change: mirrors
+   * added or changed since they were last resolved, and mirrors whose route
+   * or neighbor entries delta changes.
+   */
+  std::vector<std::string> getMirrorsToResolve(const StateDelta& delta);
 
   std::shared_ptr<SwitchState> resolveMirrors(
-      const std::shared_ptr<SwitchState>& state);
+      const std::shared_ptr<SwitchState>& state,
+      const std::vector<std::string>& mirrorNames);
 };
 } // namespace fboss
 } // namespace facebook
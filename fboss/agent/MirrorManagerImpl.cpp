@@ -11,6 +11,7 @@
 #include "fboss/agent/state/Route.h"
 #include "fboss/agent/state/RouteTable.h"
 #include "fboss/agent/state/RouteTableRib.h"
+#include "fboss/agent/state/StateDelta.h"
 #include "fboss/agent/state/SwitchState.h"
 #include "fboss/agent/state/Vlan.h"
 
@@ -28,6 +29,7 @@ std::shared_ptr<Mirror> MirrorManagerImpl<AddrT>::updateMirror(
       getIPAddress<AddrT>(mirror->getDestinationIp().value());
   const auto state = sw_->getState();
   const auto nexthops = resolveMirrorNextHops(state, destinationIp);
+  std::vector<NeighborKey> lookedUp;
 
   auto newMirror = std::make_shared<Mirror>(
       mirror->getID(),
@@ -39,8 +41,8 @@ std::shared_ptr<Mirror> MirrorManagerImpl<AddrT>::updateMirror(
       mirror->getTruncate());
 
   for (const auto& nexthop : nexthops) {
-    const auto entry =
-        resolveMirrorNextHopNeighbor(state, mirror, destinationIp, nexthop);
+    const auto entry = resolveMirrorNextHopNeighbor(
+        state, mirror, destinationIp, nexthop, &lookedUp);
 
     if (!entry) {
       continue;
@@ -60,6 +62,7 @@ std::shared_ptr<Mirror> MirrorManagerImpl<AddrT>::updateMirror(
     newMirror->setEgressPort(egressPort);
     break;
   }
+  neighborDependencies_[mirror->getID()] = std::move(lookedUp);
 
   if (*mirror == *newMirror) {
     return std::shared_ptr<Mirror>(nullptr);
@@ -67,6 +70,46 @@ std::shared_ptr<Mirror> MirrorManagerImpl<AddrT>::updateMirror(
   return newMirror;
 }
 
+template <typename AddrT>
+bool MirrorManagerImpl<AddrT>::needsResolution(
+    const StateDelta& delta,
+    const std::shared_ptr<Mirror>& mirror) const {
+  auto iter = neighborDependencies_.find(mirror->getID());
+  if (iter == neighborDependencies_.end()) {
+    return true;
+  }
+  const AddrT destinationIp =
+      getIPAddress<AddrT>(mirror->getDestinationIp().value());
+  // Routes are copied on write, so the route to the destination is unchanged
+  // exactly when the same node is the longest match in both states.
+  const auto oldRoute =
+      sw_->longestMatch<AddrT>(delta.oldState(), destinationIp, RouterID(0));
+  const auto newRoute =
+      sw_->longestMatch<AddrT>(delta.newState(), destinationIp, RouterID(0));
+  if (oldRoute != newRoute) {
+    return true;
+  }
+  for (const auto& key : iter->second) {
+    if (getNeighborEntry(delta.oldState(), key) !=
+        getNeighborEntry(delta.newState(), key)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename AddrT>
+std::shared_ptr<NeighborEntryT<AddrT>>
+MirrorManagerImpl<AddrT>::getNeighborEntry(
+    const std::shared_ptr<SwitchState>& state,
+    const NeighborKey& key) const {
+  auto vlan = state->getVlans()->getVlanIf(key.first);
+  if (!vlan) {
+    return std::shared_ptr<NeighborEntryT>(nullptr);
+  }
+  return vlan->template getNeighborEntryTable<AddrT>()->getEntryIf(key.second);
+}
+
 template <typename AddrT>
 RouteNextHopEntry::NextHopSet MirrorManagerImpl<AddrT>::resolveMirrorNextHops(
     const std::shared_ptr<SwitchState>& state,
@@ -85,7 +128,8 @@ MirrorManagerImpl<AddrT>::resolveMirrorNextHopNeighbor(
     const std::shared_ptr<SwitchState>& state,
     const std::shared_ptr<Mirror>& mirror,
     const AddrT& destinationIp,
-    const NextHop& nexthop) const {
+    const NextHop& nexthop,
+    std::vector<NeighborKey>* lookedUp) const {
   std::shared_ptr<NeighborEntryT> neighbor;
   if (!nexthop.isResolved()) {
     return std::shared_ptr<NeighborEntryT>(nullptr);
@@ -97,14 +141,14 @@ MirrorManagerImpl<AddrT>::resolveMirrorNextHopNeighbor(
       state->getInterfaces()->getInterfaceIf(mirrorEgressInterface);
   auto vlan = state->getVlans()->getVlanIf(interface->getVlanID());
 
-  if (interface->hasAddress(mirrorNextHopIp)) {
-    /* if mirror destination is directly connected */
-    neighbor = vlan->template getNeighborEntryTable<AddrT>()->getEntryIf(
-        destinationIp);
-  } else {
-    neighbor = vlan->template getNeighborEntryTable<AddrT>()->getEntryIf(
-        mirrorNextHopIp);
-  }
+  /* if mirror destination is directly connected, look it up directly */
+  NeighborKey key(
+      vlan->getID(),
+      interface->hasAddress(mirrorNextHopIp) ? destinationIp
+                                             : mirrorNextHopIp);
+  lookedUp->push_back(key);
+  neighbor = vlan->template getNeighborEntryTable<AddrT>()->getEntryIf(
+      key.second);
 
   if (!neighbor || neighbor->zeroPort() ||
       !neighbor->getPort().isPhysicalPort() ||
@@ -9,12 +9,19 @@
 #include "fboss/agent/state/Mirror.h"
 #include "fboss/agent/state/NdpEntry.h"
 #include "fboss/agent/state/RouteNextHopEntry.h"
+#include "fboss/agent/types.h"
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace facebook {
 namespace fboss {
 
 class Mirror;
 class MirrorTunnel;
+class StateDelta;
 class SwSwitch;
 
 template <typename AddrT>
@@ -31,7 +38,31 @@ class MirrorManagerImpl {
 
   std::shared_ptr<Mirror> updateMirror(const std::shared_ptr<Mirror>& mirror);
 
+  /*
+   * Whether resolving mirror again could give a different result in the new
+   * state of delta than in its old state. This is the case if delta changes
+   * the route to the mirror destination, or any of the neighbor entries
+   * looked up when the mirror was last resolved. Mirrors which were never
+   * resolved by updateMirror() always need resolution.
+   */
+  bool needsResolution(
+      const StateDelta& delta,
+      const std::shared_ptr<Mirror>& mirror) const;
+
+  /*
+   * Drop what was recorded about a mirror when resolving it.
+   */
+  void removeMirror(const std::string& name) {
+    neighborDependencies_.erase(name);
+  }
+
  private:
+  using NeighborKey = std::pair<VlanID, AddrT>;
+
+  std::shared_ptr<NeighborEntryT> getNeighborEntry(
+      const std::shared_ptr<SwitchState>& state,
+      const NeighborKey& key) const;
+
   NextHopSet resolveMirrorNextHops(
       const std::shared_ptr<SwitchState>& state,
       const AddrT& destinationIp);
@@ -40,7 +71,8 @@ class MirrorManagerImpl {
       const std::shared_ptr<SwitchState>& state,
       const std::shared_ptr<Mirror>& mirror,
       const AddrT& destinationIp,
-      const NextHop& nexthop) const;
+      const NextHop& nexthop,
+      std::vector<NeighborKey>* lookedUp) const;
 
   MirrorTunnel resolveMirrorTunnel(
       const std::shared_ptr<SwitchState>& state,
@@ -65,6 +97,10 @@ class MirrorManagerImpl {
   }
 
   SwSwitch* sw_;
+  // The neighbor entries looked up when each mirror was last resolved, by
+  // mirror name. These are all accessed from the update thread only.
+  std::unordered_map<std::string, std::vector<NeighborKey>>
+      neighborDependencies_;
 };
 
 using MirrorManagerV4 = MirrorManagerImpl<folly::IPAddressV4>;
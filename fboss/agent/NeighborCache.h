@@ -17,12 +17,19 @@
 #include <folly/IPAddress.h>
 #include <folly/MacAddress.h>
 #include <folly/Memory.h>
+#include <folly/Random.h>
+#include <folly/TokenBucket.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
+#include <algorithm>
 #include <chrono>
 #include <list>
 #include <string>
 
+DECLARE_int32(neighbor_probe_rate);
+DECLARE_int32(neighbor_probe_burst);
+
 namespace facebook {
 namespace fboss {
 
@@ -40,6 +47,7 @@ namespace fboss {
 template <typename NTable>
 class NeighborCache {
   friend class NeighborCacheEntry<NTable>;
+  friend class NeighborCacheImpl<NTable>;
 
  public:
   typedef typename NTable::Entry::AddressType AddressType;
@@ -97,6 +105,13 @@ class NeighborCache {
     impl_->clearEntries();
   }
 
+  // Apply the batched changes now rather than when the batch times out.
+  // This should only be called on the neighbor cache thread.
+  void flushChanges() {
+    std::lock_guard<std::mutex> g(cacheLock_);
+    impl_->flushChanges();
+  }
+
  protected:
   // protected constructor since this is only meant to be inherited from
   NeighborCache(
@@ -111,6 +126,9 @@ class NeighborCache {
         timeout_(timeout),
         maxNeighborProbes_(maxNeighborProbes),
         staleEntryInterval_(staleEntryInterval),
+        probeBucket_(
+            std::max(FLAGS_neighbor_probe_rate, 1),
+            std::max(FLAGS_neighbor_probe_burst, 1)),
         impl_(std::make_unique<NeighborCacheImpl<NTable>>(
             this,
             sw,
@@ -183,6 +201,15 @@ class NeighborCache {
     return maxNeighborProbes_;
   }
 
+  // How long an entry waits before retrying a probe that was not allowed
+  // by tryConsumeProbe()
+  std::chrono::milliseconds getProbeRetryInterval() const {
+    auto perProbe = 1000 / std::max(FLAGS_neighbor_probe_rate, 1);
+    return std::chrono::milliseconds(
+        std::max<uint32_t>(perProbe, 10) +
+        folly::Random::rand32(kMaxProbeRetryJitterMs));
+  }
+
  private:
   // This should only be called by a NeighborCacheEntry
   virtual void checkReachability(
@@ -209,6 +236,13 @@ class NeighborCache {
     return impl_->processEntry(ip);
   }
 
+  // This should only be called by a NeighborCacheEntry, before sending a
+  // probe. Returns false if the entry should wait to send it, so that probes
+  // for entries expiring together are spread out instead of sent in a burst.
+  bool tryConsumeProbe() {
+    return probeBucket_.consume(1);
+  }
+
   // Has the entry corresponding to ip has been hit in hw
   bool isHit(AddressType ip) {
     return sw_->getAndClearNeighborHit(RouterID(0), ip);
@@ -222,6 +256,8 @@ class NeighborCache {
   std::chrono::seconds timeout_;
   uint32_t maxNeighborProbes_{0};
   std::chrono::seconds staleEntryInterval_;
+  static constexpr uint32_t kMaxProbeRetryJitterMs = 50;
+  folly::TokenBucket probeBucket_;
   std::unique_ptr<NeighborCacheImpl<NTable>> impl_;
   std::mutex cacheLock_;
 };
@@ -19,6 +19,7 @@
 #include <folly/IPAddress.h>
 #include <folly/MacAddress.h>
 #include <folly/Random.h>
+#include <folly/io/async/HHWheelTimer.h>
 #include <chrono>
 
 /**
@@ -56,6 +57,14 @@
  * next update is scheduled. If the entry ever transitions to the EXPIRED state,
  * we do not schedule another update and the cache will flush the entry.
  *
+ * Timeouts are scheduled on the wheel timer of the neighbor cache EventBase
+ * rather than each being a timer event of its own, so the entries expiring in
+ * the same tick are all processed in a single wakeup, however many neighbors
+ * there are. Intervals are jittered so that entries learned together do not
+ * keep probing together, and probes are paced by the cache: an entry which
+ * is not allowed to probe yet retries shortly after, without using up one of
+ * its probes.
+ *
  * There is no locking in this class. Instead, the class relies on the
  * synchronization provided by NeighborCache, which should lock around all calls
  * into the cache with a single cache level lock. This class should take care
@@ -79,7 +88,7 @@ template <typename NTable>
 class NeighborCache;
 
 template <typename NTable>
-class NeighborCacheEntry : private folly::AsyncTimeout {
+class NeighborCacheEntry : private folly::HHWheelTimer::Callback {
  public:
   typedef typename NTable::Entry::AddressType AddressType;
   typedef NeighborCache<NTable> Cache;
@@ -90,8 +99,7 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
       folly::EventBase* evb,
       Cache* cache,
       NeighborEntryState state)
-      : AsyncTimeout(evb),
-        fields_(fields),
+      : fields_(fields),
         cache_(cache),
         evb_(evb),
         probesLeft_(cache_->getMaxNeighborProbes()) {
@@ -221,6 +229,19 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
     entry.ttl = getTtl();
   }
 
+  /*
+   * Shortens interval by a random amount of up to a tenth of it. Intervals are
+   * only ever shortened, so entries are never checked later than configured.
+   */
+  static std::chrono::milliseconds jitter(std::chrono::milliseconds interval) {
+    auto maxJitter = interval.count() / 10;
+    if (maxJitter <= 0) {
+      return interval;
+    }
+    return interval -
+        std::chrono::milliseconds(folly::Random::rand32(maxJitter));
+  }
+
  private:
   /*
    * We tell the cache that this entry needs to be processed. The cache is
@@ -231,6 +252,16 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
     cache_->processEntry(getIP());
   }
 
+  /*
+   * The wheel timer cancels outstanding callbacks when the EventBase is torn
+   * down. Don't treat that as an expiry, the cache is going away.
+   */
+  void callbackCanceled() noexcept override {}
+
+  void scheduleTimeout(std::chrono::milliseconds timeout) {
+    evb_->timer().scheduleTimeout(this, timeout);
+  }
+
   /*
    * Schedules an update on the evb_. This is done synchronously so that we
    * can have a destructor guard around both running the state machine and
@@ -247,11 +278,16 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
         scheduleTimeout(lifetime);
         break;
       case NeighborEntryState::STALE:
-        scheduleTimeout(std::chrono::seconds(cache_->getStaleEntryInterval()));
+        scheduleTimeout(jitter(cache_->getStaleEntryInterval()));
         break;
       case NeighborEntryState::PROBE:
       case NeighborEntryState::INCOMPLETE:
-        scheduleTimeout(std::chrono::seconds(1));
+        if (probeDeferred_) {
+          probeDeferred_ = false;
+          scheduleTimeout(cache_->getProbeRetryInterval());
+        } else {
+          scheduleTimeout(jitter(std::chrono::seconds(1)));
+        }
         break;
       case NeighborEntryState::EXPIRED:
         // This entry is expired and is already flushed. Don't schedule a
@@ -317,6 +353,11 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
   void probeIfProbesLeft() {
     DCHECK(isProbing());
     if (hasProbesLeft()) {
+      if (!cache_->tryConsumeProbe()) {
+        // Too many probes sent recently, try again shortly
+        probeDeferred_ = true;
+        return;
+      }
       if (state_ == NeighborEntryState::INCOMPLETE) {
         /* entry is INCOMPLETE, issue multicast probe */
         cache_->probeFor(getIP());
@@ -407,6 +448,7 @@ class NeighborCacheEntry : private folly::AsyncTimeout {
   folly::EventBase* evb_;
   NeighborEntryState state_{NeighborEntryState::UNINITIALIZED};
   uint8_t probesLeft_{0};
+  bool probeDeferred_{false};
   std::chrono::time_point<std::chrono::steady_clock> expireTime_;
 };
 
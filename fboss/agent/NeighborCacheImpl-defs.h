@@ -14,7 +14,9 @@
 #include <folly/futures/Future.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/xlog.h>
+#include <chrono>
 #include <list>
+#include <vector>
 #include "fboss/agent/ArpHandler.h"
 #include "fboss/agent/IPv6Handler.h"
 #include "fboss/agent/NeighborCacheImpl.h"
@@ -59,90 +61,208 @@ bool checkVlanAndIntf(
   return true;
 }
 
+/*
+ * Add or update a resolved entry in the neighbor table of the given vlan.
+ * Returns false if the state was not changed.
+ */
+template <typename NTable>
+bool programEntry(
+    std::shared_ptr<SwitchState>* state,
+    const typename NeighborCacheEntry<NTable>::EntryFields& fields,
+    VlanID vlanID) {
+  if (!checkVlanAndIntf<NTable>(*state, fields, vlanID)) {
+    // Either the vlan or intf is no longer valid.
+    return false;
+  }
+
+  auto vlan = (*state)->getVlans()->getVlanIf(vlanID).get();
+  auto* table = vlan->template getNeighborTable<NTable>().get();
+  auto node = table->getNodeIf(fields.ip);
+
+  if (!node) {
+    table = table->modify(&vlan, state);
+    table->addEntry(fields);
+    XLOG(DBG2) << "Adding entry for " << fields.ip << " --> " << fields.mac
+               << " on interface " << fields.interfaceID << " for vlan "
+               << vlanID;
+  } else {
+    if (node->getMac() == fields.mac && node->getPort() == fields.port &&
+        node->getIntfID() == fields.interfaceID &&
+        node->getState() == fields.state && !node->isPending()) {
+      // This entry was already updated while we were waiting on the lock.
+      return false;
+    }
+    table = table->modify(&vlan, state);
+    table->updateEntry(fields);
+    XLOG(DBG2) << "Converting pending entry for " << fields.ip << " --> "
+               << fields.mac << " on interface " << fields.interfaceID
+               << " for vlan " << vlanID;
+  }
+  return true;
+}
+
+/*
+ * Add a pending entry to the neighbor table of the given vlan, replacing
+ * any existing entry only if force is set.  Returns false if the state was
+ * not changed.
+ */
+template <typename NTable>
+bool programPendingEntry(
+    std::shared_ptr<SwitchState>* state,
+    const typename NeighborCacheEntry<NTable>::EntryFields& fields,
+    VlanID vlanID,
+    bool force) {
+  if (!checkVlanAndIntf<NTable>(*state, fields, vlanID)) {
+    // Either the vlan or intf is no longer valid.
+    return false;
+  }
+
+  auto vlan = (*state)->getVlans()->getVlanIf(vlanID).get();
+  auto* table = vlan->template getNeighborTable<NTable>().get();
+  auto node = table->getNodeIf(fields.ip);
+  if (node && !force) {
+    // don't replace an existing entry with a pending one unless
+    // explicitly allowed
+    return false;
+  }
+
+  table = table->modify(&vlan, state);
+  if (node) {
+    table->removeEntry(fields.ip);
+  }
+  table->addPendingEntry(fields.ip, fields.interfaceID);
+
+  XLOG(DBG4) << "Adding pending entry for " << fields.ip << " on interface "
+             << fields.interfaceID << " for vlan " << vlanID;
+  return true;
+}
+
 } // namespace ncachehelpers
 
 template <typename NTable>
 void NeighborCacheImpl<NTable>::programEntry(Entry* entry) {
   CHECK(!entry->isPending());
+  queueChange(
+      NeighborChange(NeighborChange::Type::PROGRAM, entry->getFields()));
+}
 
-  auto fields = entry->getFields();
-  auto vlanID = vlanID_;
-  auto updateFn = [fields, vlanID](const std::shared_ptr<SwitchState>& state)
-      -> std::shared_ptr<SwitchState> {
-    if (!ncachehelpers::checkVlanAndIntf<NTable>(state, fields, vlanID)) {
-      // Either the vlan or intf is no longer valid.
-      return nullptr;
-    }
+template <typename NTable>
+void NeighborCacheImpl<NTable>::programPendingEntry(Entry* entry, bool force) {
+  CHECK(entry->isPending());
+  queueChange(
+      NeighborChange(NeighborChange::Type::PENDING, entry->getFields(), force));
+}
 
-    auto vlan = state->getVlans()->getVlanIf(vlanID).get();
-    std::shared_ptr<SwitchState> newState{state};
-    auto* table = vlan->template getNeighborTable<NTable>().get();
-    auto node = table->getNodeIf(fields.ip);
-
-    if (!node) {
-      table = table->modify(&vlan, &newState);
-      table->addEntry(fields);
-      XLOG(DBG2) << "Adding entry for " << fields.ip << " --> " << fields.mac
-                 << " on interface " << fields.interfaceID << " for vlan "
-                 << vlanID;
-    } else {
-      if (node->getMac() == fields.mac && node->getPort() == fields.port &&
-          node->getIntfID() == fields.interfaceID &&
-          node->getState() == fields.state && !node->isPending()) {
-        // This entry was already updated while we were waiting on the lock.
-        return nullptr;
+template <typename NTable>
+void NeighborCacheImpl<NTable>::queueChange(NeighborChange change) {
+  auto ip = change.fields.ip;
+  auto it = pendingChanges_.find(ip);
+  if (it == pendingChanges_.end()) {
+    pendingChanges_.emplace(ip, std::move(change));
+  } else {
+    // Only the combined effect of the changes to an entry within a batch
+    // needs to be applied, which is the effect of the last change, except
+    // for a pending entry that must not replace an existing entry.
+    auto& queued = it->second;
+    change.queued = queued.queued;
+    if (change.type == NeighborChange::Type::PENDING && !change.force) {
+      if (queued.type != NeighborChange::Type::FLUSH) {
+        // The entry added by the queued change takes precedence
+        return;
       }
-      table = table->modify(&vlan, &newState);
-      table->updateEntry(fields);
-      XLOG(DBG2) << "Converting pending entry for " << fields.ip << " --> "
-                 << fields.mac << " on interface " << fields.interfaceID
-                 << " for vlan " << vlanID;
+      // The entry was flushed first, so the pending entry replaces it
+      change.force = true;
     }
-    return newState;
-  };
+    queued = std::move(change);
+  }
 
-  sw_->updateState(
-      folly::to<std::string>("add neighbor ", fields.ip), std::move(updateFn));
+  if (FLAGS_neighbor_update_batch_ms <= 0) {
+    flushChanges();
+  } else if (!flushChangesScheduled_) {
+    flushChangesScheduled_ = true;
+    evb_->runInEventBaseThread([this]() {
+      flushChangesTimeout_->scheduleTimeout(
+          std::chrono::milliseconds(FLAGS_neighbor_update_batch_ms));
+    });
+  }
 }
 
 template <typename NTable>
-void NeighborCacheImpl<NTable>::programPendingEntry(Entry* entry, bool force) {
-  CHECK(entry->isPending());
+void NeighborCacheImpl<NTable>::flushChangesTimeoutExpired() {
+  cache_->flushChanges();
+}
 
-  auto fields = entry->getFields();
-  auto vlanID = vlanID_;
-  auto updateFn =
-      [fields, vlanID, force](const std::shared_ptr<SwitchState>& state)
-      -> std::shared_ptr<SwitchState> {
-    if (!ncachehelpers::checkVlanAndIntf<NTable>(state, fields, vlanID)) {
-      // Either the vlan or intf is no longer valid.
-      return nullptr;
+template <typename NTable>
+void NeighborCacheImpl<NTable>::flushChanges() {
+  flushChangesScheduled_ = false;
+  if (pendingChanges_.empty()) {
+    return;
+  }
+
+  std::vector<NeighborChange> changes;
+  changes.reserve(pendingChanges_.size());
+  bool hasPending = false;
+  for (auto& ipAndChange : pendingChanges_) {
+    hasPending |= ipAndChange.second.type == NeighborChange::Type::PENDING;
+    changes.push_back(std::move(ipAndChange.second));
+  }
+  pendingChanges_.clear();
+
+  std::string name;
+  if (changes.size() == 1) {
+    const auto& change = changes.front();
+    switch (change.type) {
+      case NeighborChange::Type::PROGRAM:
+        name = folly::to<std::string>("add neighbor ", change.fields.ip);
+        break;
+      case NeighborChange::Type::PENDING:
+        name = folly::to<std::string>("add pending entry ", change.fields.ip);
+        break;
+      case NeighborChange::Type::FLUSH:
+        name = "remove neighbor entry";
+        break;
     }
+  } else {
+    name = folly::to<std::string>(
+        "update ", changes.size(), " neighbor entries on vlan ", vlanID_);
+  }
 
-    auto vlan = state->getVlans()->getVlanIf(vlanID).get();
+  auto* sw = sw_;
+  auto vlanID = vlanID_;
+  auto updateFn = [sw, vlanID, changes = std::move(changes)](
+                      const std::shared_ptr<SwitchState>& state)
+      -> std::shared_ptr<SwitchState> {
     std::shared_ptr<SwitchState> newState{state};
-    auto* table = vlan->template getNeighborTable<NTable>().get();
-    auto node = table->getNodeIf(fields.ip);
-    table = table->modify(&vlan, &newState);
-
-    if (node) {
-      if (!force) {
-        // don't replace an existing entry with a pending one unless
-        // explicitly allowed
-        return nullptr;
+    bool changed = false;
+    auto now = std::chrono::steady_clock::now();
+    for (const auto& change : changes) {
+      switch (change.type) {
+        case NeighborChange::Type::PROGRAM:
+          changed |= ncachehelpers::programEntry<NTable>(
+              &newState, change.fields, vlanID);
+          break;
+        case NeighborChange::Type::PENDING:
+          changed |= ncachehelpers::programPendingEntry<NTable>(
+              &newState, change.fields, vlanID, change.force);
+          break;
+        case NeighborChange::Type::FLUSH:
+          changed |=
+              flushEntryFromSwitchState(&newState, change.fields.ip, vlanID);
+          break;
       }
-      table->removeEntry(fields.ip);
+      sw->stats()->neighborUpdateLatency(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              now - change.queued));
     }
-    table->addPendingEntry(fields.ip, fields.interfaceID);
-
-    XLOG(DBG4) << "Adding pending entry for " << fields.ip << " on interface "
-               << fields.interfaceID << " for vlan " << vlanID;
-    return newState;
+    sw->stats()->neighborUpdateBatch(changes.size());
+    return changed ? newState : nullptr;
   };
 
-  sw_->updateStateNoCoalescing(
-      folly::to<std::string>("add pending entry ", fields.ip),
-      std::move(updateFn));
+  if (hasPending) {
+    sw_->updateStateNoCoalescing(std::move(name), std::move(updateFn));
+  } else {
+    sw_->updateState(std::move(name), std::move(updateFn));
+  }
 }
 
 template <typename NTable>
@@ -192,8 +312,14 @@ void NeighborCacheImpl<NTable>::clearEntries() {
   if (stopTasks.empty()) {
     stopTasks.push_back(folly::via(evb_, []() {}));
   }
+  // Since any scheduling of the batch timeout was queued before the tasks
+  // above, the timeout can be cancelled once they are done.
+  stopTasks.push_back(folly::via(
+      evb_, [this]() { flushChangesTimeout_->cancelTimeout(); }));
   folly::collectAllSemiFuture(stopTasks).get();
   entries_.clear();
+  pendingChanges_.clear();
+  flushChangesScheduled_ = false;
 }
 
 template <typename NTable>
@@ -329,8 +455,12 @@ bool NeighborCacheImpl<NTable>::removeEntry(AddressType ip) {
 template <typename NTable>
 bool NeighborCacheImpl<NTable>::flushEntryFromSwitchState(
     std::shared_ptr<SwitchState>* state,
-    AddressType ip) {
-  auto* vlan = (*state)->getVlans()->getVlan(vlanID_).get();
+    AddressType ip,
+    VlanID vlanID) {
+  auto* vlan = (*state)->getVlans()->getVlanIf(vlanID).get();
+  if (!vlan) {
+    return false;
+  }
   auto* table = vlan->template getNeighborTable<NTable>().get();
   const auto& entry = table->getNodeIf(ip);
   if (!entry) {
@@ -359,26 +489,28 @@ void NeighborCacheImpl<NTable>::flushEntry(AddressType ip, bool* flushed) {
     return;
   }
 
-  // flush from SwitchState
+  if (!flushed) {
+    queueChange(NeighborChange(
+        NeighborChange::Type::FLUSH,
+        EntryFields(ip, intfID_, NeighborState::PENDING)));
+    return;
+  }
+
+  // The caller wants to know if an entry was actually flushed, so this needs
+  // a blocking state update of its own.  Apply any other queued changes
+  // first, so that they are not reordered with it.
+  pendingChanges_.erase(ip);
+  flushChanges();
   auto updateFn = [this, ip, flushed](const std::shared_ptr<SwitchState>& state)
       -> std::shared_ptr<SwitchState> {
     std::shared_ptr<SwitchState> newState{state};
-    if (flushEntryFromSwitchState(&newState, ip)) {
-      if (flushed) {
-        *flushed = true;
-      }
+    if (flushEntryFromSwitchState(&newState, ip, vlanID_)) {
+      *flushed = true;
       return newState;
     }
     return nullptr;
   };
-
-  if (flushed) {
-    // need a blocking state update if the caller wants to know if an entry
-    // was actually flushed
-    sw_->updateStateBlocking("flush neighbor entry", std::move(updateFn));
-  } else {
-    sw_->updateState("remove neighbor entry", std::move(updateFn));
-  }
+  sw_->updateStateBlocking("flush neighbor entry", std::move(updateFn));
 }
 
 template <typename NTable>
@@ -19,9 +19,14 @@
 #include <folly/IPAddress.h>
 #include <folly/Optional.h>
 #include <folly/Random.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <gflags/gflags.h>
+#include <chrono>
 #include <list>
 #include <string>
 
+DECLARE_int32(neighbor_update_batch_ms);
+
 namespace facebook {
 namespace fboss {
 
@@ -39,6 +44,11 @@ class NeighborCache;
  * All calls into this should have acquired a cache level lock through
  * NeighborCache so only one thread should ever be operating on the
  * cache at a given time.
+ *
+ * Changes to the neighbor table are not applied to the SwitchState one at a
+ * time.  They are accumulated for up to FLAGS_neighbor_update_batch_ms, and
+ * then applied together in a single state update, so that a burst of
+ * ARP/NDP traffic does not clone the neighbor table for every entry.
  */
 template <typename NTable>
 class NeighborCacheImpl {
@@ -65,7 +75,10 @@ class NeighborCacheImpl {
         vlanID_(vlanID),
         vlanName_(vlanName),
         intfID_(intfID),
-        evb_(sw->getNeighborCacheEvb()) {}
+        evb_(sw->getNeighborCacheEvb()),
+        flushChangesTimeout_(folly::AsyncTimeout::make(
+            *evb_,
+            [this]() noexcept { flushChangesTimeoutExpired(); })) {}
 
   // Methods useful for subclasses
   void setPendingEntry(AddressType ip, bool force = false);
@@ -124,19 +137,52 @@ class NeighborCacheImpl {
   void clearEntries();
 
  private:
+  // A change to the neighbor table, waiting to be applied to the SwitchState
+  struct NeighborChange {
+    enum class Type {
+      // Add or update a resolved entry
+      PROGRAM,
+      // Add a pending entry
+      PENDING,
+      // Remove the entry
+      FLUSH,
+    };
+
+    NeighborChange(Type type, EntryFields fields, bool force = false)
+        : type(type),
+          fields(std::move(fields)),
+          force(force),
+          queued(std::chrono::steady_clock::now()) {}
+
+    Type type;
+    EntryFields fields;
+    // For PENDING changes, whether to replace an existing entry
+    bool force;
+    // When the first change to this entry in the batch was made
+    std::chrono::steady_clock::time_point queued;
+  };
+
   // These are used to program entries into the SwitchState
   void programEntry(Entry* entry);
   void programPendingEntry(Entry* entry, bool force = false);
 
+  // Add a change to the current batch, and schedule the batch to be applied
+  void queueChange(NeighborChange change);
+  // Apply all the queued changes in a single state update
+  void flushChanges();
+  void flushChangesTimeoutExpired();
+
   void processEntry(AddressType ip);
 
   // Pass in a non-null flushed if you care whether an entry
   // was actually flushed from the switch state
   void flushEntry(AddressType ip, bool* flushed = nullptr);
 
-  bool flushEntryFromSwitchState(
+  // Static so that batched state updates can run after the cache is gone
+  static bool flushEntryFromSwitchState(
       std::shared_ptr<SwitchState>* state,
-      AddressType ip);
+      AddressType ip,
+      VlanID vlanID);
 
   Entry* getCacheEntry(AddressType ip) const;
   void setCacheEntry(std::shared_ptr<Entry> entry);
@@ -160,6 +206,12 @@ class NeighborCacheImpl {
 
   // Map of all entries
   std::unordered_map<AddressType, std::shared_ptr<Entry>> entries_;
+
+  // Changes not yet applied to the SwitchState, at most one per address
+  std::unordered_map<AddressType, NeighborChange> pendingChanges_;
+  bool flushChangesScheduled_{false};
+  // Only accessed from evb_
+  std::unique_ptr<folly::AsyncTimeout> flushChangesTimeout_;
 };
 
 } // namespace fboss
@@ -26,6 +26,7 @@
 
 #include <boost/container/flat_map.hpp>
 #include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
 #include <list>
 #include <mutex>
 #include <string>
@@ -38,6 +39,25 @@ using folly::IPAddressV6;
 using folly::MacAddress;
 using std::shared_ptr;
 
+DEFINE_int32(
+    neighbor_update_batch_ms,
+    0,
+    "Time in milliseconds to accumulate neighbor table changes for, before "
+    "applying them to the switch state in a single update. Changes are "
+    "applied one at a time if this is 0.");
+
+DEFINE_int32(
+    neighbor_probe_rate,
+    1000,
+    "Maximum number of ARP/NDP probes per second each neighbor cache sends "
+    "to refresh or resolve its entries. Probes beyond this are deferred.");
+
+DEFINE_int32(
+    neighbor_probe_burst,
+    1000,
+    "Number of neighbor probes each neighbor cache may send at once, before "
+    "being paced to neighbor_probe_rate.");
+
 namespace facebook {
 namespace fboss {
 
@@ -84,6 +104,13 @@ std::list<NdpEntryThrift> NeighborUpdaterImpl::getNdpCacheData() {
   return entries;
 }
 
+void NeighborUpdaterImpl::flushPendingChanges() {
+  for (auto it = caches_.begin(); it != caches_.end(); ++it) {
+    it->second->arpCache->flushChanges();
+    it->second->ndpCache->flushChanges();
+  }
+}
+
 shared_ptr<ArpCache> NeighborUpdaterImpl::getArpCacheInternal(VlanID vlan) {
   auto res = caches_.find(vlan);
   if (res == caches_.end()) {
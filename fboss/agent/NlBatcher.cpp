@@ -0,0 +1,205 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/NlBatcher.h"
+
+extern "C" {
+#include <linux/netlink.h>
+#include <netlink/errno.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+}
+
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/NlError.h"
+#include "fboss/agent/SysError.h"
+
+#include <cerrno>
+#include <cstring>
+
+namespace facebook {
+namespace fboss {
+
+namespace {
+
+constexpr int kSocketBufferBytes = 1024 * 1024;
+// How long to wait for an ack before giving up on the requests in flight
+constexpr int kAckTimeoutSecs = 5;
+
+// Convert an errno from the kernel to a (negative) libnl error code, like
+// the synchronous libnl APIs return
+int toNlError(int err) {
+  return -nl_syserr2nlerr(err);
+}
+
+} // anonymous namespace
+
+NlBatcher::NlBatcher() {
+  sock_ = nl_socket_alloc();
+  if (!sock_) {
+    throw FbossError("failed to allocate libnl socket");
+  }
+  auto error = nl_connect(sock_, NETLINK_ROUTE);
+  nlCheckError(error, "failed to connect netlink socket to NETLINK_ROUTE");
+  error = nl_socket_set_buffer_size(
+      sock_, kSocketBufferBytes, kSocketBufferBytes);
+  nlCheckError(error, "failed to set netlink socket buffer size");
+
+  struct timeval timeout {
+    kAckTimeoutSecs, 0
+  };
+  auto ret = setsockopt(
+      nl_socket_get_fd(sock_),
+      SOL_SOCKET,
+      SO_RCVTIMEO,
+      &timeout,
+      sizeof(timeout));
+  sysCheckError(ret, "failed to set netlink socket receive timeout");
+}
+
+NlBatcher::~NlBatcher() {
+  for (auto& request : queued_) {
+    nlmsg_free(request.msg);
+  }
+  if (sock_) {
+    nl_close(sock_);
+    nl_socket_free(sock_);
+  }
+}
+
+void NlBatcher::add(struct nl_msg* msg, Callback callback) {
+  queued_.push_back(Request{msg, std::move(callback)});
+}
+
+void NlBatcher::flush() {
+  while (!empty()) {
+    sendBatch();
+    // Pick up the acks which have already arrived, and only wait for more
+    // once there is nothing left to send
+    receive(queued_.empty() || inFlight_.size() >= kMaxInFlight);
+  }
+}
+
+void NlBatcher::sendBatch() {
+  sendBuf_.clear();
+  auto firstSeq = seq_ + 1;
+  while (!queued_.empty() && inFlight_.size() < kMaxInFlight) {
+    auto& request = queued_.front();
+    auto hdr = nlmsg_hdr(request.msg);
+    auto len = NLMSG_ALIGN(hdr->nlmsg_len);
+    if (!sendBuf_.empty() && sendBuf_.size() + len > kMaxBatchBytes) {
+      break;
+    }
+    hdr->nlmsg_flags |= NLM_F_REQUEST | NLM_F_ACK;
+    hdr->nlmsg_seq = ++seq_;
+    hdr->nlmsg_pid = localPort();
+    auto offset = sendBuf_.size();
+    sendBuf_.resize(offset + len, 0);
+    memcpy(sendBuf_.data() + offset, hdr, hdr->nlmsg_len);
+
+    inFlight_.emplace(hdr->nlmsg_seq, std::move(request.callback));
+    nlmsg_free(request.msg);
+    queued_.pop_front();
+  }
+  if (sendBuf_.empty()) {
+    return;
+  }
+
+  ssize_t ret = 0;
+  do {
+    ret = sendMessage(sendBuf_.data(), sendBuf_.size());
+  } while (ret == -1 && errno == EINTR);
+  if (ret < 0) {
+    auto err = errno;
+    XLOG(ERR) << "Failed to send " << seq_ - firstSeq + 1
+              << " netlink requests: " << folly::errnoStr(err);
+    for (auto seq = firstSeq; seq != seq_ + 1; ++seq) {
+      complete(seq, toNlError(err));
+    }
+  }
+}
+
+void NlBatcher::receive(bool block) {
+  ssize_t len = 0;
+  do {
+    len = receiveMessage(recvBuf_.data(), recvBuf_.size(), block);
+  } while (len == -1 && errno == EINTR);
+  if (len < 0) {
+    auto err = errno;
+    if (!block && (err == EAGAIN || err == EWOULDBLOCK)) {
+      return;
+    }
+    // Either the acks timed out, or some were lost (ENOBUFS), so there is
+    // no telling what happened to the requests in flight
+    XLOG(ERR) << "Failed to receive netlink acks for " << inFlight_.size()
+              << " requests: " << folly::errnoStr(err);
+    failInFlight(toNlError(err));
+    return;
+  }
+
+  for (auto hdr = reinterpret_cast<struct nlmsghdr*>(recvBuf_.data());
+       NLMSG_OK(hdr, len);
+       hdr = NLMSG_NEXT(hdr, len)) {
+    if (hdr->nlmsg_type != NLMSG_ERROR ||
+        hdr->nlmsg_len < NLMSG_LENGTH(sizeof(struct nlmsgerr))) {
+      continue;
+    }
+    auto ack = static_cast<struct nlmsgerr*>(NLMSG_DATA(hdr));
+    complete(hdr->nlmsg_seq, ack->error ? toNlError(-ack->error) : 0);
+  }
+}
+
+ssize_t NlBatcher::sendMessage(const void* buf, size_t len) {
+  struct sockaddr_nl kernel;
+  memset(&kernel, 0, sizeof(kernel));
+  kernel.nl_family = AF_NETLINK;
+  return sendto(
+      nl_socket_get_fd(sock_),
+      buf,
+      len,
+      0,
+      reinterpret_cast<struct sockaddr*>(&kernel),
+      sizeof(kernel));
+}
+
+ssize_t NlBatcher::receiveMessage(void* buf, size_t len, bool block) {
+  return recv(nl_socket_get_fd(sock_), buf, len, block ? 0 : MSG_DONTWAIT);
+}
+
+uint32_t NlBatcher::localPort() const {
+  return nl_socket_get_local_port(sock_);
+}
+
+void NlBatcher::complete(uint32_t seq, int error) {
+  auto iter = inFlight_.find(seq);
+  if (iter == inFlight_.end()) {
+    XLOG(DBG2) << "Ignoring netlink ack for unknown sequence number " << seq;
+    return;
+  }
+  auto callback = std::move(iter->second);
+  inFlight_.erase(iter);
+  if (callback) {
+    callback(error);
+  }
+}
+
+void NlBatcher::failInFlight(int error) {
+  auto inFlight = std::move(inFlight_);
+  inFlight_.clear();
+  for (auto& request : inFlight) {
+    if (request.second) {
+      request.second(error);
+    }
+  }
+}
+
+} // namespace fboss
+} // namespace facebook
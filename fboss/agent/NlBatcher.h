@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Function.h>
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <netlink/msg.h>
+#include <netlink/socket.h>
+#include <sys/types.h>
+}
+
+namespace facebook {
+namespace fboss {
+
+/**
+ * Sends rtnetlink requests in batches.
+ *
+ * Requests are queued with add(), and flush() packs as many of them as fit
+ * into each sendmsg(), so that a batch of requests costs a single kernel
+ * round trip.  Every request asks for an ack, and acks are matched to their
+ * requests by sequence number as they arrive, while later batches are still
+ * being sent.  The kernel handles the requests of a batch in order, and
+ * carries on past any that fail, so each request gets its own result.
+ *
+ * Not thread safe.
+ */
+class NlBatcher {
+ public:
+  /**
+   * Called with the result of a request: 0, or a negative libnl error code.
+   * Callbacks may add more requests, which are sent by the same flush().
+   */
+  using Callback = folly::Function<void(int error)>;
+
+  // Max bytes of requests sent in one message
+  static constexpr size_t kMaxBatchBytes = 32 * 1024;
+  // Max requests awaiting acks, which must all fit in the socket's receive
+  // buffer.  Acks of failed requests carry a copy of the request.
+  static constexpr size_t kMaxInFlight = 512;
+
+  NlBatcher();
+  virtual ~NlBatcher();
+
+  /**
+   * Queue a request, such as one built with rtnl_addr_build_add_request().
+   * Takes ownership of msg.
+   */
+  void add(struct nl_msg* msg, Callback callback);
+
+  /**
+   * Send all queued requests and wait for their acks, calling each
+   * request's callback as its ack arrives.
+   */
+  void flush();
+
+  bool empty() const {
+    return queued_.empty() && inFlight_.empty();
+  }
+
+ protected:
+  /**
+   * For tests, which stand in for the kernel by overriding the methods
+   * below rather than opening a netlink socket.
+   */
+  struct NoSocket {};
+  explicit NlBatcher(NoSocket) {}
+
+  /**
+   * Send one message holding a batch of requests, like sendto(2)
+   */
+  virtual ssize_t sendMessage(const void* buf, size_t len);
+
+  /**
+   * Receive one message of acks, like recv(2).  When block is set, this
+   * fails with EAGAIN if nothing arrives within the ack timeout.
+   */
+  virtual ssize_t receiveMessage(void* buf, size_t len, bool block);
+
+  /**
+   * The netlink port the requests are sent from
+   */
+  virtual uint32_t localPort() const;
+
+ private:
+  // no copy or assign
+  NlBatcher(const NlBatcher&) = delete;
+  NlBatcher& operator=(const NlBatcher&) = delete;
+
+  struct Request {
+    struct nl_msg* msg;
+    Callback callback;
+  };
+
+  /**
+   * Send as many queued requests as fit in one message
+   */
+  void sendBatch();
+
+  /**
+   * Read acks, waiting for at least one if block is set
+   */
+  void receive(bool block);
+
+  void complete(uint32_t seq, int error);
+  void failInFlight(int error);
+
+  nl_sock* sock_{nullptr};
+  uint32_t seq_{0};
+  std::deque<Request> queued_;
+  // The callbacks of the requests sent and not yet acked, by sequence number
+  std::unordered_map<uint32_t, Callback> inFlight_;
+  std::vector<uint8_t> sendBuf_;
+  std::vector<uint8_t> recvBuf_ = std::vector<uint8_t>(64 * 1024);
+};
+
+} // namespace fboss
+} // namespace facebook
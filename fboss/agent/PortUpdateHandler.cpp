@@ -56,6 +56,11 @@ void PortUpdateHandler::stateUpdated(const StateDelta& delta) {
         }
       },
       [&](const std::shared_ptr<Port>& newPort) {
+        // Create the PortStats up front, so that the packet path of each
+        // thread finds them without having to look up the port name.
+        for (SwitchStats& switchStats : sw_->getAllThreadsSwitchStats()) {
+          switchStats.createPortStats(newPort->getID(), newPort->getName());
+        }
         sw_->portStats(newPort->getID())->setPortStatus(newPort->isUp());
       },
       [&](const std::shared_ptr<Port>& oldPort) {
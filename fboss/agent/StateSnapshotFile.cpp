@@ -0,0 +1,330 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/StateSnapshotFile.h"
+
+#include "fboss/agent/FbossError.h"
+
+#include <fcntl.h>
+#include <sys/uio.h>
+
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/Varint.h>
+#include <folly/json.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/MemoryMapping.h>
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <vector>
+
+namespace {
+
+constexpr folly::StringPiece kSnapshotMagic{"FBOSSWBS"};
+constexpr uint64_t kSnapshotVersion = 1;
+
+// Value tags
+enum class Tag : uint8_t {
+  NULLT = 0,
+  FALSE = 1,
+  TRUE = 2,
+  INT64 = 3,
+  DOUBLE = 4,
+  STRING = 5,
+  ARRAY = 6,
+  OBJECT = 7,
+};
+
+struct Section {
+  std::vector<std::string> path;
+  folly::ByteRange payload;
+};
+
+void appendVarint(uint64_t value, std::string& out) {
+  uint8_t buf[folly::kMaxVarintLength64];
+  auto len = folly::encodeVarint(value, buf);
+  out.append(reinterpret_cast<const char*>(buf), len);
+}
+
+void appendString(folly::StringPiece str, std::string& out) {
+  appendVarint(str.size(), out);
+  out.append(str.data(), str.size());
+}
+
+uint64_t readVarint(folly::ByteRange& data) {
+  try {
+    return folly::decodeVarint(data);
+  } catch (const std::invalid_argument&) {
+    throw facebook::fboss::FbossError("Truncated state snapshot");
+  }
+}
+
+folly::ByteRange readBytes(folly::ByteRange& data, uint64_t len) {
+  if (len > data.size()) {
+    throw facebook::fboss::FbossError("Truncated state snapshot");
+  }
+  auto bytes = data.subpiece(0, len);
+  data.advance(len);
+  return bytes;
+}
+
+std::string readString(folly::ByteRange& data) {
+  auto bytes = readBytes(data, readVarint(data));
+  return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+void writeSection(
+    const folly::File& file,
+    const std::vector<folly::StringPiece>& path,
+    const folly::dynamic& value) {
+  std::string payload;
+  encodeStateValue(value, payload);
+
+  std::string header;
+  appendVarint(path.size(), header);
+  for (const auto& name : path) {
+    appendString(name, header);
+  }
+  appendVarint(payload.size(), header);
+
+  iovec iov[2];
+  iov[0].iov_base = &header[0];
+  iov[0].iov_len = header.size();
+  iov[1].iov_base = &payload[0];
+  iov[1].iov_len = payload.size();
+  auto expected = header.size() + payload.size();
+  if (folly::writevFull(file.fd(), iov, 2) != static_cast<ssize_t>(expected)) {
+    throw facebook::fboss::FbossError(
+        "Error writing state snapshot: ", folly::errnoStr(errno));
+  }
+}
+
+bool isSplitSection(const folly::dynamic& value) {
+  if (!value.isObject()) {
+    return false;
+  }
+  for (const auto& key : value.keys()) {
+    if (!key.isString()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<Section> readSections(folly::ByteRange data) {
+  data.advance(kSnapshotMagic.size());
+  auto version = readVarint(data);
+  if (version != kSnapshotVersion) {
+    throw facebook::fboss::FbossError(
+        "Unsupported state snapshot version ", version);
+  }
+  std::vector<Section> sections;
+  while (true) {
+    auto depth = readVarint(data);
+    if (depth == 0) {
+      break;
+    }
+    if (depth > 2) {
+      throw facebook::fboss::FbossError(
+          "Invalid state snapshot section depth ", depth);
+    }
+    Section section;
+    for (uint64_t i = 0; i < depth; ++i) {
+      section.path.push_back(readString(data));
+    }
+    section.payload = readBytes(data, readVarint(data));
+    sections.push_back(std::move(section));
+  }
+  return sections;
+}
+
+} // namespace
+
+namespace facebook {
+namespace fboss {
+
+void encodeStateValue(const folly::dynamic& value, std::string& out) {
+  switch (value.type()) {
+    case folly::dynamic::NULLT:
+      out.push_back(static_cast<char>(Tag::NULLT));
+      return;
+    case folly::dynamic::BOOL:
+      out.push_back(
+          static_cast<char>(value.getBool() ? Tag::TRUE : Tag::FALSE));
+      return;
+    case folly::dynamic::INT64:
+      out.push_back(static_cast<char>(Tag::INT64));
+      appendVarint(folly::encodeZigZag(value.getInt()), out);
+      return;
+    case folly::dynamic::DOUBLE: {
+      out.push_back(static_cast<char>(Tag::DOUBLE));
+      auto d = value.getDouble();
+      char buf[sizeof(d)];
+      std::memcpy(buf, &d, sizeof(d));
+      out.append(buf, sizeof(buf));
+      return;
+    }
+    case folly::dynamic::STRING:
+      out.push_back(static_cast<char>(Tag::STRING));
+      appendString(value.stringPiece(), out);
+      return;
+    case folly::dynamic::ARRAY:
+      out.push_back(static_cast<char>(Tag::ARRAY));
+      appendVarint(value.size(), out);
+      for (const auto& elem : value) {
+        encodeStateValue(elem, out);
+      }
+      return;
+    case folly::dynamic::OBJECT:
+      out.push_back(static_cast<char>(Tag::OBJECT));
+      appendVarint(value.size(), out);
+      for (const auto& item : value.items()) {
+        encodeStateValue(item.first, out);
+        encodeStateValue(item.second, out);
+      }
+      return;
+  }
+  throw FbossError("Unexpected folly::dynamic type ", value.typeName());
+}
+
+folly::dynamic decodeStateValue(folly::ByteRange& data) {
+  if (data.empty()) {
+    throw FbossError("Truncated state snapshot");
+  }
+  auto tag = static_cast<Tag>(data.front());
+  data.advance(1);
+  switch (tag) {
+    case Tag::NULLT:
+      return nullptr;
+    case Tag::FALSE:
+      return false;
+    case Tag::TRUE:
+      return true;
+    case Tag::INT64:
+      return static_cast<int64_t>(folly::decodeZigZag(readVarint(data)));
+    case Tag::DOUBLE: {
+      double d;
+      auto bytes = readBytes(data, sizeof(d));
+      std::memcpy(&d, bytes.data(), sizeof(d));
+      return d;
+    }
+    case Tag::STRING:
+      return readString(data);
+    case Tag::ARRAY: {
+      auto size = readVarint(data);
+      folly::dynamic array = folly::dynamic::array;
+      array.reserve(std::min<uint64_t>(size, data.size()));
+      for (uint64_t i = 0; i < size; ++i) {
+        array.push_back(decodeStateValue(data));
+      }
+      return array;
+    }
+    case Tag::OBJECT: {
+      auto size = readVarint(data);
+      folly::dynamic object = folly::dynamic::object;
+      for (uint64_t i = 0; i < size; ++i) {
+        auto key = decodeStateValue(data);
+        object.insert(std::move(key), decodeStateValue(data));
+      }
+      return object;
+    }
+  }
+  throw FbossError("Invalid state snapshot value tag ", static_cast<int>(tag));
+}
+
+bool isStateSnapshot(folly::ByteRange data) {
+  return data.startsWith(folly::ByteRange(kSnapshotMagic));
+}
+
+bool dumpStateSnapshotToFile(
+    const std::string& filename,
+    const folly::dynamic& state) {
+  try {
+    folly::File file(filename, O_WRONLY | O_CREAT | O_TRUNC);
+    std::string header = kSnapshotMagic.str();
+    appendVarint(kSnapshotVersion, header);
+    if (folly::writeFull(file.fd(), header.data(), header.size()) !=
+        static_cast<ssize_t>(header.size())) {
+      throw FbossError(
+          "Error writing state snapshot: ", folly::errnoStr(errno));
+    }
+    for (const auto& item : state.items()) {
+      auto name = item.first.stringPiece();
+      if (!isSplitSection(item.second)) {
+        writeSection(file, {name}, item.second);
+        continue;
+      }
+      // An empty object marks the start of the sub sections, so that
+      // objects with no members survive the round trip
+      writeSection(file, {name}, folly::dynamic::object);
+      for (const auto& member : item.second.items()) {
+        writeSection(file, {name, member.first.stringPiece()}, member.second);
+      }
+    }
+    // End of sections
+    std::string trailer;
+    appendVarint(0, trailer);
+    if (folly::writeFull(file.fd(), trailer.data(), trailer.size()) !=
+        static_cast<ssize_t>(trailer.size())) {
+      throw FbossError(
+          "Error writing state snapshot: ", folly::errnoStr(errno));
+    }
+    file.close();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "Unable to write state snapshot to " << filename << ": "
+              << folly::exceptionStr(ex);
+    return false;
+  }
+  return true;
+}
+
+folly::dynamic readStateFile(const std::string& filename) {
+  folly::MemoryMapping mapping(filename.c_str());
+  auto data = mapping.range();
+  if (!isStateSnapshot(data)) {
+    return folly::parseJson(folly::StringPiece(data));
+  }
+
+  auto sections = readSections(data);
+  std::vector<std::future<folly::dynamic>> values;
+  values.reserve(sections.size());
+  for (const auto& section : sections) {
+    values.push_back(
+        std::async(std::launch::async, [payload = section.payload]() mutable {
+          auto value = decodeStateValue(payload);
+          if (!payload.empty()) {
+            throw FbossError("Trailing data in state snapshot section");
+          }
+          return value;
+        }));
+  }
+
+  folly::dynamic state = folly::dynamic::object;
+  for (size_t i = 0; i < sections.size(); ++i) {
+    const auto& path = sections[i].path;
+    auto value = values[i].get();
+    if (path.size() == 1) {
+      state[path[0]] = std::move(value);
+      continue;
+    }
+    auto parent = state.get_ptr(path[0]);
+    if (!parent || !parent->isObject()) {
+      throw FbossError(
+          "State snapshot section ", path[0], "/", path[1], " has no parent");
+    }
+    (*parent)[path[1]] = std::move(value);
+  }
+  return state;
+}
+
+} // namespace fboss
+} // namespace facebook
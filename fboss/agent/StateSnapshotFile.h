@@ -0,0 +1,59 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/dynamic.h>
+
+#include <string>
+
+namespace facebook {
+namespace fboss {
+
+/*
+ * A compact binary alternative to dumping switch state as JSON, used for the
+ * warm boot state file.
+ *
+ * The file is a sequence of sections, one per member of the top level object
+ * and, for members which are themselves objects, one per member of those
+ * (e.g. swSwitch/ports, swSwitch/routeTables, hwSwitch/hostTable). Each
+ * section is encoded and written on its own, so the full serialized state is
+ * never held in memory at once, and sections are decoded in parallel when
+ * the file is read back.
+ */
+
+/*
+ * Serialize state to filename in the binary snapshot format.
+ * Returns false if the file could not be written.
+ */
+bool dumpStateSnapshotToFile(
+    const std::string& filename,
+    const folly::dynamic& state);
+
+/*
+ * Read state written either by dumpStateSnapshotToFile() or, for files
+ * written by older versions, by dumpStateToFile().
+ * Throws if the file cannot be read or is corrupt.
+ */
+folly::dynamic readStateFile(const std::string& filename);
+
+/*
+ * Whether data starts with the binary snapshot header
+ */
+bool isStateSnapshot(folly::ByteRange data);
+
+/*
+ * Encode/decode a single value in the format used for each section
+ */
+void encodeStateValue(const folly::dynamic& value, std::string& out);
+folly::dynamic decodeStateValue(folly::ByteRange& data);
+
+} // namespace fboss
+} // namespace facebook
@@ -53,6 +53,8 @@
 #include "fboss/agent/TunManager.h"
 #include "fboss/agent/TxPacket.h"
 #include "fboss/agent/Utils.h"
+#include "fboss/agent/capture/PcapPublisher.h"
+#include "fboss/agent/capture/PcapShmRing.h"
 #include "fboss/agent/capture/PktCaptureManager.h"
 #include "fboss/agent/gen-cpp2/switch_config_types_custom_protocol.h"
 #include "fboss/agent/packet/EthHdr.h"
@@ -92,6 +94,49 @@ DEFINE_int32(
     distribution_timeout_ms,
     1000,
     "Timeout for sending to distribution_service (ms)");
+DEFINE_int32(
+    distribution_batch_size,
+    64,
+    "Number of packets sent to distribution_service in one batch");
+DEFINE_int32(
+    distribution_batch_ms,
+    10,
+    "Maximum time a packet waits to be batched before being sent to "
+    "distribution_service (ms)");
+DEFINE_int32(
+    distribution_ring_size,
+    1024,
+    "Number of packets per ethertype queued for distribution_service before "
+    "further packets are dropped");
+DEFINE_int32(
+    distribution_max_inflight,
+    4,
+    "Maximum number of outstanding batches sent to distribution_service");
+DEFINE_string(
+    distribution_shm_path,
+    "",
+    "If set, publish packets to distribution_service through shared memory "
+    "rings in this file (e.g. on /dev/shm), rather than over thrift");
+DEFINE_int32(
+    distribution_shm_slots,
+    4096,
+    "Number of packets per ethertype held in the shared memory rings");
+DEFINE_int32(
+    distribution_shm_slot_bytes,
+    2048,
+    "Size of each packet slot in the shared memory rings. Longer packets "
+    "are truncated");
+DEFINE_int32(
+    state_update_coalesce_ms,
+    0,
+    "When state updates are arriving back to back, wait up to this long for "
+    "more normal priority updates before applying them, so they are "
+    "coalesced into a single hardware update. 0 disables the wait.");
+DEFINE_int32(
+    state_update_max_batch,
+    0,
+    "Maximum number of state updates coalesced into a single hardware "
+    "update. 0 means no limit.");
 
 namespace {
 
@@ -173,10 +218,41 @@ SwSwitch::SwSwitch(std::unique_ptr<Platform> platform)
 
   // doesnt need to be guarded, only accessed by 1 event base
   pcapPusher_ = nullptr;
+  auto sendToDistributionService =
+      [this](std::vector<PublishedPacket>&& packets) {
+        if (!pcapPusher_) {
+          return folly::makeFuture();
+        }
+        return pcapPusher_->future_receivePackets(packets).thenError(
+            [this](const folly::exception_wrapper& /* unused */) {
+              stats()->pcapDistFailure();
+              FB_LOG_EVERY_MS(ERROR, 1000)
+                  << "Unable to push packets to distribution service\n";
+            });
+      };
+  pcapPublisher_ = std::make_unique<PcapPublisher>(
+      &pcapDistributionEventBase_,
+      std::move(sendToDistributionService),
+      FLAGS_distribution_batch_size,
+      std::chrono::milliseconds(FLAGS_distribution_batch_ms),
+      FLAGS_distribution_ring_size,
+      FLAGS_distribution_max_inflight);
+  if (!FLAGS_distribution_shm_path.empty()) {
+    try {
+      pcapRing_ = std::make_unique<PcapShmRingWriter>(
+          FLAGS_distribution_shm_path,
+          FLAGS_distribution_shm_slots,
+          FLAGS_distribution_shm_slot_bytes);
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "unable to create packet distribution ring, packets will "
+                << "be published over thrift: " << folly::exceptionStr(ex);
+    }
+  }
 }
 
 void SwSwitch::destroyPushClient() {
   distributionServiceReady_.store(false);
+  pcapRingAttached_.store(false);
 }
 
 void SwSwitch::constructPushClient(uint16_t port) {
@@ -190,6 +266,18 @@ void SwSwitch::constructPushClient(uint16_t port) {
     pcapPusher_ =
         std::make_unique<PcapPushSubscriberAsyncClient>(std::move(chan));
     distributionServiceReady_.store(true);
+    if (pcapRing_) {
+      // Until the service has mapped the ring, keep publishing over thrift
+      pcapPusher_->future_attachPacketRing(pcapRing_->path())
+          .thenTry([this](folly::Try<folly::Unit>&& result) {
+            if (result.hasException()) {
+              XLOG(ERR) << "distribution service did not attach to the "
+                        << "packet ring: " << result.exception().what();
+              return;
+            }
+            pcapRingAttached_.store(true);
+          });
+    }
   };
   pcapDistributionEventBase_.runInEventBaseThread(creation);
 }
@@ -393,41 +481,23 @@ void SwSwitch::exitFatal() const noexcept {
 }
 
 void SwSwitch::publishRxPacket(RxPacket* pkt, uint16_t ethertype) {
-  RxPacketData pubPkt;
-  pubPkt.srcPort = pkt->getSrcPort();
-  pubPkt.srcVlan = pkt->getSrcVlan();
-
-  for (const auto& r : pkt->getReasons()) {
-    RxReason reason;
-    reason.bytes = r.bytes;
-    reason.description = r.description;
-    pubPkt.reasons.push_back(reason);
-  }
-
-  folly::IOBuf buf_copy;
-  pkt->buf()->cloneInto(buf_copy);
-  pubPkt.packetData = buf_copy.moveToFbString();
-  auto onError = [&](const folly::exception_wrapper& /* unused */) {
-    stats()->pcapDistFailure();
-    FB_LOG_EVERY_MS(ERROR, 1000)
-        << "Unable to push packet to distribution service\n";
-  };
-  pcapPusher_->future_receiveRxPacket(pubPkt, ethertype)
-      .thenError(std::move(onError));
+  if (pcapRingAttached_.load(std::memory_order_relaxed)) {
+    pcapRing_->writeRx(pkt, ethertype);
+    return;
+  }
+  if (!pcapPublisher_->publishRx(pkt, ethertype)) {
+    stats()->pcapDistDropped();
+  }
 }
 
 void SwSwitch::publishTxPacket(TxPacket* pkt, uint16_t ethertype) {
-  TxPacketData pubPkt;
-  folly::IOBuf copy_buf;
-  pkt->buf()->cloneInto(copy_buf);
-  pubPkt.packetData = copy_buf.moveToFbString();
-  auto onError = [&](const folly::exception_wrapper& /* unused */) {
-    stats()->pcapDistFailure();
-    FB_LOG_EVERY_MS(ERROR, 1000)
-        << "Unable to push packet to distribution service\n";
-  };
-  pcapPusher_->future_receiveTxPacket(pubPkt, ethertype)
-      .thenError(std::move(onError));
+  if (pcapRingAttached_.load(std::memory_order_relaxed)) {
+    pcapRing_->writeTx(pkt, ethertype);
+    return;
+  }
+  if (!pcapPublisher_->publishTx(pkt, ethertype)) {
+    stats()->pcapDistDropped();
+  }
 }
 
 void SwSwitch::init(std::unique_ptr<TunManager> tunMgr, SwitchFlags flags) {
@@ -669,28 +739,46 @@ void SwSwitch::notifyStateObservers(const StateDelta& delta) {
 }
 
 void SwSwitch::updateState(unique_ptr<StateUpdate> update) {
+  update->enqueueTime_ = std::chrono::steady_clock::now();
+  bool highPriority = update->getPriority() == StateUpdate::Priority::HIGH;
+  bool schedule = false;
   {
     folly::SpinLockGuard guard(pendingUpdatesLock_);
-    pendingUpdates_.push_back(*update.release());
+    if (highPriority) {
+      pendingHighPriorityUpdates_.push_back(*update.release());
+    } else {
+      pendingUpdates_.push_back(*update.release());
+    }
+    // Only schedule handlePendingUpdates() if it isn't already going to run
+    // soon enough to pick up this update.
+    if (pendingUpdatesScheduled_ == PendingUpdatesScheduled::NONE ||
+        (highPriority &&
+         pendingUpdatesScheduled_ == PendingUpdatesScheduled::DELAYED)) {
+      pendingUpdatesScheduled_ = PendingUpdatesScheduled::IMMEDIATE;
+      schedule = true;
+    }
   }
 
   // Signal the update thread that updates are pending.
   // We call runInEventBaseThread() with a static function pointer since this
   // is more efficient than having to allocate a new bound function object.
-  updateEventBase_.runInEventBaseThread(handlePendingUpdatesHelper, this);
+  if (schedule) {
+    updateEventBase_.runInEventBaseThread(handlePendingUpdatesHelper, this);
+  }
 }
 
 void SwSwitch::queueStateUpdateForGettingHwInSync(
     StringPiece name,
     StateUpdateFn fn) {
   auto update = make_unique<FunctionStateUpdate>(name, std::move(fn));
+  update->enqueueTime_ = std::chrono::steady_clock::now();
   {
-    // Push the state update in front to preserver ordering.
-    // This is not particularly necessary, since this state
-    // update is freely coalesced with other state updates when
-    // we come to processing pending updates
+    // This update goes in front of the next batch of updates, whichever
+    // priority they are, to preserve ordering.  This is not particularly
+    // necessary, since this state update is freely coalesced with other
+    // state updates when we come to processing pending updates
     folly::SpinLockGuard guard(pendingUpdatesLock_);
-    pendingUpdates_.push_front(*update.release());
+    pendingHwSyncUpdates_.push_front(*update.release());
   }
   // Don't inform updateEventBase about this update being queued.
   // Rather let this update be processed with the next incoming update.
@@ -705,13 +793,21 @@ void SwSwitch::queueStateUpdateForGettingHwInSync(
   // optimizations).
 }
 
-void SwSwitch::updateState(StringPiece name, StateUpdateFn fn) {
-  auto update = make_unique<FunctionStateUpdate>(name, std::move(fn));
+void SwSwitch::updateState(
+    StringPiece name,
+    StateUpdateFn fn,
+    StateUpdate::Priority priority) {
+  auto update =
+      make_unique<FunctionStateUpdate>(name, std::move(fn), true, priority);
   updateState(std::move(update));
 }
 
-void SwSwitch::updateStateNoCoalescing(StringPiece name, StateUpdateFn fn) {
-  auto update = make_unique<FunctionStateUpdate>(name, std::move(fn), false);
+void SwSwitch::updateStateNoCoalescing(
+    StringPiece name,
+    StateUpdateFn fn,
+    StateUpdate::Priority priority) {
+  auto update =
+      make_unique<FunctionStateUpdate>(name, std::move(fn), false, priority);
   updateState(std::move(update));
 }
 
@@ -726,6 +822,25 @@ void SwSwitch::handlePendingUpdatesHelper(SwSwitch* sw) {
   sw->handlePendingUpdates();
 }
 
+bool SwSwitch::deferPendingUpdatesLocked() {
+  // Under load, wait a little for more NORMAL priority updates to show up,
+  // so that a burst of them is applied to the hardware as a single delta
+  // instead of one at a time.  We consider ourselves under load when the
+  // previous batch finished less than a coalescing window ago.  Each batch is
+  // deferred at most once, and never while HIGH priority updates are waiting.
+  if (FLAGS_state_update_coalesce_ms <= 0 || pendingUpdatesDeferred_ ||
+      !pendingHighPriorityUpdates_.empty() || pendingUpdates_.empty()) {
+    return false;
+  }
+  auto window = std::chrono::milliseconds(FLAGS_state_update_coalesce_ms);
+  if (std::chrono::steady_clock::now() - lastUpdateBatchEnd_ >= window) {
+    return false;
+  }
+  pendingUpdatesDeferred_ = true;
+  pendingUpdatesScheduled_ = PendingUpdatesScheduled::DELAYED;
+  return true;
+}
+
 void SwSwitch::handlePendingUpdates() {
   // Get the list of updates to run.
   //
@@ -734,30 +849,55 @@ void SwSwitch::handlePendingUpdates() {
   // might also end up finding 0 updates to process if a previous
   // handlePendingUpdates() call processed multiple updates.
   StateUpdateList updates;
+  bool morePending = false;
   {
     folly::SpinLockGuard guard(pendingUpdatesLock_);
-    // When deciding how many elements to pull off the pendingUpdates_
-    // list, we pull as many as we can, while making sure we don't
-    // include any updates after an update that does not allow
-    // coalescing.
-    auto iter = pendingUpdates_.begin();
-    while (iter != pendingUpdates_.end()) {
+    if (deferPendingUpdatesLocked()) {
+      updateEventBase_.runAfterDelay(
+          [this] { handlePendingUpdates(); }, FLAGS_state_update_coalesce_ms);
+      return;
+    }
+    // Take updates from the HIGH priority list if it has any, so that they
+    // don't have to wait for NORMAL priority updates to be applied first.
+    auto& pending = pendingHighPriorityUpdates_.empty()
+        ? pendingUpdates_
+        : pendingHighPriorityUpdates_;
+    // When deciding how many elements to pull off the pending list, we pull
+    // as many as we can, while making sure we don't include any updates
+    // after an update that does not allow coalescing, and not more than
+    // state_update_max_batch updates.
+    auto iter = pending.begin();
+    int32_t numUpdates = 0;
+    while (iter != pending.end()) {
       StateUpdate* update = &(*iter);
       ++iter;
-      if (!update->allowsCoalescing()) {
+      ++numUpdates;
+      if (!update->allowsCoalescing() ||
+          (FLAGS_state_update_max_batch > 0 &&
+           numUpdates >= FLAGS_state_update_max_batch)) {
         break;
       }
     }
-    updates.splice(
-        updates.begin(), pendingUpdates_, pendingUpdates_.begin(), iter);
+    updates.splice(updates.begin(), pending, pending.begin(), iter);
+    if (!updates.empty()) {
+      updates.splice(updates.begin(), pendingHwSyncUpdates_);
+    }
+    // Make sure anything we left behind gets picked up by another call.
+    morePending =
+        !pendingHighPriorityUpdates_.empty() || !pendingUpdates_.empty();
+    pendingUpdatesScheduled_ = morePending ? PendingUpdatesScheduled::IMMEDIATE
+                                           : PendingUpdatesScheduled::NONE;
+  }
+  if (morePending) {
+    updateEventBase_.runInEventBaseThread(handlePendingUpdatesHelper, this);
   }
 
-  // handlePendingUpdates() is invoked once for each update, but a previous
-  // call might have already processed everything.  If we don't have anything
-  // to do just return early.
+  // A previous call might have already processed everything.  If we don't
+  // have anything to do just return early.
   if (updates.empty()) {
     return;
   }
+  pendingUpdatesDeferred_ = false;
 
   // This function should never be called with valid updates while we are
   // not initialized yet
@@ -780,8 +920,16 @@ void SwSwitch::handlePendingUpdates() {
 
     shared_ptr<SwitchState> intermediateState;
     XLOG(INFO) << "preparing state update " << update->getName();
+    auto applyStart = std::chrono::steady_clock::now();
+    stats()->stateUpdateQueued(
+        update->getPriority() == StateUpdate::Priority::HIGH,
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            applyStart - update->enqueueTime_));
     try {
       intermediateState = update->applyUpdate(newDesiredState);
+      stats()->stateUpdatePrepared(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - applyStart));
     } catch (const std::exception& ex) {
       // Call the update's onError() function, and then immediately delete
       // it (therefore removing it from the intrusive list).  This way we won't
@@ -834,6 +982,7 @@ void SwSwitch::handlePendingUpdates() {
     updates.pop_front();
     update->onSuccess();
   }
+  lastUpdateBatchEnd_ = std::chrono::steady_clock::now();
 }
 
 void SwSwitch::setStateInternal(
@@ -848,6 +997,7 @@ void SwSwitch::setStateInternal(
   folly::SpinLockGuard guard(stateLock_);
   appliedStateDontUseDirectly_.swap(newAppliedState);
   desiredStateDontUseDirectly_.swap(newDesiredState);
+  desiredStateSnapshot_.set(desiredStateDontUseDirectly_);
 }
 
 void SwSwitch::setDesiredState(std::shared_ptr<SwitchState> newDesiredState) {
@@ -855,6 +1005,7 @@ void SwSwitch::setDesiredState(std::shared_ptr<SwitchState> newDesiredState) {
   CHECK(newDesiredState->isPublished());
   folly::SpinLockGuard guard(stateLock_);
   desiredStateDontUseDirectly_.swap(newDesiredState);
+  desiredStateSnapshot_.set(desiredStateDontUseDirectly_);
 }
 
 std::shared_ptr<SwitchState> SwSwitch::applyUpdate(
@@ -922,11 +1073,13 @@ PortStats* SwSwitch::portStats(PortID portID) {
   if (portStats) {
     return portStats;
   }
+  // PortUpdateHandler creates the PortStats of every port for all threads
+  // which already have SwitchStats, so this is only reached the first time a
+  // new thread sees a port, or for ports not in the state.
   auto portIf = getState()->getPorts()->getPortIf(portID);
   if (portIf) {
     // get portName from current state
-    return stats()->createPortStats(
-        portID, getState()->getPort(portID)->getName());
+    return stats()->createPortStats(portID, portIf->getName());
   } else {
     // only for port0 case
     XLOG(DBG0) << "Port node doesn't exist, use default name=port" << portID;
@@ -953,7 +1106,17 @@ PortStatus SwSwitch::getPortStatus(PortID portID) {
 }
 
 SwitchStats* SwSwitch::createSwitchStats() {
-  SwitchStats* s = new SwitchStats();
+  // Size the dense per-port stats from the ports the platform created, so
+  // that packet path lookups never need to take a lock.
+  uint32_t numPortSlots = 0;
+  auto state = getState();
+  if (state) {
+    for (const auto& port : *state->getPorts()) {
+      numPortSlots =
+          std::max(numPortSlots, static_cast<uint32_t>(port->getID()) + 1);
+    }
+  }
+  SwitchStats* s = new SwitchStats(numPortSlots);
   stats_.reset(s);
   return s;
 }
@@ -1093,7 +1256,9 @@ void SwSwitch::linkStateChanged(PortID portId, bool up) {
     return newState;
   };
   updateStateNoCoalescing(
-      "Port OperState Update", std::move(updateOperStateFn));
+      "Port OperState Update",
+      std::move(updateOperStateFn),
+      StateUpdate::Priority::HIGH);
 
   // Log event and update counters
   logLinkStateEvent(portId, up);
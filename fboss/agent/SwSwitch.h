@@ -18,6 +18,7 @@
 #include "fboss/agent/types.h"
 
 #include "fboss/agent/rib/RoutingInformationBase.h"
+#include "fboss/lib/ThreadCachedSnapshot.h"
 
 #include <folly/IntrusiveList.h>
 #include <folly/Optional.h>
@@ -27,6 +28,7 @@
 #include <folly/io/async/EventBase.h>
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -40,6 +42,8 @@ class IPv4Handler;
 class IPv6Handler;
 class LinkAggregationManager;
 class LldpManager;
+class PcapPublisher;
+class PcapShmRingWriter;
 class PcapPushSubscriberAsyncClient;
 class PktCaptureManager;
 class Platform;
@@ -178,6 +182,10 @@ class SwSwitch : public HwSwitch::Callback {
    * in which case the caller may now have an out-of-date copy of the state.
    * See the comments in SwitchState.h for more details about the copy-on-write
    * semantics of SwitchState.
+   *
+   * This is called on every packet and RPC, so it does not take stateLock_.
+   * The desired state is read from a per-thread cached snapshot that is only
+   * refreshed when a new state has been published.
    */
   std::shared_ptr<SwitchState> getState() const {
     return getDesiredState();
@@ -217,8 +225,14 @@ class SwSwitch : public HwSwitch::Callback {
    * send a single update notification to the HwSwitch and other update
    * subscribers.  Therefore the StateUpdateFn may be called with an
    * unpublished SwitchState in some cases.
+   *
+   * HIGH priority updates are applied ahead of any pending NORMAL priority
+   * updates.  See StateUpdate::Priority.
    */
-  void updateState(folly::StringPiece name, StateUpdateFn fn);
+  void updateState(
+      folly::StringPiece name,
+      StateUpdateFn fn,
+      StateUpdate::Priority priority = StateUpdate::Priority::NORMAL);
 
   /**
    * Schedule an update to the switch state.
@@ -232,7 +246,10 @@ class SwSwitch : public HwSwitch::Callback {
    * but can be used when there is an update that MUST be seen by the hw
    * implementation, even if the inverse update is immediately applied.
    */
-  void updateStateNoCoalescing(folly::StringPiece name, StateUpdateFn fn);
+  void updateStateNoCoalescing(
+      folly::StringPiece name,
+      StateUpdateFn fn,
+      StateUpdate::Priority priority = StateUpdate::Priority::NORMAL);
 
   /*
    * A version of updateState() that doesn't return until the update has been
@@ -623,8 +640,7 @@ class SwSwitch : public HwSwitch::Callback {
    *
    */
   std::shared_ptr<SwitchState> getDesiredState() const {
-    folly::SpinLockGuard guard(stateLock_);
-    return desiredStateDontUseDirectly_;
+    return desiredStateSnapshot_.get();
   }
 
   void publishRxPacket(RxPacket* packet, uint16_t ethertype);
@@ -680,6 +696,7 @@ class SwSwitch : public HwSwitch::Callback {
 
   static void handlePendingUpdatesHelper(SwSwitch* sw);
   void handlePendingUpdates();
+  bool deferPendingUpdatesLocked();
   std::shared_ptr<SwitchState> applyUpdate(
       const std::shared_ptr<SwitchState>& oldState,
       const std::shared_ptr<SwitchState>& newState);
@@ -735,10 +752,33 @@ class SwSwitch : public HwSwitch::Callback {
   std::unique_ptr<TunManager> tunMgr_;
 
   /*
-   * A list of pending state updates to be applied.
+   * Whether handlePendingUpdates() has been scheduled on the update thread.
+   * DELAYED means it was deferred to coalesce more NORMAL priority updates,
+   * in which case a HIGH priority update still schedules it right away.
+   */
+  enum class PendingUpdatesScheduled {
+    NONE,
+    DELAYED,
+    IMMEDIATE,
+  };
+
+  /*
+   * The lists of pending state updates to be applied, one per
+   * StateUpdate::Priority.
+   *
+   * pendingHwSyncUpdates_ holds the update that re-applies the desired
+   * state after a partial hardware failure.  It does not schedule any work
+   * by itself, and is applied at the front of the next batch.
    */
   folly::SpinLock pendingUpdatesLock_;
+  StateUpdateList pendingHighPriorityUpdates_;
   StateUpdateList pendingUpdates_;
+  StateUpdateList pendingHwSyncUpdates_;
+  PendingUpdatesScheduled pendingUpdatesScheduled_{
+      PendingUpdatesScheduled::NONE};
+  // Only accessed from the update thread.
+  std::chrono::steady_clock::time_point lastUpdateBatchEnd_;
+  bool pendingUpdatesDeferred_{false};
 
   /*
    * The current switch state: modelled as two states:
@@ -765,6 +805,12 @@ class SwSwitch : public HwSwitch::Callback {
   std::shared_ptr<SwitchState> appliedStateDontUseDirectly_;
   std::shared_ptr<SwitchState> desiredStateDontUseDirectly_;
   mutable folly::SpinLock stateLock_;
+  /*
+   * The desired state as seen by readers of getDesiredState().  This is
+   * always published together with desiredStateDontUseDirectly_, while
+   * holding stateLock_, but reading it does not require the lock.
+   */
+  ThreadCachedSnapshot<SwitchState> desiredStateSnapshot_;
 
   /*
    * A thread for performing various background tasks.
@@ -828,6 +874,12 @@ class SwSwitch : public HwSwitch::Callback {
   std::unique_ptr<ChannelCloser> closer_; // must be before pcapPusher_
   std::unique_ptr<PcapPushSubscriberAsyncClient> pcapPusher_;
   std::atomic<bool> distributionServiceReady_{false};
+  // Batches the packets published to the distribution service
+  std::unique_ptr<PcapPublisher> pcapPublisher_;
+  // Shared memory rings the distribution service reads packets from, once
+  // it has attached to them. Published packets bypass pcapPublisher_ then.
+  std::unique_ptr<PcapShmRingWriter> pcapRing_;
+  std::atomic<bool> pcapRingAttached_{false};
 
   std::unique_ptr<ArpHandler> arp_;
   std::unique_ptr<IPv4Handler> ipv4_;
@@ -10,6 +10,7 @@
 #include "fboss/agent/SwitchStats.h"
 
 #include <folly/Memory.h>
+#include <algorithm>
 #include "fboss/agent/PortStats.h"
 
 using facebook::fb303::AVG;
@@ -22,10 +23,16 @@ namespace fboss {
 // set to empty string, we'll prepend prefix when fbagent collects counters
 std::string SwitchStats::kCounterPrefix = "";
 
-SwitchStats::SwitchStats()
-    : SwitchStats(fb303::ThreadCachedServiceData::get()->getThreadStats()) {}
+constexpr uint32_t SwitchStats::kMinPortSlots;
 
-SwitchStats::SwitchStats(ThreadLocalStatsMap* map)
+SwitchStats::SwitchStats() : SwitchStats(kMinPortSlots) {}
+
+SwitchStats::SwitchStats(uint32_t numPortSlots)
+    : SwitchStats(
+          fb303::ThreadCachedServiceData::get()->getThreadStats(),
+          numPortSlots) {}
+
+SwitchStats::SwitchStats(ThreadLocalStatsMap* map, uint32_t numPortSlots)
     : trapPkts_(map, kCounterPrefix + "trapped.pkts", SUM, RATE),
       trapPktDrops_(map, kCounterPrefix + "trapped.drops", SUM, RATE),
       trapPktBogus_(map, kCounterPrefix + "trapped.bogus", SUM, RATE),
@@ -80,6 +87,24 @@ SwitchStats::SwitchStats(ThreadLocalStatsMap* map)
           SUM,
           RATE),
       updateState_(map, kCounterPrefix + "state_update.us", 50000, 0, 1000000),
+      stateUpdateQueueDelay_(
+          map,
+          kCounterPrefix + "state_update.queue_delay.us",
+          1000,
+          0,
+          1000000),
+      highPriStateUpdateQueueDelay_(
+          map,
+          kCounterPrefix + "state_update.high_pri.queue_delay.us",
+          1000,
+          0,
+          1000000),
+      stateUpdatePrepare_(
+          map,
+          kCounterPrefix + "state_update.prepare.us",
+          100,
+          0,
+          100000),
       routeUpdate_(map, kCounterPrefix + "route_update.us", 50, 0, 500),
       bgHeartbeatDelay_(
           map,
@@ -171,8 +196,30 @@ SwitchStats::SwitchStats(ThreadLocalStatsMap* map)
           AVG,
           50,
           100),
+      neighborUpdateBatchSize_(
+          map,
+          kCounterPrefix + "neighbor_update_batch_size",
+          10,
+          0,
+          1000,
+          AVG,
+          50,
+          100),
+      neighborUpdateLatency_(
+          map,
+          kCounterPrefix + "neighbor_update_latency.ms",
+          10,
+          0,
+          5000,
+          AVG,
+          50,
+          100),
       linkStateChange_(map, kCounterPrefix + "link_state.flap", SUM),
+      numPortSlots_(std::max(numPortSlots, kMinPortSlots)),
+      portSlots_(new std::atomic<PortStats*>[numPortSlots_]),
       pcapDistFailure_(map, kCounterPrefix + "pcap_dist_failure.error"),
+      pcapDistDropped_(map, kCounterPrefix + "pcap_dist_dropped"),
+      asyncTxDropped_(map, kCounterPrefix + "async_tx_dropped"),
       updateStatsExceptions_(
           map,
           kCounterPrefix + "update_stats_exceptions",
@@ -184,9 +231,14 @@ SwitchStats::SwitchStats(ThreadLocalStatsMap* map)
           map,
           kCounterPrefix + "lldp.validate_mismatch",
           SUM,
-          RATE) {}
+          RATE) {
+  for (uint32_t i = 0; i < numPortSlots_; ++i) {
+    portSlots_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
 
-PortStats* FOLLY_NULLABLE SwitchStats::port(PortID portID) {
+PortStats* FOLLY_NULLABLE SwitchStats::portLocked(PortID portID) {
+  std::lock_guard<std::mutex> guard(portsLock_);
   auto it = ports_.find(portID);
   if (it != ports_.end()) {
     return it->second.get();
@@ -204,11 +256,37 @@ SwitchStats::aggregatePort(AggregatePortID aggregatePortID) {
 }
 
 PortStats* SwitchStats::createPortStats(PortID portID, std::string portName) {
-  auto rv = ports_.emplace(
-      portID, std::make_unique<PortStats>(portID, portName, this));
-  DCHECK(rv.second);
-  const auto& it = rv.first;
-  return it->second.get();
+  std::lock_guard<std::mutex> guard(portsLock_);
+  auto it = ports_.find(portID);
+  if (it != ports_.end()) {
+    // Created by the state update thread, or by the owning thread after a
+    // miss, whichever came first
+    return it->second.get();
+  }
+  auto portStats = std::make_unique<PortStats>(portID, portName, this);
+  auto rv = portStats.get();
+  ports_.emplace(portID, std::move(portStats));
+  if (portID < numPortSlots_) {
+    portSlots_[portID].store(rv, std::memory_order_release);
+  }
+  return rv;
+}
+
+void SwitchStats::deletePortStats(PortID portID) {
+  std::unique_ptr<PortStats> portStats;
+  {
+    std::lock_guard<std::mutex> guard(portsLock_);
+    auto it = ports_.find(portID);
+    if (it == ports_.end()) {
+      return;
+    }
+    if (portID < numPortSlots_) {
+      portSlots_[portID].store(nullptr, std::memory_order_release);
+    }
+    portStats = std::move(it->second);
+    ports_.erase(it);
+  }
+  // Destroy the PortStats, which clears its counters, outside the lock
 }
 
 AggregatePortStats* SwitchStats::createAggregatePortStats(
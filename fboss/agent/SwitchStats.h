@@ -12,7 +12,9 @@
 #include <boost/container/flat_map.hpp>
 #include <boost/noncopyable.hpp>
 #include <fb303/ThreadCachedServiceData.h>
+#include <atomic>
 #include <chrono>
+#include <mutex>
 #include "fboss/agent/AggregatePortStats.h"
 #include "fboss/agent/PortStats.h"
 #include "fboss/agent/types.h"
@@ -34,18 +36,44 @@ class SwitchStats : public boost::noncopyable {
    */
   static std::string kCounterPrefix;
 
+  /*
+   * The minimum number of ports whose PortStats can be looked up without
+   * taking a lock.
+   */
+  static constexpr uint32_t kMinPortSlots = 256;
+
   SwitchStats();
+  /*
+   * Create the stats for a switch whose port IDs are all below
+   * numPortSlots.  PortStats for these ports are kept in a dense array
+   * indexed by PortID, so that looking them up on the packet path is a
+   * single load.  Ports with larger IDs still work, but are looked up in
+   * a map under a lock.
+   */
+  explicit SwitchStats(uint32_t numPortSlots);
 
   /*
    * Return the PortStats object for the given PortID.
+   *
+   * This is called for every packet, and does not block as long as the
+   * PortStats have been created in advance (see PortUpdateHandler).
    */
-  PortStats* FOLLY_NULLABLE port(PortID portID);
+  PortStats* FOLLY_NULLABLE port(PortID portID) {
+    if (portID < numPortSlots_) {
+      return portSlots_[portID].load(std::memory_order_acquire);
+    }
+    return portLocked(portID);
+  }
 
   AggregatePortStats* FOLLY_NULLABLE
   aggregatePort(AggregatePortID aggregatePortID);
 
   /*
    * Getters.
+   *
+   * PortStats may be created and deleted from the state update thread while
+   * the thread owning these stats uses them, so use forEachPortStats() to
+   * iterate over them.
    */
   PortStatsMap* getPortStats() {
     return &ports_;
@@ -54,15 +82,30 @@ class SwitchStats : public boost::noncopyable {
     return &ports_;
   }
 
-  // Create a PortStats object for the given PortID
+  template <typename Fn>
+  void forEachPortStats(Fn fn) {
+    std::lock_guard<std::mutex> guard(portsLock_);
+    for (auto& it : ports_) {
+      fn(it.first, it.second.get());
+    }
+  }
+
+  /*
+   * Create a PortStats object for the given PortID, or return the existing
+   * one if another thread already created it.
+   *
+   * This may be called from any thread.
+   */
   PortStats* createPortStats(PortID portID, std::string portName);
   AggregatePortStats* createAggregatePortStats(
       AggregatePortID id,
       std::string name);
 
-  void deletePortStats(PortID portID) {
-    ports_.erase(portID);
-  }
+  /*
+   * Delete the PortStats for the given PortID.  This may be called from any
+   * thread, but the thread owning these stats must not be using them.
+   */
+  void deletePortStats(PortID portID);
 
   void trappedPkt() {
     trapPkts_.addValue(1);
@@ -227,6 +270,18 @@ class SwitchStats : public boost::noncopyable {
     updateState_.addValue(us.count());
   }
 
+  void stateUpdateQueued(bool highPriority, std::chrono::microseconds us) {
+    if (highPriority) {
+      highPriStateUpdateQueueDelay_.addValue(us.count());
+    } else {
+      stateUpdateQueueDelay_.addValue(us.count());
+    }
+  }
+
+  void stateUpdatePrepared(std::chrono::microseconds us) {
+    stateUpdatePrepare_.addValue(us.count());
+  }
+
   void routeUpdate(std::chrono::microseconds us, uint64_t routes) {
     // As syncFib() could include no routes.
     if (routes == 0) {
@@ -275,6 +330,14 @@ class SwitchStats : public boost::noncopyable {
     neighborCacheEventBacklog_.addValue(value);
   }
 
+  void neighborUpdateBatch(int numChanges) {
+    neighborUpdateBatchSize_.addValue(numChanges);
+  }
+
+  void neighborUpdateLatency(std::chrono::milliseconds ms) {
+    neighborUpdateLatency_.addValue(ms.count());
+  }
+
   void linkStateChange() {
     linkStateChange_.addValue(1);
   }
@@ -283,6 +346,14 @@ class SwitchStats : public boost::noncopyable {
     pcapDistFailure_.incrementValue(1);
   }
 
+  void pcapDistDropped() {
+    pcapDistDropped_.incrementValue(1);
+  }
+
+  void asyncTxDropped(uint64_t count) {
+    asyncTxDropped_.incrementValue(count);
+  }
+
   void updateStatsException() {
     updateStatsExceptions_.addValue(1);
   }
@@ -312,7 +383,9 @@ class SwitchStats : public boost::noncopyable {
   typedef fb303::ThreadCachedServiceData::TLHistogram TLHistogram;
   typedef fb303::ThreadCachedServiceData::TLCounter TLCounter;
 
-  explicit SwitchStats(ThreadLocalStatsMap* map);
+  SwitchStats(ThreadLocalStatsMap* map, uint32_t numPortSlots);
+
+  PortStats* FOLLY_NULLABLE portLocked(PortID portID);
 
   // Total number of trapped packets
   TLTimeseries trapPkts_;
@@ -412,6 +485,19 @@ class SwitchStats : public boost::noncopyable {
    */
   TLHistogram updateState_;
 
+  /**
+   * Histograms for the time a StateUpdate spent queued before the update
+   * thread started applying it (in microsecond), per priority.
+   */
+  TLHistogram stateUpdateQueueDelay_;
+  TLHistogram highPriStateUpdateQueueDelay_;
+
+  /**
+   * Histogram for the time used by a single StateUpdate to prepare the new
+   * SwitchState (in microsecond)
+   */
+  TLHistogram stateUpdatePrepare_;
+
   /**
    * Histogram for time used for route update (in microsecond)
    */
@@ -459,18 +545,41 @@ class SwitchStats : public boost::noncopyable {
    */
   TLHistogram neighborCacheEventBacklog_;
 
+  /**
+   * Number of neighbor table changes applied in a single state update
+   */
+  TLHistogram neighborUpdateBatchSize_;
+  /**
+   * Time from a neighbor table change being made in the neighbor cache to
+   * it being applied to the switch state, in milliseconds
+   */
+  TLHistogram neighborUpdateLatency_;
+
   /**
    * Link state up/down change count
    */
   TLTimeseries linkStateChange_;
 
-  // Individual port stats objects, indexed by PortID
+  // Individual port stats objects, indexed by PortID.  portsLock_ protects
+  // ports_, which owns the PortStats, against concurrent creation and
+  // deletion.
+  std::mutex portsLock_;
   PortStatsMap ports_;
+  // The PortStats in ports_ for the first numPortSlots_ port IDs, readable
+  // without holding portsLock_
+  const uint32_t numPortSlots_;
+  std::unique_ptr<std::atomic<PortStats*>[]> portSlots_;
 
   AggregatePortStatsMap aggregatePortIDToStats_;
 
   // Number of packets dropped by the PCAP distribution service
   TLCounter pcapDistFailure_;
+  // Number of packets not published to the PCAP distribution service
+  // because its publishing queue was full
+  TLCounter pcapDistDropped_;
+  // Number of packets not sent because the hardware switch's async tx
+  // queue was full
+  TLCounter asyncTxDropped_;
 
   // Number of failed updateStats callbacks do to exceptions.
   TLTimeseries updateStatsExceptions_;
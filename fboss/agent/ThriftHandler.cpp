@@ -46,6 +46,7 @@
 #include "fboss/agent/state/RouteUpdater.h"
 #include "fboss/agent/state/StateUtils.h"
 #include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/SwitchStateJson.h"
 #include "fboss/agent/state/Vlan.h"
 #include "fboss/agent/state/VlanMap.h"
 
@@ -138,9 +139,15 @@ void dynamicFibUpdate(
     facebook::fboss::RouterID vrf,
     const facebook::fboss::rib::IPv4NetworkToRouteMap& v4NetworkToRoute,
     const facebook::fboss::rib::IPv6NetworkToRouteMap& v6NetworkToRoute,
+    const facebook::fboss::rib::IPv4ChangedPrefixes* v4ChangedPrefixes,
+    const facebook::fboss::rib::IPv6ChangedPrefixes* v6ChangedPrefixes,
     void* cookie) {
   facebook::fboss::rib::ForwardingInformationBaseUpdater fibUpdater(
-      vrf, v4NetworkToRoute, v6NetworkToRoute);
+      vrf,
+      v4NetworkToRoute,
+      v6NetworkToRoute,
+      v4ChangedPrefixes,
+      v6ChangedPrefixes);
 
   auto sw = static_cast<facebook::fboss::SwSwitch*>(cookie);
   sw->updateStateBlocking("", std::move(fibUpdater));
@@ -833,8 +840,35 @@ void ThriftHandler::getCurrentStateJSON(
   if (!jsonPtr) {
     throw FbossError("Malformed JSON Pointer");
   }
-  auto swState = sw_->getState()->toFollyDynamic();
-  auto dyn = swState.get_ptr(jsonPtr.value());
+  auto dyn = getSwitchStateJson(*sw_->getState(), jsonPtr.value());
+  if (!dyn) {
+    throw FbossError("JSON Pointer does not address proper object");
+  }
+  ret = folly::json::serialize(*dyn, folly::json::serialization_opts{});
+}
+
+void ThriftHandler::getCurrentStateJSONPage(
+    std::string& ret,
+    std::unique_ptr<std::string> jsonPointerStr,
+    int64_t offset,
+    int32_t limit) {
+  auto log = LOG_THRIFT_CALL(DBG1);
+  if (!jsonPointerStr) {
+    return;
+  }
+  if (offset < 0 || limit < 0) {
+    throw FbossError("Offset and limit must not be negative");
+  }
+  ensureConfigured();
+  auto const jsonPtr = folly::json_pointer::try_parse(*jsonPointerStr);
+  if (!jsonPtr) {
+    throw FbossError("Malformed JSON Pointer");
+  }
+  auto dyn = getSwitchStateJsonPage(
+      *sw_->getState(), jsonPtr.value(), offset, limit);
+  if (!dyn) {
+    throw FbossError("JSON Pointer does not address proper object");
+  }
   ret = folly::json::serialize(*dyn, folly::json::serialization_opts{});
 }
 
@@ -1116,8 +1150,15 @@ void ThriftHandler::startPktCapture(unique_ptr<CaptureInfo> info) {
   auto log = LOG_THRIFT_CALL(DBG1);
   ensureConfigured();
   auto* mgr = sw_->getCaptureMgr();
+  PcapWriterLimits limits;
+  limits.maxFileBytes = std::max<int64_t>(info->maxFileBytes, 0);
+  limits.maxFileAge =
+      std::chrono::seconds(std::max<int32_t>(info->maxFileSeconds, 0));
+  limits.numFiles = std::max<int32_t>(info->numFiles, 1);
+  limits.maxPktsPerSec = std::max<int32_t>(info->maxPktsPerSec, 0);
+  limits.maxBytesPerSec = std::max<int64_t>(info->maxBytesPerSec, 0);
   auto capture = make_unique<PktCapture>(
-      info->name, info->maxPackets, info->direction, info->filter);
+      info->name, info->maxPackets, info->direction, info->filter, limits);
   mgr->startCapture(std::move(capture));
 }
 
@@ -257,6 +257,16 @@ class ThriftHandler : virtual public FbossCtrlSvIf,
   void getCurrentStateJSON(std::string& ret, std::unique_ptr<std::string>)
       override;
 
+  /**
+   * Serialize a page of the array in the live running switch state at the
+   * path pointed to by JSON Pointer
+   */
+  void getCurrentStateJSONPage(
+      std::string& ret,
+      std::unique_ptr<std::string> jsonPointer,
+      int64_t offset,
+      int32_t limit) override;
+
   /**
    * Patch live running switch state at path pointed by jsonPointer using the
    * JSON merge patch supplied in jsonPatch
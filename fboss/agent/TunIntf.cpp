@@ -16,21 +16,47 @@ extern "C" {
 #include <linux/if_link.h>
 #include <linux/if_tun.h>
 #include <linux/rtnetlink.h>
+#include <linux/virtio_net.h>
 #include <netlink/route/link.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 }
 
+#include <folly/hash/Hash.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventHandler.h>
 #include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
 #include "fboss/agent/NlError.h"
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/SysError.h"
 #include "fboss/agent/TxPacket.h"
 #include "fboss/agent/packet/EthHdr.h"
+#include "fboss/agent/packet/IPProto.h"
+
+#include <array>
+
+DEFINE_int32(
+    tun_intf_queues,
+    1,
+    "Number of queues to open on each TUN interface. Interfaces are created "
+    "with IFF_MULTI_QUEUE when this is more than 1, while existing interfaces "
+    "keep the mode they were created with.");
+DEFINE_bool(
+    tun_intf_vnet_hdr,
+    false,
+    "Open TUN interfaces with IFF_VNET_HDR");
+DEFINE_int32(
+    tun_intf_read_batch,
+    16,
+    "Max packets to read from the host on each TUN queue per wakeup");
+DEFINE_int32(
+    tun_intf_max_pending,
+    1024,
+    "Max packets queued to be written to the host on each TUN queue");
 
 namespace facebook {
 namespace fboss {
@@ -39,8 +65,8 @@ namespace {
 
 const std::string kTunDev = "/dev/net/tun";
 
-// Max packets to be processed which are received from host
-const int kMaxSentOneTime = 16;
+// Max number of buffers to write to the host in one writev()
+constexpr size_t kMaxIovecs = 16;
 
 // Definition of `iplink_req` as it is not well defined in any header files
 struct iplink_req {
@@ -60,65 +86,109 @@ struct iplink_req {
 #ifndef IN6_ADDR_GEN_MODE_NONE
 #define IN6_ADDR_GEN_MODE_NONE 1
 #endif
+// Available since kernel-3.8
+#ifndef IFF_MULTI_QUEUE
+#define IFF_MULTI_QUEUE 0x0100
+#endif
+
+/**
+ * Hash of the addresses and TCP/UDP ports of an L3 packet, so that all the
+ * packets of a flow are sent to the host through the same queue.  Only the
+ * first buffer of the packet is looked at.
+ */
+uint32_t flowHash(const folly::IOBuf* buf) {
+  const uint8_t* data = buf->data();
+  auto len = buf->length();
+  if (len == 0) {
+    return 0;
+  }
+  size_t addrOffset;
+  size_t addrLen;
+  size_t l4Offset;
+  uint8_t proto;
+  switch (data[0] >> 4) {
+    case 4:
+      if (len < 20) {
+        return 0;
+      }
+      addrOffset = 12;
+      addrLen = 8;
+      l4Offset = (data[0] & 0xf) * 4;
+      // Keep all fragments of a packet together, by ignoring the ports of
+      // the first one
+      proto = (data[6] & 0x3f) || data[7] ? 0 : data[9];
+      break;
+    case 6:
+      if (len < 40) {
+        return 0;
+      }
+      addrOffset = 8;
+      addrLen = 32;
+      l4Offset = 40;
+      proto = data[6];
+      break;
+    default:
+      return 0;
+  }
+  auto hash = folly::hash::fnv32_buf(data + addrOffset, addrLen);
+  if ((proto == static_cast<uint8_t>(IP_PROTO::IP_PROTO_TCP) ||
+       proto == static_cast<uint8_t>(IP_PROTO::IP_PROTO_UDP)) &&
+      len >= l4Offset + 2 * sizeof(uint16_t)) {
+    hash = folly::hash::fnv32_buf(data + l4Offset, 2 * sizeof(uint16_t), hash);
+  }
+  return hash;
+}
 
 } // anonymous namespace
 
 TunIntf::TunIntf(
     SwSwitch* sw,
-    folly::EventBase* evb,
+    const std::vector<folly::EventBase*>& evbs,
     InterfaceID ifID,
     int ifIndex,
     int mtu)
-    : folly::EventHandler(evb),
-      sw_(sw),
+    : sw_(sw),
       name_(util::createTunIntfName(ifID)),
       ifID_(ifID),
       ifIndex_(ifIndex),
       mtu_(mtu) {
   DCHECK(sw) << "NULL pointer to SwSwitch.";
-  DCHECK(evb) << "NULL pointer to EventBase";
+  DCHECK(!evbs.empty()) << "No EventBase";
 
-  openFD();
-  SCOPE_FAIL {
-    closeFD();
-  };
+  openQueues(evbs);
 
   // XXX: Disabling mode on existing interface so that we end up removing
   // automatically allocated v6 link local address on next release. from
   // next release onwards we will not need it
   disableIPv6AddrGenMode(ifIndex_);
 
-  XLOG(INFO) << "Added interface " << name_ << " with fd " << fd_ << " @ index "
-             << ifIndex_ << ", "
+  XLOG(INFO) << "Added interface " << name_ << " with " << queues_.size()
+             << " queues @ index " << ifIndex_ << ", "
              << "DOWN";
 }
 
 TunIntf::TunIntf(
     SwSwitch* sw,
-    folly::EventBase* evb,
+    const std::vector<folly::EventBase*>& evbs,
     InterfaceID ifID,
     bool status,
     const Interface::Addresses& addr,
     int mtu)
-    : folly::EventHandler(evb),
-      sw_(sw),
+    : sw_(sw),
       name_(util::createTunIntfName(ifID)),
       ifID_(ifID),
       status_(status),
       addrs_(addr),
       mtu_(mtu) {
   DCHECK(sw) << "NULL pointer to SwSwitch.";
-  DCHECK(evb) << "NULL pointer to EventBase";
+  DCHECK(!evbs.empty()) << "No EventBase";
 
-  // Open Tun interface FD for socket-IO
-  openFD();
-  SCOPE_FAIL {
-    closeFD();
-  };
+  // Open Tun interface queues for socket-IO
+  openQueues(evbs);
 
   // Make the Tun interface persistent, so that the network sessions from the
   // application (i.e. BGP)  will not be reset if controller restarts
-  auto ret = ioctl(fd_, TUNSETPERSIST, 1);
+  auto ret = ioctl(queues_.front()->fd(), TUNSETPERSIST, 1);
   sysCheckError(ret, "Failed to set persist interface ", name_);
 
   // TODO: if needed, we can adjust send buffer size, TUNSETSNDBUF
@@ -154,82 +224,154 @@ TunIntf::TunIntf(
   // Disable v6 link-local address assignment on Tun interface
   disableIPv6AddrGenMode(ifIndex_);
 
-  XLOG(INFO) << "Created interface " << name_ << " with fd " << fd_
-             << " @ index " << ifIndex_ << ", " << (status ? "UP" : "DOWN");
+  XLOG(INFO) << "Created interface " << name_ << " with " << queues_.size()
+             << " queues @ index " << ifIndex_ << ", "
+             << (status ? "UP" : "DOWN");
+}
+
+TunIntf::TunIntf(
+    SwSwitch* sw,
+    const std::vector<folly::EventBase*>& evbs,
+    InterfaceID ifID,
+    const std::vector<int>& fds)
+    : sw_(sw), name_(util::createTunIntfName(ifID)), ifID_(ifID) {
+  DCHECK(sw) << "NULL pointer to SwSwitch.";
+  DCHECK(!evbs.empty()) << "No EventBase";
+
+  multiQueue_ = fds.size() > 1;
+  for (size_t i = 0; i < fds.size(); ++i) {
+    queues_.push_back(
+        std::make_unique<Queue>(this, evbs[i % evbs.size()], fds[i]));
+  }
 }
 
 TunIntf::~TunIntf() {
   stop();
 
   // We must have a valid fd to TunIntf
-  CHECK_NE(fd_, -1);
+  CHECK(!queues_.empty());
 
   // Delete interface if need be
   if (toDelete_) {
-    auto ret = ioctl(fd_, TUNSETPERSIST, 0);
+    auto ret = ioctl(queues_.front()->fd(), TUNSETPERSIST, 0);
     sysLogError(ret, "Failed to unset persist interface ", name_);
   }
 
-  // Close FD. This will delete the interface if TUNSETPERSIST is not on
-  closeFD();
+  // Close FDs. This will delete the interface if TUNSETPERSIST is not on
+  queues_.clear();
   XLOG(INFO) << (toDelete_ ? "Delete" : "Detach") << " interface " << name_;
 }
 
+template <typename Fn>
+void TunIntf::forEachQueue(Fn fn) {
+  for (auto& queue : queues_) {
+    auto q = queue.get();
+    q->evb()->runImmediatelyOrRunInEventBaseThreadAndWait([&] { fn(q); });
+  }
+}
+
 void TunIntf::stop() {
-  unregisterHandler();
+  forEachQueue([](Queue* queue) { queue->stop(); });
 }
 
 void TunIntf::start() {
-  if (fd_ != -1 && !isHandlerRegistered()) {
-    changeHandlerFD(folly::NetworkSocket::fromFd(fd_));
-    registerHandler(folly::EventHandler::READ | folly::EventHandler::PERSIST);
+  forEachQueue([](Queue* queue) { queue->start(); });
+}
+
+void TunIntf::openQueue(folly::EventBase* evb) {
+  auto fd = openFD(multiQueue_);
+  std::unique_ptr<Queue> queue;
+  {
+    SCOPE_FAIL {
+      closeFD(fd);
+    };
+    queue = std::make_unique<Queue>(this, evb, fd);
   }
+  queues_.push_back(std::move(queue));
 }
 
-void TunIntf::openFD() {
-  fd_ = open(kTunDev.c_str(), O_RDWR);
-  sysCheckError(fd_, "Cannot open ", kTunDev.c_str());
+void TunIntf::openQueues(const std::vector<folly::EventBase*>& evbs) {
+  auto numQueues = std::max(FLAGS_tun_intf_queues, 1);
+  multiQueue_ = numQueues > 1;
+  vnetHdr_ = FLAGS_tun_intf_vnet_hdr;
+
+  // Spread the queues of all the interfaces across the threads
+  auto queueEvb = [&](int queue) {
+    return evbs[(static_cast<size_t>(ifID_) + queue) % evbs.size()];
+  };
+
+  try {
+    openQueue(queueEvb(0));
+  } catch (const SysError& ex) {
+    // The kernel refuses to attach to an existing interface in a different
+    // queueing mode from the one it was created with
+    if (ex.getSysError() != EINVAL) {
+      throw;
+    }
+    multiQueue_ = !multiQueue_;
+    XLOG(INFO) << "Interface " << name_ << " exists, attaching as "
+               << (multiQueue_ ? "multi" : "single") << " queue";
+    openQueue(queueEvb(0));
+  }
+
+  // Set configured MTU
+  setMtu(getMtu());
+
+  if (multiQueue_) {
+    for (int i = 1; i < numQueues; ++i) {
+      openQueue(queueEvb(i));
+    }
+  }
+}
+
+int TunIntf::openFD(bool multiQueue) const {
+  auto fd = open(kTunDev.c_str(), O_RDWR);
+  sysCheckError(fd, "Cannot open ", kTunDev.c_str());
   SCOPE_FAIL {
-    closeFD();
+    close(fd);
   };
 
   struct ifreq ifr;
   memset(&ifr, 0, sizeof(ifr));
-  // Flags: IFF_TUN   - TUN device (no Ethernet headers)
-  //        IFF_NO_PI - Do not provide packet information
+  // Flags: IFF_TUN         - TUN device (no Ethernet headers)
+  //        IFF_NO_PI       - Do not provide packet information
+  //        IFF_MULTI_QUEUE - Allow an fd per queue
+  //        IFF_VNET_HDR    - Prefix packets with a virtio_net_hdr
   ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+  if (multiQueue) {
+    ifr.ifr_flags |= IFF_MULTI_QUEUE;
+  }
+  if (vnetHdr_) {
+    ifr.ifr_flags |= IFF_VNET_HDR;
+  }
   bzero(ifr.ifr_name, sizeof(ifr.ifr_name));
   size_t len = std::min(name_.size(), sizeof(ifr.ifr_name));
   memmove(ifr.ifr_name, name_.c_str(), len);
-  auto ret = ioctl(fd_, TUNSETIFF, (void*)&ifr);
+  auto ret = ioctl(fd, TUNSETIFF, (void*)&ifr);
   sysCheckError(ret, "Failed to create/attach interface ", name_);
 
-  // Set configured MTU
-  setMtu(mtu_);
-
   // make fd non-blocking
-  auto flags = fcntl(fd_, F_GETFL);
-  sysCheckError(flags, "Failed to get flags from fd ", fd_);
+  auto flags = fcntl(fd, F_GETFL);
+  sysCheckError(flags, "Failed to get flags from fd ", fd);
   flags |= O_NONBLOCK;
-  ret = fcntl(fd_, F_SETFL, flags);
-  sysCheckError(
-      ret, "Failed to set non-blocking flags ", flags, " to fd ", fd_);
-  flags = fcntl(fd_, F_GETFD);
-  sysCheckError(flags, "Failed to get flags from fd ", fd_);
+  ret = fcntl(fd, F_SETFL, flags);
+  sysCheckError(ret, "Failed to set non-blocking flags ", flags, " to fd ", fd);
+  flags = fcntl(fd, F_GETFD);
+  sysCheckError(flags, "Failed to get flags from fd ", fd);
   flags |= FD_CLOEXEC;
-  ret = fcntl(fd_, F_SETFD, flags);
+  ret = fcntl(fd, F_SETFD, flags);
   sysCheckError(
-      ret, "Failed to set close-on-exec flags ", flags, " to fd ", fd_);
+      ret, "Failed to set close-on-exec flags ", flags, " to fd ", fd);
 
-  XLOG(INFO) << "Create/attach to tun interface " << name_ << " @ fd " << fd_;
+  XLOG(INFO) << "Create/attach to tun interface " << name_ << " @ fd " << fd;
+  return fd;
 }
 
-void TunIntf::closeFD() noexcept {
-  auto ret = close(fd_);
-  sysLogError(ret, "Failed to close fd ", fd_, " for interface ", name_);
+void TunIntf::closeFD(int fd) noexcept {
+  auto ret = close(fd);
+  sysLogError(ret, "Failed to close fd ", fd, " for interface ", name_);
   if (ret == 0) {
-    XLOG(INFO) << "Closed fd " << fd_ << " for interface " << name_;
-    fd_ = -1;
+    XLOG(INFO) << "Closed fd " << fd << " for interface " << name_;
   }
 }
 
@@ -251,7 +393,7 @@ void TunIntf::addAddress(const folly::IPAddress& addr, uint8_t mask) {
 }
 
 void TunIntf::setMtu(int mtu) {
-  mtu_ = mtu;
+  mtu_.store(mtu, std::memory_order_relaxed);
   auto sock = socket(PF_INET, SOCK_DGRAM, 0);
   sysCheckError(sock, "Failed to open socket");
   SCOPE_EXIT {
@@ -262,14 +404,14 @@ void TunIntf::setMtu(int mtu) {
   size_t len = std::min(name_.size(), sizeof(ifr.ifr_name));
   memset(&ifr, 0, sizeof(ifr));
   memmove(ifr.ifr_name, name_.c_str(), len);
-  ifr.ifr_mtu = mtu_;
+  ifr.ifr_mtu = mtu;
   auto ret = ioctl(sock, SIOCSIFMTU, (void*)&ifr);
   sysCheckError(
       ret,
       "Failed to set MTU ",
       ifr.ifr_mtu,
-      " to fd ",
-      fd_,
+      " to interface ",
+      name_,
       " errno = ",
       errno);
   XLOG(DBG3) << "Set tun " << name_ << " MTU to " << mtu;
@@ -314,23 +456,78 @@ void TunIntf::disableIPv6AddrGenMode(int ifIndex) {
   return;
 }
 
-void TunIntf::handlerReady(uint16_t /*events*/) noexcept {
-  CHECK(fd_ != -1);
+bool TunIntf::sendPacketToHost(std::unique_ptr<RxPacket> pkt) {
+  CHECK(!queues_.empty());
+  const int l2Len = EthHdr::SIZE;
+
+  auto buf = pkt->buf();
+  if (buf->length() <= l2Len) {
+    XLOG(ERR) << "Received a too small packet with length " << buf->length();
+    return false;
+  }
+
+  // skip L2 header
+  buf->trimStart(l2Len);
+
+  return pickQueue(buf)->enqueue(std::move(pkt));
+}
+
+TunIntf::Queue* TunIntf::pickQueue(const folly::IOBuf* buf) const {
+  if (queues_.size() == 1) {
+    return queues_.front().get();
+  }
+  return queues_[flowHash(buf) % queues_.size()].get();
+}
+
+TunIntf::Queue::Queue(TunIntf* intf, folly::EventBase* evb, int fd)
+    : folly::EventHandler(evb, folly::NetworkSocket::fromFd(fd)),
+      intf_(intf),
+      evb_(evb),
+      fd_(fd) {
+  DCHECK(evb) << "NULL pointer to EventBase";
+}
+
+TunIntf::Queue::~Queue() {
+  intf_->closeFD(fd_);
+}
+
+void TunIntf::Queue::start() {
+  if (!isHandlerRegistered()) {
+    registerHandler(folly::EventHandler::READ | folly::EventHandler::PERSIST);
+  }
+}
+
+void TunIntf::Queue::stop() {
+  unregisterHandler();
+  flush();
+}
+
+void TunIntf::Queue::handlerReady(uint16_t /*events*/) noexcept {
+  auto sw = intf_->sw_;
+  auto mtu = intf_->getMtu();
 
-  // Since this is L3 packet size, we should also reserve some space for L2
-  // header, which is 18 bytes (including one vlan tag)
   int sent = 0;
   int dropped = 0;
   uint64_t bytes = 0;
   bool fdFail = false;
+  struct virtio_net_hdr vnetHdr;
   try {
-    while (sent + dropped < kMaxSentOneTime) {
-      std::unique_ptr<TxPacket> pkt;
-      pkt = sw_->allocateL3TxPacket(mtu_);
-      auto buf = pkt->buf();
-      int ret = 0;
+    while (sent + dropped < FLAGS_tun_intf_read_batch) {
+      // Reuse the packet allocated by the last read if it was not sent, and
+      // still fits the MTU
+      if (!spare_ || spare_->buf()->tailroom() < static_cast<size_t>(mtu)) {
+        spare_ = sw->allocateL3TxPacket(mtu);
+      }
+      auto buf = spare_->buf();
+      std::array<iovec, 2> iov;
+      int iovcnt = 0;
+      if (intf_->vnetHdr_) {
+        iov[iovcnt++] = {&vnetHdr, sizeof(vnetHdr)};
+      }
+      iov[iovcnt++] = {buf->writableTail(), buf->tailroom()};
+      ssize_t ret = 0;
       do {
-        ret = read(fd_, buf->writableTail(), buf->tailroom());
+        ret = readv(fd_, iov.data(), iovcnt);
       } while (ret == -1 && errno == EINTR);
       if (ret < 0) {
         if (errno != EAGAIN) {
@@ -345,7 +542,23 @@ void TunIntf::handlerReady(uint16_t /*events*/) noexcept {
         // in debug mode.
         DCHECK(false) << "Unexpected event. Nothing to read.";
         break;
-      } else if (ret > buf->tailroom()) {
+      }
+      if (intf_->vnetHdr_) {
+        // No offloads are enabled on the interface (TUNSETOFFLOAD), so the
+        // kernel should only hand us complete, checksummed packets
+        if (static_cast<size_t>(ret) <= sizeof(vnetHdr) ||
+            vnetHdr.gso_type != VIRTIO_NET_HDR_GSO_NONE ||
+            (vnetHdr.flags & VIRTIO_NET_HDR_F_NEEDS_CSUM)) {
+          XLOG(ERR) << "Unexpected packet with virtio header flags "
+                    << static_cast<int>(vnetHdr.flags) << ", gso type "
+                    << static_cast<int>(vnetHdr.gso_type)
+                    << " received from host. Drop the packet.";
+          ++dropped;
+          continue;
+        }
+        ret -= sizeof(vnetHdr);
+      }
+      if (static_cast<size_t>(ret) > buf->tailroom()) {
         // The pkt is larger than the buffer. We don't have complete packet.
         // It shall not happen unless the MTU is mis-match. Drop the packet.
         XLOG(ERR) << "Too large packet (" << ret << " > " << buf->tailroom()
@@ -354,7 +567,7 @@ void TunIntf::handlerReady(uint16_t /*events*/) noexcept {
       } else {
         bytes += ret;
         buf->append(ret);
-        sw_->sendL3Packet(std::move(pkt), ifID_);
+        sw->sendL3Packet(std::move(spare_), intf_->ifID_);
         ++sent;
       }
     } // while
@@ -368,38 +581,81 @@ void TunIntf::handlerReady(uint16_t /*events*/) noexcept {
   }
 
   XLOG(DBG4) << "Forwarded " << sent << " packets (" << bytes
-             << " bytes) from host @ fd " << fd_ << " for interface " << name_
-             << " dropped:" << dropped;
+             << " bytes) from host @ fd " << fd_ << " for interface "
+             << intf_->name_ << " dropped:" << dropped;
 }
 
-bool TunIntf::sendPacketToHost(std::unique_ptr<RxPacket> pkt) {
-  CHECK(fd_ != -1);
-  const int l2Len = EthHdr::SIZE;
+bool TunIntf::Queue::enqueue(std::unique_ptr<RxPacket> pkt) {
+  bool scheduleFlush;
+  {
+    std::lock_guard<std::mutex> g(pendingLock_);
+    if (pending_.size() >= static_cast<size_t>(FLAGS_tun_intf_max_pending)) {
+      XLOG(DBG2) << "Too many packets queued to host from Interface "
+                 << intf_->ifID_ << ". Drop the packet.";
+      return false;
+    }
+    scheduleFlush = pending_.empty();
+    pending_.push_back(std::move(pkt));
+  }
+  if (scheduleFlush) {
+    evb_->runInEventBaseThread([this] { flush(); });
+  }
+  return true;
+}
 
-  auto buf = pkt->buf();
-  if (buf->length() <= l2Len) {
-    XLOG(ERR) << "Received a too small packet with length " << buf->length();
-    return false;
+void TunIntf::Queue::flush() noexcept {
+  {
+    std::lock_guard<std::mutex> g(pendingLock_);
+    pending_.swap(writing_);
   }
+  int sent = 0;
+  for (auto& pkt : writing_) {
+    sent += write(pkt.get());
+  }
+  XLOG(DBG4) << "Sent " << sent << " of " << writing_.size()
+             << " packets to host from Interface " << intf_->ifID_ << " @ fd "
+             << fd_;
+  writing_.clear();
+}
 
-  // skip L2 header
-  buf->trimStart(l2Len);
+bool TunIntf::Queue::write(RxPacket* pkt) {
+  // A tun fd takes one packet per write, but the virtio header and all the
+  // buffers of the packet go in a single writev() without being copied.
+  auto buf = pkt->buf();
+  struct virtio_net_hdr vnetHdr;
+  std::array<iovec, kMaxIovecs> iov;
+  size_t iovcnt = 0;
+  size_t len = buf->computeChainDataLength();
+  if (intf_->vnetHdr_) {
+    memset(&vnetHdr, 0, sizeof(vnetHdr));
+    vnetHdr.gso_type = VIRTIO_NET_HDR_GSO_NONE;
+    iov[iovcnt++] = {&vnetHdr, sizeof(vnetHdr)};
+    len += sizeof(vnetHdr);
+  }
+  if (buf->countChainElements() > kMaxIovecs - iovcnt) {
+    buf->coalesce();
+  }
+  for (auto range : *buf) {
+    iov[iovcnt++] = {const_cast<uint8_t*>(range.data()), range.size()};
+  }
 
-  int ret = 0;
+  ssize_t ret = 0;
   do {
-    ret = write(fd_, buf->data(), buf->length());
+    ret = writev(fd_, iov.data(), iovcnt);
   } while (ret == -1 && errno == EINTR);
   if (ret < 0) {
-    sysLogError(ret, "Failed to send packet to host from Interface ", ifID_);
+    sysLogError(
+        ret, "Failed to send packet to host from Interface ", intf_->ifID_);
     return false;
-  } else if (ret < buf->length()) {
-    XLOG(ERR) << "Failed to send full packet to host from Interface " << ifID_
-              << ". " << ret << " bytes sent instead of " << buf->length();
+  } else if (static_cast<size_t>(ret) < len) {
+    XLOG(ERR) << "Failed to send full packet to host from Interface "
+              << intf_->ifID_ << ". " << ret << " bytes sent instead of "
+              << len;
     return false;
   }
 
   XLOG(DBG4) << "Send packet (" << ret << " bytes) to host from Interface "
-             << ifID_;
+             << intf_->ifID_;
   return true;
 }
 
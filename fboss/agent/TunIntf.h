@@ -15,13 +15,27 @@
 #include "fboss/agent/state/StateUtils.h"
 #include "fboss/agent/types.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace facebook {
 namespace fboss {
 
 class SwSwitch;
 class RxPacket;
+class TxPacket;
 
-class TunIntf : private folly::EventHandler {
+/**
+ * A TUN interface on the host for a switch interface.
+ *
+ * The interface may be opened with several queues (IFF_MULTI_QUEUE), each
+ * with its own fd served by one of the given event bases, so that packets
+ * to and from the host are spread across threads.  Packets sent to the host
+ * are queued and written in batches by the queue's event base thread.
+ */
+class TunIntf {
  public:
   /**
    * Creates a TunIntf object of already existing linux interface. Initial
@@ -31,7 +45,7 @@ class TunIntf : private folly::EventHandler {
    */
   TunIntf(
       SwSwitch* sw,
-      folly::EventBase* evb,
+      const std::vector<folly::EventBase*>& evbs,
       InterfaceID ifID,
       int ifIndex /* linux */,
       int mtu);
@@ -41,16 +55,19 @@ class TunIntf : private folly::EventHandler {
    */
   TunIntf(
       SwSwitch* sw,
-      folly::EventBase* evb,
+      const std::vector<folly::EventBase*>& evbs,
       InterfaceID ifID, // Switch interface ID
       bool status,
       const Interface::Addresses& addrs,
       int mtu);
 
-  ~TunIntf() override;
+  ~TunIntf();
 
   /**
    * Start/Stop packet forwarding on Tun interface.
+   * These wait for every queue's event base to pick up the change, so once
+   * stop() returns no packets are being read from the host, and the packets
+   * queued to be sent to the host have been written.
    */
   void start();
   void stop();
@@ -90,8 +107,12 @@ class TunIntf : private folly::EventHandler {
    * Unlike other methods, which are called on thread that serves the evb,
    * this function can be called from any thread.
    *
-   * @return true The packet is sent to host
-   *         false The packet is dropped due to errors
+   * The packet is queued, and written to the host from the thread serving
+   * the queue chosen by the packet's flow, so that a flow is never
+   * reordered.
+   *
+   * @return true The packet is queued to be sent to host
+   *         false The packet is dropped due to errors or a full queue
    */
   bool sendPacketToHost(std::unique_ptr<RxPacket> pkt);
 
@@ -117,26 +138,114 @@ class TunIntf : private folly::EventHandler {
   }
 
   int getMtu() const {
-    return mtu_;
+    return mtu_.load(std::memory_order_relaxed);
+  }
+
+  size_t getNumQueues() const {
+    return queues_.size();
   }
 
   bool getStatus() const {
     return status_;
   }
 
+ protected:
+  /**
+   * For tests, which attach the queues to fds they opened themselves, such
+   * as one end of a socketpair, rather than to an interface on the host.
+   * Takes ownership of the fds.
+   */
+  TunIntf(
+      SwSwitch* sw,
+      const std::vector<folly::EventBase*>& evbs,
+      InterfaceID ifID,
+      const std::vector<int>& fds);
+
  private:
   /**
-   * Callback for event on Tun interface's read socket-fd
-   * Override's folly::EventHandler handlerReady callback.
+   * One queue of the Tun interface, with its own fd
+   */
+  class Queue : private folly::EventHandler {
+   public:
+    Queue(TunIntf* intf, folly::EventBase* evb, int fd);
+    ~Queue() override;
+
+    int fd() const {
+      return fd_;
+    }
+
+    folly::EventBase* evb() const {
+      return evb_;
+    }
+
+    /**
+     * Must be called from the thread serving the queue's event base.
+     * stop() writes out the packets queued to the host.
+     */
+    void start();
+    void stop();
+
+    /**
+     * Queue a packet to be written to the host.  Can be called from any
+     * thread.
+     */
+    bool enqueue(std::unique_ptr<RxPacket> pkt);
+
+   private:
+    /**
+     * Callback for event on the queue's read fd
+     * Override's folly::EventHandler handlerReady callback.
+     */
+    void handlerReady(uint16_t events) noexcept override;
+
+    /**
+     * Write all queued packets to the host
+     */
+    void flush() noexcept;
+    bool write(RxPacket* pkt);
+
+    TunIntf* const intf_;
+    folly::EventBase* const evb_;
+    const int fd_;
+
+    // A packet allocated for a read which did not use it, e.g. because
+    // there was nothing left to read, kept for the next read.  Only used
+    // from the event base thread.
+    std::unique_ptr<TxPacket> spare_;
+
+    // Packets waiting to be written to the host.  A flush is scheduled on
+    // the event base whenever this goes from empty to non-empty.
+    std::mutex pendingLock_;
+    std::vector<std::unique_ptr<RxPacket>> pending_;
+    // The batch being written, kept to reuse its storage.  Only used from
+    // the event base thread.
+    std::vector<std::unique_ptr<RxPacket>> writing_;
+  };
+
+  /**
+   * Open a new fd to read/write data from one queue of the Tun interface,
+   * adding it to queues_.
+   */
+  void openQueue(folly::EventBase* evb);
+  /**
+   * Open the requested number of queues.  Interfaces which already exist
+   * keep the queueing mode (single or multi-queue) they were created with.
    */
-  void handlerReady(uint16_t events) noexcept override;
+  void openQueues(const std::vector<folly::EventBase*>& evbs);
+  int openFD(bool multiQueue) const;
+  void closeFD(int fd) noexcept;
 
   /**
-   * Open/Close a new socket-fd to read/write data from Tun interface.
-   * fd_ is mutated.
+   * Run a function on every queue from the thread serving it, waiting for
+   * it to complete.
    */
-  void openFD();
-  void closeFD() noexcept;
+  template <typename Fn>
+  void forEachQueue(Fn fn);
+
+  /**
+   * The queue used to send a packet to the host
+   */
+  Queue* pickQueue(const folly::IOBuf* buf) const;
 
   /**
    * In newer kernel an interface is automatically gets link-local IPv6 address
@@ -158,12 +267,18 @@ class TunIntf : private folly::EventHandler {
 
   Interface::Addresses addrs_; // The IP addresses assigned to this intf
 
+  // Whether the interface was opened with IFF_MULTI_QUEUE
+  bool multiQueue_{false};
+  // Whether packets carry a virtio_net_hdr (IFF_VNET_HDR)
+  bool vnetHdr_{false};
+
   /**
-   * File descriptor for this interface through which packets can
-   * be received from or sent to.
+   * The queues through which packets can be received from or sent to the
+   * interface.  Fixed after construction.
    */
-  int fd_{-1};
-  int mtu_{-1};
+  std::vector<std::unique_ptr<Queue>> queues_;
+  // Read from the queues' threads
+  std::atomic<int> mtu_{-1};
 };
 
 } // namespace fboss
@@ -18,6 +18,7 @@ extern "C" {
 #include <sys/ioctl.h>
 }
 
+#include <folly/Conv.h>
 #include <folly/Demangle.h>
 #include <folly/MapUtil.h>
 #include <folly/io/async/EventBase.h>
@@ -26,6 +27,7 @@ extern "C" {
 #include "fboss/agent/RxPacket.h"
 #include "fboss/agent/SysError.h"
 #include "fboss/agent/TunIntf.h"
+#include "fboss/agent/Utils.h"
 #include "fboss/agent/state/Interface.h"
 #include "fboss/agent/state/InterfaceMap.h"
 #include "fboss/agent/state/Port.h"
@@ -33,6 +35,14 @@ extern "C" {
 
 #include <boost/container/flat_set.hpp>
 
+#include <gflags/gflags.h>
+#include <thread>
+
+DEFINE_int32(
+    tun_io_threads,
+    2,
+    "Number of threads reading and writing packets on the TUN interfaces");
+
 namespace {
 const int kDefaultMtu = 1500;
 }
@@ -43,10 +53,40 @@ namespace fboss {
 using folly::EventBase;
 using folly::IPAddress;
 
+/**
+ * A thread serving the queues of some of the TUN interfaces
+ */
+class TunManager::IoThread {
+ public:
+  explicit IoThread(int index)
+      : thread_([this, index] {
+          initThread(folly::to<std::string>("fbossTunIo", index));
+          evb_.loopForever();
+        }) {}
+
+  ~IoThread() {
+    evb_.runInEventBaseThread([this] { evb_.terminateLoopSoon(); });
+    thread_.join();
+  }
+
+  EventBase* getEventBase() {
+    return &evb_;
+  }
+
+ private:
+  EventBase evb_;
+  std::thread thread_;
+};
+
 TunManager::TunManager(SwSwitch* sw, EventBase* evb) : sw_(sw), evb_(evb) {
   DCHECK(sw) << "NULL pointer to SwSwitch.";
   DCHECK(evb) << "NULL pointer to EventBase";
 
+  for (int i = 0; i < std::max(FLAGS_tun_io_threads, 1); ++i) {
+    ioThreads_.push_back(std::make_unique<IoThread>(i));
+    ioEvbs_.push_back(ioThreads_.back()->getEventBase());
+  }
+
   sock_ = nl_socket_alloc();
   if (!sock_) {
     throw FbossError("failed to allocate libnl socket");
@@ -110,7 +150,7 @@ void TunManager::addExistingIntf(const std::string& ifName, int ifIndex) {
     intfs_.erase(ret.first);
   };
   ret.first->second.reset(
-      new TunIntf(sw_, evb_, ifID, ifIndex, getInterfaceMtu(ifID)));
+      new TunIntf(sw_, ioEvbs_, ifID, ifIndex, getInterfaceMtu(ifID)));
 }
 
 void TunManager::addNewIntf(
@@ -126,7 +166,7 @@ void TunManager::addNewIntf(
     intfs_.erase(ret.first);
   };
   auto intf = std::make_unique<TunIntf>(
-      sw_, evb_, ifID, isUp, addrs, getInterfaceMtu(ifID));
+      sw_, ioEvbs_, ifID, isUp, addrs, getInterfaceMtu(ifID));
 
   SCOPE_FAIL {
     intf->setDelete();
@@ -140,9 +180,15 @@ void TunManager::addNewIntf(
   // create a new route table for this InterfaceID
   addRouteTable(ifID, ifIndex);
 
-  // add all addresses
+  // add all addresses.  Their results are only known once the requests are
+  // flushed, which then deletes the interface if any of them failed
   for (const auto& addr : addrs) {
-    addTunAddress(ifID, ifName, ifIndex, addr.first, addr.second);
+    addTunAddress(
+        ifID, ifName, ifIndex, addr.first, addr.second, [this, ifID](int err) {
+          if (err < 0) {
+            failedIntfs_.insert(ifID);
+          }
+        });
   }
 
   // Store it in local map on success
@@ -165,6 +211,10 @@ void TunManager::removeIntf(InterfaceID ifID) {
   // Remove the route table and associated rule
   removeRouteTable(ifID, intf->getIfIndex());
   intf->setDelete();
+
+  // The interface is only deleted from the host once the requests above
+  // have been sent, as its routes go with it
+  removedIntfs_.push_back(std::move(intf));
   intfs_.erase(iter);
 }
 
@@ -306,40 +356,50 @@ void TunManager::addRemoveRouteTable(InterfaceID ifID, int ifIndex, bool add) {
     rtnl_route_nh_set_ifindex(nexthop, ifIndex);
     rtnl_route_add_nexthop(route, nexthop);
 
+    struct nl_msg* msg = nullptr;
     if (add) {
-      error = rtnl_route_add(sock_, route, NLM_F_REPLACE);
+      error = rtnl_route_build_add_request(route, NLM_F_REPLACE, &msg);
     } else {
-      error = rtnl_route_delete(sock_, route, 0);
+      error = rtnl_route_build_del_request(route, 0, &msg);
     }
-    /**
-     * Disable: Because of some weird reason this CHECK fails while deleting
-     * v4 default route. However route actually gets wiped off from Linux
-     * routing table.
-    nlCheckError(error, "Failed to ", add ? "add" : "remove",
-                  " default route ", addr, " @ index ", ifIndex,
-                  " in table ", getTableId(ifID), " for interface ", ifID,
-                  ". ErrorCode: ", error);
-      */
-    if (error < 0) {
-      XLOG(WARNING) << "Failed to " << (add ? "add" : "remove")
-                    << " default route " << addr << " @index " << ifIndex
-                    << ". ErrorCode: " << error;
-    }
-    XLOG(INFO) << (add ? "Added" : "Removed") << " default route " << addr
-               << " @ index " << ifIndex << " in table " << getTableId(ifID)
-               << " for interface " << ifID;
+    nlCheckError(error, "Failed to build default route request for ", addr);
+
+    auto tableId = getTableId(ifID);
+    nlBatcher_.add(msg, [=](int result) {
+      /**
+       * Disable: Because of some weird reason this CHECK fails while deleting
+       * v4 default route. However route actually gets wiped off from Linux
+       * routing table.
+      nlCheckError(result, "Failed to ", add ? "add" : "remove",
+                    " default route ", addr, " @ index ", ifIndex,
+                    " in table ", tableId, " for interface ", ifID,
+                    ". ErrorCode: ", result);
+        */
+      if (result < 0) {
+        XLOG(WARNING) << "Failed to " << (add ? "add" : "remove")
+                      << " default route " << addr << " @index " << ifIndex
+                      << ". ErrorCode: " << result;
+      }
+      XLOG(INFO) << (add ? "Added" : "Removed") << " default route " << addr
+                 << " @ index " << ifIndex << " in table " << tableId
+                 << " for interface " << ifID;
+    });
   }
 }
 
 void TunManager::addRemoveSourceRouteRule(
     InterfaceID ifID,
     const folly::IPAddress& addr,
-    bool add) {
+    bool add,
+    NlBatcher::Callback done) {
   // We should not add source routing rule for link-local addresses because
   // they can be re-used across interfaces.
   if (addr.isLinkLocal()) {
     XLOG(DBG2) << "Ignoring source routing rule for link-local address "
                << addr;
+    if (done) {
+      done(0);
+    }
     return;
   }
 
@@ -367,24 +427,38 @@ void TunManager::addRemoveSourceRouteRule(
   auto error = rtnl_rule_set_src(rule, sourceaddr);
   nlCheckError(error, "Failed to set destination route to ", addr);
 
+  struct nl_msg* msg = nullptr;
   if (add) {
-    error = rtnl_rule_add(sock_, rule, NLM_F_REPLACE);
+    error = rtnl_rule_build_add_request(rule, NLM_F_REPLACE, &msg);
   } else {
-    error = rtnl_rule_delete(sock_, rule, 0);
-  }
-  nlCheckError(
-      error,
-      "Failed to ",
-      add ? "add" : "remove",
-      " rule for address ",
-      addr,
-      " to lookup table ",
-      getTableId(ifID),
-      " for interface ",
-      ifID);
-  XLOG(INFO) << (add ? "Added" : "Removed") << " rule for address " << addr
-             << " to lookup table " << getTableId(ifID) << " for interface "
-             << ifID;
+    error = rtnl_rule_build_delete_request(rule, 0, &msg);
+  }
+  nlCheckError(error, "Failed to build rule request for address ", addr);
+
+  auto tableId = getTableId(ifID);
+  nlBatcher_.add(
+      msg, [this, ifID, addr, add, tableId, done = std::move(done)](
+               int result) mutable {
+        if (result < 0) {
+          recordNlError(NlError(
+              result,
+              "Failed to ",
+              add ? "add" : "remove",
+              " rule for address ",
+              addr,
+              " to lookup table ",
+              tableId,
+              " for interface ",
+              ifID));
+        } else {
+          XLOG(INFO) << (add ? "Added" : "Removed") << " rule for address "
+                     << addr << " to lookup table " << tableId
+                     << " for interface " << ifID;
+        }
+        if (done) {
+          done(result);
+        }
+      });
 }
 
 void TunManager::addRemoveTunAddress(
@@ -392,7 +466,8 @@ void TunManager::addRemoveTunAddress(
     uint32_t ifIndex,
     const folly::IPAddress& addr,
     uint8_t mask,
-    bool add) {
+    bool add,
+    NlBatcher::Callback done) {
   auto tunaddr = rtnl_addr_alloc();
   if (!tunaddr) {
     throw FbossError("Failed to allocate address");
@@ -419,6 +494,7 @@ void TunManager::addRemoveTunAddress(
   rtnl_addr_set_prefixlen(tunaddr, mask);
   rtnl_addr_set_ifindex(tunaddr, ifIndex);
 
+  struct nl_msg* msg = nullptr;
   if (add) {
     /**
      * When you bring down interface some routes are purged but some still stay
@@ -427,25 +503,37 @@ void TunManager::addRemoveTunAddress(
      * addresses and routes for that interface with REPLACE flag overriding
      * existing ones if any.
      */
-    error = rtnl_addr_add(sock_, tunaddr, NLM_F_REPLACE);
+    error = rtnl_addr_build_add_request(tunaddr, NLM_F_REPLACE, &msg);
   } else {
-    error = rtnl_addr_delete(sock_, tunaddr, 0);
-  }
-  nlCheckError(
-      error,
-      "Failed to ",
-      add ? "add" : "remove",
-      " address ",
-      addr,
-      "/",
-      static_cast<int>(mask),
-      " to interface ",
-      ifName,
-      " @ index ",
-      ifIndex);
-  XLOG(INFO) << (add ? "Added" : "Removed") << " address " << addr.str() << "/"
-             << static_cast<int>(mask) << " on interface " << ifName
-             << " @ index " << ifIndex;
+    error = rtnl_addr_build_delete_request(tunaddr, 0, &msg);
+  }
+  nlCheckError(error, "Failed to build address request for ", addr);
+
+  nlBatcher_.add(
+      msg, [this, ifName, ifIndex, addr, mask, add, done = std::move(done)](
+               int result) mutable {
+        if (result < 0) {
+          recordNlError(NlError(
+              result,
+              "Failed to ",
+              add ? "add" : "remove",
+              " address ",
+              addr,
+              "/",
+              static_cast<int>(mask),
+              " to interface ",
+              ifName,
+              " @ index ",
+              ifIndex));
+        } else {
+          XLOG(INFO) << (add ? "Added" : "Removed") << " address "
+                     << addr.str() << "/" << static_cast<int>(mask)
+                     << " on interface " << ifName << " @ index " << ifIndex;
+        }
+        if (done) {
+          done(result);
+        }
+      });
 }
 
 void TunManager::addTunAddress(
@@ -453,17 +541,38 @@ void TunManager::addTunAddress(
     const std::string& ifName,
     uint32_t ifIndex,
     folly::IPAddress addr,
-    uint8_t mask) {
-  addRemoveSourceRouteRule(ifID, addr, true);
-  SCOPE_FAIL {
-    try {
-      addRemoveSourceRouteRule(ifID, addr, false);
-    } catch (const std::exception& ex) {
-      XLOG(ERR) << "Failed to removed partially added source rule on "
-                << "interface " << ifName;
-    }
-  };
-  addRemoveTunAddress(ifName, ifIndex, addr, mask, true);
+    uint8_t mask,
+    NlBatcher::Callback done) {
+  // Only add the address once its rule is in place, and take the rule out
+  // again if the address can not be added
+  addRemoveSourceRouteRule(
+      ifID, addr, true, [=, done = std::move(done)](int error) mutable {
+        if (error < 0) {
+          if (done) {
+            done(error);
+          }
+          return;
+        }
+        addRemoveTunAddress(
+            ifName,
+            ifIndex,
+            addr,
+            mask,
+            true,
+            [=, done = std::move(done)](int error) mutable {
+              if (error < 0) {
+                try {
+                  addRemoveSourceRouteRule(ifID, addr, false);
+                } catch (const std::exception& ex) {
+                  XLOG(ERR) << "Failed to removed partially added source "
+                            << "rule on interface " << ifName;
+                }
+              }
+              if (done) {
+                done(error);
+              }
+            });
+      });
 }
 
 void TunManager::removeTunAddress(
@@ -472,16 +581,52 @@ void TunManager::removeTunAddress(
     uint32_t ifIndex,
     folly::IPAddress addr,
     uint8_t mask) {
-  addRemoveSourceRouteRule(ifID, addr, false);
-  SCOPE_FAIL {
-    try {
-      addRemoveSourceRouteRule(ifID, addr, true);
-    } catch (const std::exception& ex) {
-      XLOG(ERR) << "Failed to add partially added source rule on "
-                << "interface " << ifName;
+  // Only remove the address once its rule is gone, and put the rule back if
+  // the address can not be removed
+  addRemoveSourceRouteRule(ifID, addr, false, [=](int error) {
+    if (error < 0) {
+      return;
+    }
+    addRemoveTunAddress(ifName, ifIndex, addr, mask, false, [=](int error) {
+      if (error < 0) {
+        try {
+          addRemoveSourceRouteRule(ifID, addr, true);
+        } catch (const std::exception& ex) {
+          XLOG(ERR) << "Failed to add partially added source rule on "
+                    << "interface " << ifName;
+        }
+      }
+    });
+  });
+}
+
+void TunManager::recordNlError(const NlError& error) {
+  XLOG(ERR) << error.what();
+  if (!nlError_) {
+    nlError_ = std::make_exception_ptr(error);
+  }
+}
+
+void TunManager::flushNetlinkRequests() {
+  SCOPE_EXIT {
+    for (auto ifID : failedIntfs_) {
+      auto iter = intfs_.find(ifID);
+      if (iter != intfs_.end()) {
+        XLOG(ERR) << "Deleting interface " << iter->second->getName()
+                  << " as its addresses could not be added";
+        iter->second->setDelete();
+        intfs_.erase(iter);
+      }
     }
+    failedIntfs_.clear();
+    removedIntfs_.clear();
   };
-  addRemoveTunAddress(ifName, ifIndex, addr, mask, false);
+  nlBatcher_.flush();
+  if (nlError_) {
+    auto error = nlError_;
+    nlError_ = nullptr;
+    std::rethrow_exception(error);
+  }
 }
 
 void TunManager::start() const {
@@ -711,6 +856,17 @@ void TunManager::sync(std::shared_ptr<SwitchState> state) {
         });
   };
 
+  // Don't leave the requests queued so far, or the interfaces parked in
+  // removedIntfs_, for a later sync if a change below fails
+  SCOPE_FAIL {
+    try {
+      flushNetlinkRequests();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "Failed to flush netlink requests of failed sync: "
+                << ex.what();
+    }
+  };
+
   // Apply changes for all interfaces
   applyChanges(
       oldIntfToInfo,
@@ -761,6 +917,9 @@ void TunManager::sync(std::shared_ptr<SwitchState> state) {
       },
       [&](ConstIntfToAddrsMapIter& oldIter) { removeIntf(oldIter->first); });
 
+  // All the changes above go to the kernel in as few round trips as possible
+  flushNetlinkRequests();
+
   start();
 
   // track number of times sync is called
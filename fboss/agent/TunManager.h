@@ -10,11 +10,15 @@
 #pragma once
 
 #include <folly/io/async/EventBase.h>
+#include "fboss/agent/NlBatcher.h"
 #include "fboss/agent/StateObserver.h"
 #include "fboss/agent/state/Interface.h"
 #include "fboss/agent/types.h"
 
 #include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
+
+#include <exception>
 
 extern "C" {
 #include <netlink/object.h>
@@ -25,6 +29,7 @@ namespace facebook {
 namespace fboss {
 
 class InterfaceMap;
+class NlError;
 class RxPacket;
 class SwSwitch;
 class TunIntf;
@@ -45,7 +50,7 @@ class TunManager : public StateObserver {
    * Send a packet to host.
    * This function can be called from any thread.
    *
-   * @return true The packet is sent to host
+   * @return true The packet is queued to be sent to host
    *         false The packet is dropped due to errors
    */
   virtual bool sendPacketToHost(
@@ -111,6 +116,12 @@ class TunManager : public StateObserver {
    */
   void setIntfStatus(const std::string& ifName, int ifIndex, bool status);
 
+  /**
+   * The changes to routes, rules and addresses below are queued, and sent to
+   * the kernel in batches by flushNetlinkRequests().  Their results are only
+   * known then, and are passed to the optional callbacks.
+   */
+
   /**
    * Add/remove a route table.
    *
@@ -143,7 +154,8 @@ class TunManager : public StateObserver {
   void addRemoveSourceRouteRule(
       InterfaceID ifID,
       const folly::IPAddress& addr,
-      bool add);
+      bool add,
+      NlBatcher::Callback done = nullptr);
 
   /**
    * Add/Remove an address to/from a TUN interface on the host
@@ -153,17 +165,20 @@ class TunManager : public StateObserver {
       uint32_t ifIndex,
       const folly::IPAddress& addr,
       uint8_t mask,
-      bool add);
+      bool add,
+      NlBatcher::Callback done = nullptr);
 
   /**
    * Add/Remove address as well source-routing-rule for TUN interface on host.
+   * done, if any, gets the first error of adding the rule and the address.
    */
   void addTunAddress(
       InterfaceID ifID,
       const std::string& ifName,
       uint32_t ifIndex,
       folly::IPAddress addr,
-      uint8_t mask);
+      uint8_t mask,
+      NlBatcher::Callback done = nullptr);
   void removeTunAddress(
       InterfaceID ifID,
       const std::string& ifName,
@@ -171,6 +186,14 @@ class TunManager : public StateObserver {
       folly::IPAddress addr,
       uint8_t mask);
 
+  /**
+   * Send all queued netlink requests and wait for their results.  Throws the
+   * first error of a rule or address change, once every request has been
+   * tried.  New interfaces which failed to get their addresses are deleted.
+   */
+  void flushNetlinkRequests();
+  void recordNlError(const NlError& error);
+
   /**
    * Netlink callback for processing and storing links
    */
@@ -216,12 +239,27 @@ class TunManager : public StateObserver {
       ADDFN addFn,
       REMOVEFN removeFn);
 
+  class IoThread;
+
   SwSwitch* sw_{nullptr};
   folly::EventBase* evb_{nullptr};
 
+  /**
+   * The threads the TUN interfaces read and write packets on, so that
+   * packets to and from the host neither wait for nor hold up evb_.
+   * Declared before intfs_, which must be destroyed first.
+   */
+  std::vector<std::unique_ptr<IoThread>> ioThreads_;
+  std::vector<folly::EventBase*> ioEvbs_;
+
   // Netlink socket for managing interface/addresses in Host/Linux
   nl_sock* sock_{nullptr};
 
+  // Batches the requests changing routes, rules and addresses
+  NlBatcher nlBatcher_;
+  // The first error from the requests being flushed
+  std::exception_ptr nlError_;
+
   /**
    * The mutex used to protect `intfs_` which can be used by
    * sync() could manipulate intfs_. Called on the thread that serves evb_.
@@ -230,6 +268,12 @@ class TunManager : public StateObserver {
   boost::container::flat_map<InterfaceID, std::unique_ptr<TunIntf>> intfs_;
   std::mutex mutex_;
 
+  // Interfaces removed from intfs_, which are only deleted from the host
+  // once the netlink requests cleaning up after them have been sent
+  std::vector<std::unique_ptr<TunIntf>> removedIntfs_;
+  // Interfaces added by this sync whose addresses could not be added
+  boost::container::flat_set<InterfaceID> failedIntfs_;
+
   // Whether the manager has registered itself to listen for state updates
   // from sw_
   bool observingState_{false};
@@ -0,0 +1,242 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PacketMatcher.h"
+
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/RxPacket.h"
+#include "fboss/agent/TxPacket.h"
+#include "fboss/agent/packet/Ethertype.h"
+#include "fboss/agent/packet/IPProto.h"
+#include "fboss/agent/packet/PktUtil.h"
+
+#include <folly/io/Cursor.h>
+
+using facebook::network::toIPAddress;
+using folly::io::Cursor;
+
+namespace {
+
+constexpr uint32_t kMacAddrsLen = 12;
+constexpr uint32_t kIPv4HdrLen = 20;
+constexpr uint32_t kIPv6HdrLen = 40;
+
+template <typename T>
+T checkRange(T value, T max, const char* field) {
+  if (value < 0 || value > max) {
+    throw facebook::fboss::FbossError(
+        "invalid ", field, " ", value, " in capture filter");
+  }
+  return value;
+}
+
+folly::CIDRNetwork toNetwork(const facebook::fboss::IpPrefix& prefix) {
+  auto ip = toIPAddress(prefix.ip);
+  checkRange<int16_t>(prefix.prefixLength, ip.bitCount(), "prefix length");
+  return folly::CIDRNetwork(ip, prefix.prefixLength);
+}
+
+bool inSubnet(const folly::IPAddress& ip, const folly::CIDRNetwork& network) {
+  return ip.family() == network.first.family() &&
+      ip.inSubnet(network.first, network.second);
+}
+
+} // namespace
+
+namespace facebook {
+namespace fboss {
+
+PacketMatcher::PacketMatcher(const std::vector<PacketMatch>& matches) {
+  for (const auto& match : matches) {
+    programs_.push_back(compile(match));
+    neededFields_ |= programs_.back().fields;
+  }
+}
+
+PacketMatcher::Program PacketMatcher::compile(const PacketMatch& match) {
+  Program program;
+  if (match.ethertype_ref().has_value()) {
+    program.fields |= ETHERTYPE;
+    program.ethertype =
+        checkRange(match.ethertype_ref().value(), 0xffff, "ethertype");
+  }
+  if (match.vlan_ref().has_value()) {
+    program.fields |= VLAN;
+    program.vlan = VlanID(checkRange(match.vlan_ref().value(), 4095, "vlan"));
+  }
+  if (match.srcPort_ref().has_value()) {
+    program.fields |= SRC_PORT;
+    program.srcPort = PortID(match.srcPort_ref().value());
+  }
+  if (match.srcIp_ref().has_value()) {
+    program.fields |= SRC_IP;
+    program.srcIp = toNetwork(match.srcIp_ref().value());
+  }
+  if (match.dstIp_ref().has_value()) {
+    program.fields |= DST_IP;
+    program.dstIp = toNetwork(match.dstIp_ref().value());
+  }
+  if (match.ipProto_ref().has_value()) {
+    program.fields |= IP_PROTO;
+    program.ipProto = checkRange<int16_t>(
+        match.ipProto_ref().value(), 0xff, "ip protocol");
+  }
+  if (match.l4SrcPort_ref().has_value()) {
+    program.fields |= L4_SRC_PORT;
+    program.l4SrcPort =
+        checkRange(match.l4SrcPort_ref().value(), 0xffff, "l4 src port");
+  }
+  if (match.l4DstPort_ref().has_value()) {
+    program.fields |= L4_DST_PORT;
+    program.l4DstPort =
+        checkRange(match.l4DstPort_ref().value(), 0xffff, "l4 dst port");
+  }
+  return program;
+}
+
+bool PacketMatcher::matches(const RxPacket* pkt) const {
+  if (empty()) {
+    return true;
+  }
+  Headers headers;
+  headers.fields |= SRC_PORT;
+  headers.srcPort = pkt->getSrcPort();
+  // The ethernet header may or may not still carry the VLAN tag
+  headers.fields |= VLAN;
+  headers.vlan = pkt->getSrcVlan();
+  parse(pkt->buf(), &headers);
+  return run(headers);
+}
+
+bool PacketMatcher::matches(const TxPacket* pkt) const {
+  if (empty()) {
+    return true;
+  }
+  Headers headers;
+  parse(pkt->buf(), &headers);
+  return run(headers);
+}
+
+void PacketMatcher::parse(const folly::IOBuf* buf, Headers* headers) const {
+  if (!(neededFields_ & (ETHERTYPE | VLAN | kL3Fields | kL4Fields))) {
+    return;
+  }
+  Cursor cursor(buf);
+  if (!cursor.canAdvance(kMacAddrsLen + sizeof(uint16_t))) {
+    return;
+  }
+  cursor.skip(kMacAddrsLen);
+  auto ethertype = cursor.readBE<uint16_t>();
+  if (ethertype == static_cast<uint16_t>(ETHERTYPE::ETHERTYPE_VLAN)) {
+    if (!cursor.canAdvance(2 * sizeof(uint16_t))) {
+      return;
+    }
+    headers->fields |= VLAN;
+    headers->vlan = VlanID(cursor.readBE<uint16_t>() & 0xfff);
+    ethertype = cursor.readBE<uint16_t>();
+  }
+  headers->fields |= ETHERTYPE;
+  headers->ethertype = ethertype;
+  if (!(neededFields_ & (kL3Fields | kL4Fields))) {
+    return;
+  }
+
+  bool hasL4;
+  if (ethertype == static_cast<uint16_t>(ETHERTYPE::ETHERTYPE_IPV4)) {
+    if (!cursor.canAdvance(kIPv4HdrLen)) {
+      return;
+    }
+    auto hdrLen = (cursor.read<uint8_t>() & 0xf) * 4;
+    // tos, total length, id
+    cursor.skip(5);
+    auto fragmentOffset = cursor.readBE<uint16_t>() & 0x1fff;
+    // ttl
+    cursor.skip(1);
+    headers->ipProto = cursor.read<uint8_t>();
+    // checksum
+    cursor.skip(2);
+    headers->srcIp = PktUtil::readIPv4(&cursor);
+    headers->dstIp = PktUtil::readIPv4(&cursor);
+    // Only the first fragment carries the L4 header, which follows any
+    // options
+    hasL4 = fragmentOffset == 0 && hdrLen >= kIPv4HdrLen &&
+        cursor.canAdvance(hdrLen - kIPv4HdrLen);
+    if (hasL4) {
+      cursor.skip(hdrLen - kIPv4HdrLen);
+    }
+  } else if (ethertype == static_cast<uint16_t>(ETHERTYPE::ETHERTYPE_IPV6)) {
+    if (!cursor.canAdvance(kIPv6HdrLen)) {
+      return;
+    }
+    cursor.skip(6);
+    // Extension headers are not followed, so the next header is treated as
+    // the L4 protocol
+    headers->ipProto = cursor.read<uint8_t>();
+    cursor.skip(1);
+    headers->srcIp = PktUtil::readIPv6(&cursor);
+    headers->dstIp = PktUtil::readIPv6(&cursor);
+    hasL4 = true;
+  } else {
+    return;
+  }
+  headers->fields |= kL3Fields;
+
+  auto proto = static_cast<IP_PROTO>(headers->ipProto);
+  if (!hasL4 || !(neededFields_ & kL4Fields) ||
+      (proto != IP_PROTO::IP_PROTO_TCP && proto != IP_PROTO::IP_PROTO_UDP) ||
+      !cursor.canAdvance(2 * sizeof(uint16_t))) {
+    return;
+  }
+  headers->fields |= kL4Fields;
+  headers->l4SrcPort = cursor.readBE<uint16_t>();
+  headers->l4DstPort = cursor.readBE<uint16_t>();
+}
+
+bool PacketMatcher::run(const Headers& headers) const {
+  for (const auto& program : programs_) {
+    // Fields the filter needs but which the packet does not have can never
+    // match, e.g. an l4 port filter against an ARP packet
+    if ((program.fields & headers.fields) != program.fields) {
+      continue;
+    }
+    if ((program.fields & ETHERTYPE) &&
+        program.ethertype != headers.ethertype) {
+      continue;
+    }
+    if ((program.fields & VLAN) && program.vlan != headers.vlan) {
+      continue;
+    }
+    if ((program.fields & SRC_PORT) && program.srcPort != headers.srcPort) {
+      continue;
+    }
+    if ((program.fields & IP_PROTO) && program.ipProto != headers.ipProto) {
+      continue;
+    }
+    if ((program.fields & L4_SRC_PORT) &&
+        program.l4SrcPort != headers.l4SrcPort) {
+      continue;
+    }
+    if ((program.fields & L4_DST_PORT) &&
+        program.l4DstPort != headers.l4DstPort) {
+      continue;
+    }
+    if ((program.fields & SRC_IP) && !inSubnet(headers.srcIp, program.srcIp)) {
+      continue;
+    }
+    if ((program.fields & DST_IP) && !inSubnet(headers.dstIp, program.dstIp)) {
+      continue;
+    }
+    return true;
+  }
+  return false;
+}
+
+} // namespace fboss
+} // namespace facebook
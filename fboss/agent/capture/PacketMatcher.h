@@ -0,0 +1,103 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/if/gen-cpp2/ctrl_types.h"
+#include "fboss/agent/types.h"
+
+#include <folly/IPAddress.h>
+#include <folly/Optional.h>
+
+#include <vector>
+
+namespace folly {
+class IOBuf;
+}
+
+namespace facebook {
+namespace fboss {
+
+class RxPacket;
+class TxPacket;
+
+/*
+ * PacketMatcher matches packets against a list of PacketMatch filters.
+ *
+ * The filters are compiled once, when the capture is created, into a flat
+ * list of field comparisons. Matching a packet parses its headers only as
+ * deep as the filters need (e.g. a filter on ethertype alone never looks
+ * past the ethernet header), and then runs the comparisons on the parsed
+ * fields, with no allocation.
+ */
+class PacketMatcher {
+ public:
+  explicit PacketMatcher(const std::vector<PacketMatch>& matches);
+
+  /*
+   * Whether there are no filters, i.e. all packets match
+   */
+  bool empty() const {
+    return programs_.empty();
+  }
+
+  bool matches(const RxPacket* pkt) const;
+  bool matches(const TxPacket* pkt) const;
+
+ private:
+  enum Field : uint32_t {
+    ETHERTYPE = 1 << 0,
+    VLAN = 1 << 1,
+    SRC_PORT = 1 << 2,
+    SRC_IP = 1 << 3,
+    DST_IP = 1 << 4,
+    IP_PROTO = 1 << 5,
+    L4_SRC_PORT = 1 << 6,
+    L4_DST_PORT = 1 << 7,
+  };
+  static constexpr uint32_t kL3Fields = SRC_IP | DST_IP | IP_PROTO;
+  static constexpr uint32_t kL4Fields = L4_SRC_PORT | L4_DST_PORT;
+
+  // A single compiled PacketMatch
+  struct Program {
+    uint32_t fields{0};
+    uint16_t ethertype{0};
+    VlanID vlan{0};
+    PortID srcPort{0};
+    folly::CIDRNetwork srcIp;
+    folly::CIDRNetwork dstIp;
+    uint8_t ipProto{0};
+    uint16_t l4SrcPort{0};
+    uint16_t l4DstPort{0};
+  };
+
+  // The packet header fields the programs run against
+  struct Headers {
+    uint32_t fields{0};
+    uint16_t ethertype{0};
+    VlanID vlan{0};
+    PortID srcPort{0};
+    folly::IPAddress srcIp;
+    folly::IPAddress dstIp;
+    uint8_t ipProto{0};
+    uint16_t l4SrcPort{0};
+    uint16_t l4DstPort{0};
+  };
+
+  static Program compile(const PacketMatch& match);
+  void parse(const folly::IOBuf* buf, Headers* headers) const;
+  bool run(const Headers& headers) const;
+
+  std::vector<Program> programs_;
+  // All fields used by any program
+  uint32_t neededFields_{0};
+};
+
+} // namespace fboss
+} // namespace facebook
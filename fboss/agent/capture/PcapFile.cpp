@@ -70,27 +70,39 @@ void PcapFile::writeGlobalHeader() {
 
   int ret = writeFull(file_.fd(), &hdr, sizeof(hdr));
   folly::checkUnixError(ret, "error writing pcap global header");
+  bytesWritten_ += ret;
 }
 
 void PcapFile::writePackets(const std::vector<PcapPkt>& pkts) {
+  writePackets(pkts.data(), pkts.size());
+}
+
+void PcapFile::writePackets(const PcapPkt* pkts, size_t count) {
   folly::fbvector<PktHeader> hdrs;
-  hdrs.reserve(pkts.size());
+  hdrs.reserve(count);
   folly::fbvector<struct iovec> iov;
   // Reserve enough space, assuming each packet is in a single IOBuf.
   // If some packets are split across IOBuf chains then we will end up
   // allocating more space as needed in the loop below.
-  iov.reserve(pkts.size() * 2);
+  iov.reserve(count * 2);
 
   // Build iovecs for all of the packet headers and data
-  for (const auto& pkt : pkts) {
-    hdrs.emplace_back(pkt);
+  for (size_t n = 0; n < count; ++n) {
+    hdrs.emplace_back(pkts[n]);
     PktHeader* curHdr = &hdrs.back();
     iov.push_back({(void*)curHdr, sizeof(PktHeader)});
-    pkt.buf()->appendToIov(&iov);
+    pkts[n].buf()->appendToIov(&iov);
   }
 
-  int ret = writevFull(file_.fd(), iov.data(), iov.size());
+  // writevFull() splits the write up as needed if there are more than
+  // IOV_MAX iovecs.
+  ssize_t ret = writevFull(file_.fd(), iov.data(), iov.size());
   folly::checkUnixError(ret, "error writing pcap data");
+  bytesWritten_ += ret;
+}
+
+uint64_t PcapFile::recordSize(const PcapPkt& pkt) {
+  return sizeof(PktHeader) + pkt.buf()->computeChainDataLength();
 }
 
 int PcapFile::openFlags(bool overwriteExisting) {
@@ -35,6 +35,20 @@ class PcapFile {
 
   void writeGlobalHeader();
   void writePackets(const std::vector<PcapPkt>& pkt);
+  void writePackets(const PcapPkt* pkts, size_t count);
+
+  /*
+   * The number of bytes written to the file so far, including the global
+   * header.
+   */
+  uint64_t bytesWritten() const {
+    return bytesWritten_;
+  }
+
+  /*
+   * The number of bytes writePackets() uses to store a packet.
+   */
+  static uint64_t recordSize(const PcapPkt& pkt);
 
   // Move constructor and assignment operator
   PcapFile(PcapFile&&) = default;
@@ -57,6 +71,7 @@ class PcapFile {
   static int openFlags(bool overwriteExisting);
 
   folly::File file_;
+  uint64_t bytesWritten_{0};
 };
 
 } // namespace fboss
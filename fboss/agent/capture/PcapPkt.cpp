@@ -79,5 +79,24 @@ PcapPkt::PcapPkt(const TxPacketData* pkt, TimePoint timestamp)
       pkt->packetData.data(), pkt->packetData.size()));
 }
 
+PcapPkt::PcapPkt(const PublishedPacket* pkt)
+    : PcapPkt(
+          pkt,
+          pkt->timestampUs_ref().has_value()
+              ? TimePoint(std::chrono::microseconds(
+                    pkt->timestampUs_ref().value()))
+              : std::chrono::system_clock::now()) {}
+
+PcapPkt::PcapPkt(const PublishedPacket* pkt, TimePoint timestamp)
+    : initialized_(true),
+      rx_(pkt->rx),
+      port_(pkt->rx ? pkt->srcPort : 0),
+      vlan_(pkt->rx ? pkt->srcVlan : 0),
+      timestamp_(timestamp),
+      buf_(),
+      reasons_(pkt->reasons) {
+  pkt->packetData.cloneInto(buf_);
+}
+
 } // namespace fboss
 } // namespace facebook
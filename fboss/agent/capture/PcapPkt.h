@@ -22,6 +22,7 @@ class RxPacket;
 class TxPacket;
 class RxPacketData;
 class TxPacketData;
+class PublishedPacket;
 
 /*
  * PcapPkt represents a packet captured on the wire.
@@ -59,6 +60,14 @@ class PcapPkt {
   explicit PcapPkt(const TxPacketData* pkt);
   PcapPkt(const TxPacketData* pkt, TimePoint timestamp);
 
+  /*
+   * Create a PcapPkt from a batched distribution service packet.
+   * The packet data is shared with the PublishedPacket, not copied.
+   * The packet's own timestamp is used, if it has one.
+   */
+  explicit PcapPkt(const PublishedPacket* pkt);
+  PcapPkt(const PublishedPacket* pkt, TimePoint timestamp);
+
   bool initialized() const {
     return initialized_;
   }
@@ -83,6 +92,9 @@ class PcapPkt {
   std::vector<RxReason> getReasons() {
     return reasons_;
   }
+  const std::vector<RxReason>& reasons() const {
+    return reasons_;
+  }
 
   // Move assignment
   PcapPkt(PcapPkt&& other) noexcept {
@@ -0,0 +1,152 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PcapPublisher.h"
+
+#include "fboss/agent/RxPacket.h"
+#include "fboss/agent/TxPacket.h"
+
+#include <folly/io/async/EventBase.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace facebook {
+namespace fboss {
+
+PcapPublisher::FlushTimeout::FlushTimeout(
+    PcapPublisher* publisher,
+    folly::EventBase* evb)
+    : folly::AsyncTimeout(evb), publisher_(publisher) {}
+
+void PcapPublisher::FlushTimeout::timeoutExpired() noexcept {
+  publisher_->flush();
+}
+
+PcapPublisher::PcapPublisher(
+    folly::EventBase* evb,
+    SendFn send,
+    uint32_t batchSize,
+    std::chrono::milliseconds interval,
+    uint32_t ringSize,
+    uint32_t maxInFlight)
+    : evb_(evb),
+      send_(std::move(send)),
+      batchSize_(std::max(batchSize, 1u)),
+      interval_(interval),
+      ringSize_(ringSize),
+      maxInFlight_(std::max(maxInFlight, 1u)),
+      flushTimeout_(this, evb) {}
+
+PcapPublisher::~PcapPublisher() {}
+
+bool PcapPublisher::publishRx(RxPacket* pkt, uint16_t ethertype) {
+  PublishedPacket published;
+  published.rx = true;
+  published.ethertype = ethertype;
+  published.srcPort = pkt->getSrcPort();
+  published.srcVlan = pkt->getSrcVlan();
+  for (const auto& r : pkt->getReasons()) {
+    RxReason reason;
+    reason.bytes = r.bytes;
+    reason.description = r.description;
+    published.reasons.push_back(std::move(reason));
+  }
+  pkt->buf()->cloneInto(published.packetData);
+  return publish(std::move(published));
+}
+
+bool PcapPublisher::publishTx(const TxPacket* pkt, uint16_t ethertype) {
+  PublishedPacket published;
+  published.rx = false;
+  published.ethertype = ethertype;
+  // The switch may still rewrite a TX packet in place (e.g. its source MAC)
+  // after it has been published, so take a copy rather than sharing it.
+  pkt->buf()->cloneInto(published.packetData);
+  published.packetData.unshare();
+  return publish(std::move(published));
+}
+
+bool PcapPublisher::publish(PublishedPacket pkt) {
+  bool requestFlush = false;
+  bool requestTimeout = false;
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    auto& ring = rings_[pkt.ethertype];
+    if (ring.size() >= ringSize_) {
+      return false;
+    }
+    ring.push_back(std::move(pkt));
+    ++pending_;
+    if (pending_ >= batchSize_) {
+      requestFlush = !flushRequested_;
+      flushRequested_ = true;
+    } else {
+      requestTimeout = !timeoutRequested_;
+      timeoutRequested_ = true;
+    }
+  }
+  if (requestFlush) {
+    evb_->runInEventBaseThread([this]() { flush(); });
+  } else if (requestTimeout) {
+    evb_->runInEventBaseThread([this]() {
+      if (!flushTimeout_.isScheduled()) {
+        flushTimeout_.scheduleTimeout(interval_);
+      }
+    });
+  }
+  return true;
+}
+
+void PcapPublisher::flush() {
+  if (inFlight_ >= maxInFlight_) {
+    // batchSent() flushes again once the service catches up. Until then the
+    // packets stay in the rings, which drop packets once they are full.
+    return;
+  }
+  flushTimeout_.cancelTimeout();
+  std::vector<PublishedPacket> batch;
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    batch.reserve(pending_);
+    for (auto& ring : rings_) {
+      std::move(
+          ring.second.begin(), ring.second.end(), std::back_inserter(batch));
+      ring.second.clear();
+    }
+    pending_ = 0;
+    flushRequested_ = false;
+    timeoutRequested_ = false;
+  }
+  if (batch.empty()) {
+    return;
+  }
+  ++inFlight_;
+  send_(std::move(batch))
+      .via(evb_)
+      .thenTry([this](folly::Try<folly::Unit>&&) {
+        // Failures are accounted for by send_
+        batchSent();
+      });
+}
+
+void PcapPublisher::batchSent() {
+  --inFlight_;
+  bool morePending;
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    morePending = pending_ > 0;
+  }
+  if (morePending) {
+    flush();
+  }
+}
+
+} // namespace fboss
+} // namespace facebook
@@ -0,0 +1,107 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/pcap_distribution_service/if/gen-cpp2/pcap_pubsub_types.h"
+
+#include <folly/Function.h>
+#include <folly/futures/Future.h>
+#include <folly/io/async/AsyncTimeout.h>
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace folly {
+class EventBase;
+}
+
+namespace facebook {
+namespace fboss {
+
+class RxPacket;
+class TxPacket;
+
+/*
+ * PcapPublisher batches the packets the switch sends and receives on their
+ * way to the pcap distribution service.
+ *
+ * Packets may be published from any thread. They are held in a bounded ring
+ * per ethertype, and shipped in a single batch from the distribution event
+ * base once batchSize packets are pending, or interval after the first
+ * pending packet, whichever comes first. Published packets share their
+ * IOBufs with the original packet rather than copying the data.
+ *
+ * At most maxInFlight batches are outstanding at once. While the service is
+ * not keeping up, packets accumulate in the rings, and once a ring is full
+ * further packets of that ethertype are dropped.
+ */
+class PcapPublisher {
+ public:
+  using SendFn = folly::Function<folly::Future<folly::Unit>(
+      std::vector<PublishedPacket>&& packets)>;
+
+  PcapPublisher(
+      folly::EventBase* evb,
+      SendFn send,
+      uint32_t batchSize,
+      std::chrono::milliseconds interval,
+      uint32_t ringSize,
+      uint32_t maxInFlight);
+  ~PcapPublisher();
+
+  /*
+   * Queue a packet for publishing.
+   *
+   * Returns false if the packet was dropped because its ring was full.
+   */
+  bool publishRx(RxPacket* pkt, uint16_t ethertype);
+  bool publishTx(const TxPacket* pkt, uint16_t ethertype);
+
+ private:
+  class FlushTimeout : public folly::AsyncTimeout {
+   public:
+    FlushTimeout(PcapPublisher* publisher, folly::EventBase* evb);
+    void timeoutExpired() noexcept override;
+
+   private:
+    PcapPublisher* publisher_;
+  };
+
+  bool publish(PublishedPacket pkt);
+  // Only called from the event base thread
+  void flush();
+  void batchSent();
+
+  folly::EventBase* evb_;
+  SendFn send_;
+  const uint32_t batchSize_;
+  const std::chrono::milliseconds interval_;
+  const uint32_t ringSize_;
+  const uint32_t maxInFlight_;
+
+  // Protects everything below, up to inFlight_
+  std::mutex mutex_;
+  std::map<uint16_t, std::deque<PublishedPacket>> rings_;
+  uint32_t pending_{0};
+  // Whether a flush, or the flush timeout, has been requested from the
+  // event base since the last flush
+  bool flushRequested_{false};
+  bool timeoutRequested_{false};
+
+  // Only accessed from the event base thread
+  uint32_t inFlight_{0};
+  FlushTimeout flushTimeout_;
+};
+
+} // namespace fboss
+} // namespace facebook
@@ -39,13 +39,33 @@ void PcapQueue::addPktInternal(const PktType* pkt) {
     pktsDropped_ += 1;
     return;
   }
-  auto newBytes = bytesInQueue_ + pkt->buf()->computeChainDataLength();
+  auto pktBytes = pkt->buf()->computeChainDataLength();
+  auto newBytes = bytesInQueue_ + pktBytes;
   if (bytesCapacity_ > 0 && newBytes >= bytesCapacity_) {
     pktsDropped_ += 1;
     return;
   }
+  // Both buckets allow a burst of up to one second's worth of packets. Check
+  // both before consuming from either, so that a packet rejected by one does
+  // not use up the tokens of the other.
+  auto now = folly::DynamicTokenBucket::defaultClockNow();
+  if ((maxPktsPerSec_ > 0 &&
+       pktBucket_.available(maxPktsPerSec_, maxPktsPerSec_, now) < 1) ||
+      (maxBytesPerSec_ > 0 &&
+       byteBucket_.available(maxBytesPerSec_, maxBytesPerSec_, now) <
+           pktBytes)) {
+    pktsRateLimited_ += 1;
+    return;
+  }
+  if (maxPktsPerSec_ > 0) {
+    pktBucket_.consume(1, maxPktsPerSec_, maxPktsPerSec_, now);
+  }
+  if (maxBytesPerSec_ > 0) {
+    byteBucket_.consume(pktBytes, maxBytesPerSec_, maxBytesPerSec_, now);
+  }
 
   queue_.emplace_back(pkt);
+  bytesInQueue_ = newBytes;
 }
 
 void PcapQueue::addPkt(const RxPacket* pkt) {
@@ -98,6 +118,19 @@ uint64_t PcapQueue::numDropped() const {
   return pktsDropped_;
 }
 
+void PcapQueue::setRateLimit(uint32_t maxPktsPerSec, uint64_t maxBytesPerSec) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  maxPktsPerSec_ = maxPktsPerSec;
+  maxBytesPerSec_ = maxBytesPerSec;
+  pktBucket_.reset();
+  byteBucket_.reset();
+}
+
+uint64_t PcapQueue::numRateLimited() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return pktsRateLimited_;
+}
+
 bool PcapQueue::wait(std::vector<PcapPkt>* swapQueue) {
   swapQueue->clear();
   swapQueue->reserve(pktCapacity_);
@@ -117,5 +150,19 @@ bool PcapQueue::wait(std::vector<PcapPkt>* swapQueue) {
   return true;
 }
 
+bool PcapQueue::poll(std::vector<PcapPkt>* swapQueue) {
+  swapQueue->clear();
+  swapQueue->reserve(pktCapacity_);
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (queue_.empty()) {
+    return !finished_;
+  }
+
+  swapQueue->swap(queue_);
+  bytesInQueue_ = 0;
+  return true;
+}
+
 } // namespace fboss
 } // namespace facebook
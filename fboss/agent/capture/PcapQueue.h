@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include <folly/TokenBucket.h>
+
 #include <condition_variable>
 #include <mutex>
 #include <vector>
@@ -71,6 +73,14 @@ class PcapQueue {
    */
   uint64_t numDropped() const;
 
+  /*
+   * Limit the rate at which packets are added to the queue.  Packets over
+   * the limit are dropped, and counted by numRateLimited() rather than
+   * numDropped().  A limit of 0 means no limit.
+   */
+  void setRateLimit(uint32_t maxPktsPerSec, uint64_t maxBytesPerSec);
+  uint64_t numRateLimited() const;
+
   /*
    * Wait for new packets from the queue.
    *
@@ -80,6 +90,14 @@ class PcapQueue {
    */
   bool wait(std::vector<PcapPkt>* swapQueue);
 
+  /*
+   * Take any packets currently in the queue, without waiting.
+   *
+   * Like wait(), this returns false only once the queue has been finished
+   * and all packets have been read.
+   */
+  bool poll(std::vector<PcapPkt>* swapQueue);
+
  private:
   // Forbidden copy constructor and assignment operator
   PcapQueue(PcapQueue const&) = delete;
@@ -97,6 +115,12 @@ class PcapQueue {
   uint64_t bytesInQueue_{0};
   uint64_t pktsDropped_{0};
   std::vector<PcapPkt> queue_;
+
+  uint32_t maxPktsPerSec_{0};
+  uint64_t maxBytesPerSec_{0};
+  folly::DynamicTokenBucket pktBucket_;
+  folly::DynamicTokenBucket byteBucket_;
+  uint64_t pktsRateLimited_{0};
 };
 
 } // namespace fboss
@@ -0,0 +1,289 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PcapShmRing.h"
+
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/TxPacket.h"
+#include "fboss/agent/packet/Ethertype.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+
+namespace facebook {
+namespace fboss {
+
+namespace {
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+const std::vector<uint16_t>& PcapShmRing::ringEthertypes() {
+  static const std::vector<uint16_t> ethertypes = {
+      static_cast<uint16_t>(ETHERTYPE::ETHERTYPE_ARP),
+      static_cast<uint16_t>(ETHERTYPE::ETHERTYPE_LLDP),
+      static_cast<uint16_t>(ETHERTYPE::ETHERTYPE_IPV4),
+      static_cast<uint16_t>(ETHERTYPE::ETHERTYPE_IPV6)};
+  return ethertypes;
+}
+
+uint32_t PcapShmRing::ringIndex(uint16_t ethertype) {
+  const auto& ethertypes = ringEthertypes();
+  auto it = std::find(ethertypes.begin(), ethertypes.end(), ethertype);
+  return it - ethertypes.begin();
+}
+
+uint64_t PcapShmRing::controlOffset(uint32_t ring) {
+  return kAlignment * (1 + ring);
+}
+
+uint64_t PcapShmRing::slotOffset(
+    const Header& header,
+    uint32_t ring,
+    uint64_t position) {
+  return controlOffset(header.numRings) +
+      (ring * uint64_t(header.slotsPerRing) +
+       position % header.slotsPerRing) *
+      header.slotBytes;
+}
+
+uint64_t PcapShmRing::fileSize(const Header& header) {
+  return slotOffset(header, header.numRings, 0);
+}
+
+PcapShmRing::~PcapShmRing() {
+  if (base_) {
+    ::munmap(base_, size_);
+  }
+}
+
+void PcapShmRing::map(int fd, uint64_t size, bool writable) {
+  auto prot = PROT_READ | (writable ? PROT_WRITE : 0);
+  auto addr = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    folly::throwSystemError("unable to map pcap ring");
+  }
+  base_ = static_cast<uint8_t*>(addr);
+  size_ = size;
+}
+
+PcapShmRingWriter::PcapShmRingWriter(
+    folly::StringPiece path,
+    uint32_t slotsPerRing,
+    uint32_t slotBytes)
+    : path_(path.str()), locks_(new folly::SpinLock[numRings()]) {
+  header_.magic = kMagic;
+  header_.version = kVersion;
+  header_.numRings = numRings();
+  header_.slotsPerRing = std::max(slotsPerRing, 1u);
+  header_.slotBytes = alignUp(
+      std::max<uint64_t>(slotBytes, sizeof(Slot) + kAlignment), kAlignment);
+  static_assert(sizeof(Header) <= kAlignment, "header must fit in one line");
+
+  // Unlink rather than truncate any existing file, which a reader may still
+  // have mapped.
+  ::unlink(path_.c_str());
+  folly::File file(path_, O_RDWR | O_CREAT | O_EXCL, 0644);
+  auto size = fileSize(header_);
+  folly::checkUnixError(
+      ::ftruncate(file.fd(), size), "unable to size pcap ring ", path_);
+  // The file starts out zeroed, i.e. with empty rings
+  map(file.fd(), size, true);
+  memcpy(base_, &header_, sizeof(header_));
+}
+
+void PcapShmRingWriter::writeRx(RxPacket* pkt, uint16_t ethertype) {
+  write(
+      pkt->buf(),
+      true,
+      ethertype,
+      pkt->getSrcPort(),
+      pkt->getSrcVlan(),
+      pkt->getReasons());
+}
+
+void PcapShmRingWriter::writeTx(const TxPacket* pkt, uint16_t ethertype) {
+  write(pkt->buf(), false, ethertype, 0, 0, {});
+}
+
+void PcapShmRingWriter::write(
+    const folly::IOBuf* buf,
+    bool rx,
+    uint16_t ethertype,
+    int32_t srcPort,
+    int32_t srcVlan,
+    const std::vector<RxPacket::RxReason>& reasons) {
+  auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+  auto ring = ringIndex(ethertype);
+  auto* control =
+      reinterpret_cast<RingControl*>(base_ + controlOffset(ring));
+  auto capacity = header_.slotBytes - sizeof(Slot);
+
+  std::lock_guard<folly::SpinLock> g(locks_[ring]);
+  auto position = control->head.load(std::memory_order_relaxed);
+  auto* slot =
+      reinterpret_cast<Slot*>(base_ + slotOffset(header_, ring, position));
+  auto* data = reinterpret_cast<uint8_t*>(slot + 1);
+
+  // Mark the slot as being written before touching its contents, so that a
+  // reader copying the previous packet out of it notices.
+  slot->seq.store(kWriting, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot->timestampUs = timestamp;
+  slot->srcPort = srcPort;
+  slot->srcVlan = srcVlan;
+  slot->ethertype = ethertype;
+  slot->rx = rx;
+  uint32_t len = 0;
+  for (const auto& range : *buf) {
+    auto n = std::min<uint64_t>(range.size(), capacity - len);
+    memcpy(data + len, range.data(), n);
+    len += n;
+  }
+  slot->len = len;
+
+  uint32_t reasonsLen = 0;
+  for (const auto& reason : reasons) {
+    uint16_t descLen = std::min<size_t>(reason.description.size(), 0xffff);
+    uint32_t bytes = reason.bytes;
+    auto needed = sizeof(bytes) + sizeof(descLen) + descLen;
+    if (len + reasonsLen + needed > capacity) {
+      break;
+    }
+    auto* out = data + len + reasonsLen;
+    memcpy(out, &bytes, sizeof(bytes));
+    memcpy(out + sizeof(bytes), &descLen, sizeof(descLen));
+    memcpy(
+        out + sizeof(bytes) + sizeof(descLen),
+        reason.description.data(),
+        descLen);
+    reasonsLen += needed;
+  }
+  slot->reasonsLen = reasonsLen;
+
+  slot->seq.store(position + 1, std::memory_order_release);
+  control->head.store(position + 1, std::memory_order_release);
+}
+
+PcapShmRingReader::PcapShmRingReader(folly::StringPiece path) {
+  folly::File file(path.str(), O_RDONLY);
+  auto ret = folly::preadFull(file.fd(), &header_, sizeof(header_), 0);
+  folly::checkUnixError(ret, "unable to read pcap ring ", path);
+  if (ret != sizeof(header_) || header_.magic != kMagic ||
+      header_.version != kVersion || header_.numRings != numRings() ||
+      header_.slotsPerRing == 0 ||
+      header_.slotBytes < sizeof(Slot) + kAlignment) {
+    throw FbossError(path, " is not a compatible pcap ring");
+  }
+  struct stat st;
+  folly::checkUnixError(::fstat(file.fd(), &st), "unable to stat ", path);
+  auto size = fileSize(header_);
+  if (static_cast<uint64_t>(st.st_size) < size) {
+    throw FbossError("pcap ring ", path, " is truncated");
+  }
+  map(file.fd(), size, false);
+
+  // Only read packets written from now on
+  for (uint32_t ring = 0; ring < header_.numRings; ++ring) {
+    auto* control =
+        reinterpret_cast<const RingControl*>(base_ + controlOffset(ring));
+    tails_.push_back(control->head.load(std::memory_order_acquire));
+  }
+}
+
+size_t PcapShmRingReader::read(
+    uint32_t ring,
+    std::vector<PublishedPacket>* out) {
+  auto* control =
+      reinterpret_cast<const RingControl*>(base_ + controlOffset(ring));
+  auto head = control->head.load(std::memory_order_acquire);
+  auto& tail = tails_[ring];
+  if (head - tail > header_.slotsPerRing) {
+    // The writer has lapped us
+    overruns_ += head - tail - header_.slotsPerRing;
+    tail = head - header_.slotsPerRing;
+  }
+
+  auto capacity = header_.slotBytes - sizeof(Slot);
+  size_t numRead = 0;
+  for (; tail < head; ++tail) {
+    auto* slot = reinterpret_cast<const Slot*>(
+        base_ + slotOffset(header_, ring, tail));
+    auto seq = slot->seq.load(std::memory_order_acquire);
+    if (seq != tail + 1) {
+      ++overruns_;
+      continue;
+    }
+
+    // Copy everything out before checking whether the slot was overwritten
+    // while we read it.  The lengths are only trusted after that check, but
+    // are bounded so that a torn slot can not make us read past it.
+    PublishedPacket pkt;
+    pkt.rx = slot->rx;
+    pkt.ethertype = slot->ethertype;
+    pkt.timestampUs_ref() = slot->timestampUs;
+    auto len = std::min<uint64_t>(slot->len, capacity);
+    auto reasonsLen = std::min<uint64_t>(slot->reasonsLen, capacity - len);
+    auto* data = reinterpret_cast<const uint8_t*>(slot + 1);
+    pkt.packetData = folly::IOBuf(folly::IOBuf::COPY_BUFFER, data, len);
+    std::string reasons(
+        reinterpret_cast<const char*>(data + len), reasonsLen);
+    if (pkt.rx) {
+      pkt.srcPort = slot->srcPort;
+      pkt.srcVlan = slot->srcVlan;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->seq.load(std::memory_order_relaxed) != seq) {
+      ++overruns_;
+      continue;
+    }
+
+    folly::ByteRange remaining(
+        reinterpret_cast<const uint8_t*>(reasons.data()), reasons.size());
+    while (remaining.size() >= sizeof(uint32_t) + sizeof(uint16_t)) {
+      uint32_t bytes;
+      uint16_t descLen;
+      memcpy(&bytes, remaining.data(), sizeof(bytes));
+      memcpy(&descLen, remaining.data() + sizeof(bytes), sizeof(descLen));
+      remaining.advance(sizeof(bytes) + sizeof(descLen));
+      if (descLen > remaining.size()) {
+        break;
+      }
+      RxReason reason;
+      reason.bytes = bytes;
+      reason.description = std::string(
+          reinterpret_cast<const char*>(remaining.data()), descLen);
+      remaining.advance(descLen);
+      pkt.reasons.push_back(std::move(reason));
+    }
+    out->push_back(std::move(pkt));
+    ++numRead;
+  }
+  return numRead;
+}
+
+} // namespace fboss
+} // namespace facebook
@@ -0,0 +1,193 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/agent/RxPacket.h"
+#include "fboss/pcap_distribution_service/if/gen-cpp2/pcap_pubsub_types.h"
+
+#include <folly/Range.h>
+#include <folly/SpinLock.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace facebook {
+namespace fboss {
+
+class TxPacket;
+
+/*
+ * A shared memory transport for the packets the switch publishes to the pcap
+ * distribution service.
+ *
+ * The agent creates a file (normally on a tmpfs such as /dev/shm) holding
+ * one ring of fixed size slots per class of ethertype, and writes each
+ * packet into the next slot of its ring.  The distribution service maps the
+ * file read-only and polls the rings, so no RPC is needed per packet.
+ *
+ * Since the reader never writes to the file, the writer cannot tell how far
+ * it has got, and simply overwrites the oldest slots.  Each slot carries a
+ * sequence number, which the reader checks before and after copying a slot
+ * (like a seqlock), so a reader which falls behind detects the packets it
+ * missed instead of reading torn data.
+ */
+class PcapShmRing {
+ public:
+  // "FBOSSPCR", as stored on little endian hosts
+  static constexpr uint64_t kMagic = 0x52435053534f4246;
+  static constexpr uint32_t kVersion = 1;
+
+  /*
+   * The ethertypes with a ring of their own.  All other ethertypes share the
+   * last ring.
+   */
+  static const std::vector<uint16_t>& ringEthertypes();
+  static uint32_t numRings() {
+    return ringEthertypes().size() + 1;
+  }
+  static uint32_t ringIndex(uint16_t ethertype);
+
+ protected:
+  struct Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t numRings;
+    uint32_t slotsPerRing;
+    uint32_t slotBytes;
+  };
+
+  // The write position of a ring, in its own cache line
+  struct alignas(64) RingControl {
+    // The number of packets ever written to the ring
+    std::atomic<uint64_t> head;
+  };
+
+  struct Slot {
+    // The ring position of the packet in the slot, plus one, once the
+    // packet has been written.  kWriting while the slot is being written.
+    std::atomic<uint64_t> seq;
+    int64_t timestampUs;
+    int32_t srcPort;
+    int32_t srcVlan;
+    // The number of bytes of packet data stored.  Packets which do not fit
+    // in the slot are truncated.
+    uint32_t len;
+    // The trap reasons, stored after the packet data if there is room, as a
+    // 32 bit reason code, then 16 bit length and description, for each reason
+    uint32_t reasonsLen;
+    uint16_t ethertype;
+    uint8_t rx;
+    uint8_t pad[5];
+  };
+
+  static constexpr uint64_t kWriting = ~0ULL;
+  static constexpr uint64_t kAlignment = 64;
+
+  static_assert(
+      std::atomic<uint64_t>::is_always_lock_free,
+      "atomics in shared memory must be lock free");
+
+  static uint64_t controlOffset(uint32_t ring);
+  static uint64_t slotOffset(
+      const Header& header,
+      uint32_t ring,
+      uint64_t position);
+  static uint64_t fileSize(const Header& header);
+
+  PcapShmRing() {}
+  ~PcapShmRing();
+
+  void map(int fd, uint64_t size, bool writable);
+
+  uint8_t* base_{nullptr};
+  uint64_t size_{0};
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  PcapShmRing(PcapShmRing const&) = delete;
+  PcapShmRing& operator=(PcapShmRing const&) = delete;
+};
+
+/*
+ * The agent side of the ring.
+ *
+ * Packets may be written from any thread.  Writers of the same ring are
+ * serialized with a spinlock that is held just long enough to copy the
+ * packet into its slot.
+ */
+class PcapShmRingWriter : public PcapShmRing {
+ public:
+  /*
+   * Create the ring file at path, replacing any existing file.
+   */
+  PcapShmRingWriter(
+      folly::StringPiece path,
+      uint32_t slotsPerRing,
+      uint32_t slotBytes);
+
+  const std::string& path() const {
+    return path_;
+  }
+
+  void writeRx(RxPacket* pkt, uint16_t ethertype);
+  void writeTx(const TxPacket* pkt, uint16_t ethertype);
+
+ private:
+  void write(
+      const folly::IOBuf* buf,
+      bool rx,
+      uint16_t ethertype,
+      int32_t srcPort,
+      int32_t srcVlan,
+      const std::vector<RxPacket::RxReason>& reasons);
+
+  const std::string path_;
+  Header header_;
+  std::unique_ptr<folly::SpinLock[]> locks_;
+};
+
+/*
+ * The distribution service side of the ring.
+ *
+ * Only a single thread may read from the rings.
+ */
+class PcapShmRingReader : public PcapShmRing {
+ public:
+  /*
+   * Map the ring file at path read-only.  Throws FbossError if the file is
+   * not a ring written by a compatible version of the agent.
+   */
+  explicit PcapShmRingReader(folly::StringPiece path);
+
+  /*
+   * Append the packets written to the ring since the last call to out, and
+   * return the number of packets appended.  The packets are copied out of
+   * shared memory.
+   */
+  size_t read(uint32_t ring, std::vector<PublishedPacket>* out);
+
+  /*
+   * The number of packets overwritten before they could be read.
+   */
+  uint64_t numOverruns() const {
+    return overruns_;
+  }
+
+ private:
+  Header header_;
+  // The next position to read in each ring
+  std::vector<uint64_t> tails_;
+  uint64_t overruns_{0};
+};
+
+} // namespace fboss
+} // namespace facebook
@@ -9,12 +9,30 @@
  */
 #include "fboss/agent/capture/PcapWriter.h"
 
-#include "fboss/agent/capture/PcapPkt.h"
+#include "fboss/agent/capture/PcapWriterService.h"
 
+#include <folly/Conv.h>
 #include <folly/String.h>
 #include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
+
+#include <unistd.h>
+#include <cstdio>
+
+DEFINE_int32(
+    pcap_write_block_kb,
+    256,
+    "When taking packet captures, buffer packets until at least this many "
+    "KB can be written to the capture file in one go");
+DEFINE_int32(
+    pcap_write_max_delay_ms,
+    1000,
+    "When taking packet captures, the maximum time to buffer packets for "
+    "before writing them to the capture file");
 
 using folly::StringPiece;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 
 namespace facebook {
 namespace fboss {
@@ -24,10 +42,11 @@ PcapWriter::PcapWriter(uint32_t maxBufferedPkts) : queue_(maxBufferedPkts) {}
 PcapWriter::PcapWriter(
     StringPiece path,
     bool overwriteExisting,
-    uint32_t maxBufferedPkts)
-    : file_(path, overwriteExisting),
-      queue_(maxBufferedPkts),
-      thread_(&PcapWriter::threadMain, this) {}
+    uint32_t maxBufferedPkts,
+    const PcapWriterLimits& limits)
+    : queue_(maxBufferedPkts) {
+  start(path, overwriteExisting, limits);
+}
 
 PcapWriter::~PcapWriter() {
   try {
@@ -41,47 +60,129 @@ PcapWriter::~PcapWriter() {
   }
 }
 
-void PcapWriter::start(folly::StringPiece path, bool overwriteExisting) {
-  file_ = PcapFile(path, overwriteExisting);
-  thread_ = std::thread(&PcapWriter::threadMain, this);
+void PcapWriter::start(
+    folly::StringPiece path,
+    bool overwriteExisting,
+    const PcapWriterLimits& limits) {
+  path_ = path.str();
+  limits_ = limits;
+  queue_.setRateLimit(limits_.maxPktsPerSec, limits_.maxBytesPerSec);
+  openFile(overwriteExisting);
+  PcapWriterService::get()->addWriter(this);
+  running_ = true;
 }
 
 void PcapWriter::finish() {
-  if (!thread_.joinable()) {
+  if (!running_) {
     // already stopped
     return;
   }
 
   queue_.finish();
-  thread_.join();
+  PcapWriterService::get()->removeWriter(this);
+  running_ = false;
   if (ex_) {
     std::rethrow_exception(ex_);
   }
 }
 
-void PcapWriter::threadMain() {
+bool PcapWriter::writeQueued(steady_clock::time_point now) {
   try {
-    file_.writeGlobalHeader();
-    writeLoop();
-    file_.close();
+    bool more = queue_.poll(&polled_);
+    if (!polled_.empty()) {
+      if (pending_.empty()) {
+        pendingSince_ = now;
+      }
+      for (auto& pkt : polled_) {
+        pendingBytes_ += PcapFile::recordSize(pkt);
+        pending_.push_back(std::move(pkt));
+      }
+      polled_.clear();
+    }
+
+    // Coalesce packets into large writes, rather than issuing a write every
+    // time the service thread wakes up.
+    if (!more ||
+        pendingBytes_ >= static_cast<uint64_t>(FLAGS_pcap_write_block_kb) *
+                1024 ||
+        (!pending_.empty() &&
+         now - pendingSince_ >= milliseconds(FLAGS_pcap_write_max_delay_ms))) {
+      writePending(now);
+    }
+    if (!more) {
+      file_.close();
+    }
+    return more;
   } catch (const std::exception& ex) {
     XLOG(ERR) << "error writing to pcap file: " << folly::exceptionStr(ex);
     ex_ = std::current_exception();
+    pending_.clear();
+    return false;
   }
 }
 
-void PcapWriter::writeLoop() {
-  std::vector<PcapPkt> pkts;
-  while (true) {
-    pkts.clear();
-    if (!queue_.wait(&pkts)) {
-      DCHECK(pkts.empty());
-      return;
+void PcapWriter::writePending(steady_clock::time_point now) {
+  size_t begin = 0;
+  while (begin < pending_.size()) {
+    if (shouldRotate(pending_[begin], now)) {
+      rotate();
+    }
+    // Write as many packets as fit in the current file
+    auto fileBytes =
+        file_.bytesWritten() + PcapFile::recordSize(pending_[begin]);
+    size_t end = begin + 1;
+    while (end < pending_.size()) {
+      auto pktBytes = PcapFile::recordSize(pending_[end]);
+      if (limits_.maxFileBytes > 0 &&
+          fileBytes + pktBytes > limits_.maxFileBytes) {
+        break;
+      }
+      fileBytes += pktBytes;
+      ++end;
     }
+    file_.writePackets(&pending_[begin], end - begin);
+    begin = end;
+  }
+  pending_.clear();
+  pendingBytes_ = 0;
+}
 
-    DCHECK(!pkts.empty());
-    file_.writePackets(pkts);
+void PcapWriter::openFile(bool overwriteExisting) {
+  file_ = PcapFile(path_, overwriteExisting);
+  file_.writeGlobalHeader();
+  fileHeaderBytes_ = file_.bytesWritten();
+  fileOpened_ = steady_clock::now();
+}
+
+bool PcapWriter::shouldRotate(
+    const PcapPkt& pkt,
+    steady_clock::time_point now) const {
+  // Each file holds at least one packet, however large
+  if (file_.bytesWritten() <= fileHeaderBytes_) {
+    return false;
+  }
+  if (limits_.maxFileBytes > 0 &&
+      file_.bytesWritten() + PcapFile::recordSize(pkt) > limits_.maxFileBytes) {
+    return true;
+  }
+  return limits_.maxFileAge.count() > 0 &&
+      now - fileOpened_ >= limits_.maxFileAge;
+}
+
+void PcapWriter::rotate() {
+  file_.close();
+  if (limits_.numFiles > 1) {
+    for (auto n = limits_.numFiles - 1; n > 1; --n) {
+      auto from = folly::to<std::string>(path_, ".", n - 1);
+      auto to = folly::to<std::string>(path_, ".", n);
+      // The older files may not exist yet
+      ::rename(from.c_str(), to.c_str());
+    }
+    ::rename(path_.c_str(), folly::to<std::string>(path_, ".1").c_str());
+  } else {
+    ::unlink(path_.c_str());
   }
+  openFile(true);
 }
 
 } // namespace fboss
@@ -10,18 +10,46 @@
 #pragma once
 
 #include "fboss/agent/capture/PcapFile.h"
+#include "fboss/agent/capture/PcapPkt.h"
 #include "fboss/agent/capture/PcapQueue.h"
 
-#include <thread>
+#include <chrono>
+#include <string>
 
 namespace facebook {
 namespace fboss {
 
+class PcapWriterService;
+
+/*
+ * Limits on the disk space and write rate used by a PcapWriter.
+ *
+ * A limit of 0 means no limit.
+ */
+struct PcapWriterLimits {
+  /*
+   * Start a new file once the current one reaches this size or age.
+   *
+   * The previous files are kept as <path>.1, <path>.2, etc., up to
+   * numFiles files in total, with the oldest files being removed.
+   */
+  uint64_t maxFileBytes{0};
+  std::chrono::seconds maxFileAge{0};
+  uint32_t numFiles{1};
+
+  /*
+   * Packets beyond these rates are dropped, rather than queued.
+   */
+  uint32_t maxPktsPerSec{0};
+  uint64_t maxBytesPerSec{0};
+};
+
 /*
  * PcapWriter listes to a PcapQueue and writes the packets it receives
  * to a pcap file.
  *
- * It performs blocking disk I/O, so it performs the writes in its own thread.
+ * It performs blocking disk I/O, so the writes are performed by the
+ * PcapWriterService thread, which is shared by all PcapWriters.
  */
 class PcapWriter {
  public:
@@ -29,10 +57,14 @@ class PcapWriter {
   explicit PcapWriter(
       folly::StringPiece path,
       bool overwriteExisting = false,
-      uint32_t maxBufferedPkts = 0);
+      uint32_t maxBufferedPkts = 0,
+      const PcapWriterLimits& limits = PcapWriterLimits());
   virtual ~PcapWriter();
 
-  void start(folly::StringPiece path, bool overwriteExisting = false);
+  void start(
+      folly::StringPiece path,
+      bool overwriteExisting = false,
+      const PcapWriterLimits& limits = PcapWriterLimits());
 
   /*
    * Get the mutex protecting this PcapWriter.
@@ -57,6 +89,12 @@ class PcapWriter {
   void addPktLocked(const TxPacket* pkt) {
     queue_.addPktLocked(pkt);
   }
+
+  /*
+   * Write out all packets added so far and close the file.
+   *
+   * This blocks until the writes have completed.
+   */
   void finish();
 
   /*
@@ -69,19 +107,54 @@ class PcapWriter {
     return queue_.numDropped();
   }
 
+  /*
+   * Return the number of packets dropped because they exceeded the rate
+   * limits.
+   */
+  uint64_t numRateLimited() const {
+    return queue_.numRateLimited();
+  }
+
  private:
+  friend class PcapWriterService;
+
   // Forbidden copy constructor and assignment operator
   PcapWriter(PcapWriter const&) = delete;
   PcapWriter& operator=(PcapWriter const&) = delete;
 
-  void threadMain();
-  void writeHeader();
-  void writeLoop();
+  /*
+   * The methods below are only called from the PcapWriterService thread.
+   */
 
+  /*
+   * Take the queued packets and write them out once enough have been
+   * buffered, or once they have been buffered for long enough.
+   *
+   * Returns false once the queue has been finished, all packets have been
+   * written and the file has been closed, or if an error occurred.
+   */
+  bool writeQueued(std::chrono::steady_clock::time_point now);
+  void writePending(std::chrono::steady_clock::time_point now);
+  void openFile(bool overwriteExisting);
+  void rotate();
+  bool shouldRotate(
+      const PcapPkt& pkt,
+      std::chrono::steady_clock::time_point now) const;
+
+  std::string path_;
+  PcapWriterLimits limits_;
   PcapFile file_;
+  uint64_t fileHeaderBytes_{0};
+  std::chrono::steady_clock::time_point fileOpened_;
   PcapQueue queue_;
   std::exception_ptr ex_;
-  std::thread thread_;
+  bool running_{false};
+
+  // Packets taken from the queue but not yet written to the file
+  std::vector<PcapPkt> pending_;
+  std::vector<PcapPkt> polled_;
+  uint64_t pendingBytes_{0};
+  std::chrono::steady_clock::time_point pendingSince_;
 };
 
 } // namespace fboss
@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PcapWriterService.h"
+
+#include "fboss/agent/capture/PcapWriter.h"
+
+#include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
+
+#include <vector>
+
+DEFINE_int32(
+    pcap_writer_poll_ms,
+    100,
+    "How often the packet capture writer thread checks for captured "
+    "packets to write to disk");
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace facebook {
+namespace fboss {
+
+PcapWriterService::PcapWriterService() {}
+
+PcapWriterService::~PcapWriterService() {
+  {
+    std::lock_guard<std::mutex> g(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+PcapWriterService* PcapWriterService::get() {
+  // Intentionally leaked, so that captures still running at exit can be
+  // torn down in any order.
+  static auto* service = new PcapWriterService();
+  return service;
+}
+
+void PcapWriterService::addWriter(PcapWriter* writer) {
+  std::lock_guard<std::mutex> g(mutex_);
+  if (!thread_.joinable()) {
+    thread_ = std::thread(&PcapWriterService::threadMain, this);
+  }
+  writers_.insert(writer);
+  cv_.notify_all();
+}
+
+void PcapWriterService::removeWriter(PcapWriter* writer) {
+  std::unique_lock<std::mutex> g(mutex_);
+  ++numRemoving_;
+  cv_.notify_all();
+  // The writer may already be gone if it hit an error
+  removedCv_.wait(g, [&] {
+    return writers_.find(writer) == writers_.end() || stopping_;
+  });
+  --numRemoving_;
+}
+
+void PcapWriterService::threadMain() {
+  std::vector<PcapWriter*> writers;
+  std::vector<PcapWriter*> finished;
+  std::unique_lock<std::mutex> g(mutex_);
+  while (!stopping_) {
+    if (writers_.empty()) {
+      cv_.wait(g);
+      continue;
+    }
+    // Wake up early to flush writers which are being removed
+    cv_.wait_for(g, milliseconds(FLAGS_pcap_writer_poll_ms), [&] {
+      return numRemoving_ > 0 || stopping_;
+    });
+
+    // Writers are only removed by this thread, so they stay valid while the
+    // lock is released to do the I/O.
+    writers.assign(writers_.begin(), writers_.end());
+    g.unlock();
+    auto now = steady_clock::now();
+    finished.clear();
+    for (auto* writer : writers) {
+      if (!writer->writeQueued(now)) {
+        finished.push_back(writer);
+      }
+    }
+    g.lock();
+
+    for (auto* writer : finished) {
+      writers_.erase(writer);
+    }
+    if (!finished.empty()) {
+      removedCv_.notify_all();
+    }
+  }
+}
+
+} // namespace fboss
+} // namespace facebook
@@ -0,0 +1,64 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace facebook {
+namespace fboss {
+
+class PcapWriter;
+
+/*
+ * PcapWriterService performs the disk I/O for all PcapWriters.
+ *
+ * A single thread periodically takes the packets queued by each writer and
+ * writes them out, so long running captures do not each need a thread of
+ * their own.  The thread is started when the first writer is added.
+ */
+class PcapWriterService {
+ public:
+  PcapWriterService();
+  ~PcapWriterService();
+
+  static PcapWriterService* get();
+
+  void addWriter(PcapWriter* writer);
+
+  /*
+   * Remove a writer whose queue has been finished.
+   *
+   * This blocks until all of the writer's packets have been written and its
+   * file has been closed.
+   */
+  void removeWriter(PcapWriter* writer);
+
+ private:
+  // Forbidden copy constructor and assignment operator
+  PcapWriterService(PcapWriterService const&) = delete;
+  PcapWriterService& operator=(PcapWriterService const&) = delete;
+
+  void threadMain();
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable removedCv_;
+  std::set<PcapWriter*> writers_;
+  // The number of removeWriter() calls waiting for the thread
+  uint32_t numRemoving_{0};
+  bool stopping_{false};
+  std::thread thread_;
+};
+
+} // namespace fboss
+} // namespace facebook
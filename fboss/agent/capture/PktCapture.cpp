@@ -28,26 +28,38 @@ PktCapture::PktCapture(
     folly::StringPiece name,
     uint64_t maxPackets,
     CaptureDirection direction,
-    const CaptureFilter& captureFilter)
+    const CaptureFilter& captureFilter,
+    const PcapWriterLimits& limits)
     : name_(name.str()),
       maxPackets_(maxPackets),
       direction_(direction),
-      packetFilter_(captureFilter) {}
+      packetFilter_(captureFilter),
+      limits_(limits) {}
 
 void PktCapture::start(StringPiece path) {
   XLOG(INFO) << "starting packet capture " << toString();
-  writer_.start(path, true);
+  writer_.start(path, true, limits_);
 }
 
 void PktCapture::stop() {
+  {
+    std::lock_guard<std::mutex> guard(writer_.mutex());
+    stopped_ = true;
+  }
   writer_.finish();
   XLOG(INFO) << "Stopped packet capture " << toString(true);
 }
 
 bool PktCapture::packetReceived(const RxPacket* pkt) {
+  // The direction and filter never change once the capture is created, so
+  // the filter can run before taking the writer lock.
+  bool capture = direction_ != CaptureDirection::CAPTURE_ONLY_TX &&
+      packetFilter_.passes(pkt);
   std::lock_guard<std::mutex> guard(writer_.mutex());
-  if (direction_ != CaptureDirection::CAPTURE_ONLY_TX &&
-      true == packetFilter_.passes(pkt)) {
+  if (stopped_) {
+    return false;
+  }
+  if (capture) {
     ++numPacketsReceived_;
     writer_.addPktLocked(pkt);
   }
@@ -55,8 +67,13 @@ bool PktCapture::packetReceived(const RxPacket* pkt) {
 }
 
 bool PktCapture::packetSent(const TxPacket* pkt) {
+  bool capture = direction_ != CaptureDirection::CAPTURE_ONLY_RX &&
+      packetFilter_.passes(pkt);
   std::lock_guard<std::mutex> guard(writer_.mutex());
-  if (direction_ != CaptureDirection::CAPTURE_ONLY_RX) {
+  if (stopped_) {
+    return false;
+  }
+  if (capture) {
     ++numPacketsSent_;
     writer_.addPktLocked(pkt);
   }
@@ -72,7 +89,9 @@ std::string PktCapture::toString(bool withStats) const {
                                                                   : "TX only"));
   if (withStats) {
     ss << ", Packet received:" << numPacketsReceived_
-       << ", Packet sent:" << numPacketsSent_;
+       << ", Packet sent:" << numPacketsSent_
+       << ", Packets dropped:" << writer_.numDropped()
+       << ", Packets rate limited:" << writer_.numRateLimited();
   }
   return ss.str();
 }
@@ -9,6 +9,7 @@
  */
 #pragma once
 
+#include "fboss/agent/capture/PacketMatcher.h"
 #include "fboss/agent/capture/PcapWriter.h"
 #include "fboss/agent/if/gen-cpp2/ctrl_types.h"
 
@@ -41,14 +42,20 @@ class RxPacketFilter {
 class PacketFilter {
  public:
   explicit PacketFilter(const CaptureFilter& captureFilter)
-      : rxPacketFilter_(captureFilter.get_rxCaptureFilter()) {}
+      : rxPacketFilter_(captureFilter.get_rxCaptureFilter()),
+        matcher_(captureFilter.get_packetMatches()) {}
 
-  bool passes(const RxPacket* pkt) {
-    return rxPacketFilter_.passes(pkt);
+  bool passes(const RxPacket* pkt) const {
+    return rxPacketFilter_.passes(pkt) && matcher_.matches(pkt);
+  }
+
+  bool passes(const TxPacket* pkt) const {
+    return matcher_.matches(pkt);
   }
 
  private:
   RxPacketFilter rxPacketFilter_;
+  PacketMatcher matcher_;
 };
 
 /*
@@ -64,7 +71,8 @@ class PktCapture {
       folly::StringPiece name,
       uint64_t maxPackets,
       CaptureDirection direction,
-      const CaptureFilter& captureFilter);
+      const CaptureFilter& captureFilter,
+      const PcapWriterLimits& limits = PcapWriterLimits());
 
   const std::string& name() const {
     return name_;
@@ -85,14 +93,22 @@ class PktCapture {
 
   const std::string name_;
 
+  // These are set at construction and never modified afterwards, so may be
+  // read without holding a lock.
+  const uint64_t maxPackets_{0};
+  const CaptureDirection direction_{CaptureDirection::CAPTURE_TX_RX};
+  const PacketFilter packetFilter_;
+  const PcapWriterLimits limits_;
+
   // Note: the rest of the state in this class is protcted by
   // the PcapWriter's mutex.
   PcapWriter writer_;
-  uint64_t maxPackets_{0};
   uint64_t numPacketsReceived_{0};
   uint64_t numPacketsSent_{0};
-  CaptureDirection direction_{CaptureDirection::CAPTURE_TX_RX};
-  PacketFilter packetFilter_;
+  // Packets may still be dispatched to the capture for a short while after
+  // it has been stopped, by threads using an older snapshot of the active
+  // captures. They are dropped once this is set.
+  bool stopped_{false};
 };
 } // namespace fboss
 } // namespace facebook
@@ -19,6 +19,7 @@
 #include <folly/logging/xlog.h>
 
 using folly::StringPiece;
+using std::shared_ptr;
 using std::string;
 using std::unique_ptr;
 
@@ -47,8 +48,8 @@ void PktCaptureManager::startCapture(unique_ptr<PktCapture> capture) {
   }
 
   capture->start(path);
-  capturesRunning_.store(true, std::memory_order_release);
   activeCaptures_[name] = std::move(capture);
+  publishActiveCapturesLocked();
 }
 
 void PktCaptureManager::stopCapture(StringPiece name) {
@@ -62,24 +63,24 @@ void PktCaptureManager::stopCapture(StringPiece name) {
   it->second->stop();
   inactiveCaptures_[nameStr] = std::move(it->second);
   activeCaptures_.erase(it);
-  capturesRunning_.store(!activeCaptures_.empty(), std::memory_order_release);
+  publishActiveCapturesLocked();
 }
 
-unique_ptr<PktCapture> PktCaptureManager::forgetCapture(StringPiece name) {
+shared_ptr<PktCapture> PktCaptureManager::forgetCapture(StringPiece name) {
   std::lock_guard<std::mutex> g(mutex_);
   auto nameStr = name.str();
   auto activeIt = activeCaptures_.find(nameStr);
   if (activeIt != activeCaptures_.end()) {
-    std::unique_ptr<PktCapture> capture = std::move(activeIt->second);
+    shared_ptr<PktCapture> capture = std::move(activeIt->second);
     activeCaptures_.erase(activeIt);
-    capturesRunning_.store(!activeCaptures_.empty(), std::memory_order_release);
+    publishActiveCapturesLocked();
     capture->stop();
     return capture;
   }
 
   auto inactiveIt = inactiveCaptures_.find(nameStr);
   if (inactiveIt != inactiveCaptures_.end()) {
-    std::unique_ptr<PktCapture> capture = std::move(inactiveIt->second);
+    shared_ptr<PktCapture> capture = std::move(inactiveIt->second);
     inactiveCaptures_.erase(inactiveIt);
     return capture;
   }
@@ -101,18 +102,14 @@ void PktCaptureManager::forgetAllCaptures() {
 
 template <typename Fn>
 void PktCaptureManager::invokeCaptures(const Fn& fn) {
-  std::lock_guard<std::mutex> g(mutex_);
-
-  for (auto it = activeCaptures_.begin(); it != activeCaptures_.end();
-       /* increment in loop */) {
-    // Increment the iterator now, in case this capture deactivates itself and
-    // we need to remove it from the active captures.
-    auto thisIt = it;
-    ++it;
-    PktCapture* capture = thisIt->second.get();
+  // This runs for every packet while any capture is active, so it only
+  // reads the published snapshot of the active captures, and leaves mutex_
+  // to the (rare) changes to the set of captures.
+  auto captures = activeSnapshot_.get();
+  for (const auto& capture : *captures) {
     bool stillActive = false;
     try {
-      stillActive = fn(capture);
+      stillActive = fn(capture.get());
     } catch (const std::exception& ex) {
       XLOG(ERR) << "error when processing packet for capture "
                 << capture->name() << " : " << folly::exceptionStr(ex);
@@ -120,21 +117,43 @@ void PktCaptureManager::invokeCaptures(const Fn& fn) {
     }
 
     if (!stillActive) {
-      XLOG(INFO) << "auto-stopping packet capture \"" << capture->name()
-                 << "\"";
-      try {
-        inactiveCaptures_[capture->name()] = std::move(thisIt->second);
-      } catch (const std::exception& ex) {
-        XLOG(ERR) << "error adding capture " << capture->name()
-                  << " to the inactive list";
-        // Can't do much else here.  Just continue and forget the capture.
-      }
-      activeCaptures_.erase(thisIt);
+      deactivateCapture(capture);
     }
   }
+}
+
+void PktCaptureManager::deactivateCapture(
+    const shared_ptr<PktCapture>& capture) {
+  std::lock_guard<std::mutex> g(mutex_);
+
+  // Several threads may see the capture finish at the same time, and it may
+  // already have been stopped, forgotten or even replaced by a new capture
+  // of the same name, so only move it if it is still the active one.
+  auto it = activeCaptures_.find(capture->name());
+  if (it == activeCaptures_.end() || it->second != capture) {
+    return;
+  }
 
-  bool running = !activeCaptures_.empty();
-  capturesRunning_.store(running, std::memory_order_release);
+  XLOG(INFO) << "auto-stopping packet capture \"" << capture->name() << "\"";
+  try {
+    inactiveCaptures_[capture->name()] = capture;
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "error adding capture " << capture->name()
+              << " to the inactive list";
+    // Can't do much else here.  Just continue and forget the capture.
+  }
+  activeCaptures_.erase(it);
+  publishActiveCapturesLocked();
+}
+
+void PktCaptureManager::publishActiveCapturesLocked() {
+  auto captures = std::make_shared<CaptureList>();
+  captures->reserve(activeCaptures_.size());
+  for (const auto& entry : activeCaptures_) {
+    captures->push_back(entry.second);
+  }
+  activeSnapshot_.set(std::move(captures));
+  capturesRunning_.store(!activeCaptures_.empty(), std::memory_order_release);
 }
 
 void PktCaptureManager::packetReceivedImpl(const RxPacket* pkt) {
@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include "fboss/lib/ThreadCachedSnapshot.h"
+
 #include <folly/Range.h>
 
 #include <atomic>
@@ -16,6 +18,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace facebook {
 namespace fboss {
@@ -38,7 +41,7 @@ class PktCaptureManager {
   void startCapture(std::unique_ptr<PktCapture> capture);
 
   void stopCapture(folly::StringPiece name);
-  std::unique_ptr<PktCapture> forgetCapture(folly::StringPiece name);
+  std::shared_ptr<PktCapture> forgetCapture(folly::StringPiece name);
 
   void stopAllCaptures();
   void forgetAllCaptures();
@@ -83,17 +86,31 @@ class PktCaptureManager {
   PktCaptureManager(PktCaptureManager const&) = delete;
   PktCaptureManager& operator=(PktCaptureManager const&) = delete;
 
+  using CaptureList = std::vector<std::shared_ptr<PktCapture>>;
+
   template <typename Fn>
   void invokeCaptures(const Fn& fn);
   void packetReceivedImpl(const RxPacket* pkt);
   void packetSentImpl(const TxPacket* pkt);
+  void deactivateCapture(const std::shared_ptr<PktCapture>& capture);
+  void publishActiveCapturesLocked();
 
   std::atomic<bool> capturesRunning_{false};
 
   std::mutex mutex_;
   std::string captureDir_;
-  std::map<std::string, std::unique_ptr<PktCapture>> activeCaptures_;
-  std::map<std::string, std::unique_ptr<PktCapture>> inactiveCaptures_;
+  std::map<std::string, std::shared_ptr<PktCapture>> activeCaptures_;
+  std::map<std::string, std::shared_ptr<PktCapture>> inactiveCaptures_;
+
+  /*
+   * The active captures, as seen by the packet path.
+   *
+   * This is republished, while holding mutex_, whenever activeCaptures_
+   * changes, so that packets can be dispatched to the captures without
+   * taking mutex_.
+   */
+  ThreadCachedSnapshot<const CaptureList> activeSnapshot_{
+      std::make_shared<const CaptureList>()};
 };
 
 } // namespace fboss
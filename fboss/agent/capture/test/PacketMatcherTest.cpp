@@ -0,0 +1,195 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PacketMatcher.h"
+
+#include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+#include "fboss/agent/hw/mock/MockTxPacket.h"
+#include "fboss/agent/packet/PktUtil.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace facebook::fboss;
+using facebook::network::toBinaryAddress;
+using folly::StringPiece;
+
+namespace {
+
+// Tagged (vlan 5) UDP packet from 10.0.0.10:5353 to 10.0.0.1:67
+constexpr auto kUdpV4 =
+    // dst mac, src mac
+    "02 01 02 03 04 05  02 00 01 00 00 01"
+    // 802.1q, vlan 5
+    "81 00  00 05"
+    // IPv4
+    "08 00"
+    "45 00 00 1c  00 00 00 00  40 11 00 00"
+    "0a 00 00 0a  0a 00 00 01"
+    // UDP
+    "14 e9 00 43  00 08 00 00";
+
+// Untagged TCP packet from 2401:db00::1:1234 to 2401:db00::2:179
+constexpr auto kTcpV6 =
+    // dst mac, src mac
+    "02 01 02 03 04 05  02 00 01 00 00 01"
+    // IPv6
+    "86 dd"
+    "60 00 00 00  00 14 06 40"
+    "24 01 db 00  00 00 00 00  00 00 00 00  00 00 00 01"
+    "24 01 db 00  00 00 00 00  00 00 00 00  00 00 00 02"
+    // TCP
+    "04 d2 00 b3  00 00 00 00  00 00 00 00  50 02 00 00"
+    "00 00 00 00";
+
+// ARP request
+constexpr auto kArp =
+    "ff ff ff ff ff ff  02 00 01 00 00 01"
+    "08 06"
+    "00 01 08 00 06 04 00 01"
+    "02 00 01 00 00 01  0a 00 00 0a"
+    "00 00 00 00 00 00  0a 00 00 01";
+
+std::unique_ptr<MockRxPacket>
+rxPacket(StringPiece hex, PortID port = PortID(1), VlanID vlan = VlanID(5)) {
+  auto pkt = MockRxPacket::fromHex(hex);
+  pkt->setSrcPort(port);
+  pkt->setSrcVlan(vlan);
+  return pkt;
+}
+
+std::unique_ptr<MockTxPacket> txPacket(StringPiece hex) {
+  auto data = PktUtil::parseHexData(hex);
+  data.coalesce();
+  auto pkt = std::make_unique<MockTxPacket>(data.length());
+  memcpy(pkt->buf()->writableData(), data.data(), data.length());
+  return pkt;
+}
+
+IpPrefix prefix(StringPiece ip, int16_t len) {
+  IpPrefix prefix;
+  prefix.ip = toBinaryAddress(folly::IPAddress(ip));
+  prefix.prefixLength = len;
+  return prefix;
+}
+
+bool matches(const PacketMatch& match, StringPiece hex) {
+  PacketMatcher matcher({match});
+  return matcher.matches(rxPacket(hex).get());
+}
+
+} // namespace
+
+TEST(PacketMatcher, Empty) {
+  PacketMatcher matcher({});
+  EXPECT_TRUE(matcher.empty());
+  EXPECT_TRUE(matcher.matches(rxPacket(kUdpV4).get()));
+  EXPECT_TRUE(matcher.matches(txPacket(kArp).get()));
+}
+
+TEST(PacketMatcher, Ethertype) {
+  PacketMatch match;
+  match.ethertype_ref() = 0x0800;
+  EXPECT_TRUE(matches(match, kUdpV4));
+  EXPECT_FALSE(matches(match, kTcpV6));
+  EXPECT_FALSE(matches(match, kArp));
+
+  match.ethertype_ref() = 0x0806;
+  EXPECT_TRUE(matches(match, kArp));
+}
+
+TEST(PacketMatcher, Vlan) {
+  PacketMatch match;
+  match.vlan_ref() = 5;
+  EXPECT_TRUE(matches(match, kUdpV4));
+
+  // Untagged packets use the vlan they were received on
+  PacketMatcher matcher({match});
+  EXPECT_TRUE(matcher.matches(rxPacket(kArp, PortID(1), VlanID(5)).get()));
+  EXPECT_FALSE(matcher.matches(rxPacket(kArp, PortID(1), VlanID(6)).get()));
+}
+
+TEST(PacketMatcher, SrcPort) {
+  PacketMatch match;
+  match.srcPort_ref() = 3;
+  PacketMatcher matcher({match});
+  EXPECT_TRUE(matcher.matches(rxPacket(kUdpV4, PortID(3)).get()));
+  EXPECT_FALSE(matcher.matches(rxPacket(kUdpV4, PortID(4)).get()));
+  // Transmitted packets have no source port
+  EXPECT_FALSE(matcher.matches(txPacket(kUdpV4).get()));
+}
+
+TEST(PacketMatcher, IpPrefix) {
+  PacketMatch match;
+  match.srcIp_ref() = prefix("10.0.0.0", 24);
+  EXPECT_TRUE(matches(match, kUdpV4));
+  EXPECT_FALSE(matches(match, kTcpV6));
+  EXPECT_FALSE(matches(match, kArp));
+
+  match.dstIp_ref() = prefix("10.0.0.2", 32);
+  EXPECT_FALSE(matches(match, kUdpV4));
+  match.dstIp_ref() = prefix("10.0.0.1", 32);
+  EXPECT_TRUE(matches(match, kUdpV4));
+
+  PacketMatch v6Match;
+  v6Match.dstIp_ref() = prefix("2401:db00::", 64);
+  EXPECT_TRUE(matches(v6Match, kTcpV6));
+  EXPECT_FALSE(matches(v6Match, kUdpV4));
+}
+
+TEST(PacketMatcher, L4) {
+  PacketMatch match;
+  match.ipProto_ref() = 17;
+  match.l4DstPort_ref() = 67;
+  EXPECT_TRUE(matches(match, kUdpV4));
+  EXPECT_FALSE(matches(match, kTcpV6));
+  EXPECT_FALSE(matches(match, kArp));
+
+  PacketMatch bgp;
+  bgp.l4DstPort_ref() = 179;
+  bgp.l4SrcPort_ref() = 1234;
+  EXPECT_TRUE(matches(bgp, kTcpV6));
+  EXPECT_FALSE(matches(bgp, kUdpV4));
+
+  PacketMatcher matcher({bgp});
+  EXPECT_TRUE(matcher.matches(txPacket(kTcpV6).get()));
+}
+
+TEST(PacketMatcher, AnyMatch) {
+  PacketMatch arp;
+  arp.ethertype_ref() = 0x0806;
+  PacketMatch bgp;
+  bgp.l4DstPort_ref() = 179;
+  PacketMatcher matcher({arp, bgp});
+  EXPECT_TRUE(matcher.matches(rxPacket(kArp).get()));
+  EXPECT_TRUE(matcher.matches(rxPacket(kTcpV6).get()));
+  EXPECT_FALSE(matcher.matches(rxPacket(kUdpV4).get()));
+}
+
+TEST(PacketMatcher, Truncated) {
+  PacketMatch match;
+  match.l4DstPort_ref() = 67;
+  // Cut the packet off in the middle of the IPv4 header
+  EXPECT_FALSE(matches(
+      match,
+      "02 01 02 03 04 05  02 00 01 00 00 01  08 00  45 00 00 1c  00 00"));
+}
+
+TEST(PacketMatcher, InvalidFilter) {
+  PacketMatch match;
+  match.vlan_ref() = 4096;
+  EXPECT_THROW(PacketMatcher({match}), FbossError);
+
+  PacketMatch badPrefix;
+  badPrefix.srcIp_ref() = prefix("10.0.0.0", 33);
+  EXPECT_THROW(PacketMatcher({badPrefix}), FbossError);
+}
@@ -0,0 +1,159 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PcapPublisher.h"
+#include "fboss/agent/capture/PcapPkt.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+#include "fboss/agent/hw/mock/MockTxPacket.h"
+
+#include <folly/io/async/EventBase.h>
+#include <gtest/gtest.h>
+
+#include <deque>
+
+using namespace facebook::fboss;
+using std::chrono::milliseconds;
+
+namespace {
+
+constexpr uint16_t kIPv4 = 0x0800;
+constexpr uint16_t kArp = 0x0806;
+
+std::unique_ptr<MockRxPacket> makePacket() {
+  auto pkt = MockRxPacket::fromHex(
+      // dst mac, src mac
+      "02 00 01 00 00 01  02 00 02 01 02 03"
+      // IPv4
+      "08 00");
+  pkt->padToLength(68);
+  pkt->setSrcPort(PortID(1));
+  pkt->setSrcVlan(VlanID(1));
+  return pkt;
+}
+
+/*
+ * Records the batches handed to the distribution service. The batches are
+ * only acknowledged when the test fulfills their promises.
+ */
+class PcapPublisherTest : public ::testing::Test {
+ public:
+  std::unique_ptr<PcapPublisher> makePublisher(
+      uint32_t batchSize,
+      milliseconds interval,
+      uint32_t ringSize,
+      uint32_t maxInFlight) {
+    return std::make_unique<PcapPublisher>(
+        &evb,
+        [this](std::vector<PublishedPacket>&& packets) {
+          batches.push_back(std::move(packets));
+          promises.emplace_back();
+          return promises.back().getFuture();
+        },
+        batchSize,
+        interval,
+        ringSize,
+        maxInFlight);
+  }
+
+  void ackAll() {
+    for (auto& promise : promises) {
+      promise.setValue();
+    }
+    promises.clear();
+    evb.loopOnce(EVLOOP_NONBLOCK);
+  }
+
+  folly::EventBase evb;
+  std::vector<std::vector<PublishedPacket>> batches;
+  std::deque<folly::Promise<folly::Unit>> promises;
+};
+
+} // unnamed namespace
+
+TEST_F(PcapPublisherTest, BatchBySize) {
+  auto publisher = makePublisher(4, milliseconds(10000), 100, 1);
+  auto pkt = makePacket();
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(publisher->publishRx(pkt.get(), kIPv4));
+  }
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  ASSERT_EQ(1, batches.size());
+  ASSERT_EQ(4, batches[0].size());
+  EXPECT_TRUE(batches[0][0].rx);
+  EXPECT_EQ(1, batches[0][0].srcPort);
+
+  // The published data is shared with the packet, not copied
+  EXPECT_EQ(pkt->buf()->data(), batches[0][0].packetData.data());
+  PcapPkt pcapPkt(&batches[0][0]);
+  EXPECT_TRUE(pcapPkt.isRx());
+  EXPECT_EQ(pkt->buf()->data(), pcapPkt.buf()->data());
+  ackAll();
+}
+
+TEST_F(PcapPublisherTest, TxPacketCopied) {
+  auto publisher = makePublisher(1, milliseconds(10000), 100, 1);
+  MockTxPacket pkt(68);
+  memset(pkt.buf()->writableData(), 0x42, pkt.buf()->length());
+  EXPECT_TRUE(publisher->publishTx(&pkt, kIPv4));
+  // The switch may rewrite the packet after publishing it
+  memset(pkt.buf()->writableData(), 0, pkt.buf()->length());
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  ASSERT_EQ(1, batches.size());
+  ASSERT_EQ(1, batches[0].size());
+  const auto& published = batches[0][0];
+  EXPECT_FALSE(published.rx);
+  EXPECT_NE(pkt.buf()->data(), published.packetData.data());
+  ASSERT_EQ(68, published.packetData.computeChainDataLength());
+  auto data = published.packetData.cloneCoalescedAsValue();
+  for (size_t i = 0; i < data.length(); ++i) {
+    EXPECT_EQ(0x42, data.data()[i]);
+  }
+  ackAll();
+}
+
+TEST_F(PcapPublisherTest, BatchByInterval) {
+  auto publisher = makePublisher(100, milliseconds(1), 100, 1);
+  auto pkt = makePacket();
+  EXPECT_TRUE(publisher->publishRx(pkt.get(), kIPv4));
+  EXPECT_TRUE(publisher->publishRx(pkt.get(), kArp));
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(0, batches.size());
+
+  while (batches.empty()) {
+    evb.loopOnce();
+  }
+  ASSERT_EQ(1, batches.size());
+  EXPECT_EQ(2, batches[0].size());
+  ackAll();
+}
+
+TEST_F(PcapPublisherTest, DropWhenRingFull) {
+  auto publisher = makePublisher(2, milliseconds(10000), 4, 1);
+  auto pkt = makePacket();
+  // The first batch is outstanding until acknowledged
+  EXPECT_TRUE(publisher->publishRx(pkt.get(), kIPv4));
+  EXPECT_TRUE(publisher->publishRx(pkt.get(), kIPv4));
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  ASSERT_EQ(1, batches.size());
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(publisher->publishRx(pkt.get(), kIPv4));
+  }
+  EXPECT_FALSE(publisher->publishRx(pkt.get(), kIPv4));
+  // Each ethertype has its own ring
+  EXPECT_TRUE(publisher->publishRx(pkt.get(), kArp));
+  evb.loopOnce(EVLOOP_NONBLOCK);
+  EXPECT_EQ(1, batches.size());
+
+  // Once the service catches up the queued packets are sent in one batch
+  ackAll();
+  ASSERT_EQ(2, batches.size());
+  EXPECT_EQ(5, batches[1].size());
+  ackAll();
+}
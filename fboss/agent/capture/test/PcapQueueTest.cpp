@@ -71,3 +71,29 @@ TEST(PcapQueueTest, SimpleAdd) {
   ByteRange waitedPktData = waitedPktBufClone->coalesce();
   EXPECT_EQ(expectedPktData, waitedPktData);
 }
+
+TEST(PcapQueueTest, RateLimitChecksBothBuckets) {
+  PcapQueue queue(100);
+  // Two packets, but only 100 bytes, a second
+  queue.setRateLimit(2, 100);
+
+  auto pkt = MockRxPacket::fromHex(
+      // dst mac, src mac, IPv4
+      "02 00 01 00 00 01  02 00 02 01 02 03  08 00");
+  pkt->padToLength(68);
+  // Leaves one packet and 32 bytes
+  queue.addPkt(pkt.get());
+  // Rejected for its size, which must not use up the last packet
+  queue.addPkt(pkt.get());
+  EXPECT_EQ(1, queue.numRateLimited());
+
+  auto small = MockRxPacket::fromHex(
+      // dst mac, src mac, IPv4
+      "02 00 01 00 00 01  02 00 02 01 02 03  08 00");
+  queue.addPkt(small.get());
+  EXPECT_EQ(1, queue.numRateLimited());
+
+  std::vector<PcapPkt> pkts;
+  queue.poll(&pkts);
+  EXPECT_EQ(2, pkts.size());
+}
@@ -0,0 +1,196 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/capture/PcapShmRing.h"
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+#include "fboss/agent/hw/mock/MockTxPacket.h"
+
+#include <folly/Conv.h>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+#include <thread>
+
+using namespace facebook::fboss;
+
+namespace {
+
+constexpr uint16_t kIPv4 = 0x0800;
+constexpr uint16_t kArp = 0x0806;
+constexpr uint16_t kMpls = 0x8847;
+
+class ReasonRxPacket : public MockRxPacket {
+ public:
+  using MockRxPacket::MockRxPacket;
+
+  std::vector<RxReason> getReasons() override {
+    return {{1, "arp"}, {7, "l3 dest miss"}};
+  }
+};
+
+std::unique_ptr<MockRxPacket> makePacket(uint32_t length, uint8_t fill = 0) {
+  auto pkt = MockRxPacket::fromHex(
+      // dst mac, src mac
+      "02 00 01 00 00 01  02 00 02 01 02 03"
+      // IPv4
+      "08 00");
+  pkt->padToLength(length, fill);
+  pkt->setSrcPort(PortID(5));
+  pkt->setSrcVlan(VlanID(1));
+  return pkt;
+}
+
+class PcapShmRingTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    path = folly::to<std::string>("/tmp/fbossPcapRingTest.", getpid());
+  }
+  void TearDown() override {
+    unlink(path.c_str());
+  }
+
+  std::string path;
+};
+
+} // namespace
+
+TEST_F(PcapShmRingTest, RoundTrip) {
+  PcapShmRingWriter writer(path, 16, 256);
+  PcapShmRingReader reader(path);
+
+  auto pkt = makePacket(68, 0xab);
+  writer.writeRx(pkt.get(), kIPv4);
+  MockTxPacket txPkt(64);
+  writer.writeTx(&txPkt, kIPv4);
+  writer.writeRx(pkt.get(), kArp);
+
+  std::vector<PublishedPacket> out;
+  EXPECT_EQ(2, reader.read(PcapShmRing::ringIndex(kIPv4), &out));
+  ASSERT_EQ(2, out.size());
+  EXPECT_TRUE(out[0].rx);
+  EXPECT_EQ(kIPv4, out[0].ethertype);
+  EXPECT_EQ(5, out[0].srcPort);
+  EXPECT_EQ(1, out[0].srcVlan);
+  EXPECT_TRUE(out[0].timestampUs_ref().has_value());
+  EXPECT_EQ(
+      pkt->buf()->cloneAsValue().moveToFbString(),
+      out[0].packetData.cloneAsValue().moveToFbString());
+  EXPECT_FALSE(out[1].rx);
+  EXPECT_EQ(64, out[1].packetData.computeChainDataLength());
+
+  // Nothing more to read from the IPv4 ring, but the ARP packet is in its
+  // own ring
+  EXPECT_EQ(0, reader.read(PcapShmRing::ringIndex(kIPv4), &out));
+  EXPECT_EQ(1, reader.read(PcapShmRing::ringIndex(kArp), &out));
+  EXPECT_EQ(kArp, out.back().ethertype);
+  EXPECT_EQ(0, reader.numOverruns());
+}
+
+TEST_F(PcapShmRingTest, OtherEthertypes) {
+  EXPECT_EQ(PcapShmRing::numRings() - 1, PcapShmRing::ringIndex(kMpls));
+
+  PcapShmRingWriter writer(path, 16, 256);
+  PcapShmRingReader reader(path);
+  auto pkt = makePacket(68);
+  writer.writeRx(pkt.get(), kMpls);
+
+  std::vector<PublishedPacket> out;
+  EXPECT_EQ(1, reader.read(PcapShmRing::numRings() - 1, &out));
+  EXPECT_EQ(kMpls, out[0].ethertype);
+}
+
+TEST_F(PcapShmRingTest, Truncate) {
+  PcapShmRingWriter writer(path, 16, 256);
+  PcapShmRingReader reader(path);
+  auto pkt = makePacket(1500);
+  writer.writeRx(pkt.get(), kIPv4);
+
+  std::vector<PublishedPacket> out;
+  ASSERT_EQ(1, reader.read(PcapShmRing::ringIndex(kIPv4), &out));
+  auto len = out[0].packetData.computeChainDataLength();
+  EXPECT_GT(len, 0);
+  EXPECT_LT(len, 256);
+}
+
+TEST_F(PcapShmRingTest, Reasons) {
+  PcapShmRingWriter writer(path, 16, 512);
+  PcapShmRingReader reader(path);
+  ReasonRxPacket pkt(makePacket(68)->buf()->clone());
+  writer.writeRx(&pkt, kArp);
+
+  std::vector<PublishedPacket> out;
+  ASSERT_EQ(1, reader.read(PcapShmRing::ringIndex(kArp), &out));
+  ASSERT_EQ(2, out[0].reasons.size());
+  EXPECT_EQ(1, out[0].reasons[0].bytes);
+  EXPECT_EQ("arp", out[0].reasons[0].description);
+  EXPECT_EQ(7, out[0].reasons[1].bytes);
+  EXPECT_EQ("l3 dest miss", out[0].reasons[1].description);
+}
+
+TEST_F(PcapShmRingTest, Overrun) {
+  PcapShmRingWriter writer(path, 8, 256);
+  PcapShmRingReader reader(path);
+  auto pkt = makePacket(68);
+  for (int i = 0; i < 20; ++i) {
+    writer.writeRx(pkt.get(), kIPv4);
+  }
+
+  // Only the last 8 packets are still in the ring
+  std::vector<PublishedPacket> out;
+  EXPECT_EQ(8, reader.read(PcapShmRing::ringIndex(kIPv4), &out));
+  EXPECT_EQ(12, reader.numOverruns());
+
+  writer.writeRx(pkt.get(), kIPv4);
+  EXPECT_EQ(1, reader.read(PcapShmRing::ringIndex(kIPv4), &out));
+  EXPECT_EQ(12, reader.numOverruns());
+}
+
+TEST_F(PcapShmRingTest, ConcurrentReader) {
+  PcapShmRingWriter writer(path, 64, 256);
+  PcapShmRingReader reader(path);
+  constexpr int kNumPkts = 100000;
+
+  std::thread writerThread([&] {
+    for (int i = 0; i < kNumPkts; ++i) {
+      // Each packet is filled with a single byte, so that torn reads show
+      auto pkt = makePacket(100, i % 256);
+      writer.writeRx(pkt.get(), kIPv4);
+    }
+  });
+
+  uint64_t numRead = 0;
+  std::vector<PublishedPacket> out;
+  auto readAll = [&] {
+    out.clear();
+    numRead += reader.read(PcapShmRing::ringIndex(kIPv4), &out);
+    for (auto& pkt : out) {
+      auto data = pkt.packetData.cloneAsValue().moveToFbString();
+      ASSERT_EQ(100, data.size());
+      for (size_t i = 15; i < data.size(); ++i) {
+        ASSERT_EQ(data[14], data[i]);
+      }
+    }
+  };
+  while (numRead + reader.numOverruns() < kNumPkts) {
+    readAll();
+  }
+  writerThread.join();
+  EXPECT_EQ(kNumPkts, numRead + reader.numOverruns());
+}
+
+TEST_F(PcapShmRingTest, BadFile) {
+  EXPECT_THROW(PcapShmRingReader reader(path), std::system_error);
+  {
+    FILE* f = fopen(path.c_str(), "w");
+    fputs("not a packet ring, but long enough to hold a header", f);
+    fclose(f);
+  }
+  EXPECT_THROW(PcapShmRingReader reader(path), FbossError);
+}
@@ -11,6 +11,7 @@
 #include "fboss/agent/capture/test/PcapUtil.h"
 #include "fboss/agent/hw/mock/MockRxPacket.h"
 
+#include <folly/Conv.h>
 #include <folly/Exception.h>
 #include <folly/ScopeGuard.h>
 #include <gtest/gtest.h>
@@ -101,3 +102,55 @@ TEST(PcapWriterTest, Drop) {
     EXPECT_EQ(68, pktInfo.hdr.caplen);
   }
 }
+
+TEST(PcapWriterTest, Rotate) {
+  char tmpDir[] = "fbossPcapTest.XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(tmpDir));
+  auto path = folly::to<std::string>(tmpDir, "/capture.pcap");
+  SCOPE_EXIT {
+    for (const auto& suffix : {"", ".1", ".2", ".3"}) {
+      unlink(folly::to<std::string>(path, suffix).c_str());
+    }
+    rmdir(tmpDir);
+  };
+
+  // Each packet takes 16 bytes of header and 68 bytes of data, and the
+  // file header takes 24 bytes, so each file holds 10 packets.
+  PcapWriterLimits limits;
+  limits.maxFileBytes = 24 + 10 * (16 + 68);
+  limits.numFiles = 3;
+  PcapWriter writer(path, true, 0, limits);
+  addPackets(&writer, 45);
+  writer.finish();
+  EXPECT_EQ(0, writer.numDropped());
+
+  // The oldest 15 packets were rotated out
+  EXPECT_EQ(5, readPcapFile(path.c_str()).size());
+  auto path1 = folly::to<std::string>(path, ".1");
+  EXPECT_EQ(10, readPcapFile(path1.c_str()).size());
+  auto path2 = folly::to<std::string>(path, ".2");
+  EXPECT_EQ(10, readPcapFile(path2.c_str()).size());
+  EXPECT_NE(0, access(folly::to<std::string>(path, ".3").c_str(), F_OK));
+}
+
+TEST(PcapWriterTest, RateLimit) {
+  char tmpPath[] = "fbossPcapTest.XXXXXX";
+  int tmpFD = mkstemp(tmpPath);
+  folly::checkUnixError(tmpFD, "failed to create temporary file");
+  SCOPE_EXIT {
+    close(tmpFD);
+    unlink(tmpPath);
+  };
+
+  PcapWriterLimits limits;
+  limits.maxPktsPerSec = 10;
+  PcapWriter writer(tmpPath, true, 0, limits);
+  addPackets(&writer, 1000);
+  writer.finish();
+  EXPECT_EQ(0, writer.numDropped());
+  EXPECT_GT(writer.numRateLimited(), 0);
+
+  auto pcapPkts = readPcapFile(tmpPath);
+  EXPECT_EQ(1000, pcapPkts.size() + writer.numRateLimited());
+  EXPECT_LT(pcapPkts.size(), 100);
+}
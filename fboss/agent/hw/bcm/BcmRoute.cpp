@@ -326,7 +326,7 @@ void BcmRouteTable::addRoute(opennsl_vrf_t vrf, const RouteT* route) {
   CHECK(route->isResolved());
   RouteNextHopEntry fwd(route->getForwardInfo());
   if (fwd.getAction() == RouteForwardAction::NEXTHOPS) {
-    fwd = RouteNextHopEntry(fwd.normalizedNextHops(), fwd.getAdminDistance());
+    fwd = RouteNextHopEntry(*fwd.normalizedNextHops(), fwd.getAdminDistance());
   }
   ret.first->second->program(fwd);
 }
@@ -1873,12 +1873,9 @@ void BcmSwitch::updateStats(SwitchStats* switchStats) {
   // Update thread-local switch statistics.
   updateThreadLocalSwitchStats(switchStats);
   // Update thread-local per-port statistics.
-  PortStatsMap* portStatsMap = switchStats->getPortStats();
-  for (auto& it : *portStatsMap) {
-    PortID portID = it.first;
-    PortStats* portStats = it.second.get();
+  switchStats->forEachPortStats([this](PortID portID, PortStats* portStats) {
     updateThreadLocalPortStats(portID, portStats);
-  }
+  });
   // Update global statistics.
   updateGlobalStats();
   // Update cpu or host bound packet stats
@@ -1,6 +1,7 @@
 // Copyright 2004-present Facebook. All Rights Reserved.
 #include "fboss/agent/hw/bcm/BcmWarmBootHelper.h"
 
+#include "fboss/agent/StateSnapshotFile.h"
 #include "fboss/agent/SysError.h"
 #include "fboss/agent/Utils.h"
 
@@ -8,7 +9,6 @@
 #include <sys/stat.h>
 
 #include <folly/FileUtil.h>
-#include <folly/json.h>
 #include <folly/logging/xlog.h>
 #include <glog/logging.h>
 
@@ -19,6 +19,11 @@ DEFINE_string(
     switch_state_file,
     "switch_state",
     "File for dumping switch state JSON in on exit");
+DEFINE_bool(
+    binary_switch_state_file,
+    false,
+    "Write the switch state file in the binary snapshot format rather than "
+    "JSON. Either format is read back on warm boot.");
 
 namespace {
 constexpr auto wbFlagPrefix = "can_warm_boot_";
@@ -131,17 +136,18 @@ bool DiscBackedBcmWarmBootHelper::checkAndClearWarmBootFlags() {
 
 bool DiscBackedBcmWarmBootHelper::storeWarmBootState(
     const folly::dynamic& switchState) {
-  warmBootStateWritten_ =
-      dumpStateToFile(warmBootSwitchStateFile(), switchState);
+  if (FLAGS_binary_switch_state_file) {
+    warmBootStateWritten_ =
+        dumpStateSnapshotToFile(warmBootSwitchStateFile(), switchState);
+  } else {
+    warmBootStateWritten_ =
+        dumpStateToFile(warmBootSwitchStateFile(), switchState);
+  }
   return warmBootStateWritten_;
 }
 
 folly::dynamic DiscBackedBcmWarmBootHelper::getWarmBootState() const {
-  std::string warmBootJson;
-  auto ret = folly::readFile(warmBootSwitchStateFile().c_str(), warmBootJson);
-  sysCheckError(
-      ret, "Unable to read switch state from : ", warmBootSwitchStateFile());
-  return folly::parseJson(warmBootJson);
+  return readStateFile(warmBootSwitchStateFile());
 }
 
 } // namespace fboss
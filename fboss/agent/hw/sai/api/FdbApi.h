@@ -107,8 +107,9 @@ class FdbApi : public SaiApi<FdbApi> {
   }
   sai_status_t _getAttribute(
       const SaiFdbTraits::FdbEntry& fdbEntry,
-      sai_attribute_t* attr) const {
-    return api_->get_fdb_entry_attribute(fdbEntry.entry(), 1, attr);
+      sai_attribute_t* attr,
+      uint32_t count) const {
+    return api_->get_fdb_entry_attribute(fdbEntry.entry(), count, attr);
   }
   sai_status_t _setAttribute(
       const SaiFdbTraits::FdbEntry& fdbEntry,
@@ -67,8 +67,11 @@ class NextHopApi : public SaiApi<NextHopApi> {
   sai_status_t _remove(NextHopSaiId next_hop_id) {
     return api_->remove_next_hop(next_hop_id);
   }
-  sai_status_t _getAttribute(NextHopSaiId id, sai_attribute_t* attr) const {
-    return api_->get_next_hop_attribute(id, 1, attr);
+  sai_status_t _getAttribute(
+      NextHopSaiId id,
+      sai_attribute_t* attr,
+      uint32_t count) const {
+    return api_->get_next_hop_attribute(id, count, attr);
   }
   sai_status_t _setAttribute(NextHopSaiId id, const sai_attribute_t* attr) {
     return api_->set_next_hop_attribute(id, attr);
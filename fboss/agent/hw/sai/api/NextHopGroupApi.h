@@ -104,13 +104,17 @@ class NextHopGroupApi : public SaiApi<NextHopGroupApi> {
   sai_status_t _remove(NextHopGroupMemberSaiId next_hop_group_id) {
     return api_->remove_next_hop_group_member(next_hop_group_id);
   }
-  sai_status_t _getAttribute(NextHopGroupSaiId id, sai_attribute_t* attr)
-      const {
-    return api_->get_next_hop_group_attribute(id, 1, attr);
+  sai_status_t _getAttribute(
+      NextHopGroupSaiId id,
+      sai_attribute_t* attr,
+      uint32_t count) const {
+    return api_->get_next_hop_group_attribute(id, count, attr);
   }
-  sai_status_t _getAttribute(NextHopGroupMemberSaiId id, sai_attribute_t* attr)
-      const {
-    return api_->get_next_hop_group_member_attribute(id, 1, attr);
+  sai_status_t _getAttribute(
+      NextHopGroupMemberSaiId id,
+      sai_attribute_t* attr,
+      uint32_t count) const {
+    return api_->get_next_hop_group_member_attribute(id, count, attr);
   }
   sai_status_t _setAttribute(
       NextHopGroupSaiId id,
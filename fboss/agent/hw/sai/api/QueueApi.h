@@ -79,8 +79,11 @@ class QueueApi : public SaiApi<QueueApi> {
   sai_status_t _remove(QueueSaiId id) {
     return api_->remove_queue(id);
   }
-  sai_status_t _getAttribute(QueueSaiId id, sai_attribute_t* attr) const {
-    return api_->get_queue_attribute(id, 1, attr);
+  sai_status_t _getAttribute(
+      QueueSaiId id,
+      sai_attribute_t* attr,
+      uint32_t count) const {
+    return api_->get_queue_attribute(id, count, attr);
   }
   sai_status_t _setAttribute(QueueSaiId id, const sai_attribute_t* attr) {
     return api_->set_queue_attribute(id, attr);
@@ -107,8 +107,9 @@ class RouteApi : public SaiApi<RouteApi> {
   }
   sai_status_t _getAttribute(
       const SaiRouteTraits::RouteEntry& routeEntry,
-      sai_attribute_t* attr) const {
-    return api_->get_route_entry_attribute(routeEntry.entry(), 1, attr);
+      sai_attribute_t* attr,
+      uint32_t count) const {
+    return api_->get_route_entry_attribute(routeEntry.entry(), count, attr);
   }
   sai_status_t _setAttribute(
       const SaiRouteTraits::RouteEntry& routeEntry,
@@ -116,6 +117,53 @@ class RouteApi : public SaiApi<RouteApi> {
     return api_->set_route_entry_attribute(routeEntry.entry(), attr);
   }
 
+  sai_status_t _bulkCreate(
+      const std::vector<SaiRouteTraits::RouteEntry>& routeEntries,
+      const uint32_t* attrCounts,
+      sai_attribute_t** attrLists,
+      sai_status_t* objectStatuses) {
+    auto entries = saiRouteEntries(routeEntries);
+    return api_->create_route_entries(
+        entries.size(),
+        entries.data(),
+        attrCounts,
+        const_cast<const sai_attribute_t**>(attrLists),
+        SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR,
+        objectStatuses);
+  }
+  sai_status_t _bulkRemove(
+      const std::vector<SaiRouteTraits::RouteEntry>& routeEntries,
+      sai_status_t* objectStatuses) {
+    auto entries = saiRouteEntries(routeEntries);
+    return api_->remove_route_entries(
+        entries.size(),
+        entries.data(),
+        SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR,
+        objectStatuses);
+  }
+  sai_status_t _bulkSetAttribute(
+      const std::vector<SaiRouteTraits::RouteEntry>& routeEntries,
+      const sai_attribute_t* attrs,
+      sai_status_t* objectStatuses) {
+    auto entries = saiRouteEntries(routeEntries);
+    return api_->set_route_entries_attribute(
+        entries.size(),
+        entries.data(),
+        attrs,
+        SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR,
+        objectStatuses);
+  }
+
+  static std::vector<sai_route_entry_t> saiRouteEntries(
+      const std::vector<SaiRouteTraits::RouteEntry>& routeEntries) {
+    std::vector<sai_route_entry_t> entries;
+    entries.reserve(routeEntries.size());
+    for (const auto& routeEntry : routeEntries) {
+      entries.push_back(*routeEntry.entry());
+    }
+    return entries;
+  }
+
   sai_route_api_t* api_;
   friend class SaiApi<RouteApi>;
 };
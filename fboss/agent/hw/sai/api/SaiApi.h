@@ -21,7 +21,9 @@
 #include <boost/variant.hpp>
 
 #include <exception>
+#include <optional>
 #include <stdexcept>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
@@ -108,6 +110,98 @@ class SaiApi {
                << "]:" << folly::logging::objectToString(key);
   }
 
+  /*
+   * Bulk versions of create2, remove2 and setAttribute2 for objects whose
+   * AdapterKey is an entry struct (routes, neighbors, ...).
+   *
+   * An api implementation may back these with the SAI bulk entry points
+   * (e.g. create_route_entries) by providing _bulkCreate, _bulkRemove and
+   * _bulkSetAttribute. Otherwise they fall back to one SAI call per object.
+   * Either way, objects are processed in order, and processing stops at the
+   * first object that fails, which is reported by throwing a SaiApiError.
+   * Objects before the failed one have been programmed, the remaining ones
+   * have not. Callers which need to know which objects were programmed when
+   * an error is thrown can pass objectStatuses, which is filled with the
+   * status of each object (SAI_STATUS_NOT_EXECUTED for unprocessed ones).
+   */
+  template <typename SaiObjectTraits>
+  std::enable_if_t<AdapterKeyIsEntryStruct<SaiObjectTraits>::value, void>
+  bulkCreate2(
+      const std::vector<typename SaiObjectTraits::AdapterKey>& entries,
+      const std::vector<typename SaiObjectTraits::CreateAttributes>&
+          createAttributes,
+      std::vector<sai_status_t>* objectStatuses = nullptr) {
+    static_assert(
+        std::is_same_v<typename SaiObjectTraits::SaiApiT, ApiT>,
+        "invalid traits for the api");
+    CHECK_EQ(entries.size(), createAttributes.size());
+    std::vector<sai_status_t> statuses;
+    if (!objectStatuses) {
+      objectStatuses = &statuses;
+    }
+    objectStatuses->assign(entries.size(), SAI_STATUS_NOT_EXECUTED);
+    if (entries.empty()) {
+      return;
+    }
+    std::vector<std::vector<sai_attribute_t>> saiAttributeTs;
+    std::vector<uint32_t> attrCounts;
+    std::vector<sai_attribute_t*> attrLists;
+    saiAttributeTs.reserve(entries.size());
+    attrCounts.reserve(entries.size());
+    attrLists.reserve(entries.size());
+    for (const auto& attributes : createAttributes) {
+      saiAttributeTs.push_back(saiAttrs(attributes));
+      attrCounts.push_back(saiAttributeTs.back().size());
+      attrLists.push_back(saiAttributeTs.back().data());
+    }
+    sai_status_t status = impl()._bulkCreate(
+        entries, attrCounts.data(), attrLists.data(), objectStatuses->data());
+    bulkCheckError(
+        status, *objectStatuses, "Failed to bulk create sai entity");
+    XLOG(DBG5) << "created " << entries.size() << " sai objects ["
+               << saiApiTypeToString(ApiT::ApiType) << "]";
+  }
+
+  template <typename AdapterKeyT>
+  void bulkRemove2(
+      const std::vector<AdapterKeyT>& entries,
+      std::vector<sai_status_t>* objectStatuses = nullptr) {
+    std::vector<sai_status_t> statuses;
+    if (!objectStatuses) {
+      objectStatuses = &statuses;
+    }
+    objectStatuses->assign(entries.size(), SAI_STATUS_NOT_EXECUTED);
+    if (entries.empty()) {
+      return;
+    }
+    sai_status_t status = impl()._bulkRemove(entries, objectStatuses->data());
+    bulkCheckError(
+        status, *objectStatuses, "Failed to bulk remove sai object");
+    XLOG(DBG5) << "removed " << entries.size() << " sai objects ["
+               << saiApiTypeToString(ApiT::ApiType) << "]";
+  }
+
+  // One attribute per object, as with setAttribute2
+  template <typename AdapterKeyT, typename AttrT>
+  void bulkSetAttribute2(
+      const std::vector<AdapterKeyT>& entries,
+      const std::vector<AttrT>& attrs) {
+    CHECK_EQ(entries.size(), attrs.size());
+    if (entries.empty()) {
+      return;
+    }
+    std::vector<sai_attribute_t> saiAttributeTs;
+    saiAttributeTs.reserve(attrs.size());
+    for (const auto& attr : attrs) {
+      saiAttributeTs.push_back(*saiAttr(attr));
+    }
+    std::vector<sai_status_t> objectStatuses(
+        entries.size(), SAI_STATUS_NOT_EXECUTED);
+    sai_status_t status = impl()._bulkSetAttribute(
+        entries, saiAttributeTs.data(), objectStatuses.data());
+    bulkCheckError(status, objectStatuses, "Failed to bulk set sai attribute");
+  }
+
   /*
    * We can do getAttribute on top of more complicated types than just
    * attributes. For example, if we overload on tuples and optionals, we
@@ -127,7 +221,7 @@ class SaiApi {
         "collection of SaiAttributes");
 
     sai_status_t status;
-    status = impl()._getAttribute(key, attr.saiAttr());
+    status = impl()._getAttribute(key, attr.saiAttr(), 1);
     /*
      * If this is a list attribute and we have not allocated enough
      * memory for the data coming from SAI, the Adapter will return
@@ -137,7 +231,7 @@ class SaiApi {
      */
     if (status == SAI_STATUS_BUFFER_OVERFLOW) {
       attr.realloc();
-      status = impl()._getAttribute(key, attr.saiAttr());
+      status = impl()._getAttribute(key, attr.saiAttr(), 1);
     }
     saiApiCheckError(status, ApiT::ApiType, "Failed to get sai attribute");
     return attr.value();
@@ -147,6 +241,12 @@ class SaiApi {
   template <typename AdapterKeyT, typename... AttrTs>
   auto getAttribute2(const AdapterKeyT& key, std::tuple<AttrTs...>& attrTuple) {
     // TODO: assert on All<IsSaiAttribute>
+    if constexpr (IsTupleOfSaiAttributes<std::tuple<AttrTs...>>::value) {
+      if (getAttributesTogether(key, attrTuple)) {
+        auto value = [](auto& attr) { return attributeValue(attr); };
+        return tupleMap(value, attrTuple);
+      }
+    }
     auto recurse = [&key, this](auto&& attr) {
       return getAttribute2(key, attr);
     };
@@ -169,10 +269,140 @@ class SaiApi {
     return impl()._setAttribute(key, saiAttr(attr));
   }
 
+ protected:
+  /*
+   * Default implementations of the bulk operations, which issue one SAI
+   * call per object. Apis whose adapter supports bulk operations hide these
+   * with their own.
+   */
+  template <typename AdapterKeyT>
+  sai_status_t _bulkCreate(
+      const std::vector<AdapterKeyT>& entries,
+      const uint32_t* attrCounts,
+      sai_attribute_t** attrLists,
+      sai_status_t* objectStatuses) {
+    for (size_t i = 0; i < entries.size(); ++i) {
+      objectStatuses[i] =
+          impl()._create(entries[i], attrCounts[i], attrLists[i]);
+      if (objectStatuses[i] != SAI_STATUS_SUCCESS) {
+        return objectStatuses[i];
+      }
+    }
+    return SAI_STATUS_SUCCESS;
+  }
+
+  template <typename AdapterKeyT>
+  sai_status_t _bulkRemove(
+      const std::vector<AdapterKeyT>& entries,
+      sai_status_t* objectStatuses) {
+    for (size_t i = 0; i < entries.size(); ++i) {
+      objectStatuses[i] = impl()._remove(entries[i]);
+      if (objectStatuses[i] != SAI_STATUS_SUCCESS) {
+        return objectStatuses[i];
+      }
+    }
+    return SAI_STATUS_SUCCESS;
+  }
+
+  template <typename AdapterKeyT>
+  sai_status_t _bulkSetAttribute(
+      const std::vector<AdapterKeyT>& entries,
+      const sai_attribute_t* attrs,
+      sai_status_t* objectStatuses) {
+    for (size_t i = 0; i < entries.size(); ++i) {
+      objectStatuses[i] = impl()._setAttribute(entries[i], &attrs[i]);
+      if (objectStatuses[i] != SAI_STATUS_SUCCESS) {
+        return objectStatuses[i];
+      }
+    }
+    return SAI_STATUS_SUCCESS;
+  }
+
  private:
   ApiT& impl() {
     return static_cast<ApiT&>(*this);
   }
+
+  /*
+   * Fetch every attribute of a tuple with a single SAI get call, instead of
+   * one call per attribute. This matters when loading many objects from the
+   * adapter, e.g. on warm boot. Returns false, leaving the attributes to be
+   * fetched one at a time, if the adapter can not return them all at once:
+   * typically because a list attribute needs a bigger buffer, which is only
+   * reallocated on the single attribute path.
+   */
+  template <typename AdapterKeyT, typename AttrTupleT>
+  bool getAttributesTogether(const AdapterKeyT& key, AttrTupleT& attrTuple) {
+    std::vector<sai_attribute_t> saiAttributeTs;
+    saiAttributeTs.reserve(std::tuple_size<AttrTupleT>::value);
+    tupleForEach(
+        [&saiAttributeTs](auto& attr) {
+          saiAttributeTs.push_back(*attributeToGet(attr).saiAttr());
+        },
+        attrTuple);
+    sai_status_t status = impl()._getAttribute(
+        key, saiAttributeTs.data(), saiAttributeTs.size());
+    if (status != SAI_STATUS_SUCCESS) {
+      return false;
+    }
+    size_t i = 0;
+    tupleForEach(
+        [&saiAttributeTs, &i](auto& attr) {
+          *attributeToGet(attr).saiAttr() = saiAttributeTs[i++];
+        },
+        attrTuple);
+    return true;
+  }
+
+  // Optional attributes are fetched like the others, as they are by the
+  // single attribute getAttribute2
+  template <typename AttrT>
+  static AttrT& attributeToGet(AttrT& attr) {
+    return attr;
+  }
+  template <typename AttrT>
+  static AttrT& attributeToGet(std::optional<AttrT>& attrOptional) {
+    if (!attrOptional) {
+      attrOptional = AttrT{};
+    }
+    return attrOptional.value();
+  }
+
+  template <typename AttrT>
+  static typename AttrT::ValueType attributeValue(AttrT& attr) {
+    return attr.value();
+  }
+  template <typename AttrT>
+  static std::optional<typename AttrT::ValueType> attributeValue(
+      std::optional<AttrT>& attrOptional) {
+    return std::optional<typename AttrT::ValueType>{attrOptional->value()};
+  }
+
+  template <typename... Args>
+  void bulkCheckError(
+      sai_status_t status,
+      const std::vector<sai_status_t>& objectStatuses,
+      const Args&... args) {
+    if (status == SAI_STATUS_SUCCESS) {
+      return;
+    }
+    // Report the status of the object which failed, if the adapter told us
+    for (size_t i = 0; i < objectStatuses.size(); ++i) {
+      if (objectStatuses[i] != SAI_STATUS_SUCCESS &&
+          objectStatuses[i] != SAI_STATUS_NOT_EXECUTED) {
+        saiApiCheckError(
+            objectStatuses[i],
+            ApiT::ApiType,
+            args...,
+            " (object ",
+            i,
+            " of ",
+            objectStatuses.size(),
+            ")");
+      }
+    }
+    saiApiCheckError(status, ApiT::ApiType, args...);
+  }
 };
 
 } // namespace fboss
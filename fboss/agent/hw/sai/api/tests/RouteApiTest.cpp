@@ -107,3 +107,57 @@ TEST_F(RouteApiTest, routeKeys) {
   EXPECT_EQ(routeKeys.size(), 1);
   EXPECT_EQ(routeKeys[0], r);
 }
+
+TEST_F(RouteApiTest, bulkCreateRemoveRoutes) {
+  std::vector<SaiRouteTraits::RouteEntry> entries;
+  std::vector<SaiRouteTraits::CreateAttributes> attributes;
+  for (int i = 0; i < 10; ++i) {
+    folly::CIDRNetwork prefix(
+        folly::IPAddress(folly::IPAddressV4::fromLongHBO(0x0a000000 + i)), 32);
+    entries.emplace_back(0, 0, prefix);
+    attributes.emplace_back(
+        SaiRouteTraits::Attributes::PacketAction{SAI_PACKET_ACTION_FORWARD},
+        SaiRouteTraits::Attributes::NextHopId(i + 1));
+  }
+  routeApi->bulkCreate2<SaiRouteTraits>(entries, attributes);
+  EXPECT_EQ(getObjectCount<SaiRouteTraits>(0), 10);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(
+        routeApi->getAttribute2(
+            entries[i], SaiRouteTraits::Attributes::NextHopId()),
+        i + 1);
+  }
+
+  std::vector<SaiRouteTraits::Attributes::NextHopId> nextHops;
+  for (int i = 0; i < 10; ++i) {
+    nextHops.emplace_back(42);
+  }
+  routeApi->bulkSetAttribute2(entries, nextHops);
+  for (const auto& entry : entries) {
+    EXPECT_EQ(
+        routeApi->getAttribute2(entry, SaiRouteTraits::Attributes::NextHopId()),
+        42);
+  }
+
+  routeApi->bulkRemove2(entries);
+  EXPECT_EQ(getObjectCount<SaiRouteTraits>(0), 0);
+}
+
+TEST_F(RouteApiTest, bulkRemoveStopsOnError) {
+  std::vector<SaiRouteTraits::RouteEntry> entries;
+  for (int i = 0; i < 3; ++i) {
+    folly::CIDRNetwork prefix(
+        folly::IPAddress(folly::IPAddressV4::fromLongHBO(0x0a000000 + i)), 32);
+    entries.emplace_back(0, 0, prefix);
+    SaiRouteTraits::Attributes::PacketAction packetActionAttribute{
+        SAI_PACKET_ACTION_DROP};
+    routeApi->create2<SaiRouteTraits>(
+        entries.back(), {packetActionAttribute, std::nullopt});
+  }
+  // The middle route doesn't exist, so the last one must be left alone
+  routeApi->remove2(entries[1]);
+  EXPECT_THROW(routeApi->bulkRemove2(entries), SaiApiError);
+  auto routeKeys = getObjectKeys<SaiRouteTraits>(0);
+  ASSERT_EQ(routeKeys.size(), 1);
+  EXPECT_EQ(routeKeys[0], entries[2]);
+}
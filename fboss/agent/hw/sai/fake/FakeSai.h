@@ -26,7 +26,10 @@
 #include "fboss/agent/hw/sai/fake/FakeSaiVirtualRouter.h"
 #include "fboss/agent/hw/sai/fake/FakeSaiVlan.h"
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
 
 extern "C" {
 #include <sai.h>
@@ -54,6 +57,22 @@ struct FakeSai {
   FakeVirtualRouterManager vrm;
   FakeVlanManager vm;
   bool initialized = false;
+  /*
+   * Route entries may be programmed from several threads at once, as with
+   * a real adapter, so the route functions serialize access to rm.
+   * routeLatency is the time each route create or remove takes, zero by
+   * default. Benchmarks set it to model an adapter writing to hardware.
+   * Tests may set routeProgrammingHook, which is called before each route
+   * create or remove takes routeMutex.
+   */
+  std::mutex routeMutex;
+  std::chrono::nanoseconds routeLatency{0};
+  std::function<void()> routeProgrammingHook;
+  /*
+   * Called for each packet sent through the hostif api, from the thread
+   * sending it. Tests use it to see when packets reach the adapter.
+   */
+  std::function<void()> packetTxHook;
 };
 
 } // namespace fboss
@@ -36,6 +36,10 @@ sai_status_t send_hostif_fn(
   }
   XLOG(INFO) << "Sending packet on port : " << std::hex << tx_port
              << " tx type : " << tx_type;
+  auto fs = FakeSai::getInstance();
+  if (fs->packetTxHook) {
+    fs->packetTxHook();
+  }
 
   return SAI_STATUS_SUCCESS;
 }
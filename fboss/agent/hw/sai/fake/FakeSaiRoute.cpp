@@ -14,31 +14,73 @@
 
 #include <folly/logging/xlog.h>
 
+#include <chrono>
+#include <mutex>
+
 using facebook::fboss::FakeRoute;
+using facebook::fboss::FakeRouteEntry;
 using facebook::fboss::FakeSai;
 
+namespace {
+FakeRouteEntry routeKey(const sai_route_entry_t* route_entry) {
+  return std::make_tuple(
+      route_entry->switch_id,
+      route_entry->vr_id,
+      facebook::fboss::fromSaiIpPrefix(route_entry->destination));
+}
+
+sai_status_t setRouteAttribute(FakeRoute& fr, const sai_attribute_t* attr) {
+  switch (attr->id) {
+    case SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION:
+      fr.packetAction = attr->value.s32;
+      break;
+    case SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID:
+      fr.nextHopId = attr->value.oid;
+      break;
+    default:
+      return SAI_STATUS_INVALID_PARAMETER;
+  }
+  return SAI_STATUS_SUCCESS;
+}
+
+// Spend the time a hardware table write takes, see FakeSai::routeLatency
+void routeProgrammingDelay(const FakeSai& fs) {
+  if (fs.routeProgrammingHook) {
+    fs.routeProgrammingHook();
+  }
+  if (fs.routeLatency.count() == 0) {
+    return;
+  }
+  auto end = std::chrono::steady_clock::now() + fs.routeLatency;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+} // namespace
+
 sai_status_t create_route_entry_fn(
     const sai_route_entry_t* route_entry,
     uint32_t attr_count,
     const sai_attribute_t* attr_list) {
   auto fs = FakeSai::getInstance();
-  auto re = std::make_tuple(
-      route_entry->switch_id,
-      route_entry->vr_id,
-      facebook::fboss::fromSaiIpPrefix(route_entry->destination));
+  auto re = routeKey(route_entry);
+  routeProgrammingDelay(*fs);
+  std::lock_guard<std::mutex> g(fs->routeMutex);
+  if (fs->rm.map().count(re)) {
+    return SAI_STATUS_ITEM_ALREADY_EXISTS;
+  }
   fs->rm.create(re);
+  auto& fr = fs->rm.get(re);
   for (int i = 0; i < attr_count; ++i) {
-    set_route_entry_attribute_fn(route_entry, &attr_list[i]);
+    setRouteAttribute(fr, &attr_list[i]);
   }
   return SAI_STATUS_SUCCESS;
 }
 
 sai_status_t remove_route_entry_fn(const sai_route_entry_t* route_entry) {
   auto fs = FakeSai::getInstance();
-  auto re = std::make_tuple(
-      route_entry->switch_id,
-      route_entry->vr_id,
-      facebook::fboss::fromSaiIpPrefix(route_entry->destination));
+  auto re = routeKey(route_entry);
+  routeProgrammingDelay(*fs);
+  std::lock_guard<std::mutex> g(fs->routeMutex);
   if (fs->rm.remove(re) == 0) {
     return SAI_STATUS_FAILURE;
   }
@@ -49,22 +91,9 @@ sai_status_t set_route_entry_attribute_fn(
     const sai_route_entry_t* route_entry,
     const sai_attribute_t* attr) {
   auto fs = FakeSai::getInstance();
-  auto re = std::make_tuple(
-      route_entry->switch_id,
-      route_entry->vr_id,
-      facebook::fboss::fromSaiIpPrefix(route_entry->destination));
-  auto& fr = fs->rm.get(re);
-  switch (attr->id) {
-    case SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION:
-      fr.packetAction = attr->value.s32;
-      break;
-    case SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID:
-      fr.nextHopId = attr->value.oid;
-      break;
-    default:
-      return SAI_STATUS_INVALID_PARAMETER;
-  }
-  return SAI_STATUS_SUCCESS;
+  auto re = routeKey(route_entry);
+  std::lock_guard<std::mutex> g(fs->routeMutex);
+  return setRouteAttribute(fs->rm.get(re), attr);
 }
 
 sai_status_t get_route_entry_attribute_fn(
@@ -72,10 +101,8 @@ sai_status_t get_route_entry_attribute_fn(
     uint32_t attr_count,
     sai_attribute_t* attr_list) {
   auto fs = FakeSai::getInstance();
-  auto re = std::make_tuple(
-      route_entry->switch_id,
-      route_entry->vr_id,
-      facebook::fboss::fromSaiIpPrefix(route_entry->destination));
+  auto re = routeKey(route_entry);
+  std::lock_guard<std::mutex> g(fs->routeMutex);
   const auto& fr = fs->rm.get(re);
   for (int i = 0; i < attr_count; ++i) {
     switch (attr_list[i].id) {
@@ -92,6 +119,66 @@ sai_status_t get_route_entry_attribute_fn(
   return SAI_STATUS_SUCCESS;
 }
 
+namespace {
+/*
+ * Apply op to each of the object_count route entries in turn, recording the
+ * per object status, the way a bulk capable adapter would.
+ */
+template <typename Op>
+sai_status_t bulk_route_op(
+    uint32_t object_count,
+    sai_bulk_op_error_mode_t mode,
+    sai_status_t* object_statuses,
+    Op op) {
+  sai_status_t status = SAI_STATUS_SUCCESS;
+  for (uint32_t i = 0; i < object_count; ++i) {
+    if (status != SAI_STATUS_SUCCESS &&
+        mode == SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR) {
+      object_statuses[i] = SAI_STATUS_NOT_EXECUTED;
+      continue;
+    }
+    object_statuses[i] = op(i);
+    if (object_statuses[i] != SAI_STATUS_SUCCESS) {
+      status = SAI_STATUS_FAILURE;
+    }
+  }
+  return status;
+}
+} // namespace
+
+sai_status_t create_route_entries_fn(
+    uint32_t object_count,
+    const sai_route_entry_t* route_entry,
+    const uint32_t* attr_count,
+    const sai_attribute_t** attr_list,
+    sai_bulk_op_error_mode_t mode,
+    sai_status_t* object_statuses) {
+  return bulk_route_op(object_count, mode, object_statuses, [&](uint32_t i) {
+    return create_route_entry_fn(&route_entry[i], attr_count[i], attr_list[i]);
+  });
+}
+
+sai_status_t remove_route_entries_fn(
+    uint32_t object_count,
+    const sai_route_entry_t* route_entry,
+    sai_bulk_op_error_mode_t mode,
+    sai_status_t* object_statuses) {
+  return bulk_route_op(object_count, mode, object_statuses, [&](uint32_t i) {
+    return remove_route_entry_fn(&route_entry[i]);
+  });
+}
+
+sai_status_t set_route_entries_attribute_fn(
+    uint32_t object_count,
+    const sai_route_entry_t* route_entry,
+    const sai_attribute_t* attr_list,
+    sai_bulk_op_error_mode_t mode,
+    sai_status_t* object_statuses) {
+  return bulk_route_op(object_count, mode, object_statuses, [&](uint32_t i) {
+    return set_route_entry_attribute_fn(&route_entry[i], &attr_list[i]);
+  });
+}
+
 namespace facebook {
 namespace fboss {
 
@@ -102,6 +189,9 @@ void populate_route_api(sai_route_api_t** route_api) {
   _route_api.remove_route_entry = &remove_route_entry_fn;
   _route_api.set_route_entry_attribute = &set_route_entry_attribute_fn;
   _route_api.get_route_entry_attribute = &get_route_entry_attribute_fn;
+  _route_api.create_route_entries = &create_route_entries_fn;
+  _route_api.remove_route_entries = &remove_route_entries_fn;
+  _route_api.set_route_entries_attribute = &set_route_entries_attribute_fn;
   *route_api = &_route_api;
 }
 
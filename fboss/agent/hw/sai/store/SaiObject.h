@@ -157,7 +157,10 @@ typename std::
  *    SaiObject manages a given SAI object. (N.B., there is no general hard
  *    guarantee for this property -- a user could load the same SaiObject more
  *    than once).
- * In all three cases, (excepting the unlikely event of moving from a non-live
+ * 4. By adopting an object which the caller already created in the SAI
+ *    adapter with the given AdapterKey, AdapterHostKey and CreateAttributes.
+ *    This is used to wrap objects created with a bulk create.
+ * In all four cases, (excepting the unlikely event of moving from a non-live
  * SaiObject), the newly constructed SaiObject is live and stores the
  * appropriate values of AdapterHostKey, AdapterKey, and CreateAttributes.
  *
@@ -198,6 +201,16 @@ class SaiObject {
     live_ = true;
   }
 
+  // Adopt an object which already exists in the adapter
+  SaiObject(
+      const typename SaiObjectTraits::AdapterKey& adapterKey,
+      const typename SaiObjectTraits::AdapterHostKey& adapterHostKey,
+      const typename SaiObjectTraits::CreateAttributes& attributes)
+      : live_(true),
+        adapterKey_(adapterKey),
+        adapterHostKey_(adapterHostKey),
+        attributes_(attributes) {}
+
   // Forbid copy construction and copy assignment
   SaiObject(const SaiObject& other) = delete;
   SaiObject& operator=(const SaiObject& other) = delete;
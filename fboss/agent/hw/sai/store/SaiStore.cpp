@@ -9,8 +9,21 @@
  */
 
 #include "fboss/agent/hw/sai/store/SaiStore.h"
+#include "fboss/lib/ParallelFor.h"
 
 #include <folly/Singleton.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <functional>
+
+DEFINE_int32(
+    sai_store_reload_threads,
+    4,
+    "Number of threads used to load the objects of different types from the "
+    "SAI adapter when reloading the SaiStore on warm boot");
 
 namespace {
 struct singleton_tag_type {};
@@ -38,7 +51,32 @@ void SaiStore::setSwitchId(sai_object_id_t switchId) {
 }
 
 void SaiStore::reload() {
-  tupleForEach([](auto& store) { store.reload(); }, stores_);
+  // Loading an object only reads its attributes, and those of the objects it
+  // is keyed by, from the adapter, never from the other stores: e.g. a next
+  // hop group's key is built from its members as the adapter reports them.
+  // So there is no ordering to respect between the types: parents and
+  // children are only ordered when the objects are released.
+  std::vector<std::function<void()>> reloads;
+  tupleForEach(
+      [&reloads](auto& store) {
+        reloads.push_back([&store]() { store.reload(); });
+      },
+      stores_);
+
+  auto numThreads = std::max(FLAGS_sai_store_reload_threads, 1);
+  folly::CPUThreadPoolExecutor executor(
+      numThreads, std::make_shared<folly::NamedThreadFactory>("SaiReload"));
+  parallelFor(&executor, reloads.size(), numThreads, [&reloads](size_t i) {
+    reloads[i]();
+  });
+
+  tupleForEach(
+      [](const auto& store) {
+        XLOG(INFO) << "Reloaded " << store.reloadedObjects() << " "
+                   << store.objectTypeName() << " objects in "
+                   << store.reloadTime().count() << "us";
+      },
+      stores_);
 }
 
 void SaiStore::release() {
@@ -9,18 +9,25 @@
  */
 #pragma once
 
+#include "fboss/agent/hw/sai/api/LoggingUtil.h"
 #include "fboss/agent/hw/sai/api/SaiApiTable.h"
 #include "fboss/agent/hw/sai/api/SaiObjectApi.h"
 #include "fboss/agent/hw/sai/store/SaiObject.h"
 #include "fboss/lib/RefMap.h"
 
+#include <gflags/gflags.h>
+
+#include <chrono>
 #include <memory>
 #include <optional>
+#include <vector>
 
 extern "C" {
 #include <sai.h>
 }
 
+DECLARE_int32(sai_store_reload_threads);
+
 namespace facebook {
 namespace fboss {
 
@@ -54,7 +61,9 @@ class SaiObjectStore {
       XLOG(FATAL)
           << "Attempted to reload() on a SaiObjectStore without a switchId";
     }
+    auto start = std::chrono::steady_clock::now();
     auto keys = getObjectKeys<SaiObjectTraits>(switchId_.value());
+    warmBootHandles_.reserve(warmBootHandles_.size() + keys.size());
     for (const auto k : keys) {
       ObjectType obj(k);
       auto adapterHostKey = obj.adapterHostKey();
@@ -64,6 +73,23 @@ class SaiObjectStore {
       }
       warmBootHandles_.push_back(ins.first);
     }
+    reloadedObjects_ = keys.size();
+    reloadTime_ = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+  }
+
+  /*
+   * The number of objects loaded by the last reload(), and how long it took
+   */
+  size_t reloadedObjects() const {
+    return reloadedObjects_;
+  }
+  std::chrono::microseconds reloadTime() const {
+    return reloadTime_;
+  }
+
+  static folly::StringPiece objectTypeName() {
+    return saiObjectTypeToString(SaiObjectTraits::ObjectType);
   }
 
   std::shared_ptr<ObjectType> setObject(
@@ -77,6 +103,79 @@ class SaiObjectStore {
     return ins.first;
   }
 
+  /*
+   * Bulk version of setObject for objects keyed by an entry struct (routes,
+   * neighbors, ...). The keys must be distinct. Objects which already exist
+   * have their attributes updated one by one as in setObject, while all of
+   * the new objects are created in the adapter with a single bulk create.
+   *
+   * Returns the objects in the same order as the keys. If the bulk create
+   * fails, the objects which were created are still added to the store
+   * before the error is rethrown.
+   */
+  template <typename T = SaiObjectTraits>
+  std::enable_if_t<
+      AdapterKeyIsEntryStruct<T>::value,
+      std::vector<std::shared_ptr<ObjectType>>>
+  setObjects(
+      const std::vector<typename T::AdapterHostKey>& adapterHostKeys,
+      const std::vector<typename T::CreateAttributes>& attributes) {
+    CHECK_EQ(adapterHostKeys.size(), attributes.size());
+    std::vector<std::shared_ptr<ObjectType>> objects(adapterHostKeys.size());
+    std::vector<typename T::AdapterKey> newKeys;
+    std::vector<typename T::CreateAttributes> newAttributes;
+    std::vector<size_t> newIndices;
+    for (size_t i = 0; i < adapterHostKeys.size(); ++i) {
+      objects[i] = objects_.ref(adapterHostKeys[i]);
+      if (objects[i]) {
+        objects[i]->setAttributes(attributes[i]);
+      } else {
+        newKeys.push_back(adapterHostKeys[i]);
+        newAttributes.push_back(attributes[i]);
+        newIndices.push_back(i);
+      }
+    }
+    auto adopt = [&](size_t i) {
+      objects[newIndices[i]] = addCreatedObject(newKeys[i], newAttributes[i]);
+    };
+    auto& api = SaiApiTable::getInstance()->getApi<typename T::SaiApiT>();
+    std::vector<sai_status_t> statuses;
+    try {
+      api.template bulkCreate2<T>(newKeys, newAttributes, &statuses);
+    } catch (const SaiApiError&) {
+      // Take ownership of the objects which were created before the failure,
+      // so they are not leaked in the adapter and a retry finds them here.
+      for (size_t i = 0; i < statuses.size(); ++i) {
+        if (statuses[i] == SAI_STATUS_SUCCESS) {
+          adopt(i);
+        }
+      }
+      throw;
+    }
+    for (size_t i = 0; i < newKeys.size(); ++i) {
+      adopt(i);
+    }
+    return objects;
+  }
+
+  /*
+   * Add an object keyed by an entry struct which has already been created in
+   * the adapter, e.g. by a bulk create issued outside of the store. The
+   * store owns the object from then on, as if setObject had created it.
+   */
+  template <typename T = SaiObjectTraits>
+  std::enable_if_t<
+      AdapterKeyIsEntryStruct<T>::value,
+      std::shared_ptr<ObjectType>>
+  addCreatedObject(
+      const typename T::AdapterKey& adapterKey,
+      const typename T::CreateAttributes& attributes) {
+    // Entry structs have AdapterKey == AdapterHostKey
+    auto ins =
+        objects_.refOrEmplace(adapterKey, adapterKey, adapterKey, attributes);
+    return ins.first;
+  }
+
   std::shared_ptr<ObjectType> get(
       const typename SaiObjectTraits::AdapterHostKey& adapterHostKey) {
     return objects_.ref(adapterHostKey);
@@ -91,6 +190,8 @@ class SaiObjectStore {
   UnorderedRefMap<typename SaiObjectTraits::AdapterHostKey, ObjectType>
       objects_;
   std::vector<std::shared_ptr<ObjectType>> warmBootHandles_;
+  size_t reloadedObjects_{0};
+  std::chrono::microseconds reloadTime_{0};
 };
 
 } // namespace detail
@@ -118,6 +219,11 @@ class SaiStore {
 
   /*
    * Reload the SaiStore from the current SAI state via SAI api calls.
+   *
+   * Each type of object is loaded independently of the others, so the
+   * SaiObjectStores are reloaded concurrently, on up to
+   * --sai_store_reload_threads threads. The time taken to load each type is
+   * logged.
    */
   void reload();
 
@@ -14,9 +14,12 @@
 #include "fboss/agent/hw/sai/store/SaiStore.h"
 
 #include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 using namespace facebook::fboss;
 
 class NextHopGroupStoreTest : public ::testing::Test {
@@ -100,6 +103,47 @@ TEST_F(NextHopGroupStoreTest, loadNextHopGroup) {
   EXPECT_EQ(got2->adapterKey(), nextHopGroupMemberId2);
 }
 
+TEST_F(NextHopGroupStoreTest, loadNextHopGroupsConcurrently) {
+  // The groups and their members are reloaded by different threads, in no
+  // particular order, yet each group is found by its members' next hops.
+  gflags::FlagSaver flagSaver;
+  FLAGS_sai_store_reload_threads = 16;
+  std::vector<NextHopGroupSaiId> groupIds;
+  std::vector<std::vector<NextHopSaiId>> nextHopIds;
+  std::vector<std::vector<NextHopGroupMemberSaiId>> memberIds;
+  for (uint32_t i = 0; i < 10; ++i) {
+    groupIds.push_back(createNextHopGroup());
+    nextHopIds.emplace_back();
+    memberIds.emplace_back();
+    for (uint32_t j = 0; j <= i; ++j) {
+      auto ip = folly::IPAddressV4::fromLongHBO(0x0a000000 + (i << 8) + j);
+      nextHopIds[i].push_back(createNextHop(folly::IPAddress(ip)));
+      memberIds[i].push_back(
+          createNextHopGroupMember(groupIds[i], nextHopIds[i][j]));
+    }
+  }
+
+  SaiStore s(0);
+  s.reload();
+  auto& store = s.get<SaiNextHopGroupTraits>();
+  auto& memberStore = s.get<SaiNextHopGroupMemberTraits>();
+  for (uint32_t i = 0; i < groupIds.size(); ++i) {
+    SaiNextHopGroupTraits::AdapterHostKey k;
+    for (uint32_t j = 0; j <= i; ++j) {
+      auto ip = folly::IPAddressV4::fromLongHBO(0x0a000000 + (i << 8) + j);
+      k.insert({42, folly::IPAddress(ip)});
+      auto member = memberStore.get(
+          SaiNextHopGroupMemberTraits::AdapterHostKey{groupIds[i],
+                                                      nextHopIds[i][j]});
+      ASSERT_TRUE(member);
+      EXPECT_EQ(member->adapterKey(), memberIds[i][j]);
+    }
+    auto got = store.get(k);
+    ASSERT_TRUE(got);
+    EXPECT_EQ(got->adapterKey(), groupIds[i]);
+  }
+}
+
 TEST_F(NextHopGroupStoreTest, nextHopGroupLoadCtor) {
   auto id = createNextHopGroup();
   SaiObject<SaiNextHopGroupTraits> obj(id);
@@ -108,3 +108,82 @@ TEST_F(RouteStoreTest, routeSetToPunt) {
   EXPECT_EQ(GET_OPT_ATTR(Route, NextHopId, obj.attributes()), 5);
   */
 }
+
+TEST_F(RouteStoreTest, bulkSetObjects) {
+  std::shared_ptr<SaiStore> s = SaiStore::getInstance();
+  s->setSwitchId(0);
+  auto& store = s->get<SaiRouteTraits>();
+
+  SaiRouteTraits::RouteEntry existing(
+      0, 0, folly::CIDRNetwork(folly::IPAddress("10.10.10.0"), 24));
+  auto existingRoute = store.setObject(
+      existing, SaiRouteTraits::CreateAttributes{SAI_PACKET_ACTION_DROP, 1});
+
+  std::vector<SaiRouteTraits::RouteEntry> entries{
+      SaiRouteTraits::RouteEntry(
+          0, 0, folly::CIDRNetwork(folly::IPAddress("10.10.11.0"), 24)),
+      existing,
+      SaiRouteTraits::RouteEntry(
+          0, 0, folly::CIDRNetwork(folly::IPAddress("10.10.12.0"), 24))};
+  std::vector<SaiRouteTraits::CreateAttributes> attributes{
+      {SAI_PACKET_ACTION_FORWARD, 5},
+      {SAI_PACKET_ACTION_FORWARD, 6},
+      {SAI_PACKET_ACTION_FORWARD, 7}};
+  auto routes = store.setObjects(entries, attributes);
+  ASSERT_EQ(routes.size(), 3);
+  EXPECT_EQ(routes[1], existingRoute);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(routes[i]->adapterKey(), entries[i]);
+    EXPECT_EQ(GET_OPT_ATTR(Route, NextHopId, routes[i]->attributes()), i + 5);
+    EXPECT_EQ(
+        saiApiTable->routeApi().getAttribute2(
+            entries[i], SaiRouteTraits::Attributes::NextHopId{}),
+        i + 5);
+  }
+  EXPECT_EQ(getObjectCount<SaiRouteTraits>(0), 3);
+
+  // Dropping the last reference removes the route from the adapter
+  routes.clear();
+  existingRoute.reset();
+  EXPECT_EQ(getObjectCount<SaiRouteTraits>(0), 0);
+}
+
+TEST_F(RouteStoreTest, bulkSetObjectsPartialFailure) {
+  std::shared_ptr<SaiStore> s = SaiStore::getInstance();
+  s->setSwitchId(0);
+  auto& store = s->get<SaiRouteTraits>();
+  auto& routeApi = saiApiTable->routeApi();
+
+  std::vector<SaiRouteTraits::RouteEntry> entries;
+  std::vector<SaiRouteTraits::CreateAttributes> attributes;
+  for (int i = 0; i < 3; ++i) {
+    entries.emplace_back(
+        0,
+        0,
+        folly::CIDRNetwork(
+            folly::IPAddress(folly::IPAddressV4::fromLongHBO(0x0a000000 + i)),
+            32));
+    attributes.push_back({SAI_PACKET_ACTION_FORWARD, i + 5});
+  }
+  // Created behind the store's back, so creating it again fails
+  routeApi.create2<SaiRouteTraits>(entries[1], attributes[1]);
+  EXPECT_THROW(store.setObjects(entries, attributes), SaiApiError);
+
+  // The route created before the failure is owned by the store
+  auto created = store.get(entries[0]);
+  ASSERT_TRUE(created);
+  EXPECT_EQ(created->adapterKey(), entries[0]);
+  EXPECT_FALSE(store.get(entries[1]));
+  EXPECT_FALSE(store.get(entries[2]));
+  EXPECT_EQ(getObjectCount<SaiRouteTraits>(0), 2);
+
+  // So a retry without the conflicting route succeeds
+  routeApi.remove2(entries[1]);
+  auto routes = store.setObjects(entries, attributes);
+  ASSERT_EQ(routes.size(), 3);
+  EXPECT_EQ(routes[0], created);
+  EXPECT_EQ(getObjectCount<SaiRouteTraits>(0), 3);
+  created.reset();
+  routes.clear();
+  EXPECT_EQ(getObjectCount<SaiRouteTraits>(0), 0);
+}
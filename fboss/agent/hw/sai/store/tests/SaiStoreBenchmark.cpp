@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/IPAddressV4.h>
+#include <folly/MacAddress.h>
+
+#include "fboss/agent/hw/sai/api/NeighborApi.h"
+#include "fboss/agent/hw/sai/api/NextHopApi.h"
+#include "fboss/agent/hw/sai/api/RouteApi.h"
+#include "fboss/agent/hw/sai/fake/FakeSai.h"
+#include "fboss/agent/hw/sai/store/SaiStore.h"
+
+using namespace facebook::fboss;
+using folly::IPAddressV4;
+
+DEFINE_int32(
+    object_count,
+    100000,
+    "Number of routes, and of neighbors and next hops, in the fake adapter "
+    "to reload the store from");
+
+namespace {
+
+/*
+ * Fill the fake adapter with objects, as if the agent had programmed them
+ * before a warm boot.
+ */
+void createObjects() {
+  auto saiApiTable = SaiApiTable::getInstance();
+  auto& routeApi = saiApiTable->routeApi();
+  auto& neighborApi = saiApiTable->neighborApi();
+  auto& nextHopApi = saiApiTable->nextHopApi();
+  SaiNeighborTraits::Attributes::DstMac dstMac{
+      folly::MacAddress("42:42:42:42:42:42")};
+  for (uint32_t i = 0; i < FLAGS_object_count; ++i) {
+    // 11.0.0.0/24, 11.0.1.0/24, ...
+    auto network = IPAddressV4::fromLongHBO(0x0b000000 + (i << 8));
+    SaiRouteTraits::RouteEntry route(0, 0, folly::CIDRNetwork(network, 24));
+    routeApi.create2<SaiRouteTraits>(route, {SAI_PACKET_ACTION_FORWARD, i});
+    // 12.0.0.0, 12.0.0.1, ...
+    auto ip = IPAddressV4::fromLongHBO(0x0c000000 + i);
+    SaiNeighborTraits::NeighborEntry neighbor(0, 0, ip);
+    neighborApi.create2<SaiNeighborTraits>(neighbor, {dstMac});
+    nextHopApi.create2<SaiNextHopTraits>({SAI_NEXT_HOP_TYPE_IP, 42, ip}, 0);
+  }
+}
+
+void reload(int32_t threads) {
+  folly::BenchmarkSuspender suspender;
+  gflags::FlagSaver flagSaver;
+  FLAGS_sai_store_reload_threads = threads;
+  SaiStore store(0);
+  suspender.dismissing([&store]() { store.reload(); });
+  // Destroying the store releases the warm boot objects without removing
+  // them from the adapter, so the next iteration reloads the same objects
+}
+
+} // unnamed namespace
+
+BENCHMARK(SaiStoreReloadSerial) {
+  reload(1);
+}
+
+BENCHMARK(SaiStoreReloadConcurrent) {
+  reload(FLAGS_sai_store_reload_threads);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  auto fs = FakeSai::getInstance();
+  sai_api_initialize(0, nullptr);
+  SaiApiTable::getInstance()->queryApis();
+  createObjects();
+
+  folly::runBenchmarks();
+  return 0;
+}
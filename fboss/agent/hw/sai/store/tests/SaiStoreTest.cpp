@@ -11,8 +11,10 @@
 #include "fboss/agent/hw/sai/store/SaiStore.h"
 #include "fboss/agent/hw/sai/fake/FakeSai.h"
 
+#include <folly/IPAddressV4.h>
 #include <folly/logging/xlog.h>
 
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
 using namespace facebook::fboss;
@@ -43,3 +45,45 @@ TEST_F(SaiStoreTest, singletonLoadEmpty) {
   store->setSwitchId(0);
   store->reload();
 }
+
+TEST_F(SaiStoreTest, reloadConcurrently) {
+  gflags::FlagSaver flagSaver;
+  FLAGS_sai_store_reload_threads = 4;
+  auto& routeApi = saiApiTable->routeApi();
+  auto& neighborApi = saiApiTable->neighborApi();
+  auto& nextHopApi = saiApiTable->nextHopApi();
+  // Other tests may have left objects behind in the fake
+  size_t numRoutes, numNeighbors, numNextHops;
+  {
+    SaiStore before(0);
+    before.reload();
+    numRoutes = before.get<SaiRouteTraits>().reloadedObjects();
+    numNeighbors = before.get<SaiNeighborTraits>().reloadedObjects();
+    numNextHops = before.get<SaiNextHopTraits>().reloadedObjects();
+  }
+  for (uint32_t i = 0; i < 100; ++i) {
+    auto ip = folly::IPAddressV4::fromLongHBO(0x0a000000 + (i << 8) + 1);
+    SaiRouteTraits::RouteEntry r(0, 0, folly::CIDRNetwork(ip, 24));
+    routeApi.create2<SaiRouteTraits>(r, {SAI_PACKET_ACTION_FORWARD, 5});
+    SaiNeighborTraits::NeighborEntry n(0, 0, ip);
+    SaiNeighborTraits::Attributes::DstMac dstMac{
+        folly::MacAddress("42:42:42:42:42:42")};
+    neighborApi.create2<SaiNeighborTraits>(n, {dstMac});
+    nextHopApi.create2<SaiNextHopTraits>({SAI_NEXT_HOP_TYPE_IP, 42, ip}, 0);
+  }
+
+  SaiStore s(0);
+  s.reload();
+  EXPECT_EQ(numRoutes + 100, s.get<SaiRouteTraits>().reloadedObjects());
+  EXPECT_EQ(
+      numNeighbors + 100, s.get<SaiNeighborTraits>().reloadedObjects());
+  EXPECT_EQ(numNextHops + 100, s.get<SaiNextHopTraits>().reloadedObjects());
+  auto ip = folly::IPAddressV4("10.0.42.1");
+  auto route = s.get<SaiRouteTraits>().get(
+      SaiRouteTraits::RouteEntry(0, 0, folly::CIDRNetwork(ip, 24)));
+  ASSERT_TRUE(route);
+  EXPECT_EQ(GET_OPT_ATTR(Route, NextHopId, route->attributes()), 5);
+  auto nextHop = s.get<SaiNextHopTraits>().get(
+      SaiNextHopTraits::AdapterHostKey{42, folly::IPAddress(ip)});
+  ASSERT_TRUE(nextHop);
+}
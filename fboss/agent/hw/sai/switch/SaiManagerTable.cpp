@@ -25,6 +25,14 @@
 #include "fboss/agent/hw/sai/switch/SaiVirtualRouterManager.h"
 #include "fboss/agent/hw/sai/switch/SaiVlanManager.h"
 
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <gflags/gflags.h>
+
+#include <algorithm>
+
+DECLARE_int32(sai_route_delta_threads);
+
 namespace facebook {
 namespace fboss {
 
@@ -50,9 +58,13 @@ SaiManagerTable::SaiManagerTable(SaiPlatform* platform) {
   nextHopGroupManager_ =
       std::make_unique<SaiNextHopGroupManager>(this, platform);
   neighborManager_ = std::make_unique<SaiNeighborManager>(this, platform);
+  deltaExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+      std::max(FLAGS_sai_route_delta_threads, 1),
+      std::make_shared<folly::NamedThreadFactory>("SaiDelta"));
 }
 
 SaiManagerTable::~SaiManagerTable() {
+  deltaExecutor_.reset();
   // Need to destroy routes before destroying other managers, as the
   // route destructor will trigger calls in those managers
   routeManager().clear();
@@ -155,5 +167,9 @@ const SaiVlanManager& SaiManagerTable::vlanManager() const {
   return *vlanManager_;
 }
 
+folly::Executor* SaiManagerTable::deltaExecutor() {
+  return deltaExecutor_.get();
+}
+
 } // namespace fboss
 } // namespace facebook
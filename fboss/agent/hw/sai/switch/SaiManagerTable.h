@@ -11,6 +11,11 @@
 
 #include <memory>
 
+namespace folly {
+class CPUThreadPoolExecutor;
+class Executor;
+} // namespace folly
+
 namespace facebook {
 namespace fboss {
 
@@ -73,6 +78,12 @@ class SaiManagerTable {
   SaiVlanManager& vlanManager();
   const SaiVlanManager& vlanManager() const;
 
+  /*
+   * Threads shared by the managers to program the independent parts of a
+   * state delta concurrently.
+   */
+  folly::Executor* deltaExecutor();
+
  private:
   std::unique_ptr<SaiBridgeManager> bridgeManager_;
   std::unique_ptr<SaiFdbManager> fdbManager_;
@@ -87,6 +98,7 @@ class SaiManagerTable {
   std::unique_ptr<SaiSwitchManager> switchManager_;
   std::unique_ptr<SaiVirtualRouterManager> virtualRouterManager_;
   std::unique_ptr<SaiVlanManager> vlanManager_;
+  std::unique_ptr<folly::CPUThreadPoolExecutor> deltaExecutor_;
 };
 
 } // namespace fboss
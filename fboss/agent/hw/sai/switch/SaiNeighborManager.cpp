@@ -70,6 +70,15 @@ void SaiNeighborManager::changeNeighbor(
 template <typename NeighborEntryT>
 void SaiNeighborManager::addNeighbor(
     const std::shared_ptr<NeighborEntryT>& swEntry) {
+  NeighborBatch batch;
+  addNeighbor(swEntry, batch);
+  flushNeighborBatch(batch);
+}
+
+template <typename NeighborEntryT>
+void SaiNeighborManager::addNeighbor(
+    const std::shared_ptr<NeighborEntryT>& swEntry,
+    NeighborBatch& batch) {
   // Handle pending()
   XLOG(INFO) << "addNeighbor " << swEntry->getIP();
   auto saiEntry = saiEntryFromSwEntry(swEntry);
@@ -89,24 +98,47 @@ void SaiNeighborManager::addNeighbor(
       return;
     }
     SaiNeighborTraits::CreateAttributes attributes{swEntry->getMac()};
-    auto& store = SaiStore::getInstance()->get<SaiNeighborTraits>();
     /*
-     * program fdb entry before creating neighbor, neighbor requires fdb entry
+     * program fdb entry before creating neighbor, neighbor requires fdb entry.
+     * When batching, the fdb entries of the neighbors after this one are
+     * programmed before this neighbor is created. That is safe since the
+     * fdb entries don't depend on each other or on any neighbor.
      */
     auto fdbEntry = managerTable_->fdbManager().addFdbEntry(
         swEntry->getIntfID(), swEntry->getMac(), swEntry->getPort());
-    auto neighbor = store.setObject(saiEntry, attributes);
+    batch.push_back(PendingNeighbor{
+        saiEntry, attributes, std::move(fdbEntry), swEntry->getIP()});
+  }
+}
+
+void SaiNeighborManager::flushNeighborBatch(NeighborBatch& batch) {
+  if (batch.empty()) {
+    return;
+  }
+  std::vector<SaiNeighborTraits::NeighborEntry> entries;
+  std::vector<SaiNeighborTraits::CreateAttributes> attributes;
+  entries.reserve(batch.size());
+  attributes.reserve(batch.size());
+  for (const auto& pending : batch) {
+    entries.push_back(pending.entry);
+    attributes.push_back(pending.attributes);
+  }
+  auto& store = SaiStore::getInstance()->get<SaiNeighborTraits>();
+  auto neighbors = store.setObjects(entries, attributes);
+  for (size_t i = 0; i < batch.size(); ++i) {
+    auto& pending = batch[i];
     /* add next hop to discovered neighbor over */
     auto nextHop = managerTable_->nextHopManager().addNextHop(
-        saiEntry.routerInterfaceId(), swEntry->getIP());
+        pending.entry.routerInterfaceId(), pending.ip);
     auto neighborHandle = std::make_unique<SaiNeighborHandle>();
-    neighborHandle->neighbor = neighbor;
-    neighborHandle->fdbEntry = fdbEntry;
+    neighborHandle->neighbor = std::move(neighbors[i]);
+    neighborHandle->fdbEntry = std::move(pending.fdbEntry);
     neighborHandle->nextHop = nextHop;
-    handles_.emplace(saiEntry, std::move(neighborHandle));
+    handles_.emplace(pending.entry, std::move(neighborHandle));
     managerTable_->nextHopGroupManager().handleResolvedNeighbor(
-        saiEntry, nextHop->adapterKey());
+        pending.entry, nextHop->adapterKey());
   }
+  batch.clear();
 }
 
 template <typename NeighborEntryT>
@@ -136,15 +168,24 @@ void SaiNeighborManager::removeNeighbor(
 }
 
 void SaiNeighborManager::processNeighborDelta(const StateDelta& delta) {
+  /*
+   * Runs of consecutive neighbor additions are created together. The batch
+   * is flushed before any change or removal, so the delta is still applied
+   * in order, e.g. a failure part way through the delta leaves the same
+   * neighbors programmed as applying the entries one by one would.
+   */
+  NeighborBatch batch;
   for (const auto& vlanDelta : delta.getVlansDelta()) {
     auto processChanged =
-        [this](const auto& oldNeighbor, const auto& newNeighbor) {
+        [this, &batch](const auto& oldNeighbor, const auto& newNeighbor) {
+          flushNeighborBatch(batch);
           changeNeighbor(oldNeighbor, newNeighbor);
         };
-    auto processAdded = [this](const auto& newNeighbor) {
-      addNeighbor(newNeighbor);
+    auto processAdded = [this, &batch](const auto& newNeighbor) {
+      addNeighbor(newNeighbor, batch);
     };
-    auto processRemoved = [this](const auto& oldNeighbor) {
+    auto processRemoved = [this, &batch](const auto& oldNeighbor) {
+      flushNeighborBatch(batch);
       removeNeighbor(oldNeighbor);
     };
     DeltaFunctions::forEachChanged(
@@ -152,6 +193,7 @@ void SaiNeighborManager::processNeighborDelta(const StateDelta& delta) {
     DeltaFunctions::forEachChanged(
         vlanDelta.getNdpDelta(), processChanged, processAdded, processRemoved);
   }
+  flushNeighborBatch(batch);
 }
 
 void SaiNeighborManager::clear() {
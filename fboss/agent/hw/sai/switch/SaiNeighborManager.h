@@ -20,6 +20,7 @@
 #include "folly/container/F14Map.h"
 
 #include <memory>
+#include <vector>
 
 namespace facebook {
 namespace fboss {
@@ -67,6 +68,25 @@ class SaiNeighborManager {
   void clear();
 
  private:
+  /*
+   * Resolved neighbors whose fdb entries are programmed, but which are not
+   * yet programmed themselves. processNeighborDelta() collects the
+   * neighbors added by a delta and creates them all with one bulk call.
+   */
+  struct PendingNeighbor {
+    SaiNeighborTraits::NeighborEntry entry;
+    SaiNeighborTraits::CreateAttributes attributes;
+    std::shared_ptr<SaiFdbEntry> fdbEntry;
+    folly::IPAddress ip;
+  };
+  using NeighborBatch = std::vector<PendingNeighbor>;
+
+  template <typename NeighborEntryT>
+  void addNeighbor(
+      const std::shared_ptr<NeighborEntryT>& swEntry,
+      NeighborBatch& batch);
+  void flushNeighborBatch(NeighborBatch& batch);
+
   SaiNeighborHandle* getNeighborHandleImpl(
       const SaiNeighborTraits::NeighborEntry& entry) const;
   SaiManagerTable* managerTable_;
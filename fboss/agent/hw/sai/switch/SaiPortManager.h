@@ -46,6 +46,9 @@ class SaiPortManager {
   const SaiPortHandle* getPortHandle(PortID swId) const;
   SaiPortHandle* getPortHandle(PortID swId);
   PortID getPortID(sai_object_id_t saiId) const;
+  const folly::F14FastMap<sai_object_id_t, PortID>& getPortSaiIds() const {
+    return portSaiIds_;
+  }
   void processPortDelta(const StateDelta& stateDelta);
 
  private:
@@ -15,9 +15,26 @@
 #include "fboss/agent/hw/sai/switch/SaiRouterInterfaceManager.h"
 #include "fboss/agent/hw/sai/switch/SaiSwitchManager.h"
 #include "fboss/agent/hw/sai/switch/SaiVirtualRouterManager.h"
+#include "fboss/lib/ParallelFor.h"
 
+#include <gflags/gflags.h>
+
+#include <algorithm>
 #include <optional>
 
+DEFINE_int32(
+    sai_route_bulk_size,
+    1024,
+    "Maximum number of routes programmed by a single SAI bulk call while "
+    "processing a route delta");
+
+DEFINE_int32(
+    sai_route_delta_threads,
+    4,
+    "Number of threads used to program the route batches of a state delta "
+    "concurrently. The thread pool is sized when the switch is initialized; "
+    "later changes can only lower the number used");
+
 namespace facebook {
 namespace fboss {
 
@@ -26,20 +43,34 @@ SaiRouteManager::SaiRouteManager(
     const SaiPlatform* platform)
     : managerTable_(managerTable), platform_(platform) {}
 
+SaiRouteManager::RouteProgrammingContext
+SaiRouteManager::makeRouteProgrammingContext(RouterID routerId) const {
+  SaiVirtualRouterHandle* virtualRouterHandle =
+      managerTable_->virtualRouterManager().getVirtualRouterHandle(routerId);
+  if (!virtualRouterHandle) {
+    throw FbossError("No virtual router with id ", routerId);
+  }
+  return RouteProgrammingContext{
+      managerTable_->switchManager().getSwitchSaiId(),
+      virtualRouterHandle->virtualRouter->adapterKey(),
+      std::nullopt};
+}
+
 template <typename AddrT>
 SaiRouteTraits::RouteEntry SaiRouteManager::routeEntryFromSwRoute(
     RouterID routerId,
     const std::shared_ptr<Route<AddrT>>& swRoute) const {
-  SwitchSaiId switchId = managerTable_->switchManager().getSwitchSaiId();
+  return routeEntryFromSwRoute(makeRouteProgrammingContext(routerId), swRoute);
+}
+
+template <typename AddrT>
+SaiRouteTraits::RouteEntry SaiRouteManager::routeEntryFromSwRoute(
+    const RouteProgrammingContext& context,
+    const std::shared_ptr<Route<AddrT>>& swRoute) const {
   folly::IPAddress prefixNetwork{swRoute->prefix().network};
   folly::CIDRNetwork prefix{prefixNetwork, swRoute->prefix().mask};
-  SaiVirtualRouterHandle* virtualRouterHandle =
-      managerTable_->virtualRouterManager().getVirtualRouterHandle(routerId);
-  if (!virtualRouterHandle) {
-    throw FbossError("No virtual router with id ", routerId);
-  }
   return SaiRouteTraits::RouteEntry{
-      switchId, virtualRouterHandle->virtualRouter->adapterKey(), prefix};
+      context.switchId, context.virtualRouterId, prefix};
 }
 
 template <typename AddrT>
@@ -92,7 +123,18 @@ template <typename AddrT>
 void SaiRouteManager::addRoute(
     RouterID routerId,
     const std::shared_ptr<Route<AddrT>>& swRoute) {
-  SaiRouteTraits::RouteEntry entry = routeEntryFromSwRoute(routerId, swRoute);
+  auto context = makeRouteProgrammingContext(routerId);
+  RouteBatch batch;
+  addRoute(context, swRoute, batch);
+  flushRouteBatch(batch);
+}
+
+template <typename AddrT>
+void SaiRouteManager::addRoute(
+    RouteProgrammingContext& context,
+    const std::shared_ptr<Route<AddrT>>& swRoute,
+    RouteBatch& batch) {
+  SaiRouteTraits::RouteEntry entry = routeEntryFromSwRoute(context, swRoute);
   auto itr = handles_.find(entry);
   if (itr != handles_.end()) {
     throw FbossError(
@@ -139,37 +181,149 @@ void SaiRouteManager::addRoute(
     }
   } else if (fwd.getAction() == TO_CPU) {
     packetAction = SAI_PACKET_ACTION_FORWARD;
-    SwitchSaiId switchId = managerTable_->switchManager().getSwitchSaiId();
-    sai_object_id_t cpuPortId =
-        SaiApiTable::getInstance()->switchApi().getAttribute2(
-            switchId, SaiSwitchTraits::Attributes::CpuPort{});
-    nextHopIdOpt = cpuPortId;
+    if (!context.cpuPortId) {
+      context.cpuPortId = SaiApiTable::getInstance()->switchApi().getAttribute2(
+          context.switchId, SaiSwitchTraits::Attributes::CpuPort{});
+    }
+    nextHopIdOpt = context.cpuPortId;
   } else if (fwd.getAction() == DROP) {
     packetAction = SAI_PACKET_ACTION_DROP;
   }
 
-  SaiRouteTraits::CreateAttributes attributes{packetAction, nextHopIdOpt};
   auto& store = SaiStore::getInstance()->get<SaiRouteTraits>();
-  auto route = store.setObject(entry, attributes);
-  auto routeHandle = std::make_unique<SaiRouteHandle>();
-  routeHandle->route = route;
-  routeHandle->nextHopGroupHandle = nextHopGroupHandle;
-  handles_.emplace(entry, std::move(routeHandle));
+  if (!store.get(entry)) {
+    batch.createIndices.push_back(batch.addedEntries.size());
+  }
+  batch.addedEntries.push_back(entry);
+  batch.addedAttributes.emplace_back(packetAction, nextHopIdOpt);
+  batch.addedNextHopGroups.push_back(std::move(nextHopGroupHandle));
 }
 
 template <typename AddrT>
 void SaiRouteManager::removeRoute(
     RouterID routerId,
     const std::shared_ptr<Route<AddrT>>& swRoute) {
-  SaiRouteTraits::RouteEntry entry = routeEntryFromSwRoute(routerId, swRoute);
-  size_t count = handles_.erase(entry);
-  if (!count) {
+  RouteBatch batch;
+  removeRoute(makeRouteProgrammingContext(routerId), swRoute, batch);
+  flushRouteBatch(batch);
+}
+
+template <typename AddrT>
+void SaiRouteManager::removeRoute(
+    const RouteProgrammingContext& context,
+    const std::shared_ptr<Route<AddrT>>& swRoute,
+    RouteBatch& batch) {
+  SaiRouteTraits::RouteEntry entry = routeEntryFromSwRoute(context, swRoute);
+  auto itr = handles_.find(entry);
+  if (itr == handles_.end()) {
     throw FbossError(
         "Failed to remove non-existent route to ", swRoute->prefix().str());
   }
+  // A route which is also referenced elsewhere (e.g. a to-me route for an
+  // interface address) stays in SAI when we drop our reference.
+  if (itr->second->route.use_count() == 1) {
+    batch.removeIndices.push_back(batch.removedEntries.size());
+  }
+  batch.removedEntries.push_back(entry);
+  batch.removedHandles.push_back(std::move(itr->second));
+  handles_.erase(itr);
 }
 
-void SaiRouteManager::processRouteDelta(const StateDelta& delta) {
+void SaiRouteManager::programRouteBatch(RouteBatch& batch) const {
+  auto& routeApi = SaiApiTable::getInstance()->routeApi();
+  try {
+    std::vector<SaiRouteTraits::RouteEntry> entries;
+    entries.reserve(batch.removeIndices.size());
+    for (auto i : batch.removeIndices) {
+      entries.push_back(batch.removedEntries[i]);
+    }
+    routeApi.bulkRemove2(entries, &batch.removeStatuses);
+    entries.clear();
+    std::vector<SaiRouteTraits::CreateAttributes> attributes;
+    entries.reserve(batch.createIndices.size());
+    attributes.reserve(batch.createIndices.size());
+    for (auto i : batch.createIndices) {
+      entries.push_back(batch.addedEntries[i]);
+      attributes.push_back(batch.addedAttributes[i]);
+    }
+    routeApi.bulkCreate2<SaiRouteTraits>(
+        entries, attributes, &batch.createStatuses);
+  } catch (...) {
+    // Rethrown by commitRouteBatch(), on the thread processing the delta
+    batch.error = std::current_exception();
+  }
+}
+
+void SaiRouteManager::commitRouteBatch(RouteBatch& batch) {
+  auto succeeded = [](const std::vector<sai_status_t>& statuses, size_t j) {
+    return j < statuses.size() && statuses[j] == SAI_STATUS_SUCCESS;
+  };
+  for (size_t j = 0; j < batch.removeIndices.size(); ++j) {
+    auto i = batch.removeIndices[j];
+    auto& handle = batch.removedHandles[i];
+    if (succeeded(batch.removeStatuses, j)) {
+      // Already removed, so the SaiObject destructor mustn't remove it
+      handle->route->release();
+    } else {
+      // Still programmed, so the handle goes back to owning the route
+      handles_.emplace(batch.removedEntries[i], std::move(handle));
+    }
+  }
+  // Only now drop the references the removed routes held on their next hop
+  // groups, since SAI won't remove a group which routes still point to.
+  batch.removedHandles.clear();
+  batch.removedEntries.clear();
+
+  // For each added route which wasn't in the store, whether it was created
+  std::vector<std::optional<bool>> created(batch.addedEntries.size());
+  for (size_t j = 0; j < batch.createIndices.size(); ++j) {
+    created[batch.createIndices[j]] = succeeded(batch.createStatuses, j);
+  }
+  auto& store = SaiStore::getInstance()->get<SaiRouteTraits>();
+  for (size_t i = 0; i < batch.addedEntries.size(); ++i) {
+    const auto& entry = batch.addedEntries[i];
+    const auto& attributes = batch.addedAttributes[i];
+    std::shared_ptr<SaiRoute> route;
+    if (created[i].has_value()) {
+      if (!*created[i]) {
+        // Its next hop group reference is dropped with the batch
+        continue;
+      }
+      route = store.addCreatedObject(entry, attributes);
+    } else if (!batch.error) {
+      // Already in the store, e.g. as a to-me route
+      route = store.setObject(entry, attributes);
+    } else {
+      continue;
+    }
+    auto routeHandle = std::make_unique<SaiRouteHandle>();
+    routeHandle->route = std::move(route);
+    routeHandle->nextHopGroupHandle = std::move(batch.addedNextHopGroups[i]);
+    handles_.emplace(entry, std::move(routeHandle));
+  }
+  batch.addedEntries.clear();
+  batch.addedAttributes.clear();
+  batch.addedNextHopGroups.clear();
+  batch.createIndices.clear();
+  batch.removeIndices.clear();
+  batch.createStatuses.clear();
+  batch.removeStatuses.clear();
+  if (batch.error) {
+    auto error = std::move(batch.error);
+    batch.error = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void SaiRouteManager::flushRouteBatch(RouteBatch& batch) {
+  programRouteBatch(batch);
+  commitRouteBatch(batch);
+}
+
+void SaiRouteManager::collectRouteBatches(
+    const StateDelta& delta,
+    std::vector<RouteBatch>& batches) {
+  auto batchSize = static_cast<size_t>(std::max(FLAGS_sai_route_bulk_size, 1));
   for (const auto& routeDelta : delta.getRouteTablesDelta()) {
     RouterID routerId;
     if (routeDelta.getOld()) {
@@ -177,26 +331,86 @@ void SaiRouteManager::processRouteDelta(const StateDelta& delta) {
     } else {
       routerId = routeDelta.getNew()->getID();
     }
-    auto processChanged = [this, routerId](
-                              const auto& oldRoute, const auto& newRoute) {
-      changeRoute(routerId, oldRoute, newRoute);
-    };
-    auto processAdded = [this, routerId](const auto& newRoute) {
-      addRoute(routerId, newRoute);
+    std::optional<RouteProgrammingContext> context;
+    auto getContext = [this, routerId, &context]() -> auto& {
+      if (!context) {
+        context = makeRouteProgrammingContext(routerId);
+      }
+      return *context;
     };
-    auto processRemoved = [this, routerId](const auto& oldRoute) {
-      removeRoute(routerId, oldRoute);
+    // The routes of a virtual router and address family go to the same
+    // batches, which makes it likely that they share next hop groups.
+    auto collect = [&](const auto& routesDelta) {
+      batches.emplace_back();
+      auto nextBatch = [&batches, batchSize]() -> auto& {
+        if (batches.back().size() >= batchSize) {
+          batches.emplace_back();
+        }
+        return batches.back();
+      };
+      DeltaFunctions::forEachChanged(
+          routesDelta,
+          [this, routerId](const auto& oldRoute, const auto& newRoute) {
+            changeRoute(routerId, oldRoute, newRoute);
+          },
+          [this, &getContext, &nextBatch](const auto& newRoute) {
+            addRoute(getContext(), newRoute, nextBatch());
+          },
+          [this, &getContext, &nextBatch](const auto& oldRoute) {
+            removeRoute(getContext(), oldRoute, nextBatch());
+          });
+      if (batches.back().size() == 0) {
+        batches.pop_back();
+      }
     };
-    DeltaFunctions::forEachChanged(
-        routeDelta.getRoutesV4Delta(),
-        processChanged,
-        processAdded,
-        processRemoved);
-    DeltaFunctions::forEachChanged(
-        routeDelta.getRoutesV6Delta(),
-        processChanged,
-        processAdded,
-        processRemoved);
+    collect(routeDelta.getRoutesV4Delta());
+    collect(routeDelta.getRoutesV6Delta());
+  }
+}
+
+void SaiRouteManager::processRouteDelta(const StateDelta& delta) {
+  /*
+   * The delta is applied in three steps:
+   * - Walk the delta, collecting the routes into batches. This is where the
+   *   next hop groups of the added routes are created, so the objects the
+   *   routes point to always exist before any route is programmed.
+   * - Program the batches. Every route entry appears once in a delta, so
+   *   the batches (of different virtual routers and address families, or
+   *   just different routes) have nothing in common in the adapter and are
+   *   programmed concurrently.
+   * - Record the programmed routes and release the next hop groups of the
+   *   removed ones, once no route points to them anymore.
+   *
+   * If anything fails, the batches are still committed, so the routes which
+   * were programmed are tracked, before the first error is rethrown.
+   */
+  std::vector<RouteBatch> batches;
+  std::exception_ptr error;
+  try {
+    collectRouteBatches(delta, batches);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  // programRouteBatch records its own errors in the batch, so this does not
+  // throw
+  parallelFor(
+      managerTable_->deltaExecutor(),
+      batches.size(),
+      std::max(FLAGS_sai_route_delta_threads, 1),
+      [this, &batches](size_t i) { programRouteBatch(batches[i]); });
+
+  for (auto& batch : batches) {
+    try {
+      commitRouteBatch(batch);
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
   }
 }
 
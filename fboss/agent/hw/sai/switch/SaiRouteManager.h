@@ -18,7 +18,10 @@
 
 #include "folly/container/F14Map.h"
 
+#include <exception>
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace facebook {
 namespace fboss {
@@ -63,6 +66,11 @@ class SaiRouteManager {
       RouterID routerId,
       const std::shared_ptr<Route<AddrT>>& swRoute);
 
+  /*
+   * Program the routes of a delta. Routes are collected into batches of at
+   * most --sai_route_bulk_size routes, which are then programmed
+   * concurrently on up to --sai_route_delta_threads threads.
+   */
   void processRouteDelta(const StateDelta& delta);
 
   SaiRouteHandle* getRouteHandle(const SaiRouteTraits::RouteEntry& entry);
@@ -72,6 +80,76 @@ class SaiRouteManager {
   void clear();
 
  private:
+  /*
+   * Lookups which are the same for every route of a virtual router. These
+   * are done once per virtual router in processRouteDelta(), rather than
+   * once per route, since a single delta can carry hundreds of thousands of
+   * routes.
+   */
+  struct RouteProgrammingContext {
+    SwitchSaiId switchId;
+    sai_object_id_t virtualRouterId;
+    // Only looked up when the first TO_CPU route is programmed
+    std::optional<sai_object_id_t> cpuPortId;
+  };
+  RouteProgrammingContext makeRouteProgrammingContext(RouterID routerId) const;
+
+  /*
+   * Routes which have been added to or removed from handles_, but not yet
+   * programmed. A batch is programmed in two steps:
+   * - programRouteBatch() issues the SAI bulk calls, removals first. It
+   *   only reads the batch and calls the adapter, so batches of distinct
+   *   routes can be programmed concurrently.
+   * - commitRouteBatch() then records the outcome in handles_ and the
+   *   SaiStore, which are not thread safe.
+   */
+  struct RouteBatch {
+    std::vector<SaiRouteTraits::RouteEntry> addedEntries;
+    std::vector<SaiRouteTraits::CreateAttributes> addedAttributes;
+    std::vector<std::shared_ptr<SaiNextHopGroupHandle>> addedNextHopGroups;
+    std::vector<SaiRouteTraits::RouteEntry> removedEntries;
+    std::vector<std::unique_ptr<SaiRouteHandle>> removedHandles;
+    // Indices of the added routes which are not in the SaiStore yet, and
+    // of the removed routes which nothing else refers to: these are the
+    // routes to create and remove in the adapter.
+    std::vector<size_t> createIndices;
+    std::vector<size_t> removeIndices;
+    // Outcome of programRouteBatch()
+    std::vector<sai_status_t> createStatuses;
+    std::vector<sai_status_t> removeStatuses;
+    std::exception_ptr error;
+
+    size_t size() const {
+      return addedEntries.size() + removedEntries.size();
+    }
+  };
+
+  template <typename AddrT>
+  SaiRouteTraits::RouteEntry routeEntryFromSwRoute(
+      const RouteProgrammingContext& context,
+      const std::shared_ptr<Route<AddrT>>& swEntry) const;
+
+  template <typename AddrT>
+  void addRoute(
+      RouteProgrammingContext& context,
+      const std::shared_ptr<Route<AddrT>>& swRoute,
+      RouteBatch& batch);
+
+  template <typename AddrT>
+  void removeRoute(
+      const RouteProgrammingContext& context,
+      const std::shared_ptr<Route<AddrT>>& swRoute,
+      RouteBatch& batch);
+
+  void programRouteBatch(RouteBatch& batch) const;
+  void commitRouteBatch(RouteBatch& batch);
+  void flushRouteBatch(RouteBatch& batch);
+
+  // Walk a delta, collecting its routes into batches
+  void collectRouteBatches(
+      const StateDelta& delta,
+      std::vector<RouteBatch>& batches);
+
   SaiRouteHandle* getRouteHandleImpl(
       const SaiRouteTraits::RouteEntry& entry) const;
 
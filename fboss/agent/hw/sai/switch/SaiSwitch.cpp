@@ -9,6 +9,7 @@
  */
 
 #include "fboss/agent/hw/sai/switch/SaiSwitch.h"
+#include "fboss/agent/SwitchStats.h"
 #include "fboss/agent/Utils.h"
 #include "fboss/agent/hw/sai/api/FdbApi.h"
 #include "fboss/agent/hw/sai/api/HostifApi.h"
@@ -33,6 +34,10 @@
 #include "fboss/agent/state/StateDelta.h"
 #include "fboss/agent/state/SwitchState.h"
 
+#include <folly/futures/Future.h>
+#include <gflags/gflags.h>
+
+#include <algorithm>
 #include <iomanip>
 #include <memory>
 #include <sstream>
@@ -40,6 +45,13 @@
 extern "C" {
 #include <sai.h>
 }
+
+DEFINE_int32(
+    sai_tx_ring_size,
+    4096,
+    "Number of packets which can be queued for async tx before further "
+    "async sends are dropped");
+
 namespace facebook {
 namespace fboss {
 
@@ -57,11 +69,22 @@ using facebook::fboss::DeltaFunctions::forEachAdded;
 static SaiSwitch* __gSaiSwitch;
 
 SaiSwitch::SaiSwitch(SaiPlatform* platform, uint32_t featuresDesired)
-    : HwSwitch(featuresDesired), platform_(platform) {
+    : HwSwitch(featuresDesired),
+      platform_(platform),
+      packetIoTables_(std::make_shared<const PacketIoTables>()),
+      txRing_(std::max(FLAGS_sai_tx_ring_size, 1)) {
   utilCreateDir(platform_->getVolatileStateDir());
   utilCreateDir(platform_->getPersistentStateDir());
 }
 
+SaiSwitch::~SaiSwitch() {
+  if (txThread_) {
+    // An empty request tells the tx thread to stop
+    txRing_.blockingWrite(TxRequest{});
+    txThread_->join();
+  }
+}
+
 void __gPacketRxCallback(
     sai_object_id_t switch_id,
     sai_size_t buffer_size,
@@ -105,34 +128,29 @@ bool SaiSwitch::isValidStateUpdate(const StateDelta& delta) const {
 }
 
 std::unique_ptr<TxPacket> SaiSwitch::allocatePacket(uint32_t size) const {
-  std::lock_guard<std::mutex> lock(saiSwitchMutex_);
-  return allocatePacketLocked(lock, size);
+  return std::make_unique<SaiTxPacket>(size);
 }
 
 bool SaiSwitch::sendPacketSwitchedAsync(
     std::unique_ptr<TxPacket> pkt) noexcept {
-  std::lock_guard<std::mutex> lock(saiSwitchMutex_);
-  return sendPacketSwitchedAsyncLocked(lock, std::move(pkt));
+  return enqueueTx(TxRequest{std::move(pkt), std::nullopt});
 }
 
 bool SaiSwitch::sendPacketOutOfPortAsync(
     std::unique_ptr<TxPacket> pkt,
     PortID portID,
-    folly::Optional<uint8_t> queue) noexcept {
-  std::lock_guard<std::mutex> lock(saiSwitchMutex_);
-  return sendPacketOutOfPortAsyncLocked(lock, std::move(pkt), portID, queue);
+    folly::Optional<uint8_t> /* queue */) noexcept {
+  return enqueueTx(TxRequest{std::move(pkt), portID});
 }
 
 bool SaiSwitch::sendPacketSwitchedSync(std::unique_ptr<TxPacket> pkt) noexcept {
-  std::lock_guard<std::mutex> lock(saiSwitchMutex_);
-  return sendPacketSwitchedSyncLocked(lock, std::move(pkt));
+  return sendPacketSwitchedImpl(std::move(pkt));
 }
 
 bool SaiSwitch::sendPacketOutOfPortSync(
     std::unique_ptr<TxPacket> pkt,
     PortID portID) noexcept {
-  std::lock_guard<std::mutex> lock(saiSwitchMutex_);
-  return sendPacketOutOfPortSyncLocked(lock, std::move(pkt), portID);
+  return sendPacketOutOfPortImpl(std::move(pkt), portID);
 }
 
 void SaiSwitch::updateStats(SwitchStats* switchStats) {
@@ -201,22 +219,56 @@ void SaiSwitch::packetRxCallback(
     const void* buffer,
     uint32_t attr_count,
     const sai_attribute_t* attr_list) {
-  std::unique_lock<std::mutex> lock(saiSwitchMutex_);
-  packetRxCallbackLocked(
-      std::move(lock), switch_id, buffer_size, buffer, attr_count, attr_list);
+  sai_object_id_t saiPortId = 0;
+  for (auto index = 0; index < attr_count; index++) {
+    const sai_attribute_t* attr = &attr_list[index];
+    switch (attr->id) {
+      case SAI_HOSTIF_PACKET_ATTR_INGRESS_PORT:
+        saiPortId = attr->value.oid;
+        break;
+      case SAI_HOSTIF_PACKET_ATTR_INGRESS_LAG:
+      case SAI_HOSTIF_PACKET_ATTR_HOSTIF_TRAP_ID:
+        break;
+      default:
+        XLOG(INFO) << "invalid attribute received";
+    }
+  }
+  CHECK_NE(saiPortId, 0);
+  auto tables = packetIoTables_.get();
+  auto portItr = tables->portIdBySaiPortId.find(saiPortId);
+  if (portItr == tables->portIdBySaiPortId.end()) {
+    XLOG(DBG2) << "dropping packet received on unknown port " << std::hex
+               << saiPortId;
+    return;
+  }
+  PortID swPortId = portItr->second;
+  auto vlanItr = tables->vlanIdByPortId.find(swPortId);
+  if (vlanItr == tables->vlanIdByPortId.end()) {
+    XLOG(DBG2) << "dropping packet received on port " << swPortId
+               << " which is not in any vlan";
+    return;
+  }
+  auto rxPacket = std::make_unique<SaiRxPacket>(
+      buffer_size, buffer, swPortId, vlanItr->second);
+  callback_->packetReceived(std::move(rxPacket));
 }
 
 void SaiSwitch::linkStateChangedCallback(
     uint32_t count,
     const sai_port_oper_status_notification_t* data) {
+  auto tables = packetIoTables_.get();
   for (auto i = 0; i < count; i++) {
     auto state = data[i].port_state == SAI_PORT_OPER_STATUS_UP ? "up" : "down";
     XLOG(INFO) << "port " << state << " notification received for " << std::hex
                << data[i].port_id;
-    // FIXME - accessing port table here is racy - T54107986
+    auto portItr = tables->portIdBySaiPortId.find(data[i].port_id);
+    if (portItr == tables->portIdBySaiPortId.end()) {
+      XLOG(WARNING) << "ignoring link state change of unknown port "
+                    << std::hex << data[i].port_id;
+      continue;
+    }
     callback_->linkStateChanged(
-        managerTable()->portManager().getPortID(data[i].port_id),
-        data[i].port_state == SAI_PORT_OPER_STATUS_UP);
+        portItr->second, data[i].port_state == SAI_PORT_OPER_STATUS_UP);
   }
 }
 
@@ -255,51 +307,10 @@ HwInitResult SaiSwitch::initLocked(
   auto state = std::make_shared<SwitchState>();
   ret.switchState = state;
   __gSaiSwitch = this;
-  return ret;
-}
-
-void SaiSwitch::packetRxCallbackLocked(
-    std::unique_lock<std::mutex>&& lock,
-    sai_object_id_t switch_id,
-    sai_size_t buffer_size,
-    const void* buffer,
-    uint32_t attr_count,
-    const sai_attribute_t* attr_list) {
-  sai_object_id_t saiPortId = 0;
-  for (auto index = 0; index < attr_count; index++) {
-    const sai_attribute_t* attr = &attr_list[index];
-    switch (attr->id) {
-      case SAI_HOSTIF_PACKET_ATTR_INGRESS_PORT:
-        saiPortId = attr->value.oid;
-        break;
-      case SAI_HOSTIF_PACKET_ATTR_INGRESS_LAG:
-      case SAI_HOSTIF_PACKET_ATTR_HOSTIF_TRAP_ID:
-        break;
-      default:
-        XLOG(INFO) << "invalid attribute received";
-    }
-  }
-  CHECK_NE(saiPortId, 0);
-  const auto& portManager = managerTable_->portManager();
-  const auto& vlanManager = managerTable_->vlanManager();
-  PortID swPortId = portManager.getPortID(saiPortId);
-  /*
-   * TODO: PortID 0 can be a valid port. Throw an exception or check for
-   * an invalid port id.
-   */
-  if (swPortId == 0) {
-    lock.unlock();
-    return;
+  if (!txThread_) {
+    txThread_ = std::make_unique<std::thread>([this]() { txThreadLoop(); });
   }
-  auto swVlanId = vlanManager.getVlanIdByPortId(swPortId);
-  auto rxPacket =
-      std::make_unique<SaiRxPacket>(buffer_size, buffer, swPortId, swVlanId);
-  /*
-   * TODO: unlock the mutex here because packet rx cb may end up calling packet
-   * tx function in the same thread stack, which also needs a lock.
-   */
-  lock.unlock();
-  callback_->packetReceived(std::move(rxPacket));
+  return ret;
 }
 
 void SaiSwitch::unregisterCallbacksLocked(
@@ -308,14 +319,35 @@ void SaiSwitch::unregisterCallbacksLocked(
 std::shared_ptr<SwitchState> SaiSwitch::stateChangedLocked(
     const std::lock_guard<std::mutex>& lock,
     const StateDelta& delta) {
-  managerTableLocked(lock)->portManager().processPortDelta(delta);
-  managerTableLocked(lock)->vlanManager().processVlanDelta(
-      delta.getVlansDelta());
-  managerTableLocked(lock)->routerInterfaceManager().processInterfaceDelta(
-      delta);
-  managerTableLocked(lock)->neighborManager().processNeighborDelta(delta);
-  managerTableLocked(lock)->routeManager().processRouteDelta(delta);
-  managerTableLocked(lock)->hostifManager().processControlPlaneDelta(delta);
+  auto managerTable = managerTableLocked(lock);
+  // Each of these creates objects that the following ones refer to, ending
+  // with the neighbors, whose next hops the routes point to.
+  managerTable->portManager().processPortDelta(delta);
+  managerTable->vlanManager().processVlanDelta(delta.getVlansDelta());
+  managerTable->routerInterfaceManager().processInterfaceDelta(delta);
+  managerTable->neighborManager().processNeighborDelta(delta);
+  // The hostif traps and the routes have no objects in common, so a changed
+  // control plane is programmed while the routes are. If the routes fail,
+  // the control plane is still waited for before the error is rethrown.
+  auto controlPlaneDelta = delta.getControlPlaneDelta();
+  auto controlPlane = folly::makeFuture();
+  if (controlPlaneDelta.getOld() != controlPlaneDelta.getNew()) {
+    controlPlane =
+        folly::via(managerTable->deltaExecutor(), [managerTable, &delta]() {
+          managerTable->hostifManager().processControlPlaneDelta(delta);
+        });
+  }
+  try {
+    managerTable->routeManager().processRouteDelta(delta);
+  } catch (...) {
+    controlPlane.wait();
+    throw;
+  }
+  std::move(controlPlane).get();
+  if (delta.oldState()->getPorts() != delta.newState()->getPorts() ||
+      delta.oldState()->getVlans() != delta.newState()->getVlans()) {
+    publishPacketIoTablesLocked(lock);
+  }
   return delta.newState();
 }
 
@@ -325,28 +357,48 @@ bool SaiSwitch::isValidStateUpdateLocked(
   return true;
 }
 
-std::unique_ptr<TxPacket> SaiSwitch::allocatePacketLocked(
-    const std::lock_guard<std::mutex>& /* lock */,
-    uint32_t size) const {
-  return std::make_unique<SaiTxPacket>(size);
-}
-
-bool SaiSwitch::sendPacketSwitchedAsyncLocked(
-    const std::lock_guard<std::mutex>& lock,
-    std::unique_ptr<TxPacket> pkt) noexcept {
-  return sendPacketSwitchedSyncLocked(lock, std::move(pkt));
+void SaiSwitch::publishPacketIoTablesLocked(
+    const std::lock_guard<std::mutex>& lock) {
+  auto tables = std::make_shared<PacketIoTables>();
+  const auto& managerTable = *managerTableLocked(lock);
+  for (const auto& entry : managerTable.portManager().getPortSaiIds()) {
+    tables->portIdBySaiPortId.emplace(entry.first, entry.second);
+    tables->saiPortIdByPortId.emplace(entry.second, PortSaiId(entry.first));
+  }
+  for (const auto& entry : managerTable.vlanManager().getVlanIdsByPortId()) {
+    tables->vlanIdByPortId.emplace(entry.first, entry.second);
+  }
+  packetIoTables_.set(std::move(tables));
 }
 
-bool SaiSwitch::sendPacketOutOfPortAsyncLocked(
-    const std::lock_guard<std::mutex>& lock,
-    std::unique_ptr<TxPacket> pkt,
-    PortID portID,
-    folly::Optional<uint8_t> /* queue */) noexcept {
-  return sendPacketOutOfPortSyncLocked(lock, std::move(pkt), portID);
+bool SaiSwitch::enqueueTx(TxRequest request) noexcept {
+  if (txRing_.write(std::move(request))) {
+    return true;
+  }
+  ++txRingDropped_;
+  XLOG_EVERY_MS(WARNING, 1000)
+      << "Dropping async tx packets: the tx queue of "
+      << txRing_.capacity() << " packets is full";
+  return false;
+}
+
+void SaiSwitch::txThreadLoop() {
+  initThread("fbossSaiTx");
+  while (true) {
+    TxRequest request;
+    txRing_.blockingRead(request);
+    if (!request.pkt) {
+      break;
+    }
+    if (request.portID) {
+      sendPacketOutOfPortImpl(std::move(request.pkt), *request.portID);
+    } else {
+      sendPacketSwitchedImpl(std::move(request.pkt));
+    }
+  }
 }
 
-bool SaiSwitch::sendPacketSwitchedSyncLocked(
-    const std::lock_guard<std::mutex>& lock,
+bool SaiSwitch::sendPacketSwitchedImpl(
     std::unique_ptr<TxPacket> pkt) noexcept {
   /*
   TODO: remove this hack when difference in src and dst mac is no longer
@@ -380,14 +432,14 @@ bool SaiSwitch::sendPacketSwitchedSyncLocked(
   return true;
 }
 
-bool SaiSwitch::sendPacketOutOfPortSyncLocked(
-    const std::lock_guard<std::mutex>& lock,
+bool SaiSwitch::sendPacketOutOfPortImpl(
     std::unique_ptr<TxPacket> pkt,
     PortID portID) noexcept {
-  auto portHandle =
-      managerTableLocked(lock)->portManager().getPortHandle(portID);
-  if (!portHandle) {
-    throw FbossError("Failed to send packet on invalid port: ", portID);
+  auto tables = packetIoTables_.get();
+  auto portItr = tables->saiPortIdByPortId.find(portID);
+  if (portItr == tables->saiPortIdByPortId.end()) {
+    XLOG(ERR) << "Failed to send packet on invalid port: " << portID;
+    return false;
   }
   /* TODO: this hack is required, sending packet out of port with with pipeline
   bypass, doesn't cause vlan tag stripping. fix this once a pipeline bypass with
@@ -425,8 +477,7 @@ bool SaiSwitch::sendPacketOutOfPortSyncLocked(
   SaiHostifApiPacket txPacket{
       reinterpret_cast<void*>(pkt->buf()->writableData()),
       pkt->buf()->length()};
-  SaiTxPacketTraits::Attributes::EgressPortOrLag egressPort(
-      portHandle->port->adapterKey());
+  SaiTxPacketTraits::Attributes::EgressPortOrLag egressPort(portItr->second);
   SaiTxPacketTraits::Attributes::TxType txType(
       SAI_HOSTIF_TX_TYPE_PIPELINE_BYPASS);
   SaiTxPacketTraits::TxAttributes attributes{txType, egressPort};
@@ -437,7 +488,11 @@ bool SaiSwitch::sendPacketOutOfPortSyncLocked(
 
 void SaiSwitch::updateStatsLocked(
     const std::lock_guard<std::mutex>& /* lock */,
-    SwitchStats* /* switchStats */) {}
+    SwitchStats* switchStats) {
+  if (auto dropped = txRingDropped_.exchange(0)) {
+    switchStats->asyncTxDropped(dropped);
+  }
+}
 
 void SaiSwitch::fetchL2TableLocked(
     const std::lock_guard<std::mutex>& /* lock */,
@@ -13,9 +13,16 @@
 #include "fboss/agent/hw/sai/api/SaiApiTable.h"
 #include "fboss/agent/hw/sai/switch/SaiManagerTable.h"
 #include "fboss/agent/hw/sai/switch/SaiRxPacket.h"
+#include "fboss/lib/ThreadCachedSnapshot.h"
 
+#include <folly/MPMCQueue.h>
+#include <folly/container/F14Map.h>
+
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <thread>
 
 namespace facebook {
 namespace fboss {
@@ -29,6 +36,8 @@ class SaiSwitch : public HwSwitch {
       uint32_t featuresDesired =
           (FeaturesDesired::PACKET_RX_DESIRED |
            FeaturesDesired::LINKSCAN_DESIRED));
+  ~SaiSwitch() override;
+
   HwInitResult init(Callback* callback) noexcept override;
 
   void unregisterCallbacks() noexcept override;
@@ -114,6 +123,10 @@ class SaiSwitch : public HwSwitch {
    *
    * Within SaiSwitch, no method should call methods from the public interface
    * to avoid a deadlock trying to lock saiSwitchMutex_ twice.
+   *
+   * The exception is the packet I/O path (allocatePacket, sendPacket*, and
+   * the packet rx and link state callbacks), which does not take
+   * saiSwitchMutex_ at all, see PacketIoTables below.
    */
   HwInitResult initLocked(
       const std::lock_guard<std::mutex>& lock,
@@ -130,29 +143,6 @@ class SaiSwitch : public HwSwitch {
       const std::lock_guard<std::mutex>& lock,
       const StateDelta& delta) const;
 
-  std::unique_ptr<TxPacket> allocatePacketLocked(
-      const std::lock_guard<std::mutex>& lock,
-      uint32_t size) const;
-
-  bool sendPacketSwitchedAsyncLocked(
-      const std::lock_guard<std::mutex>& lock,
-      std::unique_ptr<TxPacket> pkt) noexcept;
-
-  bool sendPacketOutOfPortAsyncLocked(
-      const std::lock_guard<std::mutex>& lock,
-      std::unique_ptr<TxPacket> pkt,
-      PortID portID,
-      folly::Optional<uint8_t> queue) noexcept;
-
-  bool sendPacketSwitchedSyncLocked(
-      const std::lock_guard<std::mutex>& lock,
-      std::unique_ptr<TxPacket> pkt) noexcept;
-
-  bool sendPacketOutOfPortSyncLocked(
-      const std::lock_guard<std::mutex>& lock,
-      std::unique_ptr<TxPacket> pkt,
-      PortID portID) noexcept;
-
   void updateStatsLocked(
       const std::lock_guard<std::mutex>& lock,
       SwitchStats* switchStats);
@@ -192,14 +182,6 @@ class SaiSwitch : public HwSwitch {
       const std::lock_guard<std::mutex>& lock,
       PortID port) const;
 
-  void packetRxCallbackLocked(
-      std::unique_lock<std::mutex>&& lock,
-      sai_object_id_t switch_id,
-      sai_size_t buffer_size,
-      const void* buffer,
-      uint32_t attr_count,
-      const sai_attribute_t* attr_list);
-
   void fdbEventCallbackLocked(
       uint32_t count,
       const sai_fdb_event_notification_data_t* data);
@@ -210,6 +192,35 @@ class SaiSwitch : public HwSwitch {
       const std::lock_guard<std::mutex>& lock) const;
   SaiManagerTable* managerTableLocked(const std::lock_guard<std::mutex>& lock);
 
+  /*
+   * Port and vlan lookups needed to send and receive packets. Packets are
+   * sent and received while stateChanged() may be programming a large delta
+   * under saiSwitchMutex_, so rather than querying the managers, the packet
+   * I/O path reads an immutable copy of these tables, which is rebuilt and
+   * published by the state update whenever ports or vlans change.
+   */
+  struct PacketIoTables {
+    folly::F14FastMap<sai_object_id_t, PortID> portIdBySaiPortId;
+    folly::F14FastMap<PortID, PortSaiId> saiPortIdByPortId;
+    folly::F14FastMap<PortID, VlanID> vlanIdByPortId;
+  };
+  void publishPacketIoTablesLocked(const std::lock_guard<std::mutex>& lock);
+
+  /*
+   * Async sends are queued on txRing_, and sent from txThread_.
+   * A request without a port is sent through the pipeline.
+   */
+  struct TxRequest {
+    std::unique_ptr<TxPacket> pkt;
+    std::optional<PortID> portID;
+  };
+  bool enqueueTx(TxRequest request) noexcept;
+  void txThreadLoop();
+  bool sendPacketSwitchedImpl(std::unique_ptr<TxPacket> pkt) noexcept;
+  bool sendPacketOutOfPortImpl(
+      std::unique_ptr<TxPacket> pkt,
+      PortID portID) noexcept;
+
   std::unique_ptr<SaiManagerTable> managerTable_;
   BootType bootType_{BootType::UNINITIALIZED};
   SaiPlatform* platform_;
@@ -219,11 +230,17 @@ class SaiSwitch : public HwSwitch {
    * are serialized by SwSwitch naturally, this prevents races between:
    * 1. updates
    * 2. queries (counters, thrift calls)
-   * 3. sai callbacks (port status, packet received)
+   * Packet I/O and port status callbacks deliberately stay out of it.
    */
   mutable std::mutex saiSwitchMutex_;
 
   SwitchSaiId switchId_;
+
+  ThreadCachedSnapshot<const PacketIoTables> packetIoTables_;
+  folly::MPMCQueue<TxRequest> txRing_;
+  // Async sends dropped because txRing_ was full, since the last updateStats
+  std::atomic<uint64_t> txRingDropped_{0};
+  std::unique_ptr<std::thread> txThread_;
 };
 
 } // namespace fboss
@@ -53,6 +53,9 @@ class SaiVlanManager {
   VlanID getVlanID(VlanSaiId saiVlanId) const;
   // TODO(borisb): remove after D15750266
   VlanID getVlanIdByPortId(PortID portId) const;
+  const folly::F14FastMap<PortID, VlanID>& getVlanIdsByPortId() const {
+    return vlanIdsByPortId_;
+  }
   const SaiVlanHandles& getVlanHandles() const {
     return handles_;
   }
@@ -14,7 +14,11 @@
 #include "fboss/agent/hw/sai/switch/SaiNeighborManager.h"
 #include "fboss/agent/hw/sai/switch/tests/ManagerTestBase.h"
 #include "fboss/agent/state/ArpEntry.h"
+#include "fboss/agent/state/ArpTable.h"
 #include "fboss/agent/state/NdpEntry.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
 #include "fboss/agent/types.h"
 
 using namespace facebook::fboss;
@@ -104,6 +108,37 @@ TEST_F(NeighborManagerTest, unresolveNeighbor) {
   checkMissing(pendingEntry);
 }
 
+TEST_F(NeighborManagerTest, processNeighborDeltaInOrder) {
+  // A state with the first host of one of the first two interfaces resolved
+  auto makeState = [this](int resolvedIntf) {
+    auto state = std::make_shared<SwitchState>();
+    for (int id : {0, 1}) {
+      auto vlan = makeVlan(testInterfaces[id]);
+      auto arpTable = std::make_shared<ArpTable>();
+      if (id == resolvedIntf) {
+        const auto& host = testInterfaces[id].remoteHosts[0];
+        arpTable->addEntry(
+            host.ip.asV4(),
+            host.mac,
+            PortDescriptor(PortID(host.port.id)),
+            InterfaceID(id));
+      }
+      vlan->setArpTable(arpTable);
+      state->addVlan(vlan);
+    }
+    state->publish();
+    return state;
+  };
+  // The delta adds the neighbor on vlan 0, then removes one on vlan 1 which
+  // was never programmed. The addition must be applied before the removal
+  // fails, as it would be without batching.
+  EXPECT_THROW(
+      saiManagerTable->neighborManager().processNeighborDelta(
+          StateDelta(makeState(1), makeState(0))),
+      FbossError);
+  checkEntry(makeArpEntry(intf0.id, h0), h0.mac);
+}
+
 TEST_F(NeighborManagerTest, getNonexistentNeighbor) {
   auto arpEntry = makeArpEntry(intf0.id, h0);
   checkMissing(arpEntry);
@@ -0,0 +1,154 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/IPAddressV4.h>
+
+#include "fboss/agent/hw/sai/fake/FakeSai.h"
+#include "fboss/agent/hw/sai/switch/SaiManagerTable.h"
+#include "fboss/agent/hw/sai/switch/SaiRouteManager.h"
+#include "fboss/agent/hw/sai/switch/tests/ManagerTestBase.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteTableRib.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+
+using namespace facebook::fboss;
+using folly::IPAddressV4;
+using std::make_shared;
+using std::shared_ptr;
+
+DEFINE_int32(route_count, 100000, "Number of routes in the benchmark delta");
+DEFINE_int32(
+    route_latency_ns,
+    1000,
+    "Time the fake adapter spends creating or removing each route, to model "
+    "the hardware table writes of a real adapter");
+
+DECLARE_int32(sai_route_delta_threads);
+
+namespace {
+
+/*
+ * Reuses the FakeSai manager setup from the SAI manager tests to program a
+ * single large route delta, the way SaiSwitch::stateChanged() would.
+ */
+class RouteDeltaBenchmark : public ManagerTestBase {
+ public:
+  RouteDeltaBenchmark() {
+    setupStage = SetupStage::PORT | SetupStage::VLAN | SetupStage::INTERFACE |
+        SetupStage::NEIGHBOR;
+  }
+
+  void init() {
+    SetUp();
+    emptyState_ = makeState({});
+    std::vector<shared_ptr<Route<IPAddressV4>>> routes;
+    for (uint32_t i = 0; i < FLAGS_route_count; ++i) {
+      TestRoute testRoute;
+      // 11.0.0.0/24, 11.0.1.0/24, ...
+      testRoute.destination = {
+          IPAddressV4::fromLongHBO(0x0b000000 + (i << 8)), 24};
+      // Spread the routes over a handful of ECMP groups
+      for (uint32_t intf = 0; intf <= i % 4; ++intf) {
+        testRoute.nextHopInterfaces.push_back(testInterfaces.at(intf));
+      }
+      routes.push_back(makeRoute(testRoute));
+    }
+    fullState_ = makeState(routes);
+  }
+
+  void addRoutes() {
+    saiManagerTable->routeManager().processRouteDelta(
+        StateDelta(emptyState_, fullState_));
+  }
+
+  void removeRoutes() {
+    saiManagerTable->routeManager().processRouteDelta(
+        StateDelta(fullState_, emptyState_));
+  }
+
+  void TestBody() override {}
+
+ private:
+  static shared_ptr<SwitchState> makeState(
+      const std::vector<shared_ptr<Route<IPAddressV4>>>& routes) {
+    auto rib = make_shared<RouteTable::RibTypeV4>();
+    for (const auto& route : routes) {
+      rib->addRoute(route);
+    }
+    auto routeTable = make_shared<RouteTable>(RouterID(0));
+    routeTable->setRib(rib);
+    auto routeTables = make_shared<RouteTableMap>();
+    routeTables->addRouteTable(routeTable);
+    auto state = make_shared<SwitchState>();
+    state->resetRouteTables(routeTables);
+    state->publish();
+    return state;
+  }
+
+  shared_ptr<SwitchState> emptyState_;
+  shared_ptr<SwitchState> fullState_;
+};
+
+RouteDeltaBenchmark* setup;
+
+} // unnamed namespace
+
+// The Serial benchmarks program the delta's batches one after another on a
+// single thread, the baseline for programming them concurrently.
+void addRoutes(int32_t threads) {
+  gflags::FlagSaver flagSaver;
+  FLAGS_sai_route_delta_threads = threads;
+  setup->addRoutes();
+  BENCHMARK_SUSPEND {
+    setup->removeRoutes();
+  }
+}
+
+void removeRoutes(int32_t threads) {
+  gflags::FlagSaver flagSaver;
+  FLAGS_sai_route_delta_threads = threads;
+  BENCHMARK_SUSPEND {
+    setup->addRoutes();
+  }
+  setup->removeRoutes();
+}
+
+BENCHMARK(RouteDeltaAddSerial) {
+  addRoutes(1);
+}
+
+BENCHMARK_RELATIVE(RouteDeltaAdd) {
+  addRoutes(FLAGS_sai_route_delta_threads);
+}
+
+BENCHMARK(RouteDeltaRemoveSerial) {
+  removeRoutes(1);
+}
+
+BENCHMARK_RELATIVE(RouteDeltaRemove) {
+  removeRoutes(FLAGS_sai_route_delta_threads);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  // Building the switch states is much more expensive than programming them,
+  // so do it once up front rather than in the benchmark functions.
+  RouteDeltaBenchmark benchmark;
+  benchmark.init();
+  setup = &benchmark;
+  FakeSai::getInstance()->routeLatency =
+      std::chrono::nanoseconds(FLAGS_route_latency_ns);
+
+  folly::runBenchmarks();
+  return 0;
+}
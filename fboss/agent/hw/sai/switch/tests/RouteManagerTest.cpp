@@ -9,14 +9,27 @@
  */
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/hw/sai/api/SaiApiTable.h"
+#include "fboss/agent/hw/sai/api/SaiObjectApi.h"
 #include "fboss/agent/hw/sai/fake/FakeSai.h"
 #include "fboss/agent/hw/sai/switch/SaiManagerTable.h"
 #include "fboss/agent/hw/sai/switch/SaiRouteManager.h"
 #include "fboss/agent/hw/sai/switch/SaiSwitchManager.h"
 #include "fboss/agent/hw/sai/switch/tests/ManagerTestBase.h"
 #include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteTableRib.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
 #include "fboss/agent/types.h"
 
+#include <gflags/gflags.h>
+
+#include <unordered_set>
+
+DECLARE_int32(sai_route_bulk_size);
+DECLARE_int32(sai_route_delta_threads);
+
 using namespace facebook::fboss;
 class RouteManagerTest : public ManagerTestBase {
  public:
@@ -34,6 +47,36 @@ class RouteManagerTest : public ManagerTestBase {
     tr1.nextHopInterfaces.push_back(testInterfaces.at(3));
   }
 
+  // Routes to 11.0.0.0/24, 11.0.1.0/24, ... over the next hops of tr1
+  std::vector<std::shared_ptr<Route<folly::IPAddressV4>>> makeRoutes(
+      uint32_t count) const {
+    std::vector<std::shared_ptr<Route<folly::IPAddressV4>>> routes;
+    for (uint32_t i = 0; i < count; ++i) {
+      TestRoute testRoute;
+      testRoute.destination = {
+          folly::IPAddressV4::fromLongHBO(0x0b000000 + (i << 8)), 24};
+      testRoute.nextHopInterfaces = tr1.nextHopInterfaces;
+      routes.push_back(makeRoute(testRoute));
+    }
+    return routes;
+  }
+
+  static std::shared_ptr<SwitchState> makeState(
+      const std::vector<std::shared_ptr<Route<folly::IPAddressV4>>>& routes) {
+    auto rib = std::make_shared<RouteTable::RibTypeV4>();
+    for (const auto& route : routes) {
+      rib->addRoute(route);
+    }
+    auto routeTable = std::make_shared<RouteTable>(RouterID(0));
+    routeTable->setRib(rib);
+    auto routeTables = std::make_shared<RouteTableMap>();
+    routeTables->addRouteTable(routeTable);
+    auto state = std::make_shared<SwitchState>();
+    state->resetRouteTables(routeTables);
+    state->publish();
+    return state;
+  }
+
   folly::CIDRNetwork d1;
   folly::CIDRNetwork d2;
   TestRoute tr1;
@@ -142,6 +185,89 @@ TEST_F(RouteManagerTest, removeRoute) {
   EXPECT_FALSE(saiRouteHandle);
 }
 
+TEST_F(RouteManagerTest, removeRouteFailure) {
+  auto r = makeRoute(tr1);
+  saiManagerTable->routeManager().addRoute<folly::IPAddressV4>(RouterID(0), r);
+  auto entry =
+      saiManagerTable->routeManager().routeEntryFromSwRoute(RouterID(0), r);
+  auto& routeApi = SaiApiTable::getInstance()->routeApi();
+  auto attributes = saiManagerTable->routeManager()
+                        .getRouteHandle(entry)
+                        ->route->attributes();
+  // Removed behind the manager's back, so removing it again fails
+  routeApi.remove2(entry);
+  EXPECT_THROW(
+      saiManagerTable->routeManager().removeRoute(RouterID(0), r),
+      SaiApiError);
+  // The route wasn't removed, so the manager still owns it
+  EXPECT_TRUE(saiManagerTable->routeManager().getRouteHandle(entry));
+  routeApi.create2<SaiRouteTraits>(entry, attributes);
+  saiManagerTable->routeManager().removeRoute(RouterID(0), r);
+  EXPECT_FALSE(saiManagerTable->routeManager().getRouteHandle(entry));
+}
+
+TEST_F(RouteManagerTest, processRouteDeltaConcurrently) {
+  gflags::FlagSaver flagSaver;
+  FLAGS_sai_route_bulk_size = 3;
+  FLAGS_sai_route_delta_threads = 4;
+  auto& routeManager = saiManagerTable->routeManager();
+  auto routes = makeRoutes(10);
+  auto emptyState = makeState({});
+  auto fullState = makeState(routes);
+  auto routeCount = getObjectCount<SaiRouteTraits>(0);
+
+  routeManager.processRouteDelta(StateDelta(emptyState, fullState));
+  for (const auto& route : routes) {
+    auto entry = routeManager.routeEntryFromSwRoute(RouterID(0), route);
+    EXPECT_TRUE(routeManager.getRouteHandle(entry));
+  }
+  EXPECT_EQ(getObjectCount<SaiRouteTraits>(0), routeCount + 10);
+
+  routeManager.processRouteDelta(StateDelta(fullState, emptyState));
+  for (const auto& route : routes) {
+    auto entry = routeManager.routeEntryFromSwRoute(RouterID(0), route);
+    EXPECT_FALSE(routeManager.getRouteHandle(entry));
+  }
+  EXPECT_EQ(getObjectCount<SaiRouteTraits>(0), routeCount);
+}
+
+TEST_F(RouteManagerTest, processRouteDeltaFailure) {
+  gflags::FlagSaver flagSaver;
+  FLAGS_sai_route_bulk_size = 3;
+  FLAGS_sai_route_delta_threads = 4;
+  auto& routeManager = saiManagerTable->routeManager();
+  auto routes = makeRoutes(10);
+  std::vector<SaiRouteTraits::RouteEntry> entries;
+  for (const auto& route : routes) {
+    entries.push_back(routeManager.routeEntryFromSwRoute(RouterID(0), route));
+  }
+  // Created behind the manager's back, so creating it again fails
+  auto& routeApi = SaiApiTable::getInstance()->routeApi();
+  routeApi.create2<SaiRouteTraits>(
+      entries[4], {SAI_PACKET_ACTION_DROP, std::nullopt});
+
+  EXPECT_THROW(
+      routeManager.processRouteDelta(
+          StateDelta(makeState({}), makeState(routes))),
+      SaiApiError);
+  // The other batches are still programmed, and every route which was
+  // programmed is tracked by the manager
+  auto keys = getObjectKeys<SaiRouteTraits>(0);
+  std::unordered_set<SaiRouteTraits::RouteEntry> programmed(
+      keys.begin(), keys.end());
+  EXPECT_FALSE(routeManager.getRouteHandle(entries[4]));
+  size_t tracked = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (i != 4) {
+      bool hasHandle = routeManager.getRouteHandle(entries[i]);
+      EXPECT_EQ(hasHandle, programmed.count(entries[i]) == 1);
+      tracked += hasHandle;
+    }
+  }
+  EXPECT_GE(tracked, 7);
+  routeApi.remove2(entries[4]);
+}
+
 TEST_F(RouteManagerTest, addDupRoute) {
   auto r = makeRoute(tr1);
   saiManagerTable->routeManager().addRoute<folly::IPAddressV4>(RouterID(0), r);
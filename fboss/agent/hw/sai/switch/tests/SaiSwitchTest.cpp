@@ -0,0 +1,170 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#include "fboss/agent/hw/sai/switch/SaiSwitch.h"
+#include "fboss/agent/hw/sai/fake/FakeSai.h"
+#include "fboss/agent/hw/test/AgentConfigFactory.h"
+#include "fboss/agent/platforms/common/PlatformProductInfo.h"
+#include "fboss/agent/platforms/sai/SaiFakePlatform.h"
+#include "fboss/agent/state/Route.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteTableRib.h"
+#include "fboss/agent/state/StateDelta.h"
+#include "fboss/agent/state/SwitchState.h"
+
+#include <folly/IPAddressV4.h>
+#include <folly/ScopeGuard.h>
+#include <folly/logging/xlog.h>
+#include <folly/synchronization/Baton.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace facebook::fboss;
+using folly::IPAddressV4;
+
+namespace {
+constexpr uint32_t kRouteCount = 100;
+
+std::shared_ptr<SwitchState> makeDropRouteState(uint32_t count) {
+  auto rib = std::make_shared<RouteTable::RibTypeV4>();
+  for (uint32_t i = 0; i < count; ++i) {
+    RouteFields<IPAddressV4>::Prefix prefix{
+        IPAddressV4::fromLongHBO(0x0b000000 + (i << 8)), 24};
+    RouteNextHopEntry entry(
+        RouteForwardAction::DROP, AdminDistance::STATIC_ROUTE);
+    auto route = std::make_shared<Route<IPAddressV4>>(prefix);
+    route->update(ClientID{42}, entry);
+    route->setResolved(entry);
+    rib->addRoute(route);
+  }
+  auto routeTable = std::make_shared<RouteTable>(RouterID(0));
+  routeTable->setRib(rib);
+  auto routeTables = std::make_shared<RouteTableMap>();
+  routeTables->addRouteTable(routeTable);
+  auto state = std::make_shared<SwitchState>();
+  state->resetRouteTables(routeTables);
+  state->publish();
+  return state;
+}
+} // namespace
+
+class SaiSwitchTest : public ::testing::Test, public HwSwitch::Callback {
+ public:
+  void SetUp() override {
+    fs = FakeSai::getInstance();
+    auto productInfo =
+        std::make_unique<PlatformProductInfo>(FLAGS_fruid_filepath);
+    saiPlatform = std::make_unique<SaiFakePlatform>(std::move(productInfo));
+    auto agentConfig = std::make_unique<AgentConfig>(
+        utility::getAgentConfig(), "dummyConfigStr");
+    saiPlatform->init(std::move(agentConfig));
+    // No rx or linkscan callbacks, the test drives the switch directly
+    saiSwitch = std::make_unique<SaiSwitch>(saiPlatform.get(), 0);
+    saiSwitch->init(this);
+  }
+
+  void packetReceived(std::unique_ptr<RxPacket> /* pkt */) noexcept override {}
+  void linkStateChanged(PortID /* port */, bool /* up */) override {}
+  void exitFatal() const noexcept override {}
+
+  std::unique_ptr<TxPacket> makePacket() const {
+    auto pkt = saiSwitch->allocatePacket(64);
+    memset(pkt->buf()->writableData(), 0, pkt->buf()->length());
+    return pkt;
+  }
+
+  std::shared_ptr<FakeSai> fs;
+  std::unique_ptr<SaiFakePlatform> saiPlatform;
+  std::unique_ptr<SaiSwitch> saiSwitch;
+};
+
+TEST_F(SaiSwitchTest, asyncTx) {
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(saiSwitch->sendPacketSwitchedAsync(makePacket()));
+  }
+}
+
+/*
+ * Sending a packet must not wait for a state update to finish programming:
+ * with the route delta held in the middle of programming routes, and so
+ * holding the switch's state lock, async sends still reach the adapter.
+ * The time from enqueueing each packet to the adapter sending it is logged.
+ */
+TEST_F(SaiSwitchTest, txDuringRouteDelta) {
+  constexpr int kPacketCount = 100;
+  auto emptyState = std::make_shared<SwitchState>();
+  emptyState->publish();
+  auto routeState = makeDropRouteState(kRouteCount);
+  auto routesBefore = fs->rm.map().size();
+
+  folly::Baton<> programming;
+  std::once_flag programmingStarted;
+  fs->routeProgrammingHook = [&]() {
+    std::call_once(programmingStarted, [&]() { programming.post(); });
+  };
+  // Packets are sent in the order they are queued, from the single tx thread
+  std::vector<std::chrono::steady_clock::time_point> enqueued(kPacketCount);
+  std::vector<std::chrono::steady_clock::time_point> sent(kPacketCount);
+  std::atomic<int> sentCount{0};
+  folly::Baton<> allSent;
+  fs->packetTxHook = [&]() {
+    auto i = sentCount++;
+    if (i < kPacketCount) {
+      sent[i] = std::chrono::steady_clock::now();
+    }
+    if (i + 1 == kPacketCount) {
+      allSent.post();
+    }
+  };
+  SCOPE_EXIT {
+    fs->routeProgrammingHook = nullptr;
+    fs->packetTxHook = nullptr;
+  };
+
+  // The route delta blocks on routeMutex until the packets below are sent
+  std::unique_lock<std::mutex> routes(fs->routeMutex);
+  std::thread updater([&]() {
+    saiSwitch->stateChanged(StateDelta(emptyState, routeState));
+  });
+  programming.wait();
+
+  for (int i = 0; i < kPacketCount; ++i) {
+    enqueued[i] = std::chrono::steady_clock::now();
+    EXPECT_TRUE(saiSwitch->sendPacketSwitchedAsync(makePacket()));
+  }
+  auto sentInTime = allSent.try_wait_for(std::chrono::seconds(10));
+
+  routes.unlock();
+  updater.join();
+  ASSERT_TRUE(sentInTime);
+  EXPECT_EQ(kPacketCount, sentCount.load());
+  EXPECT_EQ(routesBefore + kRouteCount, fs->rm.map().size());
+
+  std::chrono::microseconds total{0};
+  std::chrono::microseconds worst{0};
+  for (int i = 0; i < kPacketCount; ++i) {
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        sent[i] - enqueued[i]);
+    total += latency;
+    worst = std::max(worst, latency);
+  }
+  XLOG(INFO) << "Async tx latency during route delta: mean "
+             << (total / kPacketCount).count() << "us, max " << worst.count()
+             << "us";
+}
@@ -354,8 +354,26 @@ struct RxCaptureFilter {
   # can put additional Rx filters here if need be
 }
 
+/*
+ * Matches packets on their headers. A packet matches if every field that is
+ * set matches; unset fields match any packet.
+ */
+struct PacketMatch {
+  1: optional i32 ethertype
+  2: optional i32 vlan
+  // Only matches received packets
+  3: optional i32 srcPort
+  4: optional IpPrefix srcIp
+  5: optional IpPrefix dstIp
+  6: optional i16 ipProto
+  7: optional i32 l4SrcPort
+  8: optional i32 l4DstPort
+}
+
 struct CaptureFilter {
   1: RxCaptureFilter rxCaptureFilter;
+  // Capture packets matching any of these. Capture all packets if empty.
+  2: list<PacketMatch> packetMatches
 }
 
 struct CaptureInfo {
@@ -375,6 +393,19 @@ struct CaptureInfo {
    * set of criteria that packet must meet to be captured
    */
   4: CaptureFilter  filter
+  /*
+   * Limits on the disk space and bandwidth used by the capture. 0 means no
+   * limit.
+   *
+   * Once the capture file reaches maxFileBytes or maxFileSeconds, a new file
+   * is started, keeping at most numFiles files (<name>.pcap, <name>.pcap.1,
+   * etc). Packets beyond maxPktsPerSec or maxBytesPerSec are dropped.
+   */
+  5: i64 maxFileBytes = 0
+  6: i32 maxFileSeconds = 0
+  7: i32 numFiles = 1
+  8: i32 maxPktsPerSec = 0
+  9: i64 maxBytesPerSec = 0
 }
 
 struct RouteUpdateLoggingInfo {
@@ -724,6 +755,17 @@ service FbossCtrl extends fb303.FacebookService {
    */
   string getCurrentStateJSON(1: string jsonPointer)
 
+  /*
+   * Serialize at most limit elements, starting at offset, of the array in
+   * the switch state pointed by JSON pointer, e.g. the routes of a route
+   * table, without serializing the rest of the array
+   */
+  string getCurrentStateJSONPage(
+    1: string jsonPointer,
+    2: i64 offset,
+    3: i32 limit,
+  )
+
   /*
    * Apply patch at given path within the state tree. jsonPatch must  be
    * a valid JSON object string
@@ -111,7 +111,10 @@ void ConfigApplier::updateRibAndFib() {
   // Trigger recrusive resolution
   updater.updateDone();
 
-  fibUpdateCallback_(vrf_, *v4NetworkToRoute_, *v6NetworkToRoute_, cookie_);
+  // Resync the whole FIB, which after a warm boot may hold routes the RIB
+  // has not been told about
+  fibUpdateCallback_(
+      vrf_, *v4NetworkToRoute_, *v6NetworkToRoute_, nullptr, nullptr, cookie_);
 }
 
 void ConfigApplier::addInterfaceRoutes(
@@ -16,6 +16,8 @@
 #include <folly/logging/xlog.h>
 #include "fboss/agent/state/NodeMap.h"
 
+#include <vector>
+
 namespace facebook {
 namespace fboss {
 namespace rib {
@@ -23,10 +25,14 @@ namespace rib {
 ForwardingInformationBaseUpdater::ForwardingInformationBaseUpdater(
     RouterID vrf,
     const IPv4NetworkToRouteMap& v4NetworkToRoute,
-    const IPv6NetworkToRouteMap& v6NetworkToRoute)
+    const IPv6NetworkToRouteMap& v6NetworkToRoute,
+    const IPv4ChangedPrefixes* v4ChangedPrefixes,
+    const IPv6ChangedPrefixes* v6ChangedPrefixes)
     : vrf_(vrf),
       v4NetworkToRoute_(v4NetworkToRoute),
-      v6NetworkToRoute_(v6NetworkToRoute) {}
+      v6NetworkToRoute_(v6NetworkToRoute),
+      v4ChangedPrefixes_(v4ChangedPrefixes),
+      v6ChangedPrefixes_(v6ChangedPrefixes) {}
 
 std::shared_ptr<SwitchState> ForwardingInformationBaseUpdater::operator()(
     const std::shared_ptr<SwitchState>& state) {
@@ -43,42 +49,94 @@ std::shared_ptr<SwitchState> ForwardingInformationBaseUpdater::operator()(
   auto previousFibContainer = state->getFibs()->getFibContainerIf(vrf_);
   CHECK(previousFibContainer);
 
+  // Only the prefixes changed by the RIB update, or every prefix when
+  // resyncing, are patched into the FIBs; every other route is shared with
+  // the previous FIBs. So the resulting StateDelta only holds the routes
+  // that were really added, changed or removed.
+  auto nextFibV4 = createUpdatedFib(
+      v4NetworkToRoute_, v4ChangedPrefixes_, previousFibContainer->getFibV4());
+  auto nextFibV6 = createUpdatedFib(
+      v6NetworkToRoute_, v6ChangedPrefixes_, previousFibContainer->getFibV6());
+  if (nextFibV4 == previousFibContainer->getFibV4() &&
+      nextFibV6 == previousFibContainer->getFibV6()) {
+    return nextState;
+  }
+
   auto nextFibContainer = previousFibContainer->modify(&nextState);
 
-  nextFibContainer->writableFields()->fibV4 =
-      std::shared_ptr<ForwardingInformationBaseV4>(
-          createUpdatedFib(v4NetworkToRoute_));
-  nextFibContainer->writableFields()->fibV6 =
-      std::shared_ptr<ForwardingInformationBaseV6>(
-          createUpdatedFib(v6NetworkToRoute_));
+  nextFibContainer->writableFields()->fibV4 = std::move(nextFibV4);
+  nextFibContainer->writableFields()->fibV6 = std::move(nextFibV6);
 
   return nextState;
 }
 
 template <typename AddressT>
-std::unique_ptr<typename facebook::fboss::ForwardingInformationBase<AddressT>>
+std::shared_ptr<facebook::fboss::ForwardingInformationBase<AddressT>>
 ForwardingInformationBaseUpdater::createUpdatedFib(
-    const facebook::fboss::rib::NetworkToRouteMap<AddressT>& ribRange) {
-  typename facebook::fboss::ForwardingInformationBase<
-      AddressT>::Base::NodeContainer updatedFib;
-
-  for (const auto& ribRouteIt : ribRange) {
-    const facebook::fboss::rib::Route<AddressT>& ribRoute = ribRouteIt->value();
+    const facebook::fboss::rib::NetworkToRouteMap<AddressT>& ribRange,
+    const ChangedPrefixes<AddressT>* changedPrefixes,
+    const std::shared_ptr<facebook::fboss::ForwardingInformationBase<AddressT>>&
+        fib) {
+  ChangedPrefixes<AddressT> resyncedPrefixes;
+  if (!changedPrefixes) {
+    resyncedPrefixes = allPrefixes(ribRange, *fib);
+    changedPrefixes = &resyncedPrefixes;
+  }
 
-    if (!ribRoute.isResolved()) {
-      // The recursive resolution algorithm considers a next-hop TO_CPU or
-      // DROP to be resolved.
+  std::shared_ptr<facebook::fboss::ForwardingInformationBase<AddressT>>
+      updatedFib;
+  // Clone lazily: the cloned FIB shares its routes with fib, so this costs
+  // O(1) and only the patched prefixes copy part of the route map.
+  auto writableFib = [&]() {
+    if (!updatedFib) {
+      updatedFib = fib->isPublished() ? fib->clone() : fib;
+    }
+    return updatedFib.get();
+  };
+
+  for (const auto& prefix : *changedPrefixes) {
+    facebook::fboss::RoutePrefix<AddressT> fibPrefix{prefix.network,
+                                                     prefix.mask};
+    auto fibRoute = fib->exactMatch(fibPrefix);
+
+    auto ribRouteIt = ribRange.exactMatch(prefix.network, prefix.mask);
+    // The recursive resolution algorithm considers a next-hop TO_CPU or
+    // DROP to be resolved.
+    if (ribRouteIt == ribRange.end() || !ribRouteIt->value().isResolved()) {
+      if (fibRoute) {
+        writableFib()->removeNode(fibPrefix);
+      }
       continue;
     }
 
-    std::unique_ptr<facebook::fboss::Route<AddressT>> fibRoute =
-        toFibRoute(ribRoute);
-
-    auto prefix = fibRoute->prefix();
-    updatedFib.emplace(prefix, fibRoute.release());
+    std::shared_ptr<facebook::fboss::Route<AddressT>> newFibRoute =
+        toFibRoute(ribRouteIt->value());
+    if (!fibRoute) {
+      writableFib()->addNode(newFibRoute);
+    } else if (!fibRoute->isSame(newFibRoute.get())) {
+      writableFib()->updateNode(newFibRoute);
+    }
   }
 
-  return std::make_unique<ForwardingInformationBase<AddressT>>(updatedFib);
+  return updatedFib ? updatedFib : fib;
+}
+
+template <typename AddressT>
+ChangedPrefixes<AddressT> ForwardingInformationBaseUpdater::allPrefixes(
+    const facebook::fboss::rib::NetworkToRouteMap<AddressT>& ribRange,
+    const facebook::fboss::ForwardingInformationBase<AddressT>& fib) {
+  // Sorted once at the end, rather than inserted into the flat_set one by one
+  std::vector<RoutePrefix<AddressT>> prefixes;
+  prefixes.reserve(ribRange.size() + fib.size());
+  for (const auto& ribRoute : ribRange) {
+    prefixes.push_back(ribRoute.value().prefix());
+  }
+  for (const auto& fibRoute : fib) {
+    prefixes.push_back(
+        RoutePrefix<AddressT>{fibRoute->prefix().network,
+                              fibRoute->prefix().mask});
+  }
+  return ChangedPrefixes<AddressT>(prefixes.begin(), prefixes.end());
 }
 
 facebook::fboss::RouteNextHopEntry
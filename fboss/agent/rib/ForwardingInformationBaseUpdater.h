@@ -32,10 +32,17 @@ class RouteNextHopEntry;
 
 class ForwardingInformationBaseUpdater {
  public:
+  /*
+   * Only the routes for v4ChangedPrefixes and v6ChangedPrefixes are patched
+   * into the FIBs. If they are null, the FIBs are resynced with the whole
+   * RIB instead, which repairs any difference between them.
+   */
   ForwardingInformationBaseUpdater(
       RouterID vrf,
       const IPv4NetworkToRouteMap& v4NetworkToRoute,
-      const IPv6NetworkToRouteMap& v6NetworkToRoute);
+      const IPv6NetworkToRouteMap& v6NetworkToRoute,
+      const IPv4ChangedPrefixes* v4ChangedPrefixes,
+      const IPv6ChangedPrefixes* v6ChangedPrefixes);
 
   std::shared_ptr<SwitchState> operator()(
       const std::shared_ptr<SwitchState>& state);
@@ -47,14 +54,30 @@ class ForwardingInformationBaseUpdater {
       const Route<AddrT>& ribRoute);
 
  private:
+  // Returns fib with the routes for changedPrefixes patched in from ribRange,
+  // or with every route resynced from ribRange if changedPrefixes is null.
+  // Routes whose forwarding did not change, including all the routes outside
+  // of changedPrefixes, are the very same Route objects as in fib. If nothing
+  // changed, fib itself is returned.
   template <typename AddressT>
-  std::unique_ptr<typename facebook::fboss::ForwardingInformationBase<AddressT>>
+  std::shared_ptr<facebook::fboss::ForwardingInformationBase<AddressT>>
   createUpdatedFib(
-      const facebook::fboss::rib::NetworkToRouteMap<AddressT>& ribRange);
+      const facebook::fboss::rib::NetworkToRouteMap<AddressT>& ribRange,
+      const ChangedPrefixes<AddressT>* changedPrefixes,
+      const std::shared_ptr<
+          facebook::fboss::ForwardingInformationBase<AddressT>>& fib);
+
+  // Every prefix with a route in either ribRange or fib
+  template <typename AddressT>
+  static ChangedPrefixes<AddressT> allPrefixes(
+      const facebook::fboss::rib::NetworkToRouteMap<AddressT>& ribRange,
+      const facebook::fboss::ForwardingInformationBase<AddressT>& fib);
 
   RouterID vrf_;
   const IPv4NetworkToRouteMap& v4NetworkToRoute_;
   const IPv6NetworkToRouteMap& v6NetworkToRoute_;
+  const IPv4ChangedPrefixes* v4ChangedPrefixes_;
+  const IPv6ChangedPrefixes* v6ChangedPrefixes_;
 };
 
 } // namespace rib
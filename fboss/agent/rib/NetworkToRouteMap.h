@@ -10,12 +10,15 @@
 #pragma once
 
 #include "fboss/agent/rib/Route.h"
+#include "fboss/agent/state/RouteNextHopDependencies.h"
 #include "fboss/lib/RadixTree.h"
 
+#include <boost/container/flat_set.hpp>
 #include <folly/IPAddress.h>
 #include <folly/dynamic.h>
 
 #include <memory>
+#include <utility>
 
 namespace {
 constexpr auto kRoutes = "routes";
@@ -28,7 +31,53 @@ namespace rib {
 template <typename AddressT>
 class NetworkToRouteMap
     : public facebook::network::RadixTree<AddressT, Route<AddressT>> {
+  using Base = facebook::network::RadixTree<AddressT, Route<AddressT>>;
+
  public:
+  using Iterator = typename Base::Iterator;
+
+  /*
+   * The routes are also indexed by the recursive next hops of their best
+   * entry, so that a change to a prefix only requires resolving again the
+   * routes with a next hop inside it. The routes' entries are therefore only
+   * changed through the functions below, which keep the index up to date.
+   * The forwarding info of a route does not affect the index and may be
+   * changed in place.
+   */
+  std::pair<Iterator, bool> insert(
+      const RoutePrefix<AddressT>& prefix,
+      Route<AddressT> route) {
+    auto ret = Base::insert(prefix.network, prefix.mask, std::move(route));
+    updateNextHopDependencies(prefix);
+    return ret;
+  }
+
+  void updateEntry(Iterator it, ClientID clientID, RouteNextHopEntry entry) {
+    it->value().update(clientID, std::move(entry));
+    updateNextHopDependencies(it->value().prefix());
+  }
+
+  void delEntryForClient(Iterator it, ClientID clientID) {
+    it->value().delEntryForClient(clientID);
+    updateNextHopDependencies(it->value().prefix());
+  }
+
+  bool erase(Iterator it) {
+    auto prefix = it->value().prefix();
+    auto erased = Base::erase(it);
+    updateNextHopDependencies(prefix);
+    return erased;
+  }
+
+  /*
+   * Call fn with (next hop, prefix) for every route whose best entry has a
+   * recursive next hop within network.
+   */
+  template <typename Fn>
+  void forEachDependentRoute(const folly::CIDRNetwork& network, Fn fn) const {
+    nhopDependencies_.forEachDependentRoute(network, std::move(fn));
+  }
+
   folly::dynamic toFollyDynamic() const {
     folly::dynamic routesJson = folly::dynamic::array;
     for (const auto& route : *this) {
@@ -47,16 +96,38 @@ class NetworkToRouteMap
     for (const auto& routeJson : routesJson) {
       auto route = Route<AddressT>::fromFollyDynamic(routeJson);
       RoutePrefix<AddressT> prefix = route.prefix();
-      networkToRouteMap->insert(prefix.network, prefix.mask, std::move(route));
+      networkToRouteMap->insert(prefix, std::move(route));
     }
 
     return std::move(networkToRouteMap);
   }
+
+ private:
+  // Changing the tree directly would leave the next hop index stale
+  using Base::clear;
+  using Base::erase;
+  using Base::insert;
+
+  void updateNextHopDependencies(const RoutePrefix<AddressT>& prefix) {
+    auto it = this->exactMatch(prefix.network, prefix.mask);
+    nhopDependencies_.update(
+        prefix, it != this->end() ? &it->value() : nullptr);
+  }
+
+  RouteNextHopDependencies<RoutePrefix<AddressT>> nhopDependencies_;
 };
 
 using IPv4NetworkToRouteMap = NetworkToRouteMap<folly::IPAddressV4>;
 using IPv6NetworkToRouteMap = NetworkToRouteMap<folly::IPAddressV6>;
 
+// The prefixes whose route was removed or now resolves differently after an
+// update to a NetworkToRouteMap. Only these need to be patched into the FIB.
+template <typename AddressT>
+using ChangedPrefixes = boost::container::flat_set<RoutePrefix<AddressT>>;
+
+using IPv4ChangedPrefixes = ChangedPrefixes<folly::IPAddressV4>;
+using IPv6ChangedPrefixes = ChangedPrefixes<folly::IPAddressV6>;
+
 } // namespace rib
 } // namespace fboss
 } // namespace facebook
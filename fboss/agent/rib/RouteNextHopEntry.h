@@ -15,6 +15,7 @@
 
 #include "fboss/agent/rib/RouteNextHop.h"
 #include "fboss/agent/rib/RouteTypes.h"
+#include "fboss/agent/state/InternedNextHopSet.h"
 
 #include "fboss/agent/if/gen-cpp2/ctrl_types.h"
 
@@ -38,6 +39,7 @@ class RouteNextHopEntry {
  public:
   using Action = RouteForwardAction;
   using NextHopSet = boost::container::flat_set<NextHop>;
+  using InternedNextHops = InternedNextHopSet<NextHopSet>;
 
   RouteNextHopEntry(Action action, AdminDistance distance)
       : adminDistance_(distance), action_(action) {
@@ -47,9 +49,9 @@ class RouteNextHopEntry {
   RouteNextHopEntry(NextHopSet nhopSet, AdminDistance distance);
 
   RouteNextHopEntry(NextHop nhop, AdminDistance distance)
-      : adminDistance_(distance), action_(Action::NEXTHOPS) {
-    nhopSet_.emplace(std::move(nhop));
-  }
+      : adminDistance_(distance),
+        action_(Action::NEXTHOPS),
+        nhopSet_(InternedNextHops::intern(NextHopSet{std::move(nhop)})) {}
 
   AdminDistance getAdminDistance() const {
     return adminDistance_;
@@ -60,6 +62,14 @@ class RouteNextHopEntry {
   }
 
   const NextHopSet& getNextHopSet() const {
+    return nhopSet_ ? nhopSet_->nextHops() : InternedNextHops::emptyNextHops();
+  }
+
+  /*
+   * The shared next hop set, or null if there are no next hops.  Entries
+   * with equal next hops share the same instance.
+   */
+  const std::shared_ptr<const InternedNextHops>& getInternedNextHops() const {
     return nhopSet_;
   }
 
@@ -91,7 +101,7 @@ class RouteNextHopEntry {
 
   // Reset the NextHopSet
   void reset() {
-    nhopSet_.clear();
+    nhopSet_.reset();
     action_ = Action::DROP;
   }
 
@@ -111,7 +121,7 @@ class RouteNextHopEntry {
  private:
   AdminDistance adminDistance_;
   Action action_{Action::DROP};
-  NextHopSet nhopSet_;
+  std::shared_ptr<const InternedNextHops> nhopSet_;
 };
 
 /**
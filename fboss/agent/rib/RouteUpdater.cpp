@@ -47,23 +47,24 @@ template <typename AddressT>
 void RouteUpdater::addRouteImpl(
     const Prefix<AddressT>& prefix,
     NetworkToRouteMap<AddressT>* routes,
+    ChangedPrefixes<AddressT>* updated,
     ClientID clientID,
     RouteNextHopEntry entry) {
   auto it = routes->exactMatch(prefix.network, prefix.mask);
 
   if (it != routes->end()) {
-    Route<AddressT>* route = &(it->value());
-    if (route->has(clientID, entry)) {
+    if (it->value().has(clientID, entry)) {
       return;
     }
 
-    route->update(clientID, entry);
+    routes->updateEntry(it, clientID, entry);
+    updated->insert(prefix);
     return;
   }
 
   CHECK(it == routes->end());
-  routes->insert(
-      prefix.network, prefix.mask, Route<AddressT>(prefix, clientID, entry));
+  routes->insert(prefix, Route<AddressT>(prefix, clientID, entry));
+  updated->insert(prefix);
 }
 
 void RouteUpdater::addRoute(
@@ -73,14 +74,16 @@ void RouteUpdater::addRoute(
     RouteNextHopEntry entry) {
   if (network.isV4()) {
     PrefixV4 prefix{network.asV4().mask(mask), mask};
-    addRouteImpl(prefix, v4Routes_, clientID, std::move(entry));
+    addRouteImpl(
+        prefix, v4Routes_, &v4UpdatedPrefixes_, clientID, std::move(entry));
   } else {
     PrefixV6 prefix{network.asV6().mask(mask), mask};
     if (prefix.network.isLinkLocal()) {
       XLOG(DBG2) << "Ignoring v6 link-local interface route: " << prefix.str();
       return;
     }
-    addRouteImpl(prefix, v6Routes_, clientID, std::move(entry));
+    addRouteImpl(
+        prefix, v6Routes_, &v6UpdatedPrefixes_, clientID, std::move(entry));
   }
 }
 
@@ -105,6 +108,7 @@ void RouteUpdater::addLinkLocalRoutes() {
   addRouteImpl(
       kIPv6LinkLocalPrefix,
       v6Routes_,
+      &v6UpdatedPrefixes_,
       StdClientIds2ClientID(StdClientIds::LINKLOCAL_ROUTE),
       RouteNextHopEntry(
           RouteForwardAction::TO_CPU, AdminDistance::DIRECTLY_CONNECTED));
@@ -114,6 +118,7 @@ void RouteUpdater::delLinkLocalRoutes() {
   delRouteImpl(
       kIPv6LinkLocalPrefix,
       v6Routes_,
+      &v6UpdatedPrefixes_,
       StdClientIds2ClientID(StdClientIds::LINKLOCAL_ROUTE));
 }
 
@@ -121,6 +126,7 @@ template <typename AddressT>
 void RouteUpdater::delRouteImpl(
     const Prefix<AddressT>& prefix,
     NetworkToRouteMap<AddressT>* routes,
+    ChangedPrefixes<AddressT>* updated,
     ClientID clientID) {
   auto it = routes->exactMatch(prefix.network, prefix.mask);
   if (it == routes->end()) {
@@ -129,8 +135,9 @@ void RouteUpdater::delRouteImpl(
     return;
   }
 
-  Route<AddressT>& route = it->value();
-  route.delEntryForClient(clientID);
+  routes->delEntryForClient(it, clientID);
+  updated->insert(prefix);
+  const Route<AddressT>& route = it->value();
 
   XLOG(DBG3) << "Deleted next-hops for prefix " << prefix.str()
              << "from client " << clientID;
@@ -147,23 +154,28 @@ void RouteUpdater::delRoute(
     ClientID clientID) {
   if (network.isV4()) {
     PrefixV4 prefix{network.asV4().mask(mask), mask};
-    delRouteImpl(prefix, v4Routes_, clientID);
+    delRouteImpl(prefix, v4Routes_, &v4UpdatedPrefixes_, clientID);
   } else {
     CHECK(network.isV6());
     PrefixV6 prefix{network.asV6().mask(mask), mask};
-    delRouteImpl(prefix, v6Routes_, clientID);
+    delRouteImpl(prefix, v6Routes_, &v6UpdatedPrefixes_, clientID);
   }
 }
 
 template <typename AddressT>
 void RouteUpdater::removeAllRoutesFromClientImpl(
     NetworkToRouteMap<AddressT>* routes,
+    ChangedPrefixes<AddressT>* updated,
     ClientID clientID) {
   std::vector<typename NetworkToRouteMap<AddressT>::Iterator> toDelete;
 
   for (auto it : *routes) {
-    Route<AddressT>& route = it->value();
-    route.delEntryForClient(clientID);
+    const Route<AddressT>& route = it->value();
+    if (!route.getEntryForClient(clientID)) {
+      continue;
+    }
+    routes->delEntryForClient(it, clientID);
+    updated->insert(route.prefix());
     if (route.hasNoEntry()) {
       // The nexthops we removed was the only one.  Delete the route.
       toDelete.push_back(it);
@@ -177,8 +189,10 @@ void RouteUpdater::removeAllRoutesFromClientImpl(
 }
 
 void RouteUpdater::removeAllRoutesForClient(ClientID clientID) {
-  removeAllRoutesFromClientImpl<IPAddressV4>(v4Routes_, clientID);
-  removeAllRoutesFromClientImpl<IPAddressV6>(v6Routes_, clientID);
+  removeAllRoutesFromClientImpl<IPAddressV4>(
+      v4Routes_, &v4UpdatedPrefixes_, clientID);
+  removeAllRoutesFromClientImpl<IPAddressV6>(
+      v6Routes_, &v6UpdatedPrefixes_, clientID);
 }
 
 // Some helper functions for recursive weight resolution
@@ -527,8 +541,74 @@ void RouteUpdater::resolveOne(Route<AddressT>* route) {
 }
 
 template <typename AddressT>
-void RouteUpdater::resolve(NetworkToRouteMap<AddressT>* routes) {
-  for (auto it : *routes) {
+void RouteUpdater::addDependentRoutes(
+    NetworkToRouteMap<AddressT>* routes,
+    const folly::CIDRNetwork& network,
+    ChangedPrefixes<AddressT>* affected,
+    std::vector<folly::CIDRNetwork>* pending) {
+  routes->forEachDependentRoute(
+      network,
+      [&](const folly::IPAddress& nexthop, const Prefix<AddressT>& prefix) {
+        if (!affected->count(prefix) && isResolvedVia(nexthop, network) &&
+            affected->insert(prefix).second) {
+          pending->emplace_back(IPAddress(prefix.network), prefix.mask);
+        }
+      });
+}
+
+bool RouteUpdater::isResolvedVia(
+    const folly::IPAddress& nexthop,
+    const folly::CIDRNetwork& network) const {
+  // A next hop whose longest match is more specific than network does not
+  // resolve through it. If that more specific route changed as well, it is
+  // in the affected set already and its own dependents are found from it.
+  int longestMatchLength = -1;
+  if (nexthop.isV4()) {
+    auto it = v4Routes_->longestMatch(nexthop.asV4(), nexthop.bitCount());
+    if (it != v4Routes_->end()) {
+      longestMatchLength = it->masklen();
+    }
+  } else {
+    auto it = v6Routes_->longestMatch(nexthop.asV6(), nexthop.bitCount());
+    if (it != v6Routes_->end()) {
+      longestMatchLength = it->masklen();
+    }
+  }
+  return longestMatchLength <= network.second;
+}
+
+template <typename AddressT>
+std::vector<std::pair<Route<AddressT>*, RouteUpdater::ForwardInfo>>
+RouteUpdater::clearForward(
+    NetworkToRouteMap<AddressT>* routes,
+    const ChangedPrefixes<AddressT>& affected) {
+  std::vector<std::pair<Route<AddressT>*, ForwardInfo>> previous;
+  previous.reserve(affected.size());
+  for (const auto& prefix : affected) {
+    auto it = routes->exactMatch(prefix.network, prefix.mask);
+    if (it == routes->end()) {
+      // The route was deleted
+      continue;
+    }
+    Route<AddressT>& route = it->value();
+    previous.emplace_back(
+        &route,
+        ForwardInfo{
+            route.isResolved(), route.isConnected(), route.getForwardInfo()});
+    route.clearForward();
+  }
+  return previous;
+}
+
+template <typename AddressT>
+void RouteUpdater::resolve(
+    NetworkToRouteMap<AddressT>* routes,
+    const ChangedPrefixes<AddressT>& affected) {
+  for (const auto& prefix : affected) {
+    auto it = routes->exactMatch(prefix.network, prefix.mask);
+    if (it == routes->end()) {
+      continue;
+    }
     Route<AddressT>* route = &(it->value());
     if (route->needResolve()) {
       resolveOne(route);
@@ -537,17 +617,58 @@ void RouteUpdater::resolve(NetworkToRouteMap<AddressT>* routes) {
 }
 
 template <typename AddressT>
-void RouteUpdater::updateDoneImpl(NetworkToRouteMap<AddressT>* routes) {
-  for (auto it : *routes) {
-    Route<AddressT>& route = it->value();
-    route.clearForward();
+void RouteUpdater::updateChangedPrefixes(
+    NetworkToRouteMap<AddressT>* routes,
+    const ChangedPrefixes<AddressT>& affected,
+    const std::vector<std::pair<Route<AddressT>*, ForwardInfo>>& previous,
+    ChangedPrefixes<AddressT>* changed) {
+  for (const auto& prefix : affected) {
+    if (routes->exactMatch(prefix.network, prefix.mask) == routes->end()) {
+      changed->insert(prefix);
+    }
+  }
+  for (const auto& routeAndForwardInfo : previous) {
+    const Route<AddressT>& route = *routeAndForwardInfo.first;
+    const ForwardInfo& forwardInfo = routeAndForwardInfo.second;
+    if (route.isResolved() != forwardInfo.resolved ||
+        route.isConnected() != forwardInfo.connected ||
+        (route.isResolved() && !(route.getForwardInfo() == forwardInfo.fwd))) {
+      changed->insert(route.prefix());
+    }
   }
-  resolve(routes);
 }
 
 void RouteUpdater::updateDone() {
-  updateDoneImpl(v4Routes_);
-  updateDoneImpl(v6Routes_);
+  // Besides the updated routes, the routes resolving through them need to be
+  // resolved again, and so do the routes resolving through those in turn.
+  // Every other route keeps its current resolution.
+  auto v4Affected = v4UpdatedPrefixes_;
+  auto v6Affected = v6UpdatedPrefixes_;
+  std::vector<folly::CIDRNetwork> pending;
+  for (const auto& prefix : v4Affected) {
+    pending.emplace_back(IPAddress(prefix.network), prefix.mask);
+  }
+  for (const auto& prefix : v6Affected) {
+    pending.emplace_back(IPAddress(prefix.network), prefix.mask);
+  }
+  while (!pending.empty()) {
+    auto network = pending.back();
+    pending.pop_back();
+    addDependentRoutes(v4Routes_, network, &v4Affected, &pending);
+    addDependentRoutes(v6Routes_, network, &v6Affected, &pending);
+  }
+
+  // All the affected routes must be cleared before any of them is resolved,
+  // as resolveOne() recursively resolves the routes it goes through.
+  auto v4Previous = clearForward(v4Routes_, v4Affected);
+  auto v6Previous = clearForward(v6Routes_, v6Affected);
+  resolve(v4Routes_, v4Affected);
+  resolve(v6Routes_, v6Affected);
+
+  updateChangedPrefixes(
+      v4Routes_, v4Affected, v4Previous, &v4ChangedPrefixes_);
+  updateChangedPrefixes(
+      v6Routes_, v6Affected, v6Previous, &v6ChangedPrefixes_);
 }
 
 } // namespace rib
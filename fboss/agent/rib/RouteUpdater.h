@@ -20,6 +20,9 @@
 
 #include <folly/IPAddress.h>
 
+#include <utility>
+#include <vector>
+
 namespace facebook {
 namespace fboss {
 namespace rib {
@@ -74,9 +77,30 @@ class RouteUpdater {
 
   void updateDone();
 
+  // The prefixes whose forwarding changed, valid once updateDone() returns
+  const IPv4ChangedPrefixes& v4ChangedPrefixes() const {
+    return v4ChangedPrefixes_;
+  }
+  const IPv6ChangedPrefixes& v6ChangedPrefixes() const {
+    return v6ChangedPrefixes_;
+  }
+
  private:
   IPv4NetworkToRouteMap* v4Routes_{nullptr};
   IPv6NetworkToRouteMap* v6Routes_{nullptr};
+  // The prefixes added, modified or removed through this updater
+  IPv4ChangedPrefixes v4UpdatedPrefixes_;
+  IPv6ChangedPrefixes v6UpdatedPrefixes_;
+  // The prefixes whose forwarding changed as a result
+  IPv4ChangedPrefixes v4ChangedPrefixes_;
+  IPv6ChangedPrefixes v6ChangedPrefixes_;
+
+  // How a route was resolved before the update
+  struct ForwardInfo {
+    bool resolved;
+    bool connected;
+    RouteNextHopEntry fwd;
+  };
 
   // TODO(samank): rename in original file
   template <typename AddressT>
@@ -87,22 +111,44 @@ class RouteUpdater {
   void addRouteImpl(
       const Prefix<AddressT>& prefix,
       NetworkToRouteMap<AddressT>* routes,
+      ChangedPrefixes<AddressT>* updated,
       ClientID clientID,
       RouteNextHopEntry entry);
   template <typename AddressT>
   void delRouteImpl(
       const Prefix<AddressT>& prefix,
       NetworkToRouteMap<AddressT>* routes,
+      ChangedPrefixes<AddressT>* updated,
       ClientID clientID);
   template <typename AddressT>
   void removeAllRoutesFromClientImpl(
       NetworkToRouteMap<AddressT>* routes,
+      ChangedPrefixes<AddressT>* updated,
       ClientID clientID);
-  template <typename AddressT>
-  void updateDoneImpl(NetworkToRouteMap<AddressT>* routes);
 
   template <typename AddressT>
-  void resolve(NetworkToRouteMap<AddressT>* routes);
+  void addDependentRoutes(
+      NetworkToRouteMap<AddressT>* routes,
+      const folly::CIDRNetwork& network,
+      ChangedPrefixes<AddressT>* affected,
+      std::vector<folly::CIDRNetwork>* pending);
+  bool isResolvedVia(
+      const folly::IPAddress& nexthop,
+      const folly::CIDRNetwork& network) const;
+  template <typename AddressT>
+  std::vector<std::pair<Route<AddressT>*, ForwardInfo>> clearForward(
+      NetworkToRouteMap<AddressT>* routes,
+      const ChangedPrefixes<AddressT>& affected);
+  template <typename AddressT>
+  void resolve(
+      NetworkToRouteMap<AddressT>* routes,
+      const ChangedPrefixes<AddressT>& affected);
+  template <typename AddressT>
+  void updateChangedPrefixes(
+      NetworkToRouteMap<AddressT>* routes,
+      const ChangedPrefixes<AddressT>& affected,
+      const std::vector<std::pair<Route<AddressT>*, ForwardInfo>>& previous,
+      ChangedPrefixes<AddressT>* changed);
   template <typename AddressT>
   void resolveOne(Route<AddressT>* route);
 
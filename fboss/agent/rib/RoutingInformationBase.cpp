@@ -99,7 +99,11 @@ void RoutingInformationBase::reconfigure(
         updateFibCallback,
         cookie);
 
+    // The FIB is resynced with the RIB, so it is in sync again once this
+    // succeeds
+    vrfAndRouteTable.second.fibOutOfSync = true;
     configApplier.updateRibAndFib();
+    vrfAndRouteTable.second.fibOutOfSync = false;
   }
 }
 
@@ -163,11 +167,20 @@ RoutingInformationBase::UpdateStatistics RoutingInformationBase::update(
 
   updater.updateDone();
 
+  // Only the changed prefixes are patched into the FIB, unless an earlier
+  // FIB update failed and left the FIB behind the RIB. If this update fails
+  // as well, the next one resyncs the whole FIB.
+  auto& routeTable = it->second;
+  auto resync = routeTable.fibOutOfSync;
+  routeTable.fibOutOfSync = true;
   fibUpdateCallback(
       routerID,
-      it->second.v4NetworkToRoute,
-      it->second.v6NetworkToRoute,
+      routeTable.v4NetworkToRoute,
+      routeTable.v6NetworkToRoute,
+      resync ? nullptr : &updater.v4ChangedPrefixes(),
+      resync ? nullptr : &updater.v6ChangedPrefixes(),
       cookie);
+  routeTable.fibOutOfSync = false;
 
   return stats;
 }
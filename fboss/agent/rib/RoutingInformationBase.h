@@ -27,10 +27,17 @@ namespace rib {
 
 class RoutingInformationBase {
  public:
+  // v4ChangedPrefixes and v6ChangedPrefixes hold the prefixes the update
+  // changed the forwarding of, the rest of the FIB is left as is. They are
+  // null when the whole FIB must be resynced with the RIB instead: when
+  // config is applied, which includes the first update after a warm boot,
+  // and on the first update after a FIB update failed.
   using FibUpdateFunction = std::function<void(
       RouterID vrf,
       const IPv4NetworkToRouteMap& v4NetworkToRoute,
       const IPv6NetworkToRouteMap& v6NetworkToRoute,
+      const IPv4ChangedPrefixes* v4ChangedPrefixes,
+      const IPv6ChangedPrefixes* v6ChangedPrefixes,
       void* cookie)>;
 
   struct UpdateStatistics {
@@ -95,6 +102,9 @@ class RoutingInformationBase {
     IPv6NetworkToRouteMap v6NetworkToRoute;
 
     UpdateStatistics lastUpdateStats_;
+    // Set while the FIB may not match these routes, because the last FIB
+    // update failed
+    bool fibOutOfSync{false};
   };
 
   // Currently, route updates to separate VRFs are made to be sequential. In the
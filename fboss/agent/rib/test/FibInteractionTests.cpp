@@ -28,6 +28,7 @@
 
 #include "common/network/if/gen-cpp2/Address_types.h"
 #include "fboss/agent/AddressUtil.h"
+#include "fboss/agent/FbossError.h"
 #include "fboss/agent/hw/mock/MockPlatform.h"
 #include "fboss/agent/test/HwTestHandle.h"
 #include "fboss/agent/test/TestUtils.h"
@@ -48,13 +49,29 @@ void dynamicFibUpdate(
     facebook::fboss::RouterID vrf,
     const facebook::fboss::rib::IPv4NetworkToRouteMap& v4NetworkToRoute,
     const facebook::fboss::rib::IPv6NetworkToRouteMap& v6NetworkToRoute,
+    const facebook::fboss::rib::IPv4ChangedPrefixes* v4ChangedPrefixes,
+    const facebook::fboss::rib::IPv6ChangedPrefixes* v6ChangedPrefixes,
     void* cookie) {
   facebook::fboss::rib::ForwardingInformationBaseUpdater fibUpdater(
-      vrf, v4NetworkToRoute, v6NetworkToRoute);
+      vrf,
+      v4NetworkToRoute,
+      v6NetworkToRoute,
+      v4ChangedPrefixes,
+      v6ChangedPrefixes);
 
   auto sw = static_cast<facebook::fboss::SwSwitch*>(cookie);
   sw->updateStateBlocking("", std::move(fibUpdater));
 }
+
+void failedFibUpdate(
+    facebook::fboss::RouterID /* vrf */,
+    const facebook::fboss::rib::IPv4NetworkToRouteMap& /* v4NetworkToRoute */,
+    const facebook::fboss::rib::IPv6NetworkToRouteMap& /* v6NetworkToRoute */,
+    const facebook::fboss::rib::IPv4ChangedPrefixes* /* v4ChangedPrefixes */,
+    const facebook::fboss::rib::IPv6ChangedPrefixes* /* v6ChangedPrefixes */,
+    void* /* cookie */) {
+  throw facebook::fboss::FbossError("FIB update failed");
+}
 } // namespace
 
 TEST(RouteNextHopEntry, ConvertRibDropToFibDrop) {
@@ -205,13 +222,35 @@ TEST(ForwardingInformationBaseUpdater, ModifyUnpublishedSwitchState) {
   auto initialState = std::make_shared<facebook::fboss::SwitchState>();
   initialState->resetForwardingInformationBases(fibMap);
 
-  // Second, we pass the unpublished SwitchState through an update, which
-  // transitively invokes  modify() on the nodes in the Forwarding Information
-  // Base subtree
+  // Second, we pass the unpublished SwitchState through an update adding a
+  // route of each address family, which transitively invokes modify() on the
+  // nodes in the Forwarding Information Base subtree
+  facebook::fboss::rib::RouteNextHopEntry ribToCpu(
+      facebook::fboss::rib::RouteNextHopEntry::Action::TO_CPU,
+      kDefaultAdminDistance);
+
+  facebook::fboss::rib::PrefixV4 v4Prefix{folly::IPAddressV4("10.0.0.0"), 24};
+  facebook::fboss::rib::RouteV4 v4Route(
+      v4Prefix, facebook::fboss::ClientID(1), ribToCpu);
+  v4Route.setResolved(ribToCpu);
   facebook::fboss::rib::IPv4NetworkToRouteMap v4NetworkToRouteMap;
+  v4NetworkToRouteMap.insert(v4Prefix, v4Route);
+  facebook::fboss::rib::IPv4ChangedPrefixes v4ChangedPrefixes{v4Prefix};
+
+  facebook::fboss::rib::PrefixV6 v6Prefix{folly::IPAddressV6("1::"), 64};
+  facebook::fboss::rib::RouteV6 v6Route(
+      v6Prefix, facebook::fboss::ClientID(1), ribToCpu);
+  v6Route.setResolved(ribToCpu);
   facebook::fboss::rib::IPv6NetworkToRouteMap v6NetworkToRouteMap;
+  v6NetworkToRouteMap.insert(v6Prefix, v6Route);
+  facebook::fboss::rib::IPv6ChangedPrefixes v6ChangedPrefixes{v6Prefix};
+
   facebook::fboss::rib::ForwardingInformationBaseUpdater updater(
-      vrfOne, v4NetworkToRouteMap, v6NetworkToRouteMap);
+      vrfOne,
+      v4NetworkToRouteMap,
+      v6NetworkToRouteMap,
+      &v4ChangedPrefixes,
+      &v6ChangedPrefixes);
   auto updatedState = updater(initialState);
 
   // Lastly, we check that the invocations of modify() operated on the
@@ -243,6 +282,21 @@ TEST(ForwardingInformationBaseUpdater, ModifyUnpublishedSwitchState) {
                    ->getFibContainerIf(vrfOne)
                    ->getFibV6()
                    ->isPublished());
+
+  // The changed prefixes were patched into the FIBs
+  const auto& updatedFibContainer =
+      updatedState->getFibs()->getFibContainerIf(vrfOne);
+  ASSERT_EQ(1, updatedFibContainer->getFibV4()->size());
+  auto v4FibRoute = updatedFibContainer->getFibV4()->exactMatch(
+      facebook::fboss::RoutePrefixV4{v4Prefix.network, v4Prefix.mask});
+  ASSERT_NE(nullptr, v4FibRoute);
+  ASSERT_TRUE(v4FibRoute->isToCPU());
+
+  ASSERT_EQ(1, updatedFibContainer->getFibV6()->size());
+  auto v6FibRoute = updatedFibContainer->getFibV6()->exactMatch(
+      facebook::fboss::RoutePrefixV6{v6Prefix.network, v6Prefix.mask});
+  ASSERT_NE(nullptr, v6FibRoute);
+  ASSERT_TRUE(v6FibRoute->isToCPU());
 }
 
 namespace {
@@ -511,3 +565,152 @@ TEST(Rib, Update) {
   // + the one that gets added by default
   EXPECT_FIB_SIZE(state, vrfZero, 4, 4);
 }
+
+TEST(Rib, UpdateOnlyChangesAffectedFibRoutes) {
+  using namespace facebook::fboss;
+
+  const RouterID vrfZero{0};
+
+  cfg::SwitchConfig config;
+  config.vlans.resize(1);
+  config.vlans[0].id = 1;
+  config.interfaces.resize(1);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac_ref().value_unchecked() = "00:02:00:00:00:01";
+  config.interfaces[0].ipAddresses.resize(2);
+  config.interfaces[0].ipAddresses[0] = "192.168.0.19/24";
+  config.interfaces[0].ipAddresses[1] = "2401::1/64";
+
+  auto testHandle = createTestHandle(&config, ENABLE_STANDALONE_RIB);
+  auto sw = testHandle->getSw();
+
+  auto prefixA4 = folly::CIDRNetworkV4(folly::IPAddressV4("7.1.0.0"), 16);
+  auto prefixB4 = folly::CIDRNetworkV4(folly::IPAddressV4("7.2.0.0"), 16);
+  auto nexthop4 = folly::IPAddressV4("192.168.0.1");
+
+  std::vector<UnicastRoute> routesToPrefixA;
+  routesToPrefixA.push_back(
+      createUnicastRoute(prefixA4.first, prefixA4.second, nexthop4));
+  sw->rib()->update(
+      vrfZero,
+      ClientID(10),
+      AdminDistance::EBGP,
+      routesToPrefixA,
+      {},
+      false /* sync */,
+      "rib update unit test",
+      &dynamicFibUpdate,
+      static_cast<void*>(sw));
+
+  auto oldState = sw->getState();
+  auto oldRouteA = getRoute(oldState, vrfZero, prefixA4.first, prefixA4.second);
+  auto oldInterfaceRoute =
+      getRoute(oldState, vrfZero, folly::IPAddressV4("192.168.0.0"), 24);
+  ASSERT_NE(nullptr, oldRouteA);
+  ASSERT_NE(nullptr, oldInterfaceRoute);
+
+  std::vector<UnicastRoute> routesToPrefixB;
+  routesToPrefixB.push_back(
+      createUnicastRoute(prefixB4.first, prefixB4.second, nexthop4));
+  sw->rib()->update(
+      vrfZero,
+      ClientID(10),
+      AdminDistance::EBGP,
+      routesToPrefixB,
+      {},
+      false /* sync */,
+      "rib update unit test",
+      &dynamicFibUpdate,
+      static_cast<void*>(sw));
+
+  auto newState = sw->getState();
+  EXPECT_ROUTE(newState, vrfZero, prefixB4.first, prefixB4.second);
+  // Routes the update did not touch are shared with the previous FIB
+  EXPECT_EQ(
+      oldRouteA,
+      getRoute(newState, vrfZero, prefixA4.first, prefixA4.second));
+  EXPECT_EQ(
+      oldInterfaceRoute,
+      getRoute(newState, vrfZero, folly::IPAddressV4("192.168.0.0"), 24));
+  // The v6 FIB did not change at all
+  EXPECT_EQ(
+      oldState->getFibs()->getFibContainer(vrfZero)->getFibV6(),
+      newState->getFibs()->getFibContainer(vrfZero)->getFibV6());
+
+  // Re-adding the same route changes nothing
+  sw->rib()->update(
+      vrfZero,
+      ClientID(10),
+      AdminDistance::EBGP,
+      routesToPrefixB,
+      {},
+      false /* sync */,
+      "rib update unit test",
+      &dynamicFibUpdate,
+      static_cast<void*>(sw));
+  EXPECT_EQ(newState->getFibs(), sw->getState()->getFibs());
+}
+
+TEST(Rib, FailedFibUpdateIsRepairedByNextUpdate) {
+  using namespace facebook::fboss;
+
+  const RouterID vrfZero{0};
+
+  cfg::SwitchConfig config;
+  config.vlans.resize(1);
+  config.vlans[0].id = 1;
+  config.interfaces.resize(1);
+  config.interfaces[0].intfID = 1;
+  config.interfaces[0].vlanID = 1;
+  config.interfaces[0].routerID = 0;
+  config.interfaces[0].__isset.mac = true;
+  config.interfaces[0].mac_ref().value_unchecked() = "00:02:00:00:00:01";
+  config.interfaces[0].ipAddresses.resize(3);
+  config.interfaces[0].ipAddresses[0] = "0.0.0.0/0";
+  config.interfaces[0].ipAddresses[1] = "192.168.0.19/24";
+  config.interfaces[0].ipAddresses[2] = "::/0";
+
+  auto testHandle = createTestHandle(&config, ENABLE_STANDALONE_RIB);
+  auto sw = testHandle->getSw();
+
+  EXPECT_FIB_SIZE(sw->getState(), vrfZero, 2, 2);
+
+  auto nexthop = folly::IPAddressV4("11.11.11.11");
+  auto prefixA4 = folly::CIDRNetworkV4(folly::IPAddressV4("7.1.0.0"), 16);
+  auto prefixB4 = folly::CIDRNetworkV4(folly::IPAddressV4("7.2.0.0"), 16);
+
+  // The RIB takes the route, but the FIB never gets it
+  EXPECT_THROW(
+      sw->rib()->update(
+          vrfZero,
+          ClientID(10),
+          AdminDistance::EBGP,
+          {createUnicastRoute(prefixA4.first, prefixA4.second, nexthop)},
+          {},
+          false /* sync */,
+          "rib update unit test",
+          &failedFibUpdate,
+          static_cast<void*>(sw)),
+      FbossError);
+  EXPECT_NO_ROUTE(sw->getState(), vrfZero, prefixA4.first, prefixA4.second);
+  EXPECT_FIB_SIZE(sw->getState(), vrfZero, 2, 2);
+
+  // An update which does not touch prefix A brings the FIB back in sync with
+  // the RIB
+  sw->rib()->update(
+      vrfZero,
+      ClientID(20),
+      AdminDistance::EBGP,
+      {createUnicastRoute(prefixB4.first, prefixB4.second, nexthop)},
+      {},
+      false /* sync */,
+      "rib update unit test",
+      &dynamicFibUpdate,
+      static_cast<void*>(sw));
+  EXPECT_ROUTE(sw->getState(), vrfZero, prefixA4.first, prefixA4.second);
+  EXPECT_ROUTE(sw->getState(), vrfZero, prefixB4.first, prefixB4.second);
+  EXPECT_FIB_SIZE(sw->getState(), vrfZero, 4, 2);
+}
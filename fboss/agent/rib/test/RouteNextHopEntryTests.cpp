@@ -18,6 +18,7 @@
 #include <folly/IPAddress.h>
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <thread>
 #include <vector>
 
 using namespace facebook::fboss::rib;
@@ -158,3 +159,31 @@ TEST(RouteNextHopEntry, EmptyListIsDrop) {
   ASSERT_EQ(nextHopEntry.getAdminDistance(), kDefaultAdminDistance);
   ASSERT_EQ(nextHopEntry.getNextHopSet().size(), 0);
 }
+
+TEST(RouteNextHopEntry, SharedNextHopSet) {
+  UnicastRoute route;
+  route.set_dest(kPrefix);
+  route.set_nextHops(nextHopsThrift());
+
+  auto nextHopEntry = RouteNextHopEntry::from(route, kDefaultAdminDistance);
+  auto interned = nextHopEntry.getInternedNextHops();
+  ASSERT_NE(interned, nullptr);
+
+  // Entries built concurrently from the same next hops share one set
+  std::vector<std::thread> threads;
+  std::vector<RouteNextHopEntry::InternedNextHops::Ptr> results(8);
+  for (size_t i = 0; i < results.size(); ++i) {
+    threads.emplace_back([&route, &results, i] {
+      for (int j = 0; j < 1000; ++j) {
+        results[i] = RouteNextHopEntry::from(route, AdminDistance::IBGP)
+                         .getInternedNextHops();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& result : results) {
+    EXPECT_EQ(interned, result);
+  }
+}
@@ -886,6 +886,80 @@ TEST(Route, delRoutes) {
       v4Routes.end(), v4Routes.exactMatch(prefix22.network, prefix22.mask));
 }
 
+// Only the routes resolving through an updated route are resolved again
+TEST(Route, resolveOnlyAffectedRoutes) {
+  IPv4NetworkToRouteMap v4Routes;
+  IPv6NetworkToRouteMap v6Routes;
+
+  configRoutes(&v4Routes, &v6Routes);
+
+  RouteUpdater u1(&v4Routes, &v6Routes);
+  // 10/8 is resolved through interface 1, 20/8 through 10/8, and 30/8 and
+  // 40::/16 through interface 2
+  u1.addRoute(
+      IPAddress("10.0.0.0"),
+      8,
+      kClientA,
+      RouteNextHopEntry(makeNextHops({"1.1.1.10"}), kDistance));
+  u1.addRoute(
+      IPAddress("20.0.0.0"),
+      8,
+      kClientA,
+      RouteNextHopEntry(makeNextHops({"10.1.1.1"}), kDistance));
+  u1.addRoute(
+      IPAddress("30.0.0.0"),
+      8,
+      kClientA,
+      RouteNextHopEntry(makeNextHops({"2.2.2.10"}), kDistance));
+  u1.addRoute(
+      IPAddress("40::"),
+      16,
+      kClientA,
+      RouteNextHopEntry(makeNextHops({"10.1.1.2"}), kDistance));
+  u1.updateDone();
+  EXPECT_EQ(3, u1.v4ChangedPrefixes().size());
+  EXPECT_EQ(1, u1.v6ChangedPrefixes().size());
+
+  // Move 10/8 to interface 3
+  RouteUpdater u2(&v4Routes, &v6Routes);
+  u2.addRoute(
+      IPAddress("10.0.0.0"),
+      8,
+      kClientA,
+      RouteNextHopEntry(makeNextHops({"3.3.3.10"}), kDistance));
+  u2.updateDone();
+
+  IPv4ChangedPrefixes expectedV4{PrefixV4{IPAddressV4("10.0.0.0"), 8},
+                                 PrefixV4{IPAddressV4("20.0.0.0"), 8}};
+  EXPECT_EQ(expectedV4, u2.v4ChangedPrefixes());
+  IPv6ChangedPrefixes expectedV6{PrefixV6{IPAddressV6("40::"), 16}};
+  EXPECT_EQ(expectedV6, u2.v6ChangedPrefixes());
+  EXPECT_FWD_INFO(getRoute(v4Routes, "20.0.0.0/8"), InterfaceID(3), "3.3.3.10");
+  EXPECT_FWD_INFO(getRoute(v6Routes, "40::/16"), InterfaceID(3), "3.3.3.10");
+  EXPECT_FWD_INFO(getRoute(v4Routes, "30.0.0.0/8"), InterfaceID(2), "2.2.2.10");
+
+  // A more specific route for 10.1.1.1 only affects 20/8
+  RouteUpdater u3(&v4Routes, &v6Routes);
+  u3.addRoute(
+      IPAddress("10.1.1.0"),
+      24,
+      kClientA,
+      RouteNextHopEntry(makeNextHops({"4.4.4.10"}), kDistance));
+  u3.updateDone();
+  IPv4ChangedPrefixes expectedV4AfterU3{
+      PrefixV4{IPAddressV4("10.1.1.0"), 24},
+      PrefixV4{IPAddressV4("20.0.0.0"), 8}};
+  EXPECT_EQ(expectedV4AfterU3, u3.v4ChangedPrefixes());
+  EXPECT_FWD_INFO(getRoute(v4Routes, "20.0.0.0/8"), InterfaceID(4), "4.4.4.10");
+
+  // Deleting it moves 20/8 back to 10/8
+  RouteUpdater u4(&v4Routes, &v6Routes);
+  u4.delRoute(IPAddress("10.1.1.0"), 24, kClientA);
+  u4.updateDone();
+  EXPECT_EQ(expectedV4AfterU3, u4.v4ChangedPrefixes());
+  EXPECT_FWD_INFO(getRoute(v4Routes, "20.0.0.0/8"), InterfaceID(3), "3.3.3.10");
+}
+
 // Test equality of RouteNextHopsMulti.
 TEST(Route, equality) {
   // Create two identical RouteNextHopsMulti, and compare
@@ -19,9 +19,11 @@
 namespace facebook {
 namespace fboss {
 
+// The FIB is patched one prefix at a time by the standalone RIB, so use a
+// persistent container to share the unchanged routes between versions.
 template <typename AddressT>
 using ForwardingInformationBaseTraits =
-    NodeMapTraits<RoutePrefix<AddressT>, Route<AddressT>>;
+    PersistentNodeMapTraits<RoutePrefix<AddressT>, Route<AddressT>>;
 
 template <typename AddressT>
 class ForwardingInformationBase
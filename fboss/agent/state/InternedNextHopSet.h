@@ -0,0 +1,199 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/hash/Hash.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace facebook {
+namespace fboss {
+
+/*
+ * An immutable set of next hops, shared by every route using the same set.
+ *
+ * There are usually orders of magnitude fewer distinct next hop sets than
+ * routes, so rather than each route holding its own copy, sets are interned:
+ * intern() returns the existing instance for a set equal to the one passed
+ * in, if there is one.  Two interned sets are therefore equal exactly when
+ * they are the same object, and anything derived from the set (such as the
+ * normalized next hops) only needs to be computed once per set.
+ *
+ * Instances are refcounted, and removed from the intern table when the last
+ * route using them goes away.  intern() may be called from any thread.
+ *
+ * Shared by the RouteNextHopEntry of the switch state and of the standalone
+ * RIB, each interning its own NextHopSet type.
+ */
+template <typename NextHopSetT>
+class InternedNextHopSet {
+ public:
+  using NextHopSet = NextHopSetT;
+  using Ptr = std::shared_ptr<const InternedNextHopSet>;
+
+  static Ptr intern(NextHopSet nhops) {
+    auto hash = hashNextHops(nhops);
+    auto& shard = shardFor(hash);
+    // Declared before taking the lock, so that any references dropped here
+    // (which may be the last ones) are released after the lock.
+    Ptr interned;
+    std::vector<Ptr> others;
+    {
+      std::lock_guard<std::mutex> guard(shard.lock);
+      auto range = shard.sets.equal_range(hash);
+      for (auto it = range.first; it != range.second; ++it) {
+        auto existing = it->second.lock();
+        if (!existing) {
+          // Being released
+          continue;
+        }
+        if (existing->nhops_ == nhops) {
+          interned = std::move(existing);
+          break;
+        }
+        others.push_back(std::move(existing));
+      }
+      if (!interned) {
+        interned = Ptr(
+            new InternedNextHopSet(std::move(nhops), hash),
+            &InternedNextHopSet::release);
+        shard.sets.emplace(hash, interned);
+      }
+    }
+    return interned;
+  }
+
+  /*
+   * An empty set, for entries without next hops.
+   */
+  static const NextHopSet& emptyNextHops() {
+    static const NextHopSet kEmpty;
+    return kEmpty;
+  }
+
+  /*
+   * The number of distinct sets currently interned.
+   */
+  static size_t numInterned() {
+    size_t count = 0;
+    for (auto& shard : shards()) {
+      std::lock_guard<std::mutex> guard(shard.lock);
+      count += shard.sets.size();
+    }
+    return count;
+  }
+
+  const NextHopSet& nextHops() const {
+    return nhops_;
+  }
+
+  /*
+   * A process-wide unique ID for this set, which hardware layers may use to
+   * key their next hop groups instead of hashing the whole set.
+   */
+  uint64_t id() const {
+    return id_;
+  }
+
+  /*
+   * Return normalize(nextHops()), computing it only once for each value of
+   * ecmpWidth that it depends on.  The set itself is shared rather than
+   * copied, and stays valid even if a later call for another width
+   * replaces it.
+   */
+  template <typename NormalizeFn>
+  std::shared_ptr<const NextHopSet> normalizedNextHops(
+      int32_t ecmpWidth,
+      NormalizeFn&& normalize) const {
+    std::lock_guard<std::mutex> guard(normalizedLock_);
+    if (!normalized_ || normalizedEcmpWidth_ != ecmpWidth) {
+      normalized_ = std::make_shared<const NextHopSet>(normalize(nhops_));
+      normalizedEcmpWidth_ = ecmpWidth;
+    }
+    return normalized_;
+  }
+
+ private:
+  struct Shard {
+    std::mutex lock;
+    std::unordered_multimap<size_t, std::weak_ptr<const InternedNextHopSet>>
+        sets;
+  };
+  // Routes are deserialized in parallel during warm boot, so spread the
+  // table over several locks
+  static constexpr size_t kNumShards = 16;
+
+  InternedNextHopSet(NextHopSet nhops, size_t hash)
+      : nhops_(std::move(nhops)), hash_(hash), id_(nextId()) {}
+
+  // Forbidden copy constructor and assignment operator
+  InternedNextHopSet(InternedNextHopSet const&) = delete;
+  InternedNextHopSet& operator=(InternedNextHopSet const&) = delete;
+
+  static size_t hashNextHops(const NextHopSet& nhops) {
+    size_t hash = nhops.size();
+    for (const auto& nhop : nhops) {
+      auto intf = nhop.intfID();
+      hash = folly::hash::hash_combine(
+          hash,
+          nhop.addr().hash(),
+          intf ? static_cast<uint32_t>(*intf) : ~0u,
+          nhop.weight());
+    }
+    return hash;
+  }
+
+  static std::array<Shard, kNumShards>& shards() {
+    // Never destroyed, since routes may outlive static destruction
+    static auto* shards = new std::array<Shard, kNumShards>();
+    return *shards;
+  }
+
+  static Shard& shardFor(size_t hash) {
+    return shards()[hash % kNumShards];
+  }
+
+  static uint64_t nextId() {
+    static std::atomic<uint64_t> lastId{0};
+    return ++lastId;
+  }
+
+  static void release(const InternedNextHopSet* set) {
+    auto& shard = shardFor(set->hash_);
+    {
+      std::lock_guard<std::mutex> guard(shard.lock);
+      auto range = shard.sets.equal_range(set->hash_);
+      for (auto it = range.first; it != range.second;) {
+        if (it->second.expired()) {
+          it = shard.sets.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    delete set;
+  }
+
+  const NextHopSet nhops_;
+  const size_t hash_;
+  const uint64_t id_;
+
+  mutable std::mutex normalizedLock_;
+  mutable std::shared_ptr<const NextHopSet> normalized_;
+  mutable int32_t normalizedEcmpWidth_{0};
+};
+
+} // namespace fboss
+} // namespace facebook
@@ -9,14 +9,36 @@
  */
 #pragma once
 
+#include <type_traits>
+
 #include <boost/container/flat_map.hpp>
 
 #include "fboss/agent/state/NodeBase.h"
 #include "fboss/agent/state/NodeMapIterator.h"
+#include "fboss/lib/PersistentMap.h"
 
 namespace facebook {
 namespace fboss {
 
+namespace detail {
+/*
+ * By default nodes are stored in a flat_map, which is compact and fast to
+ * iterate but has to be copied in full whenever the NodeMap is cloned.  Traits
+ * may override this by defining a NodeContainer type.
+ */
+template <typename TraitsT, typename = void>
+struct NodeMapContainer {
+  using type = boost::container::flat_map<
+      typename TraitsT::KeyType,
+      std::shared_ptr<typename TraitsT::Node>>;
+};
+
+template <typename TraitsT>
+struct NodeMapContainer<TraitsT, std::void_t<typename TraitsT::NodeContainer>> {
+  using type = typename TraitsT::NodeContainer;
+};
+} // namespace detail
+
 /*
  * NodeMapFields defines the fields contained inside a NodeMapT instantiation
  */
@@ -25,8 +47,7 @@ struct NodeMapFields {
   using KeyType = typename TraitsT::KeyType;
   using Node = typename TraitsT::Node;
   using ExtraFields = typename TraitsT::ExtraFields;
-  using NodeContainer =
-      boost::container::flat_map<KeyType, std::shared_ptr<Node>>;
+  using NodeContainer = typename detail::NodeMapContainer<TraitsT>::type;
 
   NodeMapFields() {}
   NodeMapFields(NodeContainer nodes) : nodes(std::move(nodes)) {}
@@ -69,6 +90,17 @@ struct NodeMapTraits {
   }
 };
 
+/*
+ * Traits for large NodeMaps that see frequent single entry updates, such as
+ * route and neighbor tables.  Nodes are stored in a PersistentMap, so cloning
+ * the NodeMap shares the node container with the original and modifying a
+ * single node costs O(log N) instead of copying all N shared_ptrs.
+ */
+template <typename KeyT, typename NodeT, typename ExtraT = NodeMapNoExtraFields>
+struct PersistentNodeMapTraits : public NodeMapTraits<KeyT, NodeT, ExtraT> {
+  using NodeContainer = PersistentMap<KeyT, std::shared_ptr<NodeT>>;
+};
+
 /*
  * A helper class for implementing state nodes that store a set of Node
  * children.
@@ -12,7 +12,8 @@
 #include <boost/container/flat_map.hpp>
 
 /*
- * NodeMapIterator is a very small wrapper around flat_map::const_iterator.
+ * NodeMapIterator is a very small wrapper around the NodeContainer (flat_map
+ * or PersistentMap) const_iterator.
  *
  * The main difference is that dereferencing it returns only the Node,
  * and not a pair of (_Id, _Node)
@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include "fboss/lib/PersistentMap.h"
+
+#include <folly/IPAddress.h>
+
+#include <vector>
+
+namespace facebook {
+namespace fboss {
+
+/*
+ * A route with a recursive next hop depends on the longest match of that next
+ * hop, which may be a route of either address family.
+ */
+template <typename PrefixT>
+struct RouteNextHopDependency {
+  folly::IPAddress nexthop;
+  PrefixT route;
+
+  bool operator<(const RouteNextHopDependency& other) const {
+    // Order by family first, so next hops within a subnet are contiguous
+    if (nexthop.family() != other.nexthop.family()) {
+      return nexthop.family() < other.nexthop.family();
+    }
+    if (nexthop != other.nexthop) {
+      return nexthop < other.nexthop;
+    }
+    return route < other.route;
+  }
+  bool operator==(const RouteNextHopDependency& other) const {
+    return nexthop == other.nexthop && route == other.route;
+  }
+};
+
+/*
+ * Index of the routes of a table by the recursive next hops of their best
+ * entry, so that a change to a prefix only requires re-resolving the routes
+ * with a next hop inside it.
+ *
+ * Shared by the RouteTableRib of the switch state and the standalone RIB's
+ * NetworkToRouteMap. Both indexes are persistent containers, so copying them
+ * is O(1), as RouteTableRib::clone() requires.
+ */
+template <typename PrefixT>
+class RouteNextHopDependencies {
+ public:
+  /*
+   * Re-index prefix under the recursive next hops of the best entry of
+   * route, which is null if the prefix has no route any more.
+   */
+  template <typename RouteT>
+  void update(const PrefixT& prefix, const RouteT* route) {
+    std::vector<folly::IPAddress> nhops;
+    if (route && !route->hasNoEntry()) {
+      for (const auto& nhop : route->getBestEntry().second->getNextHopSet()) {
+        // Next hops with an interface are resolved already
+        if (!nhop.intfID().hasValue()) {
+          nhops.push_back(nhop.addr());
+        }
+      }
+    }
+
+    const auto& indexed = static_cast<const RouteNextHops&>(routeNhops_);
+    auto itr = indexed.find(prefix);
+    if (itr != indexed.end()) {
+      if (itr->second == nhops) {
+        return;
+      }
+      for (const auto& nhop : itr->second) {
+        dependents_.erase(RouteNextHopDependency<PrefixT>{nhop, prefix});
+      }
+    }
+    if (nhops.empty()) {
+      routeNhops_.erase(prefix);
+      return;
+    }
+    for (const auto& nhop : nhops) {
+      dependents_.emplace(RouteNextHopDependency<PrefixT>{nhop, prefix}, true);
+    }
+    routeNhops_[prefix] = std::move(nhops);
+  }
+
+  /*
+   * Call fn with (next hop, prefix) for every route whose best entry has a
+   * recursive next hop within network.
+   */
+  template <typename Fn>
+  void forEachDependentRoute(const folly::CIDRNetwork& network, Fn fn) const {
+    RouteNextHopDependency<PrefixT> first{network.first, PrefixT{}};
+    for (auto itr = dependents_.lower_bound(first); itr != dependents_.end();
+         ++itr) {
+      const auto& nexthop = itr->first.nexthop;
+      if (nexthop.family() != network.first.family() ||
+          !nexthop.inSubnet(network.first, network.second)) {
+        break;
+      }
+      fn(nexthop, itr->first.route);
+    }
+  }
+
+ private:
+  using Dependents = PersistentMap<RouteNextHopDependency<PrefixT>, bool>;
+  using RouteNextHops = PersistentMap<PrefixT, std::vector<folly::IPAddress>>;
+
+  Dependents dependents_;
+  // The next hops each route is currently indexed under in dependents_
+  RouteNextHops routeNhops_;
+};
+
+} // namespace fboss
+} // namespace facebook
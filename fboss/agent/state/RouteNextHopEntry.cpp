@@ -48,11 +48,11 @@ std::vector<NextHopThrift> fromRouteNextHopSet(RouteNextHopSet const& nhs) {
 
 RouteNextHopEntry::RouteNextHopEntry(NextHopSet nhopSet, AdminDistance distance)
     : adminDistance_(distance),
-      action_(Action::NEXTHOPS),
-      nhopSet_(std::move(nhopSet)) {
-  if (nhopSet_.size() == 0) {
+      action_(Action::NEXTHOPS) {
+  if (nhopSet.size() == 0) {
     throw FbossError("Empty nexthop set is passed to the RouteNextHopEntry");
   }
+  nhopSet_ = InternedNextHops::intern(std::move(nhopSet));
 }
 
 NextHopWeight RouteNextHopEntry::getTotalWeight() const {
@@ -83,7 +83,8 @@ std::string RouteNextHopEntry::str() const {
 bool operator==(const RouteNextHopEntry& a, const RouteNextHopEntry& b) {
   return (
       a.getAction() == b.getAction() and
-      a.getNextHopSet() == b.getNextHopSet() and
+      // Equal next hop sets are interned to the same instance
+      a.getInternedNextHops() == b.getInternedNextHops() and
       a.getAdminDistance() == b.getAdminDistance());
 }
 
@@ -91,9 +92,11 @@ bool operator<(const RouteNextHopEntry& a, const RouteNextHopEntry& b) {
   if (a.getAdminDistance() != b.getAdminDistance()) {
     return a.getAdminDistance() < b.getAdminDistance();
   }
-  return (
-      (a.getAction() == b.getAction()) ? (a.getNextHopSet() < b.getNextHopSet())
-                                       : a.getAction() < b.getAction());
+  if (a.getAction() != b.getAction()) {
+    return a.getAction() < b.getAction();
+  }
+  return a.getInternedNextHops() != b.getInternedNextHops() &&
+      a.getNextHopSet() < b.getNextHopSet();
 }
 
 // Methods for RouteNextHopEntry
@@ -132,7 +135,7 @@ folly::dynamic RouteNextHopEntry::toFollyDynamic() const {
   folly::dynamic entry = folly::dynamic::object;
   entry[kAction] = forwardActionStr(action_);
   folly::dynamic nhops = folly::dynamic::array;
-  for (const auto& nhop : nhopSet_) {
+  for (const auto& nhop : getNextHopSet()) {
     nhops.push_back(nhop.toFollyDynamic());
   }
   entry[kNexthops] = std::move(nhops);
@@ -149,8 +152,12 @@ RouteNextHopEntry RouteNextHopEntry::fromFollyDynamic(
       : AdminDistance(entryJson[kAdminDistance].asInt());
   RouteNextHopEntry entry(Action::DROP, adminDistance);
   entry.action_ = action;
+  NextHopSet nhops;
   for (const auto& nhop : entryJson[kNexthops]) {
-    entry.nhopSet_.insert(util::nextHopFromFollyDynamic(nhop));
+    nhops.insert(util::nextHopFromFollyDynamic(nhop));
+  }
+  if (!nhops.empty()) {
+    entry.nhopSet_ = InternedNextHops::intern(std::move(nhops));
   }
   return entry;
 }
@@ -159,7 +166,7 @@ bool RouteNextHopEntry::isValid(bool forMplsRoute) const {
   bool valid = true;
   if (!forMplsRoute) {
     /* for ip2mpls routes, next hop label forwarding action must be push */
-    for (const auto& nexthop : nhopSet_) {
+    for (const auto& nexthop : getNextHopSet()) {
       if (action_ != Action::NEXTHOPS) {
         continue;
       }
@@ -173,10 +180,21 @@ bool RouteNextHopEntry::isValid(bool forMplsRoute) const {
   return valid;
 }
 
-RouteNextHopEntry::NextHopSet RouteNextHopEntry::normalizedNextHops() const {
+std::shared_ptr<const RouteNextHopEntry::NextHopSet>
+RouteNextHopEntry::normalizedNextHops() const {
+  if (!nhopSet_) {
+    static const auto kEmpty = std::make_shared<const NextHopSet>();
+    return kEmpty;
+  }
+  // Many routes share the same next hops, so only normalize each set once
+  return nhopSet_->normalizedNextHops(FLAGS_ecmp_width, normalize);
+}
+
+RouteNextHopEntry::NextHopSet RouteNextHopEntry::normalize(
+    const NextHopSet& nhops) {
   NextHopSet normalizedNextHops;
   // 1)
-  for (const auto& nhop : getNextHopSet()) {
+  for (const auto& nhop : nhops) {
     normalizedNextHops.insert(ResolvedNextHop(
         nhop.addr(),
         nhop.intf(),
@@ -251,7 +269,7 @@ RouteNextHopEntry::NextHopSet RouteNextHopEntry::normalizedNextHops() const {
         }
       }
     }
-    XLOG(DBG2) << "Scaled next hops from " << getNextHopSet() << " to "
+    XLOG(DBG2) << "Scaled next hops from " << nhops << " to "
                << scaledNextHops;
     normalizedNextHops = scaledNextHops;
   }
@@ -13,6 +13,7 @@
 
 #include <folly/dynamic.h>
 
+#include "fboss/agent/state/InternedNextHopSet.h"
 #include "fboss/agent/state/RouteNextHop.h"
 #include "fboss/agent/state/RouteTypes.h"
 
@@ -25,6 +26,7 @@ class RouteNextHopEntry {
  public:
   using Action = RouteForwardAction;
   using NextHopSet = boost::container::flat_set<NextHop>;
+  using InternedNextHops = InternedNextHopSet<NextHopSet>;
 
   RouteNextHopEntry(Action action, AdminDistance distance)
       : adminDistance_(distance), action_(action) {
@@ -34,9 +36,9 @@ class RouteNextHopEntry {
   RouteNextHopEntry(NextHopSet nhopSet, AdminDistance distance);
 
   RouteNextHopEntry(NextHop nhop, AdminDistance distance)
-      : adminDistance_(distance), action_(Action::NEXTHOPS) {
-    nhopSet_.emplace(std::move(nhop));
-  }
+      : adminDistance_(distance),
+        action_(Action::NEXTHOPS),
+        nhopSet_(InternedNextHops::intern(NextHopSet{std::move(nhop)})) {}
 
   AdminDistance getAdminDistance() const {
     return adminDistance_;
@@ -47,10 +49,18 @@ class RouteNextHopEntry {
   }
 
   const NextHopSet& getNextHopSet() const {
+    return nhopSet_ ? nhopSet_->nextHops() : InternedNextHops::emptyNextHops();
+  }
+
+  /*
+   * The shared next hop set, or null if there are no next hops.  Entries
+   * with equal next hops share the same instance.
+   */
+  const std::shared_ptr<const InternedNextHops>& getInternedNextHops() const {
     return nhopSet_;
   }
 
-  NextHopSet normalizedNextHops() const;
+  std::shared_ptr<const NextHopSet> normalizedNextHops() const;
 
   // Get the sum of the weights of all the nexthops in the entry
   NextHopWeight getTotalWeight() const;
@@ -80,16 +90,18 @@ class RouteNextHopEntry {
 
   // Reset the NextHopSet
   void reset() {
-    nhopSet_.clear();
+    nhopSet_.reset();
     action_ = Action::DROP;
   }
 
   bool isValid(bool forMplsRoute = false) const;
 
  private:
+  static NextHopSet normalize(const NextHopSet& nhops);
+
   AdminDistance adminDistance_;
   Action action_{Action::DROP};
-  NextHopSet nhopSet_;
+  std::shared_ptr<const InternedNextHops> nhopSet_;
 };
 
 /**
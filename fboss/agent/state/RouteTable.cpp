@@ -18,8 +18,6 @@
 
 namespace {
 constexpr auto kRouterId = "routerId";
-constexpr auto kRibV4 = "ribV4";
-constexpr auto kRibV6 = "ribV6";
 } // namespace
 
 namespace facebook {
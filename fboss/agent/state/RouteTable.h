@@ -38,6 +38,9 @@ struct RouteTableFields {
    */
   static RouteTableFields fromFollyDynamic(const folly::dynamic& json);
 
+  static constexpr char kRibV4[] = "ribV4";
+  static constexpr char kRibV6[] = "ribV6";
+
   const RouterID id{0};
   typedef RouteTableRib<folly::IPAddressV4> RibTypeV4;
   typedef RouteTableRib<folly::IPAddressV6> RibTypeV6;
@@ -14,10 +14,6 @@
 #include "fboss/agent/state/RouteTable.h"
 #include "fboss/agent/state/SwitchState.h"
 
-namespace {
-constexpr auto kRoutes = "routes";
-}
-
 namespace facebook {
 namespace fboss {
 
@@ -63,9 +59,7 @@ std::shared_ptr<RouteTableRib<AddrT>> RouteTableRib<AddrT>::fromFollyDynamic(
   auto rib = std::make_shared<RouteTableRib<AddrT>>();
   auto routesJson = routes[kRoutes];
   for (const auto& routeJson : routesJson) {
-    auto route = Route<AddrT>::fromFollyDynamic(routeJson);
-    rib->addRoute(route);
-    rib->addRouteInRadixTree(route);
+    rib->addRoute(Route<AddrT>::fromFollyDynamic(routeJson));
   }
   return rib;
 }
@@ -82,18 +76,9 @@ RouteTableRib<AddrT>* RouteTableRib<AddrT>::modify(
       (*state)->getRouteTables()->getRouteTable(id);
   RouteTable* clonedRouteTable = routeTable->modify(state);
 
+  // The clone shares the routes, radix tree and next hop index with this rib,
+  // so it is in sync and ready to be modified right away.
   auto clonedRib = this->clone();
-  // Generate the radix tree from the cloned nodeMap_. Remember, we haven't
-  // clone every route yet. So we will still use the old route pointer.
-  // Right now only revertNewRouteEntry() needs modify(). The expected result of
-  // modify() is that we have a cloned RouteTableRib return if the current one
-  // is published. To make sure the cloned RouteTableRib works, we need to
-  // ensure radixTree_ and nodeMap_ in sync before we return a newly cloned rib.
-  for (const auto& node : nodeMap_->getAllNodes()) {
-    clonedRib->radixTree_.insert(
-        node.first.network, node.first.mask, node.second);
-  }
-  CHECK_EQ(clonedRib->size(), clonedRib->radixTree_.size());
 
   auto clonedRibPtr = clonedRib.get();
   clonedRouteTable->setRib(clonedRib);
@@ -104,19 +89,52 @@ RouteTableRib<AddrT>* RouteTableRib<AddrT>::modify(
 template <typename AddrT>
 void RouteTableRib<AddrT>::addRoute(
     const std::shared_ptr<Route<AddrT>>& route) {
+  const auto& prefix = route->prefix();
   nodeMap_->addRoute(route);
+  auto inserted = radixTree_.insert(prefix.network, prefix.mask, route).second;
+  if (!inserted) {
+    throw FbossError(
+        "Add failed, prefix for: ",
+        route->str(),
+        " already exists in RadixTree");
+  }
+  updateNextHopDependencies(prefix);
 }
 
 template <typename AddrT>
 void RouteTableRib<AddrT>::updateRoute(
     const std::shared_ptr<Route<AddrT>>& route) {
+  const auto& prefix = route->prefix();
   nodeMap_->updateRoute(route);
+  auto itr = radixTree_.exactMatch(prefix.network, prefix.mask);
+  if (itr == radixTree_.end()) {
+    throw FbossError(
+        "Update failed, prefix for: ",
+        route->str(),
+        " not present in RadixTree");
+  }
+  itr->value() = route;
+  updateNextHopDependencies(prefix);
 }
 
 template <typename AddrT>
 void RouteTableRib<AddrT>::removeRoute(
     const std::shared_ptr<Route<AddrT>>& route) {
+  const auto& prefix = route->prefix();
   nodeMap_->removeRoute(route);
+  auto erased = radixTree_.erase(prefix.network, prefix.mask);
+  if (!erased) {
+    throw FbossError(
+        "Remove failed, prefix for: ",
+        route->str(),
+        " not present in RadixTree");
+  }
+  updateNextHopDependencies(prefix);
+}
+
+template <typename AddrT>
+void RouteTableRib<AddrT>::updateNextHopDependencies(const Prefix& prefix) {
+  nhopDependencies_.update(prefix, exactMatch(prefix).get());
 }
 
 template class RouteTableRib<folly::IPAddressV4>;
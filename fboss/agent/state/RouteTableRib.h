@@ -10,11 +10,14 @@
 // Copyright 2004-present Facebook.  All rights reserved.
 #pragma once
 
+#include <vector>
+
 #include "fboss/agent/FbossError.h"
 #include "fboss/agent/state/NodeMap.h"
+#include "fboss/agent/state/RouteNextHopDependencies.h"
 #include "fboss/agent/state/RouteTypes.h"
 #include "fboss/agent/types.h"
-#include "fboss/lib/RadixTree.h"
+#include "fboss/lib/PersistentRadixTree.h"
 
 namespace facebook {
 namespace fboss {
@@ -28,7 +31,7 @@ class RouteTableRib;
 
 template <typename AddrT>
 using RouteTableRibNodeMapTraits =
-    NodeMapTraits<RoutePrefix<AddrT>, Route<AddrT>>;
+    PersistentNodeMapTraits<RoutePrefix<AddrT>, Route<AddrT>>;
 
 template <typename AddrT>
 class RouteTableRibNodeMap : public NodeMapT<
@@ -78,8 +81,8 @@ class RouteTableRib : public NodeBase {
 
   using Prefix = RoutePrefix<AddrT>;
   using RouteType = Route<AddrT>;
-  using RoutesRadixTree =
-      facebook::network::RadixTree<AddrT, std::shared_ptr<Route<AddrT>>>;
+  using RoutesRadixTree = facebook::network::
+      PersistentRadixTree<AddrT, std::shared_ptr<Route<AddrT>>>;
 
   bool empty() const {
     return nodeMap_->empty();
@@ -108,17 +111,15 @@ class RouteTableRib : public NodeBase {
 
   std::shared_ptr<RouteTableRib> clone() const {
     // In this clone(), we make sure the root RouteTableRib version increased by
-    // 1. And then we use the default NodeMap clone() to clone the childNode
-    // `nodeMap_`, so we don't have to clone every route in `nodeMap_`.
-    // Besides, we don't clone the RadixTree. So that, we can just add/update/
-    // remove routes on nodeMap_ and then call
-    // `cloneToRadixTreeWithForwardClear()` to build the whole radixTree_
-    // after all the changes.
+    // 1. The routes, the radix tree and the next hop index are all persistent
+    // containers, so the clone shares them with this RIB and later changes
+    // only copy the paths leading to the modified prefixes. The routes
+    // themselves are still the old route pointers until they are modified.
     auto routeTableRib =
         std::make_shared<RouteTableRib>(getNodeID(), getGeneration() + 1);
-    // Note: this is the default NodeMap clone(), only the nodeMap pointer is
-    // cloned, while all the routes are still the old route pointer.
     routeTableRib->nodeMap_ = nodeMap_->clone();
+    routeTableRib->radixTree_ = radixTree_;
+    routeTableRib->nhopDependencies_ = nhopDependencies_;
     return routeTableRib;
   }
 
@@ -140,11 +141,14 @@ class RouteTableRib : public NodeBase {
     return fromFollyDynamic(folly::parseJson(jsonStr));
   }
 
+  static constexpr char kRoutes[] = "routes";
+
   /*
    * The following functions modify the static state.
    * These should only be called on unpublished objects which are only visible
    * to a single thread.
-   * To add/update/remove a route, we only do it on nodeMap_
+   * Routes are added/updated/removed in nodeMap_, radixTree_ and the next hop
+   * index together, so they are always in sync.
    */
   void addRoute(const std::shared_ptr<Route<AddrT>>& route);
   void updateRoute(const std::shared_ptr<Route<AddrT>>& route);
@@ -153,19 +157,21 @@ class RouteTableRib : public NodeBase {
     return nodeMap_->getRouteIf(prefix);
   }
 
-  void cloneToRadixTreeWithForwardClear() {
-    // We should expect this function is called only before we publish the rib
-    CHECK(!isPublished());
-    radixTree_.clear();
-    for (const auto& node : nodeMap_->getAllNodes()) {
-      auto route = node.second;
-      if (route->isPublished()) {
-        route = route->clone(RouteType::Fields::COPY_PREFIX_AND_NEXTHOPS);
-      }
-      route->clearForward();
-      radixTree_.insert(node.first.network, node.first.mask, route);
-    }
-    CHECK_EQ(size(), radixTree_.size());
+  /*
+   * Re-index the next hops of the route for prefix, if any. Routes that are
+   * not published yet may be modified in place, in which case this must be
+   * called once the modification is done.
+   */
+  void updateNextHopDependencies(const Prefix& prefix);
+
+  /*
+   * Call fn with (next hop, prefix) for every route in this RIB whose best
+   * entry has a recursive next hop within network. These are the routes that
+   * may need to be resolved again when the route for network changes.
+   */
+  template <typename Fn>
+  void forEachDependentRoute(const folly::CIDRNetwork& network, Fn fn) const {
+    nhopDependencies_.forEachDependentRoute(network, std::move(fn));
   }
 
   // STRONGLY RECOMMEND to use routes() which returns the NodeMap
@@ -174,52 +180,17 @@ class RouteTableRib : public NodeBase {
   const RoutesRadixTree& routesRadixTree() const {
     return radixTree_;
   }
-  RoutesRadixTree& writableRoutesRadixTree() {
-    CHECK(!isPublished());
-    return radixTree_;
-  }
 
   std::shared_ptr<Route<AddrT>> longestMatch(const AddrT& nexthop) const {
     auto citr = radixTree_.longestMatch(nexthop, nexthop.bitCount());
     return citr != radixTree_.end() ? citr->value() : nullptr;
   }
 
-  void addRouteInRadixTree(const std::shared_ptr<Route<AddrT>>& route) {
-    auto inserted =
-        radixTree_.insert(route->prefix().network, route->prefix().mask, route)
-            .second;
-    if (!inserted) {
-      throw FbossError(
-          "Add failed, prefix for: ",
-          route->str(),
-          " already exists in RadixTree");
-    }
-  }
-  void updateRouteInRadixTree(const std::shared_ptr<Route<AddrT>>& route) {
-    auto itr =
-        radixTree_.exactMatch(route->prefix().network, route->prefix().mask);
-    if (itr == radixTree_.end()) {
-      throw FbossError(
-          "Update failed, prefix for: ",
-          route->str(),
-          " not present in RadixTree");
-    }
-    itr->value() = route;
-  }
-  void removeRouteInRadixTree(const std::shared_ptr<Route<AddrT>>& route) {
-    auto erased =
-        radixTree_.erase(route->prefix().network, route->prefix().mask);
-    if (!erased) {
-      throw FbossError(
-          "Remove failed, prefix for: ",
-          route->str(),
-          " not present in RadixTree");
-    }
-  }
-
  private:
   RoutesRadixTree radixTree_;
   std::shared_ptr<RoutesNodeMap> nodeMap_;
+  // Index of routes by the recursive next hops of their best entry
+  RouteNextHopDependencies<Prefix> nhopDependencies_;
 };
 
 } // namespace fboss
@@ -117,6 +117,7 @@ void RouteUpdater::addRouteImpl(
   rib = makeClone(ribCloned);
   // make sure rib is cloned before any change
   CHECK(ribCloned->cloned);
+  ribCloned->changed.insert(prefix);
   if (old) {
     std::shared_ptr<RouteT> newRoute;
     // If the node is not published yet, we assume this thread has exclusive
@@ -197,6 +198,7 @@ void RouteUpdater::delRouteImpl(
 
   // make sure rib is cloned before any change
   CHECK(ribCloned->cloned);
+  ribCloned->changed.insert(prefix);
   // If the node is not published yet, we assume this thread has exclusive
   // access to the node. Therefore, we can do the modification in-place
   // directly.
@@ -232,29 +234,31 @@ template <typename AddrT, typename RibT>
 void RouteUpdater::removeAllRoutesForClientImpl(
     RibT* ribCloned,
     ClientID clientId) {
+  std::vector<std::shared_ptr<Route<AddrT>>> routesToChange;
+  for (const auto& route : *ribCloned->rib->routes()) {
+    if (route->getEntryForClient(clientId)) {
+      routesToChange.push_back(route);
+    }
+  }
+  if (routesToChange.empty()) {
+    return;
+  }
   auto rib = makeClone(ribCloned);
 
-  std::vector<std::shared_ptr<Route<AddrT>>> routesToDelete;
-
   // make sure rib is cloned before any change
   CHECK(ribCloned->cloned);
-  for (auto& routeNode : rib->writableRoutes()->writableNodes()) {
-    auto route = routeNode.second;
+  for (auto route : routesToChange) {
+    ribCloned->changed.insert(route->prefix());
     if (route->isPublished()) {
       route = route->clone();
-      routeNode.second = route;
+      rib->updateRoute(route);
     }
     route->delEntryForClient(clientId);
     if (route->hasNoEntry()) {
       // The nexthops we removed was the only one.  Delete the route.
-      routesToDelete.push_back(routeNode.second);
+      rib->removeRoute(route);
     }
   }
-
-  // Now, delete whatever routes went from 1 nexthoplist to 0.
-  for (std::shared_ptr<Route<AddrT>>& route : routesToDelete) {
-    rib->removeRoute(route);
-  }
 }
 
 void RouteUpdater::removeAllRoutesForClient(RouterID rid, ClientID clientId) {
@@ -609,45 +613,130 @@ void RouteUpdater::resolveOne(RouteT* route, ClonedRib* ribCloned) {
              << " route " << route->str();
 }
 
-void RouteUpdater::resolve() {
-  // First, we need to make sure every route of the changed rib is cloned
-  // and the RadixTree of this changed rib is also generated.
-  // The reason why we have to do the same for-loop separately is because the
-  // resolveOne needs radixTree_ to find nexthop, so we have to build the tree
-  // before resolveOne().
-  for (auto& ribCloned : clonedRibs_) {
-    if (ribCloned.second.v4.cloned) {
-      ribCloned.second.v4.rib->cloneToRadixTreeWithForwardClear();
+bool RouteUpdater::isResolvedVia(
+    RouterID id,
+    const ClonedRib* ribCloned,
+    const folly::IPAddress& nexthop,
+    const folly::CIDRNetwork& network) const {
+  // A next hop is affected by a change to network only if its longest match
+  // was or now is the route for network itself. A next hop matching a longer,
+  // unchanged prefix within network resolves the same way as before.
+  auto matches = [&network](const auto& route) {
+    return route != nullptr && route->prefix().mask == network.second &&
+        IPAddress(route->prefix().network) == network.first;
+  };
+  auto origRt = orig_->getRouteTableIf(id);
+  if (nexthop.isV4()) {
+    const auto& nh = nexthop.asV4();
+    return matches(ribCloned->v4.rib->longestMatch(nh)) ||
+        (origRt && matches(origRt->getRibV4()->longestMatch(nh)));
+  }
+  const auto& nh = nexthop.asV6();
+  return matches(ribCloned->v6.rib->longestMatch(nh)) ||
+      (origRt && matches(origRt->getRibV6()->longestMatch(nh)));
+}
+
+template <typename AddrT, typename RibT>
+void RouteUpdater::clearForwardOfChanged(RibT* ribCloned) {
+  auto rib = ribCloned->rib.get();
+  for (const auto& prefix : ribCloned->changed) {
+    auto route = rib->exactMatch(prefix);
+    if (!route) {
+      // The route was deleted
+      continue;
     }
-    if (ribCloned.second.v6.cloned) {
-      ribCloned.second.v6.rib->cloneToRadixTreeWithForwardClear();
+    if (route->isPublished()) {
+      route = route->clone(RouteFields<AddrT>::COPY_PREFIX_AND_NEXTHOPS);
+      rib->updateRoute(route);
     }
+    route->clearForward();
   }
+}
 
-  // Ideally, just need to resolve the routes that is changed or impacted by
-  // the changed routes.
-  // However, Without copy-on-write RadixTree, it is O(n) to find out the
-  // routes that are changed. In this case, we just simply loop through all
-  // routes and resolve those that are not resolved yet.
-  // TODO(joseph5wu) T23364375 will try to improve it in the future.
-  for (auto& ribCloned : clonedRibs_) {
-    if (ribCloned.second.v4.cloned) {
-      auto rib = ribCloned.second.v4.rib.get();
-      for (auto& routeNode : rib->writableRoutesRadixTree()) {
-        if (routeNode.value()->needResolve()) {
-          resolveOne(routeNode.value().get(), &ribCloned.second);
-        }
-      }
+template <typename RibT>
+void RouteUpdater::resolveChangedRoutes(RibT* ribCloned, ClonedRib* clonedRib) {
+  auto rib = ribCloned->rib.get();
+  for (const auto& prefix : ribCloned->changed) {
+    auto route = rib->exactMatch(prefix);
+    if (route && route->needResolve()) {
+      resolveOne(route.get(), clonedRib);
     }
-    if (ribCloned.second.v6.cloned) {
-      auto rib = ribCloned.second.v6.rib.get();
-      for (auto& routeNode : rib->writableRoutesRadixTree()) {
-        if (routeNode.value()->needResolve()) {
-          resolveOne(routeNode.value().get(), &ribCloned.second);
-        }
+  }
+}
+
+void RouteUpdater::resolveChanged(RouterID id, ClonedRib* ribCloned) {
+  auto& v4 = ribCloned->v4;
+  auto& v6 = ribCloned->v6;
+  if (v4.changed.empty() && v6.changed.empty()) {
+    return;
+  }
+  // Routes that were not published yet may have been modified in place, so
+  // bring the next hop index of the changed routes up to date first.
+  for (const auto& prefix : v4.changed) {
+    v4.rib->updateNextHopDependencies(prefix);
+  }
+  for (const auto& prefix : v6.changed) {
+    v6.rib->updateNextHopDependencies(prefix);
+  }
+
+  // Find the routes resolving through a changed prefix. Their forwarding info
+  // may change as well, which affects the routes resolving through them in
+  // turn, so keep walking the next hop index until no new route is found.
+  std::vector<CIDRNetwork> pending;
+  for (const auto& prefix : v4.changed) {
+    pending.emplace_back(IPAddress(prefix.network), prefix.mask);
+  }
+  for (const auto& prefix : v6.changed) {
+    pending.emplace_back(IPAddress(prefix.network), prefix.mask);
+  }
+  while (!pending.empty()) {
+    auto network = pending.back();
+    pending.pop_back();
+
+    std::vector<std::pair<IPAddress, PrefixV4>> dependentsV4;
+    v4.rib->forEachDependentRoute(
+        network, [&](const IPAddress& nexthop, const PrefixV4& prefix) {
+          dependentsV4.emplace_back(nexthop, prefix);
+        });
+    std::vector<std::pair<IPAddress, PrefixV6>> dependentsV6;
+    v6.rib->forEachDependentRoute(
+        network, [&](const IPAddress& nexthop, const PrefixV6& prefix) {
+          dependentsV6.emplace_back(nexthop, prefix);
+        });
+
+    auto addDependent = [&](auto* rib, const auto& dependent) {
+      const auto& prefix = dependent.second;
+      if (rib->changed.count(prefix) ||
+          !isResolvedVia(id, ribCloned, dependent.first, network)) {
+        return;
       }
+      makeClone(rib);
+      rib->changed.insert(prefix);
+      pending.emplace_back(IPAddress(prefix.network), prefix.mask);
+    };
+    for (const auto& dependent : dependentsV4) {
+      addDependent(&v4, dependent);
+    }
+    for (const auto& dependent : dependentsV6) {
+      addDependent(&v6, dependent);
     }
   }
+
+  // Clear the forwarding info of every affected route before resolving any of
+  // them, since resolveOne() recursively resolves the routes it goes through.
+  clearForwardOfChanged<IPAddressV4>(&v4);
+  clearForwardOfChanged<IPAddressV6>(&v6);
+  resolveChangedRoutes(&v4, ribCloned);
+  resolveChangedRoutes(&v6, ribCloned);
+}
+
+void RouteUpdater::resolve() {
+  // Only the routes that changed, and the routes that resolve through them,
+  // need to be resolved again. Every other route keeps its published, already
+  // resolved forwarding info.
+  for (auto& ribCloned : clonedRibs_) {
+    resolveChanged(ribCloned.first, &ribCloned.second);
+  }
 }
 
 std::shared_ptr<RouteTableMap> RouteUpdater::updateDone() {
@@ -721,48 +810,44 @@ void RouteUpdater::addInterfaceAndLinkLocalRoutes(
   }
 }
 
-template <typename RibT>
-bool RouteUpdater::dedupRoutes(const RibT* oldRib, RibT* newRib) {
+template <typename RibT, typename PrefixSetT>
+bool RouteUpdater::dedupRoutes(
+    const RibT* oldRib,
+    RibT* newRib,
+    const PrefixSetT& changedPrefixes) {
   bool isSame = true;
   if (oldRib == newRib) {
     return isSame;
   }
-  const auto oldRoutes = oldRib->routes();
-  auto& newRoutes = newRib->writableRoutesRadixTree();
-  // make sure radixTree_ and nodeMap_ has the same size in newRib
-  CHECK_EQ(newRib->size(), newRoutes.size());
+  // newRib was cloned from oldRib, so any route outside of changedPrefixes
+  // is still the very same route object in both.
   // Copy routes from old route table if they are
   // same. For matching prefixes, which don't have
   // same attributes inherit the generation number
-  for (const auto& oldRoute : *oldRoutes) {
-    auto newIter = newRoutes.exactMatch(
-        oldRoute->prefix().network, oldRoute->prefix().mask);
-    if (newIter == newRoutes.end()) {
-      isSame = false;
+  for (const auto& prefix : changedPrefixes) {
+    auto oldRoute = oldRib->exactMatch(prefix);
+    auto newRoute = newRib->exactMatch(prefix);
+    if (!oldRoute || !newRoute) {
+      if (oldRoute != newRoute) {
+        // added or deleted
+        isSame = false;
+      }
+      continue;
+    }
+    if (oldRoute == newRoute) {
       continue;
     }
-    auto& newRoute = newIter->value();
     if (oldRoute->isSame(newRoute.get())) {
       // both routes are completely same, instead of using the new route,
-      // we re-use the old route. First update oldRoute to radixTree_
-      newIter->value() = oldRoute;
-      // we also need to update the nodeMap_
+      // we re-use the old route.
       newRib->updateRoute(oldRoute);
     } else {
       isSame = false;
       newRoute->inheritGeneration(*oldRoute);
-      newRib->updateRoute(newRoute);
     }
   }
-  if (newRoutes.size() != oldRoutes->size()) {
-    isSame = false;
-  } else {
-    // If sizes are same we would have already caught any
-    // difference while looking up all routes from oldRoutes
-    // in newRoutes, so do nothing
-  }
   // make sure after change nodeMap_ and radixTree_ size still match
-  CHECK_EQ(newRib->size(), newRoutes.size());
+  CHECK_EQ(newRib->size(), newRib->routesRadixTree().size());
   return isSame;
 }
 
@@ -789,10 +874,11 @@ std::shared_ptr<RouteTableMap> RouteUpdater::deduplicate(
     const auto& oldTable = oldIter->second;
     auto& newTable = newIter->second;
     if (oldTable != newTable) {
+      const auto& ribCloned = clonedRibs_.at(newVrf);
       // Handle V4 RIB
       const auto& oldV4 = oldTable->getRibV4();
       auto& newV4 = newTable->writableRibV4();
-      if (dedupRoutes(oldV4.get(), newV4.get())) {
+      if (dedupRoutes(oldV4.get(), newV4.get(), ribCloned.v4.changed)) {
         newTable->setRib(oldV4);
       } else {
         isSame = false;
@@ -801,7 +887,7 @@ std::shared_ptr<RouteTableMap> RouteUpdater::deduplicate(
       // Handle get V6 RIB
       const auto& oldV6 = oldTable->getRibV6();
       auto& newV6 = newTable->writableRibV6();
-      if (dedupRoutes(oldV6.get(), newV6.get())) {
+      if (dedupRoutes(oldV6.get(), newV6.get(), ribCloned.v6.changed)) {
         newTable->setRib(oldV6);
       } else {
         isSame = false;
@@ -106,13 +106,18 @@ class RouteUpdater {
   typedef RouteTableRib<folly::IPAddressV6> RouteTableRibV6;
 
   struct ClonedRib {
+    // changed holds the prefixes whose route may differ from the original
+    // rib: the ones added, modified or removed by this updater, and the ones
+    // that had to be resolved again because of them.
     struct RibV4 {
       std::shared_ptr<RouteTableRibV4> rib;
       bool cloned{false};
+      boost::container::flat_set<PrefixV4> changed;
     } v4;
     struct RibV6 {
       std::shared_ptr<RouteTableRibV6> rib;
       bool cloned{false};
+      boost::container::flat_set<PrefixV6> changed;
     } v6;
   };
   boost::container::flat_map<RouterID, ClonedRib> clonedRibs_;
@@ -137,8 +142,18 @@ class RouteUpdater {
   template <typename AddrT, typename RibT>
   void removeAllRoutesForClientImpl(RibT* ribCloned, ClientID clientId);
 
-  // resolve all routes that are not resolved yet
+  // resolve the changed routes and the routes depending on them
   void resolve();
+  void resolveChanged(RouterID id, ClonedRib* ribCloned);
+  template <typename AddrT, typename RibT>
+  void clearForwardOfChanged(RibT* ribCloned);
+  template <typename RibT>
+  void resolveChangedRoutes(RibT* ribCloned, ClonedRib* clonedRib);
+  bool isResolvedVia(
+      RouterID id,
+      const ClonedRib* ribCloned,
+      const folly::IPAddress& nexthop,
+      const folly::CIDRNetwork& network) const;
   template <typename RouteT>
   void resolveOne(RouteT* route, ClonedRib* clonedRib);
   template <typename RtRibT, typename AddrT>
@@ -151,8 +166,11 @@ class RouteUpdater {
       bool* hasDrop,
       RouteNextHopSet& fwd);
   // Functions to deduplicate routing tables during sync mode
-  template <typename RibT>
-  bool dedupRoutes(const RibT* origRib, RibT* newRib);
+  template <typename RibT, typename PrefixSetT>
+  bool dedupRoutes(
+      const RibT* origRib,
+      RibT* newRib,
+      const PrefixSetT& changedPrefixes);
   std::shared_ptr<RouteTableMap> deduplicate(RouteTableMap::NodeContainer* map);
 };
 
@@ -9,6 +9,7 @@
  */
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include <folly/FBString.h>
@@ -33,8 +34,24 @@ class SwitchState;
  */
 class StateUpdate {
  public:
-  explicit StateUpdate(folly::StringPiece name, bool allowCoalesce = true)
-      : name_(name.str()), allowCoalesce_(allowCoalesce) {}
+  /*
+   * The update thread keeps a separate queue for each priority.  Pending
+   * HIGH priority updates are always applied before any pending NORMAL ones,
+   * so that control plane critical changes (link state, LACP forwarding) are
+   * not stuck behind a burst of route or neighbor updates.  Updates of the
+   * same priority are applied in the order they were scheduled, but there is
+   * no ordering between updates of different priorities.
+   */
+  enum class Priority {
+    HIGH,
+    NORMAL,
+  };
+
+  explicit StateUpdate(
+      folly::StringPiece name,
+      bool allowCoalesce = true,
+      Priority priority = Priority::NORMAL)
+      : name_(name.str()), allowCoalesce_(allowCoalesce), priority_(priority) {}
   virtual ~StateUpdate() {}
 
   const std::string& getName() const {
@@ -45,6 +62,10 @@ class StateUpdate {
     return allowCoalesce_;
   }
 
+  Priority getPriority() const {
+    return priority_;
+  }
+
   /*
    * Apply the update, and return a new SwitchState.
    *
@@ -85,11 +106,14 @@ class StateUpdate {
 
   std::string name_;
   bool allowCoalesce_;
+  Priority priority_;
 
   // An intrusive list hook for maintaining the list of pending updates.
   folly::IntrusiveListHook listHook_;
-  // The SwSwitch code needs access to our listHook_ member so it can maintain
-  // the update list.
+  // When the update was scheduled, used to measure queueing delay.
+  std::chrono::steady_clock::time_point enqueueTime_;
+  // The SwSwitch code needs access to our listHook_ and enqueueTime_ members
+  // so it can maintain the update list.
   friend class SwSwitch;
 };
 
@@ -29,29 +29,18 @@
 
 #include "fboss/agent/state/NodeBase-defs.h"
 
+#include <future>
+
 using std::make_shared;
 using std::shared_ptr;
 using std::chrono::seconds;
 
 namespace {
-constexpr auto kInterfaces = "interfaces";
-constexpr auto kPorts = "ports";
-constexpr auto kVlans = "vlans";
-constexpr auto kRouteTables = "routeTables";
-constexpr auto kDefaultVlan = "defaultVlan";
-constexpr auto kAcls = "acls";
-constexpr auto kSflowCollectors = "sFlowCollectors";
-constexpr auto kControlPlane = "controlPlane";
-constexpr auto kQosPolicies = "qosPolicies";
 constexpr auto kArpTimeout = "arpTimeout";
 constexpr auto kNdpTimeout = "ndpTimeout";
 constexpr auto kArpAgerInterval = "arpAgerInterval";
 constexpr auto kMaxNeighborProbes = "maxNeighborProbes";
 constexpr auto kStaleEntryInterval = "staleEntryInterval";
-constexpr auto kLoadBalancers = "loadBalancers";
-constexpr auto kMirrors = "mirrors";
-constexpr auto kAggregatePorts = "aggregatePorts";
-constexpr auto kLabelForwardingInformationBase = "labelFib";
 
 // TODO: remove validator when oss gflags supports DEFINE_uint32 directly
 bool ValidateEcmpWidth(const char* flagname, int32_t value) {
@@ -109,12 +98,19 @@ folly::dynamic SwitchStateFields::toFollyDynamic() const {
 SwitchStateFields SwitchStateFields::fromFollyDynamic(
     const folly::dynamic& swJson) {
   SwitchStateFields switchState;
+  // Route tables, vlans (which hold the neighbor tables) and acls make up
+  // nearly all of a large state, so build them in parallel with the rest.
+  auto routeTables = std::async(std::launch::async, [&swJson]() {
+    return RouteTableMap::fromFollyDynamic(swJson[kRouteTables]);
+  });
+  auto vlans = std::async(std::launch::async, [&swJson]() {
+    return VlanMap::fromFollyDynamic(swJson[kVlans]);
+  });
+  auto acls = std::async(std::launch::async, [&swJson]() {
+    return AclMap::fromFollyDynamic(swJson[kAcls]);
+  });
   switchState.interfaces = InterfaceMap::fromFollyDynamic(swJson[kInterfaces]);
   switchState.ports = PortMap::fromFollyDynamic(swJson[kPorts]);
-  switchState.vlans = VlanMap::fromFollyDynamic(swJson[kVlans]);
-  switchState.routeTables =
-      RouteTableMap::fromFollyDynamic(swJson[kRouteTables]);
-  switchState.acls = AclMap::fromFollyDynamic(swJson[kAcls]);
   if (swJson.count(kSflowCollectors) > 0) {
     switchState.sFlowCollectors =
         SflowCollectorMap::fromFollyDynamic(swJson[kSflowCollectors]);
@@ -143,6 +139,9 @@ SwitchStateFields SwitchStateFields::fromFollyDynamic(
     switchState.labelFib = LabelForwardingInformationBase::fromFollyDynamic(
         swJson[kLabelForwardingInformationBase]);
   }
+  switchState.routeTables = routeTables.get();
+  switchState.vlans = vlans.get();
+  switchState.acls = acls.get();
   // TODO verify that created state here is internally consistent t4155406
   return switchState;
 }
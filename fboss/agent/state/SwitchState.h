@@ -69,6 +69,22 @@ struct SwitchStateFields {
    * Reconstruct object from folly::dynamic
    */
   static SwitchStateFields fromFollyDynamic(const folly::dynamic& json);
+
+  // Keys of the serialized state
+  static constexpr char kInterfaces[] = "interfaces";
+  static constexpr char kPorts[] = "ports";
+  static constexpr char kVlans[] = "vlans";
+  static constexpr char kRouteTables[] = "routeTables";
+  static constexpr char kDefaultVlan[] = "defaultVlan";
+  static constexpr char kAcls[] = "acls";
+  static constexpr char kSflowCollectors[] = "sFlowCollectors";
+  static constexpr char kControlPlane[] = "controlPlane";
+  static constexpr char kQosPolicies[] = "qosPolicies";
+  static constexpr char kLoadBalancers[] = "loadBalancers";
+  static constexpr char kMirrors[] = "mirrors";
+  static constexpr char kAggregatePorts[] = "aggregatePorts";
+  static constexpr char kLabelForwardingInformationBase[] = "labelFib";
+
   // Static state, which can be accessed without locking.
   std::shared_ptr<PortMap> ports;
   std::shared_ptr<AggregatePortMap> aggPorts;
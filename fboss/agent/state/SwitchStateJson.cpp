@@ -0,0 +1,252 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/state/SwitchStateJson.h"
+
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/state/AclMap.h"
+#include "fboss/agent/state/AggregatePortMap.h"
+#include "fboss/agent/state/ArpTable.h"
+#include "fboss/agent/state/ControlPlane.h"
+#include "fboss/agent/state/InterfaceMap.h"
+#include "fboss/agent/state/LabelForwardingInformationBase.h"
+#include "fboss/agent/state/LoadBalancerMap.h"
+#include "fboss/agent/state/MirrorMap.h"
+#include "fboss/agent/state/NdpTable.h"
+#include "fboss/agent/state/PortMap.h"
+#include "fboss/agent/state/QosPolicyMap.h"
+#include "fboss/agent/state/RouteTable.h"
+#include "fboss/agent/state/RouteTableMap.h"
+#include "fboss/agent/state/RouteTableRib.h"
+#include "fboss/agent/state/SflowCollectorMap.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/Vlan.h"
+#include "fboss/agent/state/VlanMap.h"
+
+#include <folly/Conv.h>
+
+#include <limits>
+
+namespace facebook {
+namespace fboss {
+
+namespace {
+
+using Tokens = folly::Range<const std::string*>;
+
+struct Page {
+  size_t offset;
+  size_t limit;
+};
+
+folly::Optional<size_t> arrayIndex(const std::string& token) {
+  auto index = folly::tryTo<size_t>(token);
+  if (index.hasError()) {
+    return folly::none;
+  }
+  return index.value();
+}
+
+/*
+ * Resolve the rest of the pointer within json, once the walk reaches a node
+ * which has to be serialized as a whole.
+ */
+folly::Optional<folly::dynamic>
+resolveJson(folly::dynamic json, Tokens tokens, const Page* page) {
+  auto* cur = &json;
+  for (const auto& token : tokens) {
+    if (cur->isObject()) {
+      cur = cur->get_ptr(token);
+    } else if (cur->isArray()) {
+      auto index = arrayIndex(token);
+      cur = index && *index < cur->size() ? &(*cur)[*index] : nullptr;
+    } else {
+      cur = nullptr;
+    }
+    if (!cur) {
+      return folly::none;
+    }
+  }
+  if (!page) {
+    return std::move(*cur);
+  }
+  if (!cur->isArray()) {
+    throw FbossError("JSON Pointer does not address an array");
+  }
+  folly::dynamic elems = folly::dynamic::array;
+  for (auto i = page->offset; i < cur->size() && elems.size() < page->limit;
+       ++i) {
+    elems.push_back(std::move((*cur)[i]));
+  }
+  return elems;
+}
+
+template <typename NodeT>
+folly::Optional<folly::dynamic>
+resolveNode(const NodeT& node, Tokens tokens, const Page* page) {
+  return resolveJson(node.toFollyDynamic(), tokens, page);
+}
+
+folly::Optional<folly::dynamic>
+resolveNode(const RouteTable& table, Tokens tokens, const Page* page);
+folly::Optional<folly::dynamic>
+resolveNode(const Vlan& vlan, Tokens tokens, const Page* page);
+
+/*
+ * Resolve the pointer within an array of nodes, only serializing the nodes
+ * that are addressed.
+ */
+template <typename Iterator>
+folly::Optional<folly::dynamic>
+resolveEntries(Iterator begin, Iterator end, Tokens tokens, const Page* page) {
+  if (tokens.empty()) {
+    Page all{0, std::numeric_limits<size_t>::max()};
+    if (!page) {
+      page = &all;
+    }
+    auto it = begin;
+    for (size_t i = 0; i < page->offset && it != end; ++i) {
+      ++it;
+    }
+    folly::dynamic entries = folly::dynamic::array;
+    for (; it != end && entries.size() < page->limit; ++it) {
+      entries.push_back((*it)->toFollyDynamic());
+    }
+    return entries;
+  }
+  auto index = arrayIndex(tokens[0]);
+  if (!index) {
+    return folly::none;
+  }
+  auto it = begin;
+  for (size_t i = 0; i < *index && it != end; ++i) {
+    ++it;
+  }
+  if (it == end) {
+    return folly::none;
+  }
+  return resolveNode(**it, tokens.subpiece(1), page);
+}
+
+template <typename MapT>
+folly::Optional<folly::dynamic>
+resolveNodeMap(const MapT& map, Tokens tokens, const Page* page) {
+  if (tokens.empty()) {
+    return resolveJson(map.toFollyDynamic(), tokens, page);
+  }
+  if (tokens[0] == MapT::kEntries) {
+    return resolveEntries(map.begin(), map.end(), tokens.subpiece(1), page);
+  }
+  if (tokens[0] == MapT::kExtraFields) {
+    return resolveJson(
+        map.getExtraFields().toFollyDynamic(), tokens.subpiece(1), page);
+  }
+  return folly::none;
+}
+
+template <typename AddrT>
+folly::Optional<folly::dynamic> resolveRib(
+    const RouteTableRib<AddrT>& rib,
+    Tokens tokens,
+    const Page* page) {
+  if (tokens.empty()) {
+    return resolveJson(rib.toFollyDynamic(), tokens, page);
+  }
+  if (tokens[0] == RouteTableRib<AddrT>::kRoutes) {
+    auto routes = rib.routes();
+    return resolveEntries(
+        routes->begin(), routes->end(), tokens.subpiece(1), page);
+  }
+  return folly::none;
+}
+
+folly::Optional<folly::dynamic>
+resolveNode(const RouteTable& table, Tokens tokens, const Page* page) {
+  if (!tokens.empty() && tokens[0] == RouteTableFields::kRibV4) {
+    return resolveRib(*table.getRibV4(), tokens.subpiece(1), page);
+  }
+  if (!tokens.empty() && tokens[0] == RouteTableFields::kRibV6) {
+    return resolveRib(*table.getRibV6(), tokens.subpiece(1), page);
+  }
+  return resolveJson(table.toFollyDynamic(), tokens, page);
+}
+
+folly::Optional<folly::dynamic>
+resolveNode(const Vlan& vlan, Tokens tokens, const Page* page) {
+  if (!tokens.empty() && tokens[0] == VlanFields::kArpTable) {
+    return resolveNodeMap(*vlan.getArpTable(), tokens.subpiece(1), page);
+  }
+  if (!tokens.empty() && tokens[0] == VlanFields::kNdpTable) {
+    return resolveNodeMap(*vlan.getNdpTable(), tokens.subpiece(1), page);
+  }
+  return resolveJson(vlan.toFollyDynamic(), tokens, page);
+}
+
+folly::Optional<folly::dynamic>
+resolveSwitchState(const SwitchState& state, Tokens tokens, const Page* page) {
+  if (tokens.empty()) {
+    return resolveJson(state.toFollyDynamic(), tokens, page);
+  }
+  using Fields = SwitchStateFields;
+  const auto& name = tokens[0];
+  auto rest = tokens.subpiece(1);
+  if (name == Fields::kInterfaces) {
+    return resolveNodeMap(*state.getInterfaces(), rest, page);
+  } else if (name == Fields::kPorts) {
+    return resolveNodeMap(*state.getPorts(), rest, page);
+  } else if (name == Fields::kVlans) {
+    return resolveNodeMap(*state.getVlans(), rest, page);
+  } else if (name == Fields::kRouteTables) {
+    return resolveNodeMap(*state.getRouteTables(), rest, page);
+  } else if (name == Fields::kAcls) {
+    return resolveNodeMap(*state.getAcls(), rest, page);
+  } else if (name == Fields::kSflowCollectors) {
+    return resolveNodeMap(*state.getSflowCollectors(), rest, page);
+  } else if (name == Fields::kQosPolicies) {
+    return resolveNodeMap(*state.getQosPolicies(), rest, page);
+  } else if (name == Fields::kLoadBalancers) {
+    return resolveNodeMap(*state.getLoadBalancers(), rest, page);
+  } else if (name == Fields::kMirrors) {
+    return resolveNodeMap(*state.getMirrors(), rest, page);
+  } else if (name == Fields::kAggregatePorts) {
+    return resolveNodeMap(*state.getAggregatePorts(), rest, page);
+  } else if (name == Fields::kLabelForwardingInformationBase) {
+    return resolveNodeMap(
+        *state.getLabelForwardingInformationBase(), rest, page);
+  } else if (name == Fields::kControlPlane) {
+    return resolveNode(*state.getControlPlane(), rest, page);
+  } else if (name == Fields::kDefaultVlan) {
+    return resolveJson(
+        static_cast<uint32_t>(state.getDefaultVlan()), rest, page);
+  }
+  return folly::none;
+}
+
+} // namespace
+
+folly::Optional<folly::dynamic> getSwitchStateJson(
+    const SwitchState& state,
+    const folly::json_pointer& ptr) {
+  const auto& tokens = ptr.tokens();
+  return resolveSwitchState(
+      state, Tokens(tokens.data(), tokens.size()), nullptr);
+}
+
+folly::Optional<folly::dynamic> getSwitchStateJsonPage(
+    const SwitchState& state,
+    const folly::json_pointer& ptr,
+    size_t offset,
+    size_t limit) {
+  const auto& tokens = ptr.tokens();
+  Page page{offset, limit};
+  return resolveSwitchState(state, Tokens(tokens.data(), tokens.size()), &page);
+}
+
+} // namespace fboss
+} // namespace facebook
@@ -0,0 +1,51 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/dynamic.h>
+#include <folly/json_pointer.h>
+
+namespace facebook {
+namespace fboss {
+
+class SwitchState;
+
+/*
+ * Serialize the part of state addressed by ptr, i.e. the equivalent of
+ * state.toFollyDynamic().get_ptr(ptr).
+ *
+ * The pointer is resolved against the state tree itself (SwitchState, then
+ * NodeMap, then node, and into the route and neighbor tables), so that only
+ * the addressed subtree is serialized rather than the whole state.
+ *
+ * Returns folly::none if ptr does not address anything in the state.
+ */
+folly::Optional<folly::dynamic> getSwitchStateJson(
+    const SwitchState& state,
+    const folly::json_pointer& ptr);
+
+/*
+ * Serialize at most limit elements, starting at offset, of the array
+ * addressed by ptr (e.g. /routeTables/entries/0/ribV4/routes), so that large
+ * tables can be fetched a page at a time. Only the returned elements are
+ * serialized.
+ *
+ * Returns folly::none if ptr does not address anything in the state, and
+ * throws FbossError if it does not address an array.
+ */
+folly::Optional<folly::dynamic> getSwitchStateJsonPage(
+    const SwitchState& state,
+    const folly::json_pointer& ptr,
+    size_t offset,
+    size_t limit);
+
+} // namespace fboss
+} // namespace facebook
@@ -43,9 +43,7 @@ constexpr auto kDhcpV6Relay = "dhcpV6Relay";
 constexpr auto kDhcpV6RelayOverrides = "dhcpRelayOverridesV6";
 constexpr auto kMemberPorts = "memberPorts";
 constexpr auto kTagged = "tagged";
-constexpr auto kArpTable = "arpTable";
 constexpr auto kArpResponseTable = "arpResponseTable";
-constexpr auto kNdpTable = "ndpTable";
 constexpr auto kNdpResponseTable = "ndpResponseTable";
 } // namespace
 
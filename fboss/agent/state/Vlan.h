@@ -73,6 +73,9 @@ struct VlanFields {
   folly::dynamic toFollyDynamic() const;
   static VlanFields fromFollyDynamic(const folly::dynamic& vlanJson);
 
+  static constexpr char kArpTable[] = "arpTable";
+  static constexpr char kNdpTable[] = "ndpTable";
+
   const VlanID id{0};
   std::string name;
   InterfaceID intfID{0};
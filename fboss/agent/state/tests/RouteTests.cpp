@@ -31,6 +31,7 @@
 
 #include <folly/Optional.h>
 #include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 
 using namespace facebook::fboss;
@@ -425,6 +426,98 @@ TEST(Route, resolve) {
   }
 }
 
+// A change to a route only resolves again the routes with a next hop
+// resolving through it, directly or not, whatever their address family
+TEST(Route, resolveOnlyDependentRoutes) {
+  auto stateV1 = applyInitConfig();
+  ASSERT_NE(nullptr, stateV1);
+
+  auto rid = RouterID(0);
+  RouteUpdater u1(stateV1->getRouteTables());
+  u1.addRoute(
+      rid,
+      IPAddress("50.0.0.0"),
+      8,
+      CLIENT_A,
+      RouteNextHopEntry(makeNextHops({"1.1.1.10"}), DISTANCE));
+  // Resolved through 50.0.0.0/8
+  u1.addRoute(
+      rid,
+      IPAddress("40.0.0.0"),
+      8,
+      CLIENT_A,
+      RouteNextHopEntry(makeNextHops({"50.0.0.1"}), DISTANCE));
+  // Resolved through 40.0.0.0/8, so through 50.0.0.0/8 in turn
+  u1.addRoute(
+      rid,
+      IPAddress("2001::"),
+      64,
+      CLIENT_A,
+      RouteNextHopEntry(makeNextHops({"40.0.0.1"}), DISTANCE));
+  // Has a next hop within 50.0.0.0/8, resolved through a longer prefix
+  u1.addRoute(
+      rid,
+      IPAddress("50.1.0.0"),
+      16,
+      CLIENT_A,
+      RouteNextHopEntry(makeNextHops({"3.3.3.10"}), DISTANCE));
+  u1.addRoute(
+      rid,
+      IPAddress("70.0.0.0"),
+      8,
+      CLIENT_A,
+      RouteNextHopEntry(makeNextHops({"50.1.0.1"}), DISTANCE));
+  // Unrelated
+  u1.addRoute(
+      rid,
+      IPAddress("60.0.0.0"),
+      8,
+      CLIENT_A,
+      RouteNextHopEntry(makeNextHops({"1.1.1.20"}), DISTANCE));
+  auto tables2 = u1.updateDone();
+  ASSERT_NE(nullptr, tables2);
+
+  // Make the forwarding info of the routes not resolving through
+  // 50.0.0.0/8 stale, so that resolving them again would show
+  auto r70 = GET_ROUTE_V4(tables2, rid, "70.0.0.0/8");
+  auto r60 = GET_ROUTE_V4(tables2, rid, "60.0.0.0/8");
+  r70->setResolved(RouteNextHopEntry(RouteForwardAction::TO_CPU, DISTANCE));
+  r60->setResolved(RouteNextHopEntry(RouteForwardAction::TO_CPU, DISTANCE));
+  tables2->publish();
+
+  RouteUpdater u2(tables2);
+  u2.addRoute(
+      rid,
+      IPAddress("50.0.0.0"),
+      8,
+      CLIENT_A,
+      RouteNextHopEntry(makeNextHops({"2.2.2.10"}), DISTANCE));
+  auto tables3 = u2.updateDone();
+  ASSERT_NE(nullptr, tables3);
+  EXPECT_NODEMAP_MATCH(tables3);
+  tables3->publish();
+
+  // The dependent routes follow the new next hop
+  auto r50 = GET_ROUTE_V4(tables3, rid, "50.0.0.0/8");
+  EXPECT_RESOLVED(r50);
+  EXPECT_FWD_INFO(r50, InterfaceID(2), "2.2.2.10");
+  auto r40 = GET_ROUTE_V4(tables3, rid, "40.0.0.0/8");
+  EXPECT_RESOLVED(r40);
+  EXPECT_FWD_INFO(r40, InterfaceID(2), "2.2.2.10");
+  auto r2001 = GET_ROUTE_V6(tables3, rid, "2001::/64");
+  EXPECT_RESOLVED(r2001);
+  EXPECT_FWD_INFO(r2001, InterfaceID(2), "2.2.2.10");
+
+  // The other routes were left alone
+  EXPECT_EQ(
+      GET_ROUTE_V4(tables2, rid, "50.1.0.0/16"),
+      GET_ROUTE_V4(tables3, rid, "50.1.0.0/16"));
+  EXPECT_EQ(r70, GET_ROUTE_V4(tables3, rid, "70.0.0.0/8"));
+  EXPECT_TRUE(r70->isToCPU());
+  EXPECT_EQ(r60, GET_ROUTE_V4(tables3, rid, "60.0.0.0/8"));
+  EXPECT_TRUE(r60->isToCPU());
+}
+
 TEST(Route, resolveDropToCPUMix) {
   auto stateV1 = applyInitConfig();
   ASSERT_NE(nullptr, stateV1);
@@ -1710,6 +1803,61 @@ TEST(Route, equality) {
   EXPECT_TRUE(nhm1 == nhm2);
 }
 
+TEST(Route, internedNextHops) {
+  auto numInterned = RouteNextHopEntry::InternedNextHops::numInterned();
+  {
+    RouteNextHopEntry entry1(newNextHops(3, "100.64.1."), DISTANCE);
+    RouteNextHopEntry entry2(newNextHops(3, "100.64.1."), DISTANCE);
+    RouteNextHopEntry entry3(newNextHops(2, "100.64.1."), DISTANCE);
+    // Equal sets are shared, different ones are not
+    EXPECT_EQ(entry1.getInternedNextHops(), entry2.getInternedNextHops());
+    EXPECT_NE(entry1.getInternedNextHops(), entry3.getInternedNextHops());
+    EXPECT_NE(
+        entry1.getInternedNextHops()->id(), entry3.getInternedNextHops()->id());
+    EXPECT_EQ(
+        numInterned + 2, RouteNextHopEntry::InternedNextHops::numInterned());
+
+    auto entry4 = RouteNextHopEntry::fromFollyDynamic(entry1.toFollyDynamic());
+    EXPECT_EQ(entry1.getInternedNextHops(), entry4.getInternedNextHops());
+    EXPECT_EQ(entry1, entry4);
+    EXPECT_TRUE(entry3 < entry1);
+    EXPECT_FALSE(entry1 < entry4);
+
+    auto drop = RouteNextHopEntry(RouteForwardAction::DROP, DISTANCE);
+    EXPECT_EQ(nullptr, drop.getInternedNextHops());
+    EXPECT_TRUE(drop.getNextHopSet().empty());
+  }
+  // Sets no longer used by any entry are released
+  EXPECT_EQ(numInterned, RouteNextHopEntry::InternedNextHops::numInterned());
+}
+
+TEST(Route, normalizedNextHopsFollowEcmpWidth) {
+  gflags::FlagSaver flagSaver;
+  RouteNextHopSet nhops{
+      ResolvedNextHop(IPAddress("100.64.2.10"), InterfaceID(1), 30),
+      ResolvedNextHop(IPAddress("100.64.2.11"), InterfaceID(1), 10)};
+  RouteNextHopEntry entry(nhops, DISTANCE);
+
+  FLAGS_ecmp_width = 64;
+  auto normalized = entry.normalizedNextHops();
+  EXPECT_EQ(nhops, *normalized);
+  // The normalized next hops are cached and shared, not copied
+  EXPECT_EQ(normalized, entry.normalizedNextHops());
+
+  // They are recomputed for a new width
+  FLAGS_ecmp_width = 4;
+  RouteNextHopSet scaled{
+      ResolvedNextHop(IPAddress("100.64.2.10"), InterfaceID(1), 3),
+      ResolvedNextHop(IPAddress("100.64.2.11"), InterfaceID(1), 1)};
+  EXPECT_EQ(scaled, *entry.normalizedNextHops());
+  EXPECT_EQ(scaled, *RouteNextHopEntry(nhops, DISTANCE).normalizedNextHops());
+  // The set returned earlier is still valid
+  EXPECT_EQ(nhops, *normalized);
+
+  FLAGS_ecmp_width = 64;
+  EXPECT_EQ(nhops, *entry.normalizedNextHops());
+}
+
 // Test that a copy of a RouteNextHopsMulti is a deep copy, and that the
 // resulting objects can be modified independently.
 TEST(Route, deepCopy) {
@@ -0,0 +1,110 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/hw/mock/MockPlatform.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/state/SwitchStateJson.h"
+#include "fboss/agent/test/RouteDistributionGenerator.h"
+#include "fboss/agent/test/RouteGeneratorTestUtils.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::json_pointer;
+
+namespace {
+
+std::shared_ptr<SwitchState> makeState(MockPlatform* platform) {
+  return utility::RouteDistributionSwitchStatesGenerator(
+             createTestState(platform), {{64, 100}}, {{24, 100}}, 1000, 2)
+      .get()
+      .back();
+}
+
+} // namespace
+
+TEST(SwitchStateJson, MatchesFullSerialization) {
+  auto platform = createMockPlatform();
+  auto state = makeState(platform.get());
+  auto full = state->toFollyDynamic();
+
+  for (auto ptr : {"",
+                   "/ports",
+                   "/ports/entries",
+                   "/ports/entries/0",
+                   "/ports/entries/1/portName",
+                   "/ports/extraFields",
+                   "/vlans/entries/0/arpTable",
+                   "/vlans/entries/0/arpTable/entries",
+                   "/vlans/entries/0/vlanName",
+                   "/interfaces/entries/0",
+                   "/routeTables/entries/0",
+                   "/routeTables/entries/0/routerId",
+                   "/routeTables/entries/0/ribV4/routes/5",
+                   "/routeTables/entries/0/ribV6/routes/7/prefix",
+                   "/controlPlane",
+                   "/defaultVlan"}) {
+    auto jsonPtr = json_pointer::parse(ptr);
+    auto expected = full.get_ptr(jsonPtr);
+    ASSERT_NE(nullptr, expected) << ptr;
+    auto json = getSwitchStateJson(*state, jsonPtr);
+    ASSERT_TRUE(json.hasValue()) << ptr;
+    EXPECT_EQ(*expected, *json) << ptr;
+  }
+}
+
+TEST(SwitchStateJson, MissingPath) {
+  auto platform = createMockPlatform();
+  auto state = makeState(platform.get());
+
+  for (auto ptr : {"/foo",
+                   "/ports/foo",
+                   "/ports/entries/100000",
+                   "/ports/entries/bar",
+                   "/routeTables/entries/0/ribV4/routes/100000",
+                   "/defaultVlan/0"}) {
+    EXPECT_FALSE(getSwitchStateJson(*state, json_pointer::parse(ptr)))
+        << ptr;
+  }
+}
+
+TEST(SwitchStateJson, Page) {
+  auto platform = createMockPlatform();
+  auto state = makeState(platform.get());
+  auto ptr = json_pointer::parse("/routeTables/entries/0/ribV4/routes");
+  auto routes = *state->toFollyDynamic().get_ptr(ptr);
+  ASSERT_GT(routes.size(), 10);
+
+  folly::dynamic paged = folly::dynamic::array;
+  for (size_t offset = 0;; offset += 10) {
+    auto page = getSwitchStateJsonPage(*state, ptr, offset, 10);
+    ASSERT_TRUE(page.hasValue());
+    EXPECT_LE(page->size(), 10);
+    if (page->empty()) {
+      break;
+    }
+    for (auto& route : *page) {
+      paged.push_back(std::move(route));
+    }
+  }
+  EXPECT_EQ(routes, paged);
+
+  // Pages of arrays which are serialized as a whole
+  auto portPtr = json_pointer::parse("/ports/entries/0/queues");
+  auto queues = *state->toFollyDynamic().get_ptr(portPtr);
+  auto page = getSwitchStateJsonPage(*state, portPtr, 0, queues.size());
+  ASSERT_TRUE(page.hasValue());
+  EXPECT_EQ(queues, *page);
+
+  EXPECT_THROW(
+      getSwitchStateJsonPage(*state, json_pointer::parse("/ports"), 0, 10),
+      FbossError);
+}
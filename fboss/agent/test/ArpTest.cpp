@@ -14,6 +14,7 @@
 #include "fboss/agent/AddressUtil.h"
 #include "fboss/agent/ArpHandler.h"
 #include "fboss/agent/FbossError.h"
+#include "fboss/agent/NeighborCacheEntry.h"
 #include "fboss/agent/NeighborUpdater.h"
 #include "fboss/agent/SwSwitch.h"
 #include "fboss/agent/SwitchStats.h"
@@ -37,11 +38,16 @@
 #include "fboss/agent/test/TestUtils.h"
 
 #include <boost/range/combine.hpp>
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 #include <array>
 #include <future>
 #include <string>
 
+DECLARE_int32(neighbor_update_batch_ms);
+DECLARE_int32(neighbor_probe_rate);
+DECLARE_int32(neighbor_probe_burst);
+
 using namespace facebook::fboss;
 using facebook::network::toBinaryAddress;
 using facebook::network::toIPAddress;
@@ -843,6 +849,37 @@ TEST(ArpTest, FlushEntry) {
       thriftHandler.flushNeighborEntry(std::move(binAddrPtr), 123), FbossError);
 }
 
+TEST(ArpTest, BatchedUpdates) {
+  gflags::FlagSaver flagSaver;
+  // Long enough for the batch not to time out during the test
+  FLAGS_neighbor_update_batch_ms = 60000;
+  auto handle = setupTestHandle();
+  auto sw = handle->getSw();
+
+  // The entries learnt from all the replies are added in one state update
+  EXPECT_HW_CALL(sw, stateChanged(_)).Times(1);
+  sendArpReply(handle.get(), "10.0.0.11", "02:10:20:30:40:11", 2);
+  sendArpReply(handle.get(), "10.0.0.15", "02:10:20:30:40:15", 3);
+  sendArpReply(handle.get(), "10.0.0.7", "02:10:20:30:40:07", 1);
+  // A newer reply for the same address replaces the queued entry
+  sendArpReply(handle.get(), "10.0.0.7", "02:10:20:30:40:08", 5);
+
+  sw->getNeighborUpdater()->waitForPendingUpdates();
+  waitForStateUpdates(sw);
+  // Nothing is applied until the batch is flushed
+  EXPECT_EQ(getArpEntry(sw, IPAddressV4("10.0.0.7")), nullptr);
+
+  sw->getNeighborUpdater()->flushPendingChanges().get();
+  waitForStateUpdates(sw);
+
+  auto entry = getArpEntry(sw, IPAddressV4("10.0.0.7"));
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->getMac(), MacAddress("02:10:20:30:40:08"));
+  EXPECT_EQ(entry->getPort(), PortDescriptor(PortID(5)));
+  EXPECT_NE(getArpEntry(sw, IPAddressV4("10.0.0.11")), nullptr);
+  EXPECT_NE(getArpEntry(sw, IPAddressV4("10.0.0.15")), nullptr);
+}
+
 TEST(ArpTest, PendingArp) {
   auto handle = setupTestHandle();
   auto sw = handle->getSw();
@@ -1137,6 +1174,57 @@ TEST(ArpTest, ArpExpiration) {
   EXPECT_TRUE(arpExpirations[0]->wait());
 }
 
+TEST(ArpTest, ProbeIntervalJitter) {
+  using Entry = NeighborCacheEntry<ArpTable>;
+  for (int i = 0; i < 1000; ++i) {
+    // Shortened by up to a tenth, never lengthened
+    auto interval = Entry::jitter(std::chrono::seconds(1));
+    EXPECT_GT(interval, std::chrono::milliseconds(900));
+    EXPECT_LE(interval, std::chrono::milliseconds(1000));
+  }
+  // Too short to jitter
+  EXPECT_EQ(
+      std::chrono::milliseconds(9),
+      Entry::jitter(std::chrono::milliseconds(9)));
+}
+
+TEST(ArpTest, ProbesPaced) {
+  gflags::FlagSaver flagSaver;
+  FLAGS_neighbor_probe_rate = 1;
+  FLAGS_neighbor_probe_burst = 1;
+  auto handle = setupTestHandle(std::chrono::seconds(1), 3);
+  auto sw = handle->getSw();
+
+  VlanID vlanID(1);
+  IPAddressV4 senderIP = IPAddressV4("10.0.0.1");
+  std::array<IPAddressV4, 3> targetIP = {IPAddressV4("10.0.0.2"),
+                                         IPAddressV4("10.0.0.3"),
+                                         IPAddressV4("10.0.0.4")};
+  for (auto ip : targetIP) {
+    testSendArpRequest(sw, vlanID, senderIP, ip);
+  }
+
+  // All three entries want to probe again after a second. The cache only
+  // allows one probe a second, so the other two retry a second later rather
+  // than all three probing together, and stay pending meanwhile.
+  CounterCache counters(sw);
+  EXPECT_HW_CALL(sw, sendPacketSwitchedAsync_(_))
+      .Times(testing::AnyNumber());
+  std::promise<bool> done;
+  auto* evb = sw->getBackgroundEvb();
+  evb->runInEventBaseThread(
+      [&]() { evb->tryRunAfterDelay([&]() { done.set_value(true); }, 1500); });
+  done.get_future().wait();
+
+  counters.update();
+  counters.checkDelta(SwitchStats::kCounterPrefix + "arp.request.tx.sum", 1);
+  for (auto ip : targetIP) {
+    auto entry = getArpEntry(sw, ip, vlanID);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_TRUE(entry->isPending());
+  }
+}
+
 TEST(ArpTest, PortFlapRecover) {
   auto handle = setupTestHandle(std::chrono::seconds(1));
   auto sw = handle->getSw();
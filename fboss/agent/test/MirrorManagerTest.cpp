@@ -374,6 +374,58 @@ TYPED_TEST(MirrorManagerTest, ResolveMirrorWithoutEgressPort) {
   });
 }
 
+TYPED_TEST(MirrorManagerTest, ResolveMirrorAddedAfterRoutes) {
+  const auto params = MirrorManagerTestParams<TypeParam>::getParams();
+
+  this->updateState(
+      "ResolveMirrorAddedAfterRoutes: addRoute",
+      [=](const std::shared_ptr<SwitchState>& state) {
+        auto updatedState = this->addNeighbor(
+            state,
+            params.interfaces[0],
+            params.neighborIPs[0],
+            params.neighborMACs[0],
+            params.neighborPorts[0]);
+        RouteNextHopSet nextHops = {params.nextHop(0)};
+        return this->addRoute(updatedState, params.longerPrefix, nextHops);
+      });
+
+  // The mirror is resolved without any route or neighbor changes
+  this->updateState(
+      "ResolveMirrorAddedAfterRoutes: addMirror",
+      [=](const std::shared_ptr<SwitchState>& state) {
+        return this->addErspanMirror(
+            state, kMirrorName, params.mirrorDestination);
+      });
+
+  std::shared_ptr<Mirror> resolvedMirror;
+  this->verifyStateUpdate([&]() {
+    auto state = this->sw_->getState();
+    resolvedMirror = state->getMirrors()->getMirrorIf(kMirrorName);
+    ASSERT_NE(resolvedMirror, nullptr);
+    EXPECT_TRUE(resolvedMirror->isResolved());
+    ASSERT_TRUE(resolvedMirror->getEgressPort().hasValue());
+    EXPECT_EQ(resolvedMirror->getEgressPort().value(), params.neighborPorts[0]);
+  });
+
+  // Neighbor entries the mirror does not depend on leave it alone
+  this->updateState(
+      "ResolveMirrorAddedAfterRoutes: addOtherNeighbor",
+      [=](const std::shared_ptr<SwitchState>& state) {
+        return this->addNeighbor(
+            state,
+            params.interfaces[1],
+            params.neighborIPs[1],
+            params.neighborMACs[1],
+            params.neighborPorts[1]);
+      });
+
+  this->verifyStateUpdate([&]() {
+    auto state = this->sw_->getState();
+    EXPECT_EQ(state->getMirrors()->getMirrorIf(kMirrorName), resolvedMirror);
+  });
+}
+
 TYPED_TEST(MirrorManagerTest, ResolveMirrorWithEgressPort) {
   const auto params = MirrorManagerTestParams<TypeParam>::getParams();
 
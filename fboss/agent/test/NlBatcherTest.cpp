@@ -0,0 +1,203 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/NlBatcher.h"
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <netlink/errno.h>
+}
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace facebook::fboss;
+
+namespace {
+
+/*
+ * Stands in for the kernel: records the requests of each message sent, and
+ * acks them, in reverse order, when the batcher reads its socket.
+ */
+class FakeKernelBatcher : public NlBatcher {
+ public:
+  FakeKernelBatcher() : NlBatcher(NoSocket()) {}
+
+  // The sequence numbers of the requests in each message sent
+  std::vector<std::vector<uint32_t>> sent;
+  // The size of each message sent
+  std::vector<size_t> sentBytes;
+  // errno to fail requests with, by sequence number
+  std::map<uint32_t, int> errors;
+  // Whether the kernel acks requests at all
+  bool ack{true};
+
+ protected:
+  ssize_t sendMessage(const void* buf, size_t len) override {
+    sent.emplace_back();
+    sentBytes.push_back(len);
+    int remaining = len;
+    for (auto hdr = static_cast<const struct nlmsghdr*>(buf);
+         NLMSG_OK(hdr, remaining);
+         hdr = NLMSG_NEXT(hdr, remaining)) {
+      EXPECT_TRUE(hdr->nlmsg_flags & NLM_F_ACK);
+      EXPECT_EQ(kPort, hdr->nlmsg_pid);
+      sent.back().push_back(hdr->nlmsg_seq);
+      unacked_.push_back(hdr->nlmsg_seq);
+    }
+    return len;
+  }
+
+  ssize_t receiveMessage(void* buf, size_t len, bool /* block */) override {
+    if (!ack || unacked_.empty()) {
+      // Whether blocking or not, no ack arrives
+      errno = EAGAIN;
+      return -1;
+    }
+    auto out = static_cast<uint8_t*>(buf);
+    size_t used = 0;
+    // An ack nobody asked for is ignored
+    writeAck(out, used, len, 0, 0);
+    while (!unacked_.empty() &&
+           used + NLMSG_SPACE(sizeof(struct nlmsgerr)) <= len) {
+      auto seq = unacked_.back();
+      unacked_.pop_back();
+      auto error = errors.find(seq);
+      writeAck(out, used, len, seq, error == errors.end() ? 0 : error->second);
+    }
+    return used;
+  }
+
+  uint32_t localPort() const override {
+    return kPort;
+  }
+
+ private:
+  static constexpr uint32_t kPort = 42;
+
+  static void
+  writeAck(uint8_t* buf, size_t& used, size_t len, uint32_t seq, int error) {
+    auto space = NLMSG_SPACE(sizeof(struct nlmsgerr));
+    ASSERT_LE(used + space, len);
+    auto hdr = reinterpret_cast<struct nlmsghdr*>(buf + used);
+    memset(hdr, 0, space);
+    hdr->nlmsg_len = NLMSG_LENGTH(sizeof(struct nlmsgerr));
+    hdr->nlmsg_type = NLMSG_ERROR;
+    hdr->nlmsg_seq = seq;
+    static_cast<struct nlmsgerr*>(NLMSG_DATA(hdr))->error = -error;
+    used += space;
+  }
+
+  std::vector<uint32_t> unacked_;
+};
+
+// A request with payloadBytes of padding, to control the size of batches
+struct nl_msg* makeRequest(size_t payloadBytes = 0) {
+  auto msg = nlmsg_alloc_size(NLMSG_SPACE(payloadBytes));
+  auto hdr =
+      nlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, RTM_NEWADDR, payloadBytes, 0);
+  memset(nlmsg_data(hdr), 0, payloadBytes);
+  return msg;
+}
+
+} // unnamed namespace
+
+TEST(NlBatcherTest, AcksMatchedBySequenceNumber) {
+  FakeKernelBatcher batcher;
+  std::vector<int> results(3, 1);
+  for (int i = 0; i < 3; ++i) {
+    batcher.add(makeRequest(), [&results, i](int error) {
+      results[i] = error;
+    });
+  }
+  // Requests are numbered from 1, and acked in reverse order
+  batcher.errors[2] = EEXIST;
+  batcher.flush();
+  ASSERT_EQ(1, batcher.sent.size());
+  EXPECT_EQ(3, batcher.sent[0].size());
+  EXPECT_EQ(0, results[0]);
+  EXPECT_EQ(-NLE_EXIST, results[1]);
+  EXPECT_EQ(0, results[2]);
+  EXPECT_TRUE(batcher.empty());
+}
+
+TEST(NlBatcherTest, SplitsBatchesAtMaxInFlight) {
+  FakeKernelBatcher batcher;
+  size_t acked = 0;
+  auto count = NlBatcher::kMaxInFlight + 10;
+  for (size_t i = 0; i < count; ++i) {
+    batcher.add(makeRequest(), [&acked](int error) {
+      EXPECT_EQ(0, error);
+      ++acked;
+    });
+  }
+  batcher.flush();
+  EXPECT_EQ(count, acked);
+  ASSERT_EQ(2, batcher.sent.size());
+  EXPECT_EQ(NlBatcher::kMaxInFlight, batcher.sent[0].size());
+  EXPECT_EQ(10, batcher.sent[1].size());
+}
+
+TEST(NlBatcherTest, SplitsBatchesAtMaxBytes) {
+  FakeKernelBatcher batcher;
+  // Three of these fit in a message, four don't
+  auto payloadBytes = NlBatcher::kMaxBatchBytes / 4;
+  size_t acked = 0;
+  for (int i = 0; i < 5; ++i) {
+    batcher.add(makeRequest(payloadBytes), [&acked](int /* error */) {
+      ++acked;
+    });
+  }
+  batcher.flush();
+  EXPECT_EQ(5, acked);
+  ASSERT_EQ(2, batcher.sent.size());
+  EXPECT_EQ(3, batcher.sent[0].size());
+  EXPECT_EQ(2, batcher.sent[1].size());
+  for (auto bytes : batcher.sentBytes) {
+    EXPECT_LE(bytes, NlBatcher::kMaxBatchBytes);
+  }
+}
+
+TEST(NlBatcherTest, FailsInFlightOnTimeout) {
+  FakeKernelBatcher batcher;
+  batcher.ack = false;
+  std::vector<int> results;
+  for (int i = 0; i < 3; ++i) {
+    batcher.add(makeRequest(), [&results](int error) {
+      results.push_back(error);
+    });
+  }
+  batcher.flush();
+  ASSERT_EQ(3, results.size());
+  for (auto error : results) {
+    EXPECT_EQ(-nl_syserr2nlerr(EAGAIN), error);
+  }
+  EXPECT_TRUE(batcher.empty());
+}
+
+TEST(NlBatcherTest, CallbackAddsRequests) {
+  FakeKernelBatcher batcher;
+  std::vector<int> completed;
+  batcher.add(makeRequest(), [&batcher, &completed](int /* error */) {
+    completed.push_back(1);
+    // e.g. adding a route once its interface address is in place
+    batcher.add(makeRequest(), [&completed](int /* error */) {
+      completed.push_back(2);
+    });
+  });
+  batcher.flush();
+  EXPECT_EQ(std::vector<int>({1, 2}), completed);
+  EXPECT_EQ(2, batcher.sent.size());
+  EXPECT_TRUE(batcher.empty());
+}
@@ -20,6 +20,10 @@
 #include "fboss/agent/test/HwTestHandle.h"
 #include "fboss/agent/test/TestUtils.h"
 
+#include <folly/synchronization/Baton.h>
+
+#include <thread>
+
 using namespace facebook::fboss;
 using std::string;
 
@@ -110,6 +114,31 @@ TEST_F(PortUpdateHandlerTest, PortAdded) {
   EXPECT_EQ(counters.value("port21.up"), 0);
 }
 
+TEST_F(PortUpdateHandlerTest, PortAddedOtherThread) {
+  folly::Baton<> statsCreated;
+  folly::Baton<> portsAdded;
+  size_t numPortStats = 0;
+  PortStats* port21Stats = nullptr;
+  std::thread otherThread([&] {
+    EXPECT_EQ(sw->stats()->getPortStats()->size(), 0);
+    statsCreated.post();
+    portsAdded.wait();
+    // The PortStats were created by the state update, not by this lookup
+    port21Stats = sw->stats()->port(PortID(21));
+    numPortStats = sw->stats()->getPortStats()->size();
+  });
+  statsCreated.wait();
+
+  portUpdateHandler->stateUpdated(
+      *std::make_shared<StateDelta>(std::make_shared<SwitchState>(), addState));
+  portsAdded.post();
+  otherThread.join();
+
+  EXPECT_EQ(numPortStats, 21);
+  ASSERT_NE(port21Stats, nullptr);
+  EXPECT_EQ(port21Stats->getPortName(), "port21");
+}
+
 TEST_F(PortUpdateHandlerTest, PortRemoved) {
   // // Cache the current stats
   CounterCache counters(sw);
@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/json.h>
+
+#include "fboss/agent/Constants.h"
+#include "fboss/agent/StateSnapshotFile.h"
+#include "fboss/agent/Utils.h"
+#include "fboss/agent/hw/mock/MockPlatform.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/test/RouteGeneratorTestUtils.h"
+#include "fboss/agent/test/RouteScaleGenerators.h"
+#include "fboss/agent/test/TestUtils.h"
+
+using namespace facebook::fboss;
+
+/*
+ * Compares the time taken to write the warm boot state on exit, and to read
+ * it back and rebuild the SwitchState on restart, for the JSON and binary
+ * switch state files.
+ */
+
+namespace {
+
+std::shared_ptr<SwitchState> state;
+std::string jsonFile;
+std::string binaryFile;
+
+folly::dynamic warmBootState() {
+  folly::dynamic switchState = folly::dynamic::object;
+  switchState[kSwSwitch] = state->toFollyDynamic();
+  return switchState;
+}
+
+std::unique_ptr<SwitchState> restore(const folly::dynamic& switchState) {
+  return SwitchState::uniquePtrFromFollyDynamic(switchState[kSwSwitch]);
+}
+
+} // unnamed namespace
+
+BENCHMARK(JsonExit) {
+  dumpStateToFile(jsonFile, warmBootState());
+}
+
+BENCHMARK_RELATIVE(BinaryExit) {
+  dumpStateSnapshotToFile(binaryFile, warmBootState());
+}
+
+BENCHMARK(JsonRestart) {
+  std::string json;
+  folly::readFile(jsonFile.c_str(), json);
+  folly::doNotOptimizeAway(restore(folly::parseJson(json)));
+}
+
+BENCHMARK_RELATIVE(BinaryRestart) {
+  folly::doNotOptimizeAway(restore(readStateFile(binaryFile)));
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  auto platform = createMockPlatform();
+  state = utility::HgridUuRouteScaleGenerator(createTestState(platform.get()))
+              .get()
+              .back();
+  folly::test::TemporaryDirectory tmpDir;
+  jsonFile = (tmpDir.path() / "json").string();
+  binaryFile = (tmpDir.path() / "binary").string();
+  // Restart benchmarks read the files written here
+  dumpStateToFile(jsonFile, warmBootState());
+  dumpStateSnapshotToFile(binaryFile, warmBootState());
+
+  folly::runBenchmarks();
+  return 0;
+}
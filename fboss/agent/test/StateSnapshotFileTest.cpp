@@ -0,0 +1,106 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#include "fboss/agent/StateSnapshotFile.h"
+#include "fboss/agent/Constants.h"
+#include "fboss/agent/FbossError.h"
+#include "fboss/agent/Utils.h"
+#include "fboss/agent/hw/mock/MockPlatform.h"
+#include "fboss/agent/state/SwitchState.h"
+#include "fboss/agent/test/RouteDistributionGenerator.h"
+#include "fboss/agent/test/RouteGeneratorTestUtils.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+using folly::dynamic;
+
+namespace {
+
+dynamic makeState() {
+  dynamic hwSwitch = dynamic::object("hostTable", dynamic::array())(
+      "warmBootCache", dynamic::object);
+  // Objects keyed by integers are written as a single section
+  dynamic ecmps = dynamic::object(1, "one")(2, dynamic::array(1, 2, 3));
+  return dynamic::object(kSwSwitch, dynamic::object)(kHwSwitch, hwSwitch)(
+      "ecmps", ecmps)(
+      "scalars",
+      dynamic::object("null", nullptr)("true", true)("false", false)(
+          "negative", -12345678901)("double", 2.5)("string", "foo"));
+}
+
+class StateSnapshotFileTest : public ::testing::Test {
+ public:
+  std::string filename(const std::string& name) const {
+    return (tmpDir_.path() / name).string();
+  }
+
+ private:
+  folly::test::TemporaryDirectory tmpDir_;
+};
+
+} // unnamed namespace
+
+TEST_F(StateSnapshotFileTest, encodeDecode) {
+  auto state = makeState();
+  std::string encoded;
+  encodeStateValue(state, encoded);
+  folly::ByteRange data(folly::StringPiece(encoded));
+  EXPECT_EQ(state, decodeStateValue(data));
+  EXPECT_TRUE(data.empty());
+}
+
+TEST_F(StateSnapshotFileTest, roundTrip) {
+  auto state = makeState();
+  auto file = filename("binary");
+  ASSERT_TRUE(dumpStateSnapshotToFile(file, state));
+  EXPECT_EQ(state, readStateFile(file));
+}
+
+TEST_F(StateSnapshotFileTest, readJson) {
+  auto state = makeState();
+  state.erase("ecmps");
+  auto file = filename("json");
+  ASSERT_TRUE(dumpStateToFile(file, state));
+  EXPECT_EQ(state, readStateFile(file));
+}
+
+TEST_F(StateSnapshotFileTest, truncated) {
+  auto file = filename("binary");
+  ASSERT_TRUE(dumpStateSnapshotToFile(file, makeState()));
+  std::string contents;
+  ASSERT_TRUE(folly::readFile(file.c_str(), contents));
+  contents.resize(contents.size() - 1);
+  ASSERT_TRUE(folly::writeFile(contents, file.c_str()));
+  EXPECT_THROW(readStateFile(file), FbossError);
+}
+
+TEST_F(StateSnapshotFileTest, switchState) {
+  auto platform = createMockPlatform();
+  auto switchState = utility::RouteDistributionSwitchStatesGenerator(
+                         createTestState(platform.get()),
+                         {{64, 1000}},
+                         {{24, 1000}},
+                         4000,
+                         2)
+                         .get()
+                         .back();
+  dynamic state = dynamic::object(kSwSwitch, switchState->toFollyDynamic());
+  auto file = filename("binary");
+  ASSERT_TRUE(dumpStateSnapshotToFile(file, state));
+
+  auto restored = readStateFile(file);
+  EXPECT_EQ(state, restored);
+  auto restoredState = SwitchState::fromFollyDynamic(restored[kSwSwitch]);
+  EXPECT_EQ(switchState->toFollyDynamic(), restoredState->toFollyDynamic());
+}
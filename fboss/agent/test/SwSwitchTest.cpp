@@ -27,8 +27,10 @@
 #include <folly/IPAddressV4.h>
 #include <folly/IPAddressV6.h>
 #include <folly/MacAddress.h>
+#include <folly/synchronization/Baton.h>
 
 #include <algorithm>
+#include <vector>
 
 using namespace facebook::fboss;
 using folly::IPAddressV4;
@@ -76,6 +78,18 @@ TEST_F(SwSwitchTest, GetPortStats) {
   portStats = sw->portStats(PortID(0));
   EXPECT_EQ(sw->stats()->getPortStats()->size(), 2);
   EXPECT_EQ(portStats->getPortName(), "port0");
+
+  // Ports beyond the dense array are still found
+  PortID bigPort(SwitchStats::kMinPortSlots + 10);
+  portStats = sw->portStats(bigPort);
+  EXPECT_EQ(sw->stats()->getPortStats()->size(), 3);
+  EXPECT_EQ(portStats, sw->portStats(bigPort));
+  EXPECT_EQ(sw->stats()->getPortStats()->size(), 3);
+  sw->stats()->deletePortStats(bigPort);
+  EXPECT_EQ(sw->stats()->port(bigPort), nullptr);
+  sw->stats()->deletePortStats(PortID(5));
+  EXPECT_EQ(sw->stats()->port(PortID(5)), nullptr);
+  EXPECT_EQ(sw->stats()->getPortStats()->size(), 1);
 }
 ACTION(ThrowException) {
   throw std::exception();
@@ -185,3 +199,33 @@ TEST_F(SwSwitchTest, TestStateNonCoalescing) {
   // 0 neighbor entries expected, i.e. entries must be purged
   verifyReachableCnt(0);
 }
+
+TEST_F(SwSwitchTest, HighPriorityUpdatesAppliedFirst) {
+  // Hold the update thread so that all of the updates below are queued
+  // before any of them get applied.
+  folly::Baton<> blocked;
+  folly::Baton<> release;
+  sw->getUpdateEvb()->runInEventBaseThread([&] {
+    blocked.post();
+    release.wait();
+  });
+  blocked.wait();
+
+  std::vector<string> applied;
+  auto recordUpdate = [&applied](const string& name) {
+    return [&applied, name](const std::shared_ptr<SwitchState>& /*state*/) {
+      applied.push_back(name);
+      return std::shared_ptr<SwitchState>();
+    };
+  };
+  sw->updateState("normal1", recordUpdate("normal1"));
+  sw->updateStateNoCoalescing("normal2", recordUpdate("normal2"));
+  sw->updateStateNoCoalescing(
+      "high1", recordUpdate("high1"), StateUpdate::Priority::HIGH);
+  sw->updateState("high2", recordUpdate("high2"), StateUpdate::Priority::HIGH);
+  release.post();
+  waitForStateUpdates(sw);
+
+  std::vector<string> expected{"high1", "high2", "normal1", "normal2"};
+  EXPECT_EQ(expected, applied);
+}
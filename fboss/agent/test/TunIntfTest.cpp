@@ -0,0 +1,199 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/agent/TunIntf.h"
+
+#include "fboss/agent/SwSwitch.h"
+#include "fboss/agent/hw/mock/MockPlatform.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+#include "fboss/agent/test/TestUtils.h"
+
+#include <folly/Format.h>
+#include <folly/io/async/EventBase.h>
+#include <gtest/gtest.h>
+
+extern "C" {
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace facebook::fboss;
+
+namespace {
+
+/*
+ * A TunIntf whose queues write to sockets rather than to an interface on
+ * the host
+ */
+class TestTunIntf : public TunIntf {
+ public:
+  TestTunIntf(SwSwitch* sw, folly::EventBase* evb, const std::vector<int>& fds)
+      : TunIntf(sw, {evb}, InterfaceID(1), fds) {}
+};
+
+class TunIntfTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    sw_ = setupMockSwitchWithoutHW(createMockPlatform(), nullptr, DEFAULT);
+  }
+
+  void TearDown() override {
+    // Run the flushes still scheduled before the interface goes away
+    evb_.loop();
+    intf_.reset();
+    for (auto fd : peers_) {
+      close(fd);
+    }
+  }
+
+  void createIntf(int numQueues) {
+    std::vector<int> fds;
+    for (int i = 0; i < numQueues; ++i) {
+      int pair[2];
+      ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0, pair));
+      fds.push_back(pair[0]);
+      peers_.push_back(pair[1]);
+    }
+    intf_ = std::make_unique<TestTunIntf>(sw_.get(), &evb_, fds);
+    ASSERT_EQ(numQueues, intf_->getNumQueues());
+  }
+
+  /*
+   * Send a UDP packet from 10.0.0.1:srcPort to 10.0.0.dst, tagged with tag.
+   * fragment is 0 for a whole packet, 1 for the first fragment of one, and
+   * 2 for a later fragment, which carries no UDP header.
+   */
+  void send(uint8_t dst, uint16_t srcPort, uint8_t tag, int fragment = 0) {
+    auto pkt = MockRxPacket::fromHex(folly::sformat(
+        // dst mac, src mac, IPv4
+        "02 00 01 00 00 01  02 00 02 01 02 03  08 00"
+        // Version(4), IHL(5), DSCP(0), ECN(0), Total Length(29)
+        "45  00  00 1d"
+        // Identification(0), Flags, Fragment offset
+        "00 00  {}"
+        // TTL(64), Protocol(17), Checksum (0, fake)
+        "40  11  00 00"
+        // Source IP (10.0.0.1), Destination IP (10.0.0.dst)
+        "0a 00 00 01  0a 00 00 {:02x}"
+        // Source port, destination port (53), length, checksum or payload
+        "{:02x} {:02x}  00 35  00 09  00 00"
+        // Tag
+        "{:02x}",
+        fragment == 0 ? "00 00" : fragment == 1 ? "20 00" : "00 10",
+        dst,
+        srcPort >> 8,
+        srcPort & 0xff,
+        tag));
+    EXPECT_TRUE(intf_->sendPacketToHost(std::move(pkt)));
+  }
+
+  /*
+   * The packets written to each queue, as (destination, tag) pairs
+   */
+  std::vector<std::vector<std::pair<uint8_t, uint8_t>>> received() {
+    std::vector<std::vector<std::pair<uint8_t, uint8_t>>> packets;
+    for (auto fd : peers_) {
+      packets.emplace_back();
+      uint8_t buf[128];
+      ssize_t len;
+      while ((len = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        // The Ethernet header is not sent to the host
+        EXPECT_EQ(29, len);
+        packets.back().emplace_back(buf[19], buf[28]);
+      }
+    }
+    return packets;
+  }
+
+ protected:
+  std::unique_ptr<SwSwitch> sw_;
+  folly::EventBase evb_;
+  std::unique_ptr<TestTunIntf> intf_;
+  std::vector<int> peers_;
+};
+
+} // unnamed namespace
+
+TEST_F(TunIntfTest, FlowsKeepToOneQueue) {
+  createIntf(4);
+  // Flows differ by source port, packets of a flow by their tag
+  constexpr int kFlows = 16;
+  for (uint8_t tag = 0; tag < 4; ++tag) {
+    for (int flow = 0; flow < kFlows; ++flow) {
+      send(1, 1000 + flow, flow * 4 + tag);
+    }
+  }
+  evb_.loop();
+
+  std::map<int, size_t> flowQueues;
+  std::set<size_t> usedQueues;
+  std::map<int, std::vector<uint8_t>> flowTags;
+  auto packets = received();
+  for (size_t queue = 0; queue < packets.size(); ++queue) {
+    for (const auto& pkt : packets[queue]) {
+      int flow = pkt.second / 4;
+      auto inserted = flowQueues.emplace(flow, queue);
+      EXPECT_EQ(queue, inserted.first->second) << "flow " << flow;
+      usedQueues.insert(queue);
+      flowTags[flow].push_back(pkt.second % 4);
+    }
+  }
+  EXPECT_EQ(kFlows, flowQueues.size());
+  EXPECT_LT(1, usedQueues.size());
+  // No flow is reordered
+  for (const auto& tags : flowTags) {
+    EXPECT_EQ(std::vector<uint8_t>({0, 1, 2, 3}), tags.second);
+  }
+}
+
+TEST_F(TunIntfTest, FragmentsKeepToOneQueue) {
+  createIntf(4);
+  // The first fragment has the ports, later ones do not, so both must be
+  // hashed on the addresses only
+  for (uint8_t dst = 1; dst <= 16; ++dst) {
+    send(dst, 1000 + dst, 0, 1);
+    send(dst, 0, 1, 2);
+  }
+  evb_.loop();
+
+  std::map<uint8_t, std::set<size_t>> dstQueues;
+  auto packets = received();
+  size_t count = 0;
+  for (size_t queue = 0; queue < packets.size(); ++queue) {
+    for (const auto& pkt : packets[queue]) {
+      dstQueues[pkt.first].insert(queue);
+      ++count;
+    }
+  }
+  EXPECT_EQ(32, count);
+  for (const auto& queues : dstQueues) {
+    EXPECT_EQ(1, queues.second.size()) << "destination " << queues.first;
+  }
+}
+
+TEST_F(TunIntfTest, StopWritesQueuedPackets) {
+  createIntf(1);
+  for (uint8_t tag = 0; tag < 3; ++tag) {
+    send(1, 1000, tag);
+  }
+  // Without running the event base, which would flush the packets anyway
+  intf_->stop();
+
+  auto packets = received();
+  ASSERT_EQ(1, packets.size());
+  ASSERT_EQ(3, packets[0].size());
+  for (uint8_t tag = 0; tag < 3; ++tag) {
+    EXPECT_EQ(tag, packets[0][tag].second);
+  }
+}
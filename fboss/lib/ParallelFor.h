@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/Executor.h>
+#include <folly/futures/Future.h>
+
+namespace facebook {
+namespace fboss {
+
+/*
+ * Call fn(i) for every i in [0, count), on the calling thread and up to
+ * maxThreads - 1 threads of executor, and return once all the calls have
+ * completed.
+ *
+ * Indices are handed out one at a time from a shared counter, so a slow call
+ * does not hold up the others.  Calls for different indices may run
+ * concurrently, and in any order.  The calling thread takes part, so this
+ * makes progress even if the executor's threads are all busy.
+ *
+ * If a call throws, the thread it ran on takes no more indices.  The first
+ * exception is rethrown once every thread has stopped.
+ */
+template <typename Fn>
+void parallelFor(
+    folly::Executor* executor,
+    size_t count,
+    size_t maxThreads,
+    Fn&& fn) {
+  std::atomic<size_t> next{0};
+  auto runNext = [&next, count, &fn]() {
+    for (auto i = next++; i < count; i = next++) {
+      fn(i);
+    }
+  };
+  auto numThreads = std::min(std::max<size_t>(maxThreads, 1), count);
+  std::vector<folly::Future<folly::Unit>> workers;
+  for (size_t i = 1; i < numThreads; ++i) {
+    workers.push_back(folly::via(executor, runNext));
+  }
+
+  folly::exception_wrapper error;
+  try {
+    runNext();
+  } catch (...) {
+    error = folly::exception_wrapper(std::current_exception());
+  }
+  for (auto& result : folly::collectAll(workers).get()) {
+    if (result.hasException() && !error) {
+      error = std::move(result.exception());
+    }
+  }
+  if (error) {
+    error.throw_exception();
+  }
+}
+
+} // namespace fboss
+} // namespace facebook
@@ -0,0 +1,624 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace facebook {
+namespace fboss {
+
+/*
+ * PersistentMap is an ordered associative container with value semantics
+ * and structural sharing.
+ *
+ * It is implemented as an AVL tree whose nodes are reference counted.
+ * Copying a PersistentMap is O(1): both copies share the same tree. Any
+ * subsequent modification copies only the nodes on the path from the root to
+ * the modified entry (path copying), so a single insert, update or erase is
+ * O(log N) regardless of how many other maps share the untouched subtrees.
+ *
+ * Nodes that are referenced by a single tree are modified in place, so a
+ * batch of modifications applied to a freshly copied map only copies each
+ * shared node once.  As with the rest of the SwitchState, a map must only be
+ * modified by a single thread; concurrent readers of other copies are safe
+ * since shared nodes are never modified.
+ *
+ * The interface mirrors the subset of boost::container::flat_map that
+ * NodeMapT and its users rely on, so it can be used as a drop-in NodeContainer.
+ * Iterators are invalidated by any modification of the map, exactly as with
+ * flat_map.  Note that obtaining a mutable iterator (non-const begin() or
+ * find()) unshares the nodes it may be used to modify: the path to the entry
+ * for find(), and the whole tree for begin().
+ */
+template <typename K, typename V, typename Compare = std::less<K>>
+class PersistentMap {
+  struct Node;
+  using NodePtr = std::shared_ptr<Node>;
+
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<const K, V>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using key_compare = Compare;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+
+ private:
+  struct Node {
+    template <typename... Args>
+    explicit Node(Args&&... args) : value(std::forward<Args>(args)...) {}
+
+    value_type value;
+    NodePtr left;
+    NodePtr right;
+    uint8_t height{1};
+  };
+
+  // An AVL tree of height h holds at least fib(h + 2) - 1 nodes, so this is
+  // enough for any map that fits in memory.
+  static constexpr size_t kMaxHeight = 64;
+
+  template <bool IsConst>
+  class IteratorImpl {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = typename PersistentMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer =
+        std::conditional_t<IsConst, const value_type*, value_type*>;
+    using reference =
+        std::conditional_t<IsConst, const value_type&, value_type&>;
+
+    IteratorImpl() {}
+    /* implicit */ IteratorImpl(std::nullptr_t) {}
+    // Allow conversion from iterator to const_iterator
+    template <bool C = IsConst, typename = std::enable_if_t<C>>
+    /* implicit */ IteratorImpl(const IteratorImpl<false>& other)
+        : root_(other.root_), path_(other.path_), depth_(other.depth_) {}
+
+    reference operator*() const {
+      return path_[depth_ - 1]->value;
+    }
+    pointer operator->() const {
+      return &path_[depth_ - 1]->value;
+    }
+
+    IteratorImpl& operator++() {
+      increment();
+      return *this;
+    }
+    IteratorImpl operator++(int) {
+      IteratorImpl tmp(*this);
+      increment();
+      return tmp;
+    }
+    IteratorImpl& operator--() {
+      decrement();
+      return *this;
+    }
+    IteratorImpl operator--(int) {
+      IteratorImpl tmp(*this);
+      decrement();
+      return tmp;
+    }
+
+    template <bool OtherConst>
+    bool operator==(const IteratorImpl<OtherConst>& other) const {
+      if (depth_ == 0 || other.depth_ == 0) {
+        return depth_ == other.depth_;
+      }
+      return path_[depth_ - 1] == other.path_[other.depth_ - 1];
+    }
+    template <bool OtherConst>
+    bool operator!=(const IteratorImpl<OtherConst>& other) const {
+      return !operator==(other);
+    }
+
+   private:
+    friend class PersistentMap;
+    template <bool>
+    friend class IteratorImpl;
+
+    explicit IteratorImpl(Node* root) : root_(root) {}
+
+    void push(Node* node) {
+      path_[depth_++] = node;
+    }
+    void pushLeftSpine(Node* node) {
+      for (; node; node = node->left.get()) {
+        push(node);
+      }
+    }
+    void pushRightSpine(Node* node) {
+      for (; node; node = node->right.get()) {
+        push(node);
+      }
+    }
+
+    void increment() {
+      auto node = path_[depth_ - 1];
+      if (node->right) {
+        pushLeftSpine(node->right.get());
+        return;
+      }
+      // Walk up until we arrive from a left child
+      while (--depth_ > 0 && path_[depth_ - 1]->right.get() == node) {
+        node = path_[depth_ - 1];
+      }
+    }
+
+    void decrement() {
+      if (depth_ == 0) {
+        // Decrementing end() yields the last entry
+        pushRightSpine(root_);
+        return;
+      }
+      auto node = path_[depth_ - 1];
+      if (node->left) {
+        pushRightSpine(node->left.get());
+        return;
+      }
+      // Walk up until we arrive from a right child
+      while (--depth_ > 0 && path_[depth_ - 1]->left.get() == node) {
+        node = path_[depth_ - 1];
+      }
+    }
+
+    // The path from the root down to the current entry.  An empty path
+    // denotes end().
+    Node* root_{nullptr};
+    std::array<Node*, kMaxHeight> path_;
+    uint8_t depth_{0};
+  };
+
+ public:
+  using iterator = IteratorImpl<false>;
+  using const_iterator = IteratorImpl<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  PersistentMap() {}
+  PersistentMap(std::initializer_list<value_type> values) {
+    for (const auto& value : values) {
+      insert(value);
+    }
+  }
+  PersistentMap(const PersistentMap& other) = default;
+  PersistentMap(PersistentMap&& other) noexcept
+      : root_(std::move(other.root_)), size_(other.size_) {
+    other.size_ = 0;
+  }
+  PersistentMap& operator=(const PersistentMap& other) = default;
+  PersistentMap& operator=(PersistentMap&& other) noexcept {
+    root_ = std::move(other.root_);
+    size_ = other.size_;
+    other.size_ = 0;
+    return *this;
+  }
+
+  size_type size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  void clear() {
+    root_.reset();
+    size_ = 0;
+  }
+  void swap(PersistentMap& other) noexcept {
+    std::swap(root_, other.root_);
+    std::swap(size_, other.size_);
+  }
+
+  const_iterator begin() const {
+    const_iterator it(root_.get());
+    it.pushLeftSpine(root_.get());
+    return it;
+  }
+  const_iterator end() const {
+    return const_iterator(root_.get());
+  }
+  const_iterator cbegin() const {
+    return begin();
+  }
+  const_iterator cend() const {
+    return end();
+  }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+  const_reverse_iterator crbegin() const {
+    return rbegin();
+  }
+  const_reverse_iterator crend() const {
+    return rend();
+  }
+
+  /*
+   * Mutable iteration may modify any entry, so the whole tree is unshared
+   * first.  Prefer the const overloads when no modification is needed.
+   */
+  iterator begin() {
+    unshareAll(root_);
+    iterator it(root_.get());
+    it.pushLeftSpine(root_.get());
+    return it;
+  }
+  iterator end() {
+    return iterator(root_.get());
+  }
+  reverse_iterator rbegin() {
+    unshareAll(root_);
+    return reverse_iterator(end());
+  }
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+
+  const_iterator find(const K& key) const {
+    const_iterator it(root_.get());
+    for (auto node = root_.get(); node;) {
+      it.push(node);
+      if (comp_(key, node->value.first)) {
+        node = node->left.get();
+      } else if (comp_(node->value.first, key)) {
+        node = node->right.get();
+      } else {
+        return it;
+      }
+    }
+    return end();
+  }
+
+  /*
+   * Only the path to the found entry is unshared, so updating the value of a
+   * single entry through the returned iterator is O(log N).
+   */
+  iterator find(const K& key) {
+    if (!contains(key)) {
+      return end();
+    }
+    iterator it(nullptr);
+    for (auto nodePtr = &root_;;) {
+      unshare(*nodePtr);
+      auto node = nodePtr->get();
+      it.push(node);
+      if (comp_(key, node->value.first)) {
+        nodePtr = &node->left;
+      } else if (comp_(node->value.first, key)) {
+        nodePtr = &node->right;
+      } else {
+        break;
+      }
+    }
+    it.root_ = root_.get();
+    return it;
+  }
+
+  size_type count(const K& key) const {
+    return contains(key) ? 1 : 0;
+  }
+
+  const_iterator lower_bound(const K& key) const {
+    const_iterator it(root_.get());
+    uint8_t depth = 0;
+    for (auto node = root_.get(); node;) {
+      it.push(node);
+      if (comp_(node->value.first, key)) {
+        node = node->right.get();
+      } else {
+        depth = it.depth_;
+        node = node->left.get();
+      }
+    }
+    it.depth_ = depth;
+    return it;
+  }
+
+  const_iterator upper_bound(const K& key) const {
+    const_iterator it(root_.get());
+    uint8_t depth = 0;
+    for (auto node = root_.get(); node;) {
+      it.push(node);
+      if (comp_(key, node->value.first)) {
+        depth = it.depth_;
+        node = node->left.get();
+      } else {
+        node = node->right.get();
+      }
+    }
+    it.depth_ = depth;
+    return it;
+  }
+
+  const V& at(const K& key) const {
+    auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("PersistentMap::at: key not found");
+    }
+    return it->second;
+  }
+  V& at(const K& key) {
+    auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("PersistentMap::at: key not found");
+    }
+    return it->second;
+  }
+
+  V& operator[](const K& key) {
+    return try_emplace(key).first->second;
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return emplace(value);
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return emplace(std::move(value));
+  }
+  template <typename P>
+  std::pair<iterator, bool> insert(P&& value) {
+    return emplace(std::forward<P>(value));
+  }
+  // The hint is of no use to a tree with path copying; it is accepted
+  // for flat_map compatibility.
+  iterator insert(const_iterator /*hint*/, const value_type& value) {
+    return emplace(value).first;
+  }
+  iterator insert(const_iterator /*hint*/, value_type&& value) {
+    return emplace(std::move(value)).first;
+  }
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      emplace(*first);
+    }
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    auto node = std::make_shared<Node>(std::forward<Args>(args)...);
+    // Take a copy of the key, the node is moved into the tree
+    K key = node->value.first;
+    if (contains(key)) {
+      return std::make_pair(find(key), false);
+    }
+    insertNode(root_, std::move(node));
+    ++size_;
+    return std::make_pair(find(key), true);
+  }
+  template <typename... Args>
+  iterator emplace_hint(const_iterator /*hint*/, Args&&... args) {
+    return emplace(std::forward<Args>(args)...).first;
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+    if (contains(key)) {
+      return std::make_pair(find(key), false);
+    }
+    insertNode(
+        root_,
+        std::make_shared<Node>(
+            std::piecewise_construct,
+            std::forward_as_tuple(key),
+            std::forward_as_tuple(std::forward<Args>(args)...)));
+    ++size_;
+    return std::make_pair(find(key), true);
+  }
+
+  size_type erase(const K& key) {
+    if (!contains(key)) {
+      return 0;
+    }
+    eraseNode(root_, key);
+    --size_;
+    return 1;
+  }
+
+  /*
+   * Returns an iterator to the entry following the erased one.  This costs an
+   * extra O(log N) lookup compared to flat_map.
+   */
+  iterator erase(const_iterator pos) {
+    K key = pos->first;
+    erase(key);
+    auto next = lower_bound(key);
+    if (next == end()) {
+      return end();
+    }
+    return find(next->first);
+  }
+  iterator erase(iterator pos) {
+    return erase(const_iterator(pos));
+  }
+
+  bool operator==(const PersistentMap& other) const {
+    if (size_ != other.size_) {
+      return false;
+    }
+    if (root_ == other.root_) {
+      return true;
+    }
+    return std::equal(begin(), end(), other.begin());
+  }
+  bool operator!=(const PersistentMap& other) const {
+    return !operator==(other);
+  }
+
+  /*
+   * Returns true if both maps share the same tree, i.e. one is an unmodified
+   * copy of the other.
+   */
+  bool sharesRootWith(const PersistentMap& other) const {
+    return root_ == other.root_;
+  }
+
+ private:
+  bool contains(const K& key) const {
+    for (auto node = root_.get(); node;) {
+      if (comp_(key, node->value.first)) {
+        node = node->left.get();
+      } else if (comp_(node->value.first, key)) {
+        node = node->right.get();
+      } else {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static uint8_t height(const NodePtr& node) {
+    return node ? node->height : 0;
+  }
+
+  static void updateHeight(Node* node) {
+    node->height = 1 + std::max(height(node->left), height(node->right));
+  }
+
+  /*
+   * Ensure that node is referenced only by this tree so that it can be
+   * modified in place.  This must be applied top down: a node reachable
+   * through a shared parent has a reference count of one even though it is
+   * visible to other trees.
+   */
+  static void unshare(NodePtr& node) {
+    if (node && node.use_count() > 1) {
+      node = std::make_shared<Node>(static_cast<const Node&>(*node));
+    }
+  }
+
+  static void unshareAll(NodePtr& node) {
+    if (!node) {
+      return;
+    }
+    unshare(node);
+    unshareAll(node->left);
+    unshareAll(node->right);
+  }
+
+  // The rotations expect node to be unshared already
+  static void rotateRight(NodePtr& node) {
+    unshare(node->left);
+    NodePtr pivot = std::move(node->left);
+    node->left = std::move(pivot->right);
+    updateHeight(node.get());
+    pivot->right = std::move(node);
+    updateHeight(pivot.get());
+    node = std::move(pivot);
+  }
+
+  static void rotateLeft(NodePtr& node) {
+    unshare(node->right);
+    NodePtr pivot = std::move(node->right);
+    node->right = std::move(pivot->left);
+    updateHeight(node.get());
+    pivot->left = std::move(node);
+    updateHeight(pivot.get());
+    node = std::move(pivot);
+  }
+
+  static void rebalance(NodePtr& node) {
+    updateHeight(node.get());
+    int balance = int(height(node->left)) - int(height(node->right));
+    if (balance > 1) {
+      if (height(node->left->left) < height(node->left->right)) {
+        unshare(node->left);
+        rotateLeft(node->left);
+      }
+      rotateRight(node);
+    } else if (balance < -1) {
+      if (height(node->right->right) < height(node->right->left)) {
+        unshare(node->right);
+        rotateRight(node->right);
+      }
+      rotateLeft(node);
+    }
+  }
+
+  // Expects the key of newNode not to be present in the tree
+  void insertNode(NodePtr& node, NodePtr newNode) {
+    if (!node) {
+      node = std::move(newNode);
+      return;
+    }
+    unshare(node);
+    if (comp_(newNode->value.first, node->value.first)) {
+      insertNode(node->left, std::move(newNode));
+    } else {
+      insertNode(node->right, std::move(newNode));
+    }
+    rebalance(node);
+  }
+
+  // Detach the leftmost node of the subtree rooted at node
+  static NodePtr removeMin(NodePtr& node) {
+    unshare(node);
+    if (!node->left) {
+      NodePtr min = std::move(node);
+      node = std::move(min->right);
+      return min;
+    }
+    auto min = removeMin(node->left);
+    rebalance(node);
+    return min;
+  }
+
+  // Expects key to be present in the tree
+  void eraseNode(NodePtr& node, const K& key) {
+    if (comp_(key, node->value.first)) {
+      unshare(node);
+      eraseNode(node->left, key);
+    } else if (comp_(node->value.first, key)) {
+      unshare(node);
+      eraseNode(node->right, key);
+    } else if (!node->left) {
+      node = NodePtr(node->right);
+      return;
+    } else if (!node->right) {
+      node = NodePtr(node->left);
+      return;
+    } else {
+      unshare(node);
+      // Replace the erased node with its in-order successor.  Keys are
+      // immutable, so the successor node itself is relinked in place.
+      auto successor = removeMin(node->right);
+      successor->left = std::move(node->left);
+      successor->right = std::move(node->right);
+      node = std::move(successor);
+    }
+    rebalance(node);
+  }
+
+  NodePtr root_;
+  size_type size_{0};
+  Compare comp_;
+};
+
+} // namespace fboss
+} // namespace facebook
@@ -0,0 +1,419 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include <glog/logging.h>
+
+#include <folly/IPAddress.h>
+#include <folly/Optional.h>
+
+namespace facebook {
+namespace network {
+
+/*
+ * PersistentRadixTree is a path compressed binary trie of IP prefixes with
+ * structural sharing, offering the lookup subset of RadixTree.
+ *
+ * Nodes are reference counted and shared between copies of the tree. Copying
+ * a tree is O(1); inserting or erasing a prefix copies only the nodes on the
+ * path from the root to that prefix, so two versions of a routing table that
+ * differ in a handful of prefixes share all other subtrees.  Nodes that are
+ * referenced by a single tree are modified in place.
+ *
+ * Like the rest of the SwitchState, a tree must only be modified by a single
+ * thread. Other copies of it can be read concurrently since shared nodes are
+ * never modified. Obtaining a mutable iterator (non-const begin() or
+ * exactMatch()) unshares the nodes it gives access to.
+ *
+ * Every node is either a value node or an internal node with two children.
+ * Iterators only visit value nodes, in pre-order, and are invalidated by any
+ * modification of the tree.
+ */
+template <typename IPADDRTYPE, typename T>
+class PersistentRadixTree {
+ public:
+  class Node;
+
+ private:
+  using NodePtr = std::shared_ptr<Node>;
+  // A path from the root to a node holds at most one node per prefix length
+  static constexpr size_t kMaxDepth = IPADDRTYPE::bitCount() + 1;
+
+ public:
+  class Node {
+   public:
+    Node(const IPADDRTYPE& ipAddr, uint8_t masklen)
+        : ipAddress_(ipAddr), masklen_(masklen) {}
+    template <typename VALUE>
+    Node(const IPADDRTYPE& ipAddr, uint8_t masklen, VALUE&& value)
+        : ipAddress_(ipAddr),
+          masklen_(masklen),
+          value_(std::forward<VALUE>(value)) {}
+
+    const IPADDRTYPE& ipAddress() const {
+      return ipAddress_;
+    }
+    uint8_t masklen() const {
+      return masklen_;
+    }
+    bool isValueNode() const {
+      return value_.hasValue();
+    }
+    const T& value() const {
+      return *value_;
+    }
+    T& value() {
+      return *value_;
+    }
+
+   private:
+    friend class PersistentRadixTree;
+
+    bool covers(const IPADDRTYPE& ipAddr, uint8_t masklen) const {
+      return masklen >= masklen_ && ipAddr.mask(masklen_) == ipAddress_;
+    }
+    // The child to descend to for a prefix covered by and longer than this
+    NodePtr& childFor(const IPADDRTYPE& ipAddr) {
+      return ipAddr.getNthMSBit(masklen_) ? right_ : left_;
+    }
+    const Node* childFor(const IPADDRTYPE& ipAddr) const {
+      return ipAddr.getNthMSBit(masklen_) ? right_.get() : left_.get();
+    }
+
+    IPADDRTYPE ipAddress_;
+    uint8_t masklen_;
+    folly::Optional<T> value_;
+    NodePtr left_;
+    NodePtr right_;
+  };
+
+ private:
+  template <bool IsConst>
+  class IteratorImpl {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Node;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, const Node*, Node*>;
+    using reference = std::conditional_t<IsConst, const Node&, Node&>;
+
+    IteratorImpl() {}
+    // Allow conversion from Iterator to ConstIterator
+    template <bool C = IsConst, typename = std::enable_if_t<C>>
+    /* implicit */ IteratorImpl(const IteratorImpl<false>& other)
+        : path_(other.path_), depth_(other.depth_) {}
+
+    reference operator*() const {
+      return *path_[depth_ - 1];
+    }
+    pointer operator->() const {
+      return path_[depth_ - 1];
+    }
+
+    IteratorImpl& operator++() {
+      do {
+        advance();
+      } while (depth_ > 0 && !path_[depth_ - 1]->isValueNode());
+      return *this;
+    }
+    IteratorImpl operator++(int) {
+      IteratorImpl tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+    template <bool OtherConst>
+    bool operator==(const IteratorImpl<OtherConst>& other) const {
+      if (depth_ == 0 || other.depth_ == 0) {
+        return depth_ == other.depth_;
+      }
+      return path_[depth_ - 1] == other.path_[other.depth_ - 1];
+    }
+    template <bool OtherConst>
+    bool operator!=(const IteratorImpl<OtherConst>& other) const {
+      return !operator==(other);
+    }
+
+   private:
+    friend class PersistentRadixTree;
+    template <bool>
+    friend class IteratorImpl;
+
+    void push(Node* node) {
+      path_[depth_++] = node;
+    }
+
+    // Pre-order successor of the current node, value node or not
+    void advance() {
+      auto node = path_[depth_ - 1];
+      if (node->left_) {
+        push(node->left_.get());
+        return;
+      }
+      if (node->right_) {
+        push(node->right_.get());
+        return;
+      }
+      // Walk up until we find a right subtree we have not visited yet
+      while (--depth_ > 0) {
+        auto parent = path_[depth_ - 1];
+        if (parent->left_.get() == node && parent->right_) {
+          push(parent->right_.get());
+          return;
+        }
+        node = parent;
+      }
+    }
+
+    // Path from the root to the current node, empty for end()
+    std::array<Node*, kMaxDepth> path_;
+    uint8_t depth_{0};
+  };
+
+ public:
+  using Iterator = IteratorImpl<false>;
+  using ConstIterator = IteratorImpl<true>;
+
+  PersistentRadixTree() {}
+
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  void clear() {
+    root_.reset();
+    size_ = 0;
+  }
+
+  ConstIterator begin() const {
+    ConstIterator itr;
+    if (root_) {
+      itr.push(root_.get());
+      if (!root_->isValueNode()) {
+        ++itr;
+      }
+    }
+    return itr;
+  }
+  ConstIterator end() const {
+    return ConstIterator();
+  }
+  Iterator begin() {
+    unshareAll(root_);
+    Iterator itr;
+    if (root_) {
+      itr.push(root_.get());
+      if (!root_->isValueNode()) {
+        ++itr;
+      }
+    }
+    return itr;
+  }
+  Iterator end() {
+    return Iterator();
+  }
+
+  /*
+   * Insert a IP, mask, value in tree. Returns true if a node was inserted,
+   * false if a node for IP, mask already existed in which case the tree is
+   * left untouched.
+   */
+  template <typename VALUE>
+  std::pair<Iterator, bool>
+  insert(const IPADDRTYPE& ipaddr, uint8_t masklen, VALUE&& value) {
+    auto toAdd = ipaddr.mask(masklen);
+    auto itr = exactMatch(toAdd, masklen);
+    if (itr != end()) {
+      return std::make_pair(itr, false);
+    }
+    insertImpl(root_, toAdd, masklen, std::forward<VALUE>(value));
+    ++size_;
+    return std::make_pair(exactMatch(toAdd, masklen), true);
+  }
+
+  // Erase a IP, mask
+  bool erase(const IPADDRTYPE& ipaddr, uint8_t masklen) {
+    auto toErase = ipaddr.mask(masklen);
+    if (findNode(toErase, masklen) == nullptr) {
+      return false;
+    }
+    eraseImpl(root_, toErase, masklen);
+    --size_;
+    return true;
+  }
+
+  ConstIterator exactMatch(const IPADDRTYPE& ipaddr, uint8_t masklen) const {
+    auto toMatch = ipaddr.mask(masklen);
+    ConstIterator itr;
+    for (auto node = root_.get(); node && node->covers(toMatch, masklen);) {
+      itr.push(node);
+      if (node->masklen_ == masklen) {
+        return node->isValueNode() ? itr : end();
+      }
+      node = node->childFor(toMatch).get();
+    }
+    return end();
+  }
+
+  /*
+   * Only the path to the matched node is unshared, so updating the value of
+   * a single prefix through the returned iterator is O(prefix length).
+   */
+  Iterator exactMatch(const IPADDRTYPE& ipaddr, uint8_t masklen) {
+    auto toMatch = ipaddr.mask(masklen);
+    if (findNode(toMatch, masklen) == nullptr) {
+      return end();
+    }
+    Iterator itr;
+    for (auto nodePtr = &root_;;) {
+      unshare(*nodePtr);
+      auto node = nodePtr->get();
+      itr.push(node);
+      if (node->masklen_ == masklen) {
+        return itr;
+      }
+      nodePtr = &node->childFor(toMatch);
+    }
+  }
+
+  // NOTE: masklen is unsigned and must be <= ipaddr.bitCount()
+  ConstIterator longestMatch(const IPADDRTYPE& ipaddr, uint8_t masklen) const {
+    auto toMatch = ipaddr.mask(masklen);
+    ConstIterator itr;
+    uint8_t matchDepth = 0;
+    for (auto node = root_.get(); node && node->covers(toMatch, masklen);) {
+      itr.push(node);
+      if (node->isValueNode()) {
+        matchDepth = itr.depth_;
+      }
+      if (node->masklen_ == masklen) {
+        break;
+      }
+      node = node->childFor(toMatch).get();
+    }
+    itr.depth_ = matchDepth;
+    return itr;
+  }
+
+  /*
+   * Returns true if both trees share the same root, i.e. one is an unmodified
+   * copy of the other.
+   */
+  bool sharesRootWith(const PersistentRadixTree& other) const {
+    return root_ == other.root_;
+  }
+
+ private:
+  const Node* findNode(const IPADDRTYPE& toMatch, uint8_t masklen) const {
+    for (const Node* node = root_.get(); node && node->covers(toMatch, masklen);) {
+      if (node->masklen_ == masklen) {
+        return node->isValueNode() ? node : nullptr;
+      }
+      node = node->childFor(toMatch);
+    }
+    return nullptr;
+  }
+
+  /*
+   * Ensure that node is referenced only by this tree so that it can be
+   * modified in place. Must be applied top down, see PersistentMap.
+   */
+  static void unshare(NodePtr& node) {
+    if (node && node.use_count() > 1) {
+      node = std::make_shared<Node>(static_cast<const Node&>(*node));
+    }
+  }
+
+  static void unshareAll(NodePtr& node) {
+    if (!node) {
+      return;
+    }
+    unshare(node);
+    unshareAll(node->left_);
+    unshareAll(node->right_);
+  }
+
+  // Expects the prefix not to be present as a value node
+  template <typename VALUE>
+  void insertImpl(
+      NodePtr& node,
+      const IPADDRTYPE& toAdd,
+      uint8_t masklen,
+      VALUE&& value) {
+    if (!node) {
+      node = std::make_shared<Node>(toAdd, masklen, std::forward<VALUE>(value));
+      return;
+    }
+    if (node->covers(toAdd, masklen)) {
+      unshare(node);
+      if (node->masklen_ == masklen) {
+        // Turn an internal node into a value node
+        node->value_.emplace(std::forward<VALUE>(value));
+        return;
+      }
+      insertImpl(
+          node->childFor(toAdd), toAdd, masklen, std::forward<VALUE>(value));
+      return;
+    }
+    // The new prefix diverges from this subtree. Hang both off their longest
+    // common prefix, which is the new prefix itself if it covers the subtree.
+    // The existing subtree is reused as is.
+    auto common = IPADDRTYPE::longestCommonPrefix(
+        {node->ipAddress_, node->masklen_}, {toAdd, masklen});
+    NodePtr parent;
+    if (common.second == masklen) {
+      parent =
+          std::make_shared<Node>(toAdd, masklen, std::forward<VALUE>(value));
+      parent->childFor(node->ipAddress_) = std::move(node);
+    } else {
+      parent = std::make_shared<Node>(common.first, common.second);
+      parent->childFor(node->ipAddress_) = std::move(node);
+      parent->childFor(toAdd) =
+          std::make_shared<Node>(toAdd, masklen, std::forward<VALUE>(value));
+    }
+    node = std::move(parent);
+  }
+
+  // Expects the prefix to be present as a value node
+  void eraseImpl(NodePtr& node, const IPADDRTYPE& toErase, uint8_t masklen) {
+    DCHECK(node && node->covers(toErase, masklen));
+    unshare(node);
+    if (node->masklen_ == masklen) {
+      node->value_.clear();
+    } else {
+      eraseImpl(node->childFor(toErase), toErase, masklen);
+    }
+    if (node->isValueNode()) {
+      return;
+    }
+    // Internal nodes need two children, collapse this one otherwise
+    if (!node->left_) {
+      node = NodePtr(node->right_);
+    } else if (!node->right_) {
+      node = NodePtr(node->left_);
+    }
+  }
+
+  NodePtr root_;
+  size_t size_{0};
+};
+
+} // namespace network
+} // namespace facebook
@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <folly/SpinLock.h>
+#include <folly/ThreadLocal.h>
+
+namespace facebook {
+namespace fboss {
+
+/*
+ * ThreadCachedSnapshot publishes an immutable, reference counted value to
+ * many reader threads.
+ *
+ * Writers replace the value with set() and bump a generation number.  Each
+ * reader thread keeps a cached copy of the most recent snapshot it has seen,
+ * together with the generation it was taken at.  get() only compares the
+ * cached generation against the published one (a single acquire load of a
+ * read-mostly cache line), and only takes the writer lock when the value has
+ * actually changed since the last call from this thread.
+ *
+ * The cached copy handed out to a thread has its own control block, which
+ * holds a single reference on the published value.  Copying or destroying
+ * the shared_ptr returned by get() therefore only touches that thread's
+ * reference count, instead of every reader bouncing the cache line of the
+ * published value's control block.  The pointer returned is the same as the
+ * published one, so callers may still compare snapshots for identity.
+ *
+ * The trade-off is that a thread which stops calling get() keeps its last
+ * snapshot alive until it either calls get() again, exits, or the
+ * ThreadCachedSnapshot itself is destroyed.
+ */
+template <typename T>
+class ThreadCachedSnapshot {
+ public:
+  ThreadCachedSnapshot() {}
+  explicit ThreadCachedSnapshot(std::shared_ptr<T> value)
+      : value_(std::move(value)) {}
+
+  /*
+   * Return the most recently published value.
+   */
+  std::shared_ptr<T> get() const {
+    auto& cache = *cache_;
+    if (cache.generation != generation_.load(std::memory_order_acquire)) {
+      refresh(cache);
+    }
+    return cache.value;
+  }
+
+  /*
+   * Publish a new value.
+   *
+   * The previous value is returned, so that the caller controls where the
+   * (possibly expensive) destruction of the old value happens.  Threads which
+   * still have the old value cached drop their reference on their next call
+   * to get().
+   */
+  std::shared_ptr<T> set(std::shared_ptr<T> value) {
+    std::lock_guard<folly::SpinLock> guard(lock_);
+    value_.swap(value);
+    generation_.store(
+        generation_.load(std::memory_order_relaxed) + 1,
+        std::memory_order_release);
+    return value;
+  }
+
+  /*
+   * The generation number of the published value.  It is incremented by
+   * every call to set().
+   */
+  uint64_t generation() const {
+    return generation_.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct Cache {
+    uint64_t generation{0};
+    std::shared_ptr<T> value;
+  };
+
+  void refresh(Cache& cache) const {
+    std::shared_ptr<T> published;
+    uint64_t generation;
+    {
+      std::lock_guard<folly::SpinLock> guard(lock_);
+      published = value_;
+      generation = generation_.load(std::memory_order_relaxed);
+    }
+    if (published) {
+      // Give this thread a private control block that owns one reference on
+      // the published value.
+      auto holder = std::make_shared<std::shared_ptr<T>>(std::move(published));
+      cache.value = std::shared_ptr<T>(holder, holder->get());
+    } else {
+      cache.value.reset();
+    }
+    cache.generation = generation;
+  }
+
+  // Forbidden copy constructor and assignment operator
+  ThreadCachedSnapshot(ThreadCachedSnapshot const&) = delete;
+  ThreadCachedSnapshot& operator=(ThreadCachedSnapshot const&) = delete;
+
+  mutable folly::SpinLock lock_;
+  std::shared_ptr<T> value_;
+  // Starts ahead of Cache::generation so that each thread's first get()
+  // picks up the value passed to the constructor.
+  std::atomic<uint64_t> generation_{1};
+  mutable folly::ThreadLocal<Cache> cache_;
+};
+
+} // namespace fboss
+} // namespace facebook
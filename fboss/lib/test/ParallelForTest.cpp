@@ -0,0 +1,56 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#include "fboss/lib/ParallelFor.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+
+TEST(ParallelFor, callsEachIndexOnce) {
+  folly::CPUThreadPoolExecutor executor(4);
+  std::vector<std::atomic<int>> calls(1000);
+  parallelFor(&executor, calls.size(), 4, [&calls](size_t i) { ++calls[i]; });
+  for (const auto& count : calls) {
+    EXPECT_EQ(1, count.load());
+  }
+
+  // Nothing to do, or fewer indices than threads
+  parallelFor(&executor, 0, 4, [](size_t) { FAIL(); });
+  std::atomic<int> total{0};
+  parallelFor(&executor, 2, 4, [&total](size_t i) { total += i + 1; });
+  EXPECT_EQ(3, total.load());
+}
+
+TEST(ParallelFor, rethrowsAfterAllCallsStop) {
+  folly::CPUThreadPoolExecutor executor(4);
+  std::atomic<int> running{0};
+  EXPECT_THROW(
+      parallelFor(
+          &executor,
+          100,
+          4,
+          [&running](size_t i) {
+            ++running;
+            if (i % 10 == 0) {
+              --running;
+              throw std::runtime_error("failed");
+            }
+            --running;
+          }),
+      std::runtime_error);
+  // No call is still running once the error has been rethrown
+  EXPECT_EQ(0, running.load());
+}
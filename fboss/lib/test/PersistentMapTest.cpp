@@ -0,0 +1,153 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#include "fboss/lib/PersistentMap.h"
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+
+namespace {
+using IntMap = PersistentMap<int, std::shared_ptr<int>>;
+
+void expectSameContents(
+    const IntMap& map,
+    const std::map<int, std::shared_ptr<int>>& expected) {
+  ASSERT_EQ(map.size(), expected.size());
+  auto it = map.begin();
+  for (const auto& entry : expected) {
+    ASSERT_TRUE(it != map.end());
+    EXPECT_EQ(entry.first, it->first);
+    EXPECT_EQ(entry.second, it->second);
+    ++it;
+  }
+  EXPECT_TRUE(it == map.end());
+  // And backwards
+  auto rit = map.rbegin();
+  for (auto eit = expected.rbegin(); eit != expected.rend(); ++eit) {
+    ASSERT_TRUE(rit != map.rend());
+    EXPECT_EQ(eit->first, rit->first);
+    ++rit;
+  }
+  EXPECT_TRUE(rit == map.rend());
+}
+} // namespace
+
+TEST(PersistentMap, insertFindErase) {
+  IntMap map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+  for (int i = 0; i < 100; ++i) {
+    auto ret = map.insert(std::make_pair(i, std::make_shared<int>(i)));
+    EXPECT_TRUE(ret.second);
+    EXPECT_EQ(i, ret.first->first);
+  }
+  EXPECT_EQ(100, map.size());
+  EXPECT_FALSE(map.insert(std::make_pair(5, nullptr)).second);
+  EXPECT_EQ(5, *map.at(5));
+
+  const auto& cmap = map;
+  EXPECT_TRUE(cmap.find(100) == cmap.end());
+  EXPECT_EQ(42, *cmap.find(42)->second);
+  EXPECT_EQ(1, cmap.count(99));
+
+  EXPECT_EQ(1, map.erase(42));
+  EXPECT_EQ(0, map.erase(42));
+  EXPECT_TRUE(cmap.find(42) == cmap.end());
+  auto next = map.erase(cmap.find(41));
+  EXPECT_EQ(43, next->first);
+  EXPECT_EQ(98, map.size());
+  EXPECT_EQ(43, cmap.lower_bound(41)->first);
+  EXPECT_EQ(44, cmap.upper_bound(43)->first);
+}
+
+TEST(PersistentMap, copiesAreIndependent) {
+  IntMap orig;
+  for (int i = 0; i < 1000; ++i) {
+    orig.emplace(i, std::make_shared<int>(i));
+  }
+  IntMap copy = orig;
+  EXPECT_TRUE(copy.sharesRootWith(orig));
+  EXPECT_EQ(orig, copy);
+
+  auto newVal = std::make_shared<int>(-1);
+  copy.find(500)->second = newVal;
+  copy.erase(10);
+  copy.emplace(5000, newVal);
+  EXPECT_FALSE(copy.sharesRootWith(orig));
+  EXPECT_NE(orig, copy);
+
+  // The original is untouched
+  const auto& corig = orig;
+  EXPECT_EQ(1000, orig.size());
+  EXPECT_EQ(500, *corig.find(500)->second);
+  EXPECT_TRUE(corig.find(10) != corig.end());
+  EXPECT_TRUE(corig.find(5000) == corig.end());
+
+  const auto& ccopy = copy;
+  EXPECT_EQ(1000, copy.size());
+  EXPECT_EQ(newVal, ccopy.find(500)->second);
+  EXPECT_TRUE(ccopy.find(10) == ccopy.end());
+  // Unmodified entries still point to the same values
+  EXPECT_EQ(corig.find(700)->second, ccopy.find(700)->second);
+}
+
+TEST(PersistentMap, mutableIteration) {
+  IntMap orig;
+  for (int i = 0; i < 50; ++i) {
+    orig[i] = std::make_shared<int>(i);
+  }
+  IntMap copy = orig;
+  for (auto& entry : copy) {
+    entry.second = std::make_shared<int>(*entry.second * 2);
+  }
+  for (const auto& entry : orig) {
+    EXPECT_EQ(entry.first, *entry.second);
+  }
+  for (const auto& entry : static_cast<const IntMap&>(copy)) {
+    EXPECT_EQ(entry.first * 2, *entry.second);
+  }
+}
+
+TEST(PersistentMap, randomizedAgainstStdMap) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> keyDist(0, 2000);
+  IntMap map;
+  std::map<int, std::shared_ptr<int>> expected;
+  std::vector<std::pair<IntMap, std::map<int, std::shared_ptr<int>>>>
+      snapshots;
+  for (int i = 0; i < 20000; ++i) {
+    auto key = keyDist(gen);
+    switch (gen() % 3) {
+      case 0:
+      case 1: {
+        auto val = std::make_shared<int>(i);
+        map[key] = val;
+        expected[key] = val;
+        break;
+      }
+      case 2:
+        EXPECT_EQ(expected.erase(key), map.erase(key));
+        break;
+    }
+    if (i % 1000 == 0) {
+      snapshots.emplace_back(map, expected);
+    }
+  }
+  expectSameContents(map, expected);
+  // Every snapshot must still hold its contents at the time it was taken
+  for (const auto& snapshot : snapshots) {
+    expectSameContents(snapshot.first, snapshot.second);
+  }
+}
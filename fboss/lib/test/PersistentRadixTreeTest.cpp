@@ -0,0 +1,138 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#include "fboss/lib/PersistentRadixTree.h"
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include <folly/IPAddressV4.h>
+#include <gtest/gtest.h>
+
+using namespace facebook::network;
+using folly::IPAddressV4;
+
+namespace {
+using Tree = PersistentRadixTree<IPAddressV4, int>;
+using Prefix = std::pair<IPAddressV4, uint8_t>;
+
+void expectSameContents(const Tree& tree, const std::map<Prefix, int>& ref) {
+  EXPECT_EQ(ref.size(), tree.size());
+  size_t count = 0;
+  for (const auto& node : tree) {
+    ++count;
+    auto itr = ref.find(Prefix(node.ipAddress(), node.masklen()));
+    ASSERT_TRUE(itr != ref.end());
+    EXPECT_EQ(itr->second, node.value());
+  }
+  EXPECT_EQ(ref.size(), count);
+}
+} // namespace
+
+TEST(PersistentRadixTree, insertMatchErase) {
+  Tree tree;
+  EXPECT_TRUE(tree.empty());
+  EXPECT_TRUE(tree.insert(IPAddressV4("10.0.0.0"), 8, 8).second);
+  EXPECT_TRUE(tree.insert(IPAddressV4("10.1.0.0"), 16, 16).second);
+  EXPECT_TRUE(tree.insert(IPAddressV4("10.1.1.0"), 24, 24).second);
+  EXPECT_TRUE(tree.insert(IPAddressV4("0.0.0.0"), 0, 0).second);
+  EXPECT_FALSE(tree.insert(IPAddressV4("10.1.0.0"), 16, -1).second);
+  EXPECT_EQ(4, tree.size());
+
+  const auto& ctree = tree;
+  EXPECT_EQ(24, ctree.longestMatch(IPAddressV4("10.1.1.1"), 32)->value());
+  EXPECT_EQ(16, ctree.longestMatch(IPAddressV4("10.1.2.1"), 32)->value());
+  EXPECT_EQ(8, ctree.longestMatch(IPAddressV4("10.2.1.1"), 32)->value());
+  EXPECT_EQ(0, ctree.longestMatch(IPAddressV4("11.0.0.1"), 32)->value());
+  EXPECT_TRUE(ctree.exactMatch(IPAddressV4("10.1.0.0"), 15) == ctree.end());
+
+  EXPECT_TRUE(tree.erase(IPAddressV4("10.1.0.0"), 16));
+  EXPECT_FALSE(tree.erase(IPAddressV4("10.1.0.0"), 16));
+  EXPECT_EQ(8, ctree.longestMatch(IPAddressV4("10.1.2.1"), 32)->value());
+  EXPECT_EQ(24, ctree.longestMatch(IPAddressV4("10.1.1.1"), 32)->value());
+
+  EXPECT_TRUE(tree.erase(IPAddressV4("0.0.0.0"), 0));
+  EXPECT_TRUE(ctree.longestMatch(IPAddressV4("11.0.0.1"), 32) == ctree.end());
+  EXPECT_EQ(2, tree.size());
+}
+
+TEST(PersistentRadixTree, copiesAreIndependent) {
+  Tree orig;
+  for (int i = 0; i < 256; ++i) {
+    orig.insert(IPAddressV4::fromLongHBO(0x0a000000 | (i << 8)), 24, i);
+  }
+  Tree copy = orig;
+  EXPECT_TRUE(copy.sharesRootWith(orig));
+
+  copy.exactMatch(IPAddressV4("10.0.5.0"), 24)->value() = -5;
+  copy.erase(IPAddressV4("10.0.6.0"), 24);
+  copy.insert(IPAddressV4("10.0.0.0"), 16, -16);
+  EXPECT_FALSE(copy.sharesRootWith(orig));
+
+  const auto& corig = orig;
+  EXPECT_EQ(256, orig.size());
+  EXPECT_EQ(5, corig.exactMatch(IPAddressV4("10.0.5.0"), 24)->value());
+  EXPECT_TRUE(corig.exactMatch(IPAddressV4("10.0.6.0"), 24) != corig.end());
+  EXPECT_TRUE(corig.longestMatch(IPAddressV4("10.0.6.1"), 32) != corig.end());
+
+  const auto& ccopy = copy;
+  EXPECT_EQ(256, copy.size());
+  EXPECT_EQ(-5, ccopy.exactMatch(IPAddressV4("10.0.5.0"), 24)->value());
+  EXPECT_EQ(-16, ccopy.longestMatch(IPAddressV4("10.0.6.1"), 32)->value());
+}
+
+TEST(PersistentRadixTree, randomizedAgainstStdMap) {
+  std::mt19937 gen(42);
+  Tree tree;
+  std::map<Prefix, int> ref;
+  std::vector<std::pair<Tree, std::map<Prefix, int>>> snapshots;
+  for (int i = 0; i < 50000; ++i) {
+    uint8_t mask = gen() % 9 + (gen() % 2 ? 16 : 0);
+    auto addr = IPAddressV4::fromLongHBO(gen() & 0xff0f0000).mask(mask);
+    Prefix prefix(addr, mask);
+    if (gen() % 3) {
+      auto ret = tree.insert(addr, mask, i);
+      auto refRet = ref.emplace(prefix, i);
+      EXPECT_EQ(refRet.second, ret.second);
+      EXPECT_EQ(refRet.first->second, ret.first->value());
+    } else {
+      EXPECT_EQ(ref.erase(prefix) == 1, tree.erase(addr, mask));
+    }
+
+    if (i % 100 == 0) {
+      auto query = IPAddressV4::fromLongHBO(gen() & 0xff0f0000);
+      const auto& ctree = tree;
+      auto match = ctree.longestMatch(query, 32);
+      auto best = ref.end();
+      for (auto itr = ref.begin(); itr != ref.end(); ++itr) {
+        if (query.mask(itr->first.second) == itr->first.first &&
+            (best == ref.end() || itr->first.second > best->first.second)) {
+          best = itr;
+        }
+      }
+      if (best == ref.end()) {
+        EXPECT_TRUE(match == ctree.end());
+      } else {
+        ASSERT_TRUE(match != ctree.end());
+        EXPECT_EQ(best->first.second, match->masklen());
+        EXPECT_EQ(best->second, match->value());
+      }
+    }
+    if (i % 5000 == 0) {
+      snapshots.emplace_back(tree, ref);
+    }
+  }
+  expectSameContents(tree, ref);
+  // Every snapshot must still hold its contents at the time it was taken
+  for (const auto& snapshot : snapshots) {
+    expectSameContents(snapshot.first, snapshot.second);
+  }
+}
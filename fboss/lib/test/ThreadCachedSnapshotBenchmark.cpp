@@ -0,0 +1,89 @@
+// Copyright 2004-present Facebook. All Rights Reserved.
+#include "fboss/lib/ThreadCachedSnapshot.h"
+
+#include <folly/Benchmark.h>
+#include <folly/SpinLock.h>
+#include "common/init/Init.h"
+
+#include <thread>
+#include <vector>
+
+using namespace facebook::fboss;
+using namespace folly;
+
+/*
+ * Models the SwitchState reads done by the packet RX path: every packet takes
+ * a reference to the current state, does a little work with it and drops the
+ * reference.  The state is replaced every kUpdateInterval packets, to account
+ * for the cost of picking up new states.
+ */
+namespace {
+constexpr size_t kUpdateInterval = 10000;
+
+struct State {
+  explicit State(uint64_t gen) : generation(gen) {}
+  uint64_t generation;
+};
+
+class SpinLockedState {
+ public:
+  explicit SpinLockedState(std::shared_ptr<State> state)
+      : state_(std::move(state)) {}
+  std::shared_ptr<State> get() const {
+    SpinLockGuard guard(lock_);
+    return state_;
+  }
+  void set(std::shared_ptr<State> state) {
+    SpinLockGuard guard(lock_);
+    state_.swap(state);
+  }
+
+ private:
+  mutable SpinLock lock_;
+  std::shared_ptr<State> state_;
+};
+
+template <typename Publisher>
+void runReaders(size_t numIters, size_t numThreads) {
+  Publisher publisher(std::make_shared<State>(0));
+  std::vector<std::thread> threads;
+  auto perThread = numIters / numThreads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&publisher, perThread, t] {
+      uint64_t sum = 0;
+      for (size_t n = 0; n < perThread; ++n) {
+        auto state = publisher.get();
+        sum += state->generation;
+        if (t == 0 && n % kUpdateInterval == 0) {
+          publisher.set(std::make_shared<State>(n));
+        }
+      }
+      doNotOptimizeAway(sum);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+} // namespace
+
+#define STATE_READ_BENCHMARKS(threads)                                 \
+  BENCHMARK(SpinLockedStateRead_##threads##Threads, n) {               \
+    runReaders<SpinLockedState>(n, threads);                           \
+  }                                                                    \
+  BENCHMARK_RELATIVE(ThreadCachedStateRead_##threads##Threads, n) {    \
+    runReaders<ThreadCachedSnapshot<State>>(n, threads);               \
+  }                                                                    \
+  BENCHMARK_DRAW_LINE();
+
+STATE_READ_BENCHMARKS(1)
+STATE_READ_BENCHMARKS(2)
+STATE_READ_BENCHMARKS(4)
+STATE_READ_BENCHMARKS(8)
+STATE_READ_BENCHMARKS(16)
+
+int main(int argc, char** argv) {
+  facebook::initFacebook(&argc, &argv);
+  runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+
+#include "fboss/lib/ThreadCachedSnapshot.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace facebook::fboss;
+
+TEST(ThreadCachedSnapshot, getReturnsPublishedValue) {
+  ThreadCachedSnapshot<int> empty;
+  EXPECT_EQ(nullptr, empty.get());
+
+  auto first = std::make_shared<int>(1);
+  ThreadCachedSnapshot<int> snapshot(first);
+  // The same object is handed out, with a separate reference count
+  EXPECT_EQ(first.get(), snapshot.get().get());
+  EXPECT_EQ(snapshot.get(), snapshot.get());
+
+  auto second = std::make_shared<int>(2);
+  auto gen = snapshot.generation();
+  EXPECT_EQ(first, snapshot.set(second));
+  EXPECT_EQ(gen + 1, snapshot.generation());
+  EXPECT_EQ(second.get(), snapshot.get().get());
+  EXPECT_EQ(2, *snapshot.get());
+}
+
+TEST(ThreadCachedSnapshot, oldValueReleasedOnRefresh) {
+  auto first = std::make_shared<int>(1);
+  std::weak_ptr<int> weakFirst = first;
+  ThreadCachedSnapshot<int> snapshot(std::move(first));
+  auto held = snapshot.get();
+
+  snapshot.set(std::make_shared<int>(2));
+  // A reader still holding the old snapshot keeps it alive
+  EXPECT_FALSE(weakFirst.expired());
+  held.reset();
+  // ... and so does this thread's cache, until the next get()
+  EXPECT_FALSE(weakFirst.expired());
+  EXPECT_EQ(2, *snapshot.get());
+  EXPECT_TRUE(weakFirst.expired());
+}
+
+TEST(ThreadCachedSnapshot, concurrentReaders) {
+  ThreadCachedSnapshot<int> snapshot(std::make_shared<int>(0));
+  constexpr int kNumUpdates = 10000;
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      int last = 0;
+      while (!done.load()) {
+        auto value = snapshot.get();
+        // Values are published in order, so readers never go backwards
+        EXPECT_LE(last, *value);
+        last = *value;
+      }
+      EXPECT_EQ(kNumUpdates, *snapshot.get());
+    });
+  }
+  for (int i = 1; i <= kNumUpdates; ++i) {
+    snapshot.set(std::make_shared<int>(i));
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+}
@@ -1,4 +1,5 @@
 #include "NetlinkManager.h"
+#include <fb303/ServiceData.h>
 #include <chrono>
 #include "NetlinkManagerException.h"
 #include "folly/Format.h"
@@ -17,8 +18,21 @@ DEFINE_string(
     interfaces,
     "",
     "comma-separated list of names of interfaces to listen to");
+DEFINE_int32(
+    route_batch_ms,
+    50,
+    "How long to collect route changes for before sending them to the agent");
+DEFINE_int32(
+    route_batch_max,
+    10000,
+    "Send collected route changes to the agent as soon as there are this many");
 
 namespace {
+const std::string kBatchSize = "netlink_manager.route_batch_size";
+const std::string kBatchLatencyMs = "netlink_manager.route_batch_latency_ms";
+const std::string kCollapsed = "netlink_manager.route_updates_collapsed";
+const std::string kBatchFailures = "netlink_manager.route_batch_failures";
+
 struct nl_dump_params initDumpParams() {
   struct nl_dump_params dumpParams;
   memset(&dumpParams, 0, sizeof(dumpParams));
@@ -265,39 +279,119 @@ void NetlinkManager::addRouteViaFbossThrift(
   UnicastRoute unicastRoute;
   unicastRoute.dest = nlAddrToIpPrefix(nlDst);
   unicastRoute.nextHopAddrs = nexthops;
-  eb_->runInEventBaseThread([this, unicastRoute]() {
-    FbossClient fbossClient = getFbossClient(FLAGS_ip, FLAGS_fboss_port);
-    fbossClient->future_addUnicastRoute(FBOSS_CLIENT_ID, unicastRoute)
-        .thenValue(
-            [](auto&&) { VLOG(2) << "NetlinkManager route add success"; })
-        .thenError(
-            folly::tag_t<std::exception>{},
-            [unicastRoute](const std::exception& ex) {
-              BinaryAddress binaryDst = unicastRoute.dest.ip;
-              VLOG(2) << folly::sformat(
-                  "Route add failed for destination {}. Error sending thrift calls to FBOSS agent: {}",
-                  binAddrToStr(binaryDst),
-                  ex.what());
-            });
-  });
+  queueRouteUpdate(nlDst, std::move(unicastRoute));
 }
 
 void NetlinkManager::deleteRouteViaFbossThrift(struct nl_addr* nlDst) {
-  IpPrefix prefix = nlAddrToIpPrefix(nlDst);
-
-  eb_->runInEventBaseThread([this, prefix]() {
-    FbossClient fbossClient = getFbossClient(FLAGS_ip, FLAGS_fboss_port);
-    fbossClient->future_deleteUnicastRoute(FBOSS_CLIENT_ID, prefix)
-        .thenValue(
-            [](auto&&) { VLOG(2) << "NetlinkManager route delete success"; })
-        .thenError(folly::tag_t<std::exception>{}, [prefix](const std::exception& ex) {
-          BinaryAddress binaryDst = prefix.ip;
-          VLOG(2) << folly::sformat(
-              "Route delete failed for destination {}. Error sending thrift calls to FBOSS agent: {}",
-              binAddrToStr(binaryDst),
-              ex.what());
-        });
-  });
+  queueRouteUpdate(nlDst, folly::none);
+}
+
+void NetlinkManager::queueRouteUpdate(
+    struct nl_addr* nlDst,
+    folly::Optional<UnicastRoute> route) {
+  DCHECK(eb_->isInEventBaseThread());
+  folly::CIDRNetwork network{nlAddrToFollyAddr(nlDst),
+                             nl_addr_get_prefixlen(nlDst)};
+  if (pendingRoutes_.empty()) {
+    pendingSince_ = Clock::now();
+    if (!flushTimeout_) {
+      flushTimeout_ =
+          folly::AsyncTimeout::make(*eb_, [this]() noexcept {
+            flushRouteUpdates();
+          });
+    }
+    flushTimeout_->scheduleTimeout(FLAGS_route_batch_ms);
+  }
+
+  // Only the last change to a prefix matters, e.g. a route added and then
+  // deleted again before it was sent is just deleted
+  auto ret = pendingRoutes_.emplace(network, PendingRoute());
+  if (!ret.second) {
+    fb303::fbData->addStatValue(kCollapsed, 1, fb303::SUM);
+  }
+  ret.first->second.prefix = nlAddrToIpPrefix(nlDst);
+  ret.first->second.route = std::move(route);
+
+  if (pendingRoutes_.size() >= static_cast<size_t>(FLAGS_route_batch_max)) {
+    flushTimeout_->cancelTimeout();
+    flushRouteUpdates();
+  }
+}
+
+FbossCtrlAsyncClient* NetlinkManager::getRouteClient() {
+  if (!routeClient_ || routeClientFailed_) {
+    routeClientFailed_ = false;
+    routeClient_ = getFbossClient(FLAGS_ip, FLAGS_fboss_port);
+  }
+  return routeClient_.get();
+}
+
+void NetlinkManager::flushRouteUpdates() {
+  if (pendingRoutes_.empty()) {
+    return;
+  }
+  std::vector<UnicastRoute> toAdd;
+  std::vector<IpPrefix> toDelete;
+  for (auto& pending : pendingRoutes_) {
+    if (pending.second.route) {
+      toAdd.push_back(std::move(pending.second.route).value());
+    } else {
+      toDelete.push_back(std::move(pending.second.prefix));
+    }
+  }
+  pendingRoutes_.clear();
+  fb303::fbData->addStatValue(
+      kBatchSize, toAdd.size() + toDelete.size(), fb303::AVG);
+  VLOG(2) << "Sending " << toAdd.size() << " route adds and "
+          << toDelete.size() << " route deletes to FBOSS agent";
+  sendRouteUpdates(std::move(toAdd), std::move(toDelete));
+}
+
+void NetlinkManager::sendRouteUpdates(
+    std::vector<UnicastRoute> toAdd,
+    std::vector<IpPrefix> toDelete) {
+  auto since = pendingSince_;
+  auto onSuccess = [since](const char* op, size_t count) {
+    auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(
+        Clock::now() - since);
+    fb303::fbData->addStatValue(kBatchLatencyMs, latency.count(), fb303::AVG);
+    VLOG(2) << "NetlinkManager route " << op << " of " << count
+            << " routes success";
+  };
+  auto onError = [this](const char* op, size_t count, const std::exception& ex) {
+    fb303::fbData->addStatValue(kBatchFailures, 1, fb303::SUM);
+    VLOG(2) << folly::sformat(
+        "Route {} failed for {} routes. Error sending thrift calls to FBOSS agent: {}",
+        op,
+        count,
+        ex.what());
+    // Reconnect for the next batch, in case the agent went away
+    routeClientFailed_ = true;
+  };
+
+  // There is at most one change per prefix, so the order of the calls does
+  // not matter
+  auto client = getRouteClient();
+  if (!toDelete.empty()) {
+    auto count = toDelete.size();
+    client->future_deleteUnicastRoutes(FBOSS_CLIENT_ID, toDelete)
+        .thenValue([onSuccess, count](auto&&) { onSuccess("delete", count); })
+        .thenError(
+            folly::tag_t<std::exception>{},
+            [onError, count](const std::exception& ex) {
+              onError("delete", count, ex);
+            });
+  }
+  if (!toAdd.empty()) {
+    auto count = toAdd.size();
+    client->future_addUnicastRoutes(FBOSS_CLIENT_ID, toAdd)
+        .thenValue([onSuccess, count](auto&&) { onSuccess("add", count); })
+        .thenError(
+            folly::tag_t<std::exception>{},
+            [onError, count](const std::exception& ex) {
+              onError("add", count, ex);
+            });
+  }
 }
 } // namespace fboss
 } // namespace facebook
@@ -5,6 +5,11 @@ extern "C" {
 #include <netlink/socket.h>
 }
 
+#include <folly/IPAddress.h>
+#include <folly/Optional.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <chrono>
+#include <map>
 #include <mutex>
 #include <string>
 #include "NetlinkPoller.h"
@@ -24,6 +29,7 @@ class NetlinkManager {
   const static int FBOSS_CLIENT_ID =
       static_cast<int>(StdClientIds::NETLINK_LISTENER);
   NetlinkManager(folly::EventBase* eb);
+  virtual ~NetlinkManager() = default;
   void run();
   struct nl_sock* getNetlinkSocket() const;
   std::set<std::string> getMonitoredInterfaces();
@@ -31,6 +37,22 @@ class NetlinkManager {
   void stopMonitoringInterface(std::string ifname);
   static void checkError(int errCode, std::string messages);
 
+ protected:
+  /*
+   * Route changes are not sent to the agent one at a time. They are queued
+   * for up to --route_batch_ms, keeping only the last change to each prefix,
+   * and then sent with one addUnicastRoutes and one deleteUnicastRoutes call.
+   */
+  void addRouteViaFbossThrift(
+      struct nl_addr* nlDst,
+      const std::vector<BinaryAddress>& nexthops);
+  void deleteRouteViaFbossThrift(struct nl_addr* nlDst);
+  void flushRouteUpdates();
+  // Sends one batch of route changes to the agent. Overridden by tests.
+  virtual void sendRouteUpdates(
+      std::vector<UnicastRoute> toAdd,
+      std::vector<IpPrefix> toDelete);
+
  private:
   void setMonitoredInterfaces();
   std::set<std::string> getFbossInterfaces();
@@ -65,18 +87,34 @@ class NetlinkManager {
         return "unknown";
     }
   }
-  void addRouteViaFbossThrift(
+  void queueRouteUpdate(
       struct nl_addr* nlDst,
-      const std::vector<BinaryAddress>& nexthops);
-  void deleteRouteViaFbossThrift(struct nl_addr* nlDst);
+      folly::Optional<UnicastRoute> route);
+  FbossCtrlAsyncClient* getRouteClient();
   void logAndDie(const char* msg);
   void terminateEventBase();
 
+  using Clock = std::chrono::steady_clock;
+  // The latest change to a prefix. No route means the prefix was deleted.
+  struct PendingRoute {
+    folly::Optional<UnicastRoute> route;
+    IpPrefix prefix;
+  };
+
   std::set<std::string> monitoredInterfaces_;
   folly::EventBase* eb_;
   std::unique_ptr<NetlinkPoller> poller_{nullptr};
   std::unique_ptr<NlResources> nlResources_{nullptr};
   std::mutex interfacesMutex_;
+
+  // Route changes waiting to be sent to the agent, only used from eb_
+  std::map<folly::CIDRNetwork, PendingRoute> pendingRoutes_;
+  // When the oldest change in pendingRoutes_ was received
+  Clock::time_point pendingSince_;
+  std::unique_ptr<folly::AsyncTimeout> flushTimeout_;
+  // Reused across batches, and reconnected after a failure
+  FbossClient routeClient_;
+  bool routeClientFailed_{false};
 };
 } // namespace fboss
 } // namespace facebook
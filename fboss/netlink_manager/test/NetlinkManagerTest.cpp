@@ -0,0 +1,149 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/netlink_manager/NetlinkManager.h"
+#include "fboss/agent/AddressUtil.h"
+
+#include <folly/Format.h>
+#include <folly/io/async/EventBase.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+DECLARE_int32(route_batch_ms);
+DECLARE_int32(route_batch_max);
+
+using namespace facebook::fboss;
+using facebook::network::toBinaryAddress;
+using facebook::network::toIPAddress;
+
+namespace {
+
+std::string prefixStr(const IpPrefix& prefix) {
+  return folly::sformat(
+      "{}/{}", toIPAddress(prefix.ip).str(), prefix.prefixLength);
+}
+
+/*
+ * Records the batches of route changes it would have sent to the agent
+ */
+class TestNetlinkManager : public NetlinkManager {
+ public:
+  explicit TestNetlinkManager(folly::EventBase* evb) : NetlinkManager(evb) {}
+
+  struct Batch {
+    // Next hop of each route added, by prefix
+    std::map<std::string, std::string> added;
+    std::set<std::string> deleted;
+  };
+  std::vector<Batch> sent;
+
+  void add(const std::string& prefix, const std::string& nexthop) {
+    auto dst = parse(prefix);
+    addRouteViaFbossThrift(
+        dst.get(), {toBinaryAddress(folly::IPAddress(nexthop))});
+  }
+
+  void del(const std::string& prefix) {
+    auto dst = parse(prefix);
+    deleteRouteViaFbossThrift(dst.get());
+  }
+
+ protected:
+  void sendRouteUpdates(
+      std::vector<UnicastRoute> toAdd,
+      std::vector<IpPrefix> toDelete) override {
+    sent.emplace_back();
+    for (const auto& route : toAdd) {
+      ASSERT_EQ(1, route.nextHopAddrs.size());
+      sent.back().added.emplace(
+          prefixStr(route.dest), toIPAddress(route.nextHopAddrs[0]).str());
+    }
+    for (const auto& prefix : toDelete) {
+      sent.back().deleted.insert(prefixStr(prefix));
+    }
+  }
+
+ private:
+  struct NlAddrDeleter {
+    void operator()(struct nl_addr* addr) const {
+      nl_addr_put(addr);
+    }
+  };
+
+  static std::unique_ptr<struct nl_addr, NlAddrDeleter> parse(
+      const std::string& prefix) {
+    struct nl_addr* addr = nullptr;
+    EXPECT_EQ(0, nl_addr_parse(prefix.c_str(), AF_UNSPEC, &addr));
+    return std::unique_ptr<struct nl_addr, NlAddrDeleter>(addr);
+  }
+};
+
+} // unnamed namespace
+
+TEST(NetlinkManagerTest, CollapsesChangesToPrefix) {
+  gflags::FlagSaver flagSaver;
+  FLAGS_route_batch_ms = 0;
+  folly::EventBase evb;
+  TestNetlinkManager manager(&evb);
+
+  // Changed
+  manager.add("10.0.0.0/24", "1.1.1.1");
+  manager.add("10.0.0.0/24", "1.1.1.2");
+  // Deleted and added back
+  manager.add("10.0.1.0/24", "1.1.1.1");
+  manager.del("10.0.1.0/24");
+  manager.add("10.0.1.0/24", "1.1.1.3");
+  // Added and deleted again
+  manager.add("2401::/64", "2401:db00::1");
+  manager.del("2401::/64");
+  // Nothing is sent before the batch times out
+  EXPECT_TRUE(manager.sent.empty());
+  evb.loop();
+
+  ASSERT_EQ(1, manager.sent.size());
+  EXPECT_EQ(
+      (std::map<std::string, std::string>{{"10.0.0.0/24", "1.1.1.2"},
+                                          {"10.0.1.0/24", "1.1.1.3"}}),
+      manager.sent[0].added);
+  EXPECT_EQ(std::set<std::string>({"2401::/64"}), manager.sent[0].deleted);
+}
+
+TEST(NetlinkManagerTest, FlushesAtBatchMax) {
+  gflags::FlagSaver flagSaver;
+  FLAGS_route_batch_ms = 0;
+  FLAGS_route_batch_max = 3;
+  folly::EventBase evb;
+  TestNetlinkManager manager(&evb);
+
+  manager.add("10.0.0.0/24", "1.1.1.1");
+  manager.add("10.0.1.0/24", "1.1.1.1");
+  // Changes to a prefix already queued do not count towards the limit
+  manager.add("10.0.1.0/24", "1.1.1.2");
+  EXPECT_TRUE(manager.sent.empty());
+  // The third prefix sends the batch without waiting for the timeout
+  manager.del("10.0.2.0/24");
+  ASSERT_EQ(1, manager.sent.size());
+  EXPECT_EQ(2, manager.sent[0].added.size());
+  EXPECT_EQ(1, manager.sent[0].deleted.size());
+
+  // The next change starts a new batch, sent when it times out
+  manager.add("10.0.3.0/24", "1.1.1.1");
+  EXPECT_EQ(1, manager.sent.size());
+  evb.loop();
+  ASSERT_EQ(2, manager.sent.size());
+  EXPECT_EQ(
+      (std::map<std::string, std::string>{{"10.0.3.0/24", "1.1.1.1"}}),
+      manager.sent[1].added);
+  EXPECT_TRUE(manager.sent[1].deleted.empty());
+}
@@ -2,10 +2,74 @@
 
 #include "fboss/pcap_distribution_service/if/gen-cpp2/pcap_pubsub_types.h"
 
+#include <folly/io/Cursor.h>
+
+#include <algorithm>
+#include <chrono>
+
 namespace facebook { namespace fboss {
 
 uint16_t PcapBufferManager::UNKNOWN = 0xFFFF;
 
+namespace {
+
+int64_t timestampUs(const PcapPkt& pkt) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             pkt.timestamp().time_since_epoch())
+      .count();
+}
+
+/*
+ * The ethertype of a packet in the UNKNOWN buffer, which holds packets of
+ * many ethertypes
+ */
+uint16_t parseEthertype(const PcapPkt& pkt) {
+  folly::io::Cursor cursor(pkt.buf());
+  if (!cursor.canAdvance(14)) {
+    return PcapBufferManager::UNKNOWN;
+  }
+  cursor.skip(12);
+  auto ethertype = cursor.readBE<uint16_t>();
+  if (ethertype == 0x8100 && cursor.canAdvance(4)) {
+    cursor.skip(2);
+    ethertype = cursor.readBE<uint16_t>();
+  }
+  return ethertype;
+}
+
+bool matches(
+    const PcapPkt& pkt,
+    uint16_t ethertype,
+    const PacketDumpFilter& filter) {
+  if (!filter.ethertypes.empty() &&
+      std::find(
+          filter.ethertypes.begin(),
+          filter.ethertypes.end(),
+          static_cast<int16_t>(ethertype)) == filter.ethertypes.end()) {
+    return false;
+  }
+  if (filter.rx_ref().has_value() && filter.rx_ref().value() != pkt.isRx()) {
+    return false;
+  }
+  if (filter.srcPort_ref().has_value() &&
+      (!pkt.isRx() ||
+       filter.srcPort_ref().value() != static_cast<int32_t>(pkt.port()))) {
+    return false;
+  }
+  if (filter.sinceUs_ref().has_value() || filter.untilUs_ref().has_value()) {
+    auto ts = timestampUs(pkt);
+    if ((filter.sinceUs_ref().has_value() &&
+         ts < filter.sinceUs_ref().value()) ||
+        (filter.untilUs_ref().has_value() &&
+         ts >= filter.untilUs_ref().value())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
 PcapBufferManager::PcapBufferManager() {
   for(auto e : PcapBufferManager::getEthertypes()){
     buffers_[e] = PcapCircularBuffer();
@@ -28,30 +92,91 @@ void PcapBufferManager::addPkt(PcapPkt&& pkt, uint16_t ethertype) {
 void PcapBufferManager::dumpPackets(
     std::vector<CapturedPacket>& out,
     uint16_t ethertype) {
-  auto buf = buffers_[ethertype].release();
-  for (int i = 0; i < buf.size(); i++) {
+  auto it = buffers_.find(ethertype);
+  if (it == buffers_.end()) {
+    return;
+  }
+  auto snapshot = it->second.snapshot();
+  out.reserve(out.size() + snapshot.pkts.size());
+  for (const auto& pkt : snapshot.pkts) {
     CapturedPacket p;
-    p.rx = buf[i].isRx();
+    p.rx = pkt->isRx();
 
-    PacketData data;
-    folly::IOBuf packetData;
+    // fbbinary needs its own contiguous copy of the data, so copy it once,
+    // straight out of the (possibly chained) buffer.
+    folly::fbstring packetData;
+    packetData.reserve(pkt->buf()->computeChainDataLength());
+    for (const auto& range : *pkt->buf()) {
+      packetData.append(
+          reinterpret_cast<const char*>(range.data()), range.size());
+    }
 
+    PacketData data;
     if (p.rx) {
       RxPacketData r;
-      r.srcPort = buf[i].port();
-      r.srcVlan = buf[i].vlan();
-      buf[i].buf()->cloneInto(packetData);
-      r.packetData = packetData.moveToFbString();
-      r.reasons = buf[i].getReasons();
-      data.set_rxpkt(r);
+      r.srcPort = pkt->port();
+      r.srcVlan = pkt->vlan();
+      r.packetData = std::move(packetData);
+      r.reasons = pkt->reasons();
+      data.set_rxpkt(std::move(r));
     } else {
       TxPacketData t;
-      buf[i].buf()->cloneInto(packetData);
-      t.packetData = packetData.moveToFbString();
-      data.set_txpkt(t);
+      t.packetData = std::move(packetData);
+      data.set_txpkt(std::move(t));
     }
-    p.pkt = data;
+    p.pkt = std::move(data);
     out.emplace_back(std::move(p));
   }
 }
+
+folly::Optional<PacketDumpCursor> PcapBufferManager::dumpPackets(
+    std::vector<PublishedPacket>& out,
+    const PacketDumpFilter& filter,
+    const PacketDumpCursor& cursor,
+    uint32_t maxPackets) {
+  const auto& ethertypes = getEthertypes();
+  auto seq = static_cast<uint64_t>(std::max<int64_t>(cursor.seq, 0));
+  for (auto index = std::max(cursor.buffer, 0);
+       index < static_cast<int32_t>(ethertypes.size());
+       ++index, seq = 0) {
+    auto bufferEthertype = ethertypes[index];
+    bool unknown = bufferEthertype == UNKNOWN;
+    if (!unknown && !filter.ethertypes.empty() &&
+        std::find(
+            filter.ethertypes.begin(),
+            filter.ethertypes.end(),
+            static_cast<int16_t>(bufferEthertype)) ==
+            filter.ethertypes.end()) {
+      continue;
+    }
+
+    auto snapshot = buffers_.at(bufferEthertype).snapshot(seq);
+    for (size_t i = 0; i < snapshot.pkts.size(); ++i) {
+      if (out.size() >= maxPackets) {
+        PacketDumpCursor next;
+        next.buffer = index;
+        next.seq = snapshot.firstSeq + i;
+        return next;
+      }
+      const auto& pkt = *snapshot.pkts[i];
+      auto ethertype = unknown ? parseEthertype(pkt) : bufferEthertype;
+      if (!matches(pkt, ethertype, filter)) {
+        continue;
+      }
+      PublishedPacket published;
+      published.rx = pkt.isRx();
+      published.ethertype = ethertype;
+      if (pkt.isRx()) {
+        published.srcPort = pkt.port();
+        published.srcVlan = pkt.vlan();
+        published.reasons = pkt.reasons();
+      }
+      // Shares the packet data with the buffer
+      pkt.buf()->cloneInto(published.packetData);
+      published.timestampUs_ref() = timestampUs(pkt);
+      out.push_back(std::move(published));
+    }
+  }
+  return folly::none;
+}
 }}
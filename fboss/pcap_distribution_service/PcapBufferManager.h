@@ -8,6 +8,8 @@
 #include "fboss/agent/IPv6Handler.h"
 #include "fboss/agent/LldpManager.h"
 
+#include <folly/Optional.h>
+
 #include <map>
 #include <vector>
 
@@ -21,6 +23,18 @@ class PcapBufferManager {
   PcapBufferManager();
   void addPkt(PcapPkt&& pkt, uint16_t ethertype);
   void dumpPackets(std::vector<CapturedPacket>& out, uint16_t ethertype);
+  /*
+   * Append up to maxPackets packets matching filter to out, starting from
+   * cursor. The packet data is shared with the buffers rather than copied.
+   *
+   * Returns the cursor to continue the dump from, or none once every buffer
+   * has been dumped.
+   */
+  folly::Optional<PacketDumpCursor> dumpPackets(
+      std::vector<PublishedPacket>& out,
+      const PacketDumpFilter& filter,
+      const PacketDumpCursor& cursor,
+      uint32_t maxPackets);
   static uint16_t UNKNOWN;
   static const std::vector<uint16_t>& getEthertypes() {
     static const std::vector<uint16_t> ethertypes = {
@@ -6,42 +6,85 @@
 
 #include "folly/Synchronized.h"
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 namespace facebook { namespace fboss {
 
 class PcapCircularBuffer {
  public:
-  explicit PcapCircularBuffer(int n = 100)
-      : buf_(boost::circular_buffer<PcapPkt>(n)) {}
+  /*
+   * A view of the packets in the buffer at some point in time.
+   *
+   * Every packet added to the buffer gets the next sequence number, starting
+   * from 0, so that a dump can be resumed from where it stopped even if the
+   * oldest packets have since been pushed out.  pkts[i] has sequence number
+   * firstSeq + i.
+   */
+  struct Snapshot {
+    uint64_t firstSeq{0};
+    std::vector<std::shared_ptr<const PcapPkt>> pkts;
+  };
+
+  explicit PcapCircularBuffer(int n = 100) : buf_(Ring(n)) {}
 
   void addPkt(PcapPkt pkt) {
-    buf_.wlock()->push_back(std::move(pkt));
+    // Allocate before taking the lock
+    auto shared = std::make_shared<const PcapPkt>(std::move(pkt));
+    auto locked = buf_.wlock();
+    locked->pkts.push_back(std::move(shared));
+    ++locked->numAdded;
   }
 
   void resize(int n) {
-    buf_.wlock()->set_capacity(n);
+    auto locked = buf_.wlock();
+    // set_capacity() would drop the newest packets rather than the oldest
+    while (locked->pkts.size() > static_cast<size_t>(n)) {
+      locked->pkts.pop_front();
+    }
+    locked->pkts.set_capacity(n);
   }
 
   int size() {
-    return buf_.rlock()->size();
+    return buf_.rlock()->pkts.size();
   }
 
   int capacity() {
-    return buf_.rlock()->capacity();
+    return buf_.rlock()->pkts.capacity();
   }
 
-  // release the buffer to a user to dump, and swap in
-  // a new buffer
-  boost::circular_buffer<PcapPkt> release() {
-    return buf_.copy();
+  /*
+   * Snapshot the packets with sequence numbers of at least fromSeq.
+   *
+   * The packets themselves are shared with the buffer rather than copied,
+   * so the lock is only held to copy the pointers.
+   */
+  Snapshot snapshot(uint64_t fromSeq = 0) {
+    Snapshot snapshot;
+    auto locked = buf_.rlock();
+    const auto& pkts = locked->pkts;
+    auto oldestSeq = locked->numAdded - pkts.size();
+    snapshot.firstSeq =
+        std::min(std::max(fromSeq, oldestSeq), locked->numAdded);
+    snapshot.pkts.assign(
+        pkts.begin() + (snapshot.firstSeq - oldestSeq), pkts.end());
+    return snapshot;
   }
 
   // can add new functions, such as get after timestamp
 
  private:
-  folly::Synchronized<boost::circular_buffer<PcapPkt>> buf_;
+  struct Ring {
+    explicit Ring(int n) : pkts(n) {}
+
+    boost::circular_buffer<std::shared_ptr<const PcapPkt>> pkts;
+    // The number of packets ever added
+    uint64_t numAdded{0};
+  };
+
+  folly::Synchronized<Ring> buf_;
 };
 
 }}
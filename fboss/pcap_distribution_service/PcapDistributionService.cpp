@@ -30,7 +30,7 @@ int main(int argc, char** argv) {
 
   auto dist = make_unique<PcapDistributor>(evb);
   auto buff = make_unique<PcapBufferManager>();
-  auto pushsub = make_shared<ThriftHandler>(move(dist), move(buff));
+  auto pushsub = make_shared<ThriftHandler>(evb, move(dist), move(buff));
 
   SocketAddress ctrl_address("::1", ctrl_constants::DEFAULT_CTRL_PORT());
   auto socket = TAsyncSocket::newSocket(evb.get(), ctrl_address);
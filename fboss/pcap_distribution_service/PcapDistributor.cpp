@@ -24,6 +24,23 @@ using namespace apache::thrift;
 
 namespace facebook { namespace fboss {
 
+namespace {
+/*
+ * Remove a subscriber's client. Packets may still be being sent on it, so
+ * it can outlive its close callback, which is cleared first.
+ */
+template <typename SubscriberMap>
+void eraseSubscriber(
+    SubscriberMap& subs,
+    const typename SubscriberMap::key_type& key) {
+  auto it = subs.find(key);
+  if (it != subs.end()) {
+    it->second->getChannel()->setCloseCallback(nullptr);
+    subs.erase(it);
+  }
+}
+} // namespace
+
 void PcapDistributor::subscribe(unique_ptr<string> hostname, int port) {
   auto creation = [&, hostname = move(hostname), port ]() {
     auto locked_map = subs_.wlock();
@@ -33,20 +50,21 @@ void PcapDistributor::subscribe(unique_ptr<string> hostname, int port) {
     auto chan = HeaderClientChannel::newChannel(socket);
     auto key = pair<string, int>(*hostname, port);
     ChannelCloserCB closer(this, key);
-    locked_map->erase(key);
+    eraseSubscriber(*locked_map, key);
     locked_callbacks->erase(key);
     locked_callbacks->emplace(key, move(closer));
     chan->setCloseCallback(&locked_callbacks->at(key));
     locked_map->emplace(
-        key, make_unique<PcapSubscriberAsyncClient>(move(chan)));
+        key, make_shared<PcapSubscriberAsyncClient>(move(chan)));
     LOG(INFO) << "CREATED SUBSCRIBER: " << *hostname << " " << port;
   };
   evb_->runInEventBaseThread(move(creation));
 }
 
 void PcapDistributor::unsubscribe(const string& hostname, int port) {
-  subs_.wlock()->erase(pair<string, int>(hostname, port));
-  callbacks_.wlock()->erase(pair<string, int>(hostname, port));
+  auto key = pair<string, int>(hostname, port);
+  eraseSubscriber(*subs_.wlock(), key);
+  callbacks_.wlock()->erase(key);
   LOG(INFO) << "UNSUBSCRIBED CLIENT: " << hostname << " " << port;
 }
 
@@ -71,4 +89,26 @@ void PcapDistributor::distributeTxPacket(TxPacketData* packetData) {
         .thenError(folly::tag_t<std::runtime_error>{}, move(onError));
   }
 }
+
+void PcapDistributor::distributePackets(
+    const vector<PublishedPacket>& packets) {
+  // Take references to the subscribers rather than holding the lock while
+  // sending, so subscribing and unsubscribing do not wait on the sends
+  vector<shared_ptr<PcapSubscriberAsyncClient>> subscribers;
+  {
+    auto locked_map = subs_.rlock();
+    subscribers.reserve(locked_map->size());
+    for (auto& i : *locked_map) {
+      subscribers.push_back(i.second);
+    }
+  }
+  auto onError = [](runtime_error&& e) {
+    FB_LOG_EVERY_MS(ERROR, 1000) << e.what();
+  };
+  // The packet data is shared with the batch, not copied
+  for (auto& subscriber : subscribers) {
+    subscriber->future_receivePackets(packets).thenError(
+        folly::tag_t<std::runtime_error>{}, onError);
+  }
+}
 }}
@@ -28,6 +28,11 @@ class PcapDistributor {
   void unsubscribe(const std::string& hostname, int port);
   void distributeRxPacket(RxPacketData* packetData);
   void distributeTxPacket(TxPacketData* packetData);
+  /*
+   * Distribute a batch of packets published by the switch, with one
+   * receivePackets call per subscriber.
+   */
+  void distributePackets(const std::vector<PublishedPacket>& packets);
 
  private:
   /*
@@ -50,10 +55,11 @@ class PcapDistributor {
     const std::pair<std::string, int> key_;
   };
 
-  // Map of hostname and port to client object
+  // Map of hostname and port to client object. Clients are shared so that
+  // packets can be sent to them without holding the lock.
   folly::Synchronized<std::map<
       std::pair<std::string, int>,
-      std::unique_ptr<PcapSubscriberAsyncClient>>>
+      std::shared_ptr<PcapSubscriberAsyncClient>>>
       subs_;
   folly::Synchronized<std::map<std::pair<std::string, int>, ChannelCloserCB>>
       callbacks_;
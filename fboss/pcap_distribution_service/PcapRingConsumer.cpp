@@ -0,0 +1,51 @@
+#include "fboss/pcap_distribution_service/PcapRingConsumer.h"
+
+#include "fboss/pcap_distribution_service/PcapBufferManager.h"
+#include "fboss/pcap_distribution_service/PcapDistributor.h"
+
+#include <folly/GLog.h>
+#include <gflags/gflags.h>
+
+DEFINE_int32(
+    packet_ring_poll_ms,
+    10,
+    "How often to poll the shared memory packet rings for new packets");
+
+using namespace std;
+
+namespace facebook { namespace fboss {
+
+PcapRingConsumer::PcapRingConsumer(
+    folly::EventBase* evb,
+    unique_ptr<PcapShmRingReader> reader,
+    PcapDistributor* dist,
+    PcapBufferManager* buffMgr)
+    : folly::AsyncTimeout(evb),
+      reader_(move(reader)),
+      dist_(dist),
+      buffMgr_(buffMgr) {}
+
+void PcapRingConsumer::start() {
+  scheduleTimeout(FLAGS_packet_ring_poll_ms);
+}
+
+void PcapRingConsumer::timeoutExpired() noexcept {
+  for (uint32_t ring = 0; ring < PcapShmRing::numRings(); ++ring) {
+    pkts_.clear();
+    if (reader_->read(ring, &pkts_) == 0) {
+      continue;
+    }
+    dist_->distributePackets(pkts_);
+    for (const auto& pkt : pkts_) {
+      buffMgr_->addPkt(PcapPkt(&pkt), pkt.ethertype);
+    }
+  }
+  if (reader_->numOverruns() != lastOverruns_) {
+    FB_LOG_EVERY_MS(WARNING, 1000)
+        << "Missed " << reader_->numOverruns() - lastOverruns_
+        << " packets from the packet rings";
+    lastOverruns_ = reader_->numOverruns();
+  }
+  scheduleTimeout(FLAGS_packet_ring_poll_ms);
+}
+}}
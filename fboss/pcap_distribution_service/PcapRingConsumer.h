@@ -0,0 +1,40 @@
+#pragma once
+
+#include "fboss/agent/capture/PcapShmRing.h"
+
+#include <folly/io/async/AsyncTimeout.h>
+
+#include <memory>
+#include <vector>
+
+namespace facebook { namespace fboss {
+
+class PcapBufferManager;
+class PcapDistributor;
+
+/*
+ * This class reads the packets the switch writes to the shared memory
+ * rings, and hands them to the distributor and buffer manager.
+ *
+ * The rings are polled from the event base, so the switch does not need
+ * to make an RPC per packet.
+ */
+class PcapRingConsumer : public folly::AsyncTimeout {
+ public:
+  PcapRingConsumer(
+      folly::EventBase* evb,
+      std::unique_ptr<PcapShmRingReader> reader,
+      PcapDistributor* dist,
+      PcapBufferManager* buffMgr);
+
+  void start();
+  void timeoutExpired() noexcept override;
+
+ private:
+  std::unique_ptr<PcapShmRingReader> reader_;
+  PcapDistributor* dist_;
+  PcapBufferManager* buffMgr_;
+  std::vector<PublishedPacket> pkts_;
+  uint64_t lastOverruns_{0};
+};
+}}
@@ -2,15 +2,25 @@
 
 #include "fboss/pcap_distribution_service/PcapBufferManager.h"
 #include "fboss/pcap_distribution_service/PcapDistributor.h"
+#include "fboss/pcap_distribution_service/PcapRingConsumer.h"
 
 #include "fboss/agent/capture/PcapPkt.h"
 
+#include <folly/io/async/EventBase.h>
+
+#include <algorithm>
 #include <memory>
 
 using namespace std;
 
 namespace facebook { namespace fboss {
 
+ThriftHandler::ThriftHandler(
+    shared_ptr<folly::EventBase> evb,
+    unique_ptr<PcapDistributor> d,
+    unique_ptr<PcapBufferManager> b)
+    : evb_(move(evb)), dist_(move(d)), buffMgr_(move(b)) {}
+
 void ThriftHandler::subscribe(unique_ptr<string> hostname, int port) {
   dist_->subscribe(move(hostname), port);
 }
@@ -33,6 +43,25 @@ void ThriftHandler::receiveTxPacket(
   buffMgr_->addPkt(PcapPkt(pkt.get()), ethertype);
 }
 
+void ThriftHandler::receivePackets(unique_ptr<vector<PublishedPacket>> pkts) {
+  dist_->distributePackets(*pkts);
+  for (const auto& pkt : *pkts) {
+    buffMgr_->addPkt(PcapPkt(&pkt), pkt.ethertype);
+  }
+}
+
+void ThriftHandler::attachPacketRing(unique_ptr<string> path) {
+  // Throws, back to the switch, if the ring can not be mapped
+  auto reader = make_unique<PcapShmRingReader>(*path);
+  evb_->runInEventBaseThreadAndWait([&]() {
+    // The switch attaches again each time it reconnects
+    ringConsumer_ = make_unique<PcapRingConsumer>(
+        evb_.get(), move(reader), dist_.get(), buffMgr_.get());
+    ringConsumer_->start();
+  });
+  LOG(INFO) << "ATTACHED PACKET RING: " << *path;
+}
+
 void ThriftHandler::kill(){
   LOG(INFO) << "KILL SIGNAL FROM AGENT";
   exit(0);
@@ -51,4 +80,16 @@ void ThriftHandler::dumpPacketsByType(
     buffMgr_->dumpPackets(out, type);
   }
 }
+
+void ThriftHandler::dumpPacketsPage(
+    PacketDumpPage& out,
+    unique_ptr<PacketDumpFilter> filter,
+    unique_ptr<PacketDumpCursor> cursor,
+    int32_t maxPackets) {
+  auto next = buffMgr_->dumpPackets(
+      out.packets, *filter, *cursor, std::max(maxPackets, 1));
+  if (next) {
+    out.next_ref() = *next;
+  }
+}
 }}
@@ -8,6 +8,7 @@ namespace facebook { namespace fboss {
 
 class PcapDistributor;
 class PcapBufferManager;
+class PcapRingConsumer;
 
 /*
  * This class handles users connecting to the service,
@@ -15,10 +16,10 @@ class PcapBufferManager;
  */
 class ThriftHandler : virtual public PcapPushSubscriberSvIf {
  public:
-  explicit ThriftHandler(
+  ThriftHandler(
+      std::shared_ptr<folly::EventBase> evb,
       std::unique_ptr<PcapDistributor> d,
-      std::unique_ptr<PcapBufferManager> b)
-      : dist_(std::move(d)), buffMgr_(std::move(b)) {}
+      std::unique_ptr<PcapBufferManager> b);
   /*
    * Called by clients to subscribe to the distribution service
    */
@@ -32,6 +33,15 @@ class ThriftHandler : virtual public PcapPushSubscriberSvIf {
       override;
   void receiveTxPacket(std::unique_ptr<TxPacketData> pkt, int16_t ethertype)
       override;
+  /*
+   * Called by SwSwitch with a batch of received and sent packets
+   */
+  void receivePackets(
+      std::unique_ptr<std::vector<PublishedPacket>> pkts) override;
+  /*
+   * Called by SwSwitch to have packets read from shared memory instead
+   */
+  void attachPacketRing(std::unique_ptr<std::string> path) override;
   /*
    * A thrift kill switch for the service
    */
@@ -44,9 +54,20 @@ class ThriftHandler : virtual public PcapPushSubscriberSvIf {
   void dumpPacketsByType(
       std::vector<CapturedPacket>& out,
       std::unique_ptr<std::vector<int16_t>> ethertypes) override;
+  /*
+   * Dump the buffered packets matching a filter, a page at a time
+   */
+  void dumpPacketsPage(
+      PacketDumpPage& out,
+      std::unique_ptr<PacketDumpFilter> filter,
+      std::unique_ptr<PacketDumpCursor> cursor,
+      int32_t maxPackets) override;
 
  private:
+  std::shared_ptr<folly::EventBase> evb_;
   std::unique_ptr<PcapDistributor> dist_;
   std::unique_ptr<PcapBufferManager> buffMgr_;
+  // Only accessed from evb_
+  std::unique_ptr<PcapRingConsumer> ringConsumer_;
 };
 }}
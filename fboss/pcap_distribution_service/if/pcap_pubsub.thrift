@@ -3,6 +3,7 @@ namespace py neteng.fboss.pcap_pubsub
 namespace py.asyncio neteng.fboss.asyncio.pcap_pubsub
 
 typedef binary (cpp2.type = "::folly::fbstring") fbbinary
+typedef binary (cpp2.type = "folly::IOBuf") IOBuf
 
 const i32 PCAP_PUBSUB_PORT = 5911
 
@@ -42,6 +43,50 @@ struct CapturedPacket {
   2: required PacketData pkt
 }
 
+// A packet published by the switch as part of a batch. The packet data
+// is an IOBuf so that the switch can hand over its packet buffers without
+// flattening them.
+struct PublishedPacket {
+  1: required bool rx,
+  2: required i16 ethertype,
+  // srcPort, srcVlan and reasons are only set for rx packets
+  3: i32 srcPort,
+  4: i32 srcVlan,
+  5: required IOBuf packetData,
+  6: list<RxReason> reasons
+  // When the packet was sent or received, if known
+  7: optional i64 timestampUs
+}
+
+// Selects the packets returned by dumpPacketsPage. Unset fields match all
+// packets.
+struct PacketDumpFilter {
+  // Empty to match all ethertypes
+  1: list<i16> ethertypes
+  // Only packets seen in [sinceUs, untilUs), in microseconds since the epoch
+  2: optional i64 sinceUs
+  3: optional i64 untilUs
+  // The port rx packets were received on
+  4: optional i32 srcPort
+  5: optional bool rx
+}
+
+// Where a paged dump has got to
+struct PacketDumpCursor {
+  // The index of the buffer being dumped, in the order of the ethertypes the
+  // service buffers
+  1: i32 buffer = 0
+  // The sequence number of the next packet in that buffer
+  2: i64 seq = 0
+}
+
+struct PacketDumpPage {
+  // The packet data is shared with the service's buffers, not copied
+  1: list<PublishedPacket> packets
+  // Where the next page starts. Unset once the dump is complete
+  2: optional PacketDumpCursor next
+}
+
 // This interface is for a user to connect to the service,
 // and open subscriptions and request packet dumps
 service PcapPushSubscriber {
@@ -49,6 +94,11 @@ service PcapPushSubscriber {
   // distributor
   void receiveRxPacket(1: RxPacketData packet, 2: i16 type)
   void receiveTxPacket(1: TxPacketData packet, 2: i16 type)
+  // Batched version of receiveRxPacket and receiveTxPacket
+  void receivePackets(1: list<PublishedPacket> packets)
+  // Read the packets from the shared memory rings in the file at path,
+  // rather than waiting for them to be sent over thrift
+  void attachPacketRing(1: string path)
 
   // Give the switch the ability to kill the distribution
   // process if needed
@@ -63,6 +113,14 @@ service PcapPushSubscriber {
   // Request by type of packet, or get all ethertypes
   list<CapturedPacket> dumpAllPackets()
   list<CapturedPacket> dumpPacketsByType(1: list<i16> ethertypes)
+  // Dump at most maxPackets packets matching filter, starting at cursor.
+  // Large dumps are fetched a page at a time, by passing the returned
+  // cursor back in, so they never need to be held in memory all at once.
+  // Packets pushed out of the buffers between pages are skipped.
+  PacketDumpPage dumpPacketsPage(
+    1: PacketDumpFilter filter,
+    2: PacketDumpCursor cursor,
+    3: i32 maxPackets)
 }
 
 // This interface is for a subscriber to receive a packet stream
@@ -72,4 +130,7 @@ service PcapSubscriber {
   // distributor upon receiving a packet from the switch.
   void receiveRxPacket(1: RxPacketData packet)
   void receiveTxPacket(1: TxPacketData packet)
+  // Called instead of the above with each batch of packets the switch
+  // publishes
+  void receivePackets(1: list<PublishedPacket> packets)
 }
@@ -0,0 +1,179 @@
+/*
+ *  Copyright (c) 2004-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include "fboss/pcap_distribution_service/PcapBufferManager.h"
+#include "fboss/agent/capture/PcapPkt.h"
+#include "fboss/agent/hw/mock/MockRxPacket.h"
+
+#include <folly/Format.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+using namespace facebook::fboss;
+using std::chrono::seconds;
+
+namespace {
+
+constexpr uint16_t kIPv4 = 0x0800;
+constexpr uint16_t kArp = 0x0806;
+// Slow protocols, which have no buffer of their own
+constexpr uint16_t kLacp = 0x8809;
+
+const PcapPkt::TimePoint kEpoch{};
+
+PcapPkt makePkt(uint16_t ethertype, int port, PcapPkt::TimePoint timestamp) {
+  auto pkt = MockRxPacket::fromHex(folly::sformat(
+      // dst mac, src mac, ethertype
+      "02 00 01 00 00 01  02 00 02 01 02 03  {:02x} {:02x}",
+      ethertype >> 8,
+      ethertype & 0xff));
+  pkt->padToLength(68);
+  pkt->setSrcPort(PortID(port));
+  pkt->setSrcVlan(VlanID(1));
+  return PcapPkt(pkt.get(), timestamp);
+}
+
+/*
+ * Dump every packet matching filter, maxPackets at a time, checking each
+ * page's size along the way.
+ */
+std::vector<PublishedPacket> dumpAll(
+    PcapBufferManager& manager,
+    const PacketDumpFilter& filter,
+    uint32_t maxPackets,
+    int* pages = nullptr) {
+  std::vector<PublishedPacket> all;
+  folly::Optional<PacketDumpCursor> cursor = PacketDumpCursor();
+  int count = 0;
+  while (cursor) {
+    std::vector<PublishedPacket> page;
+    cursor = manager.dumpPackets(page, filter, *cursor, maxPackets);
+    EXPECT_LE(page.size(), maxPackets);
+    if (cursor) {
+      EXPECT_EQ(maxPackets, page.size());
+    }
+    all.insert(all.end(), page.begin(), page.end());
+    ++count;
+  }
+  if (pages) {
+    *pages = count;
+  }
+  return all;
+}
+
+} // unnamed namespace
+
+TEST(PcapBufferManagerTest, PagesResumeFromCursor) {
+  PcapBufferManager manager;
+  for (int i = 0; i < 5; ++i) {
+    manager.addPkt(makePkt(kIPv4, i, kEpoch + seconds(i)), kIPv4);
+  }
+  for (int i = 0; i < 3; ++i) {
+    manager.addPkt(makePkt(kArp, 10 + i, kEpoch + seconds(i)), kArp);
+  }
+
+  int pages = 0;
+  auto pkts = dumpAll(manager, PacketDumpFilter(), 3, &pages);
+  EXPECT_EQ(3, pages);
+  // Each packet exactly once, buffer by buffer, oldest first
+  std::vector<int32_t> ports;
+  for (const auto& pkt : pkts) {
+    ports.push_back(pkt.srcPort);
+  }
+  EXPECT_EQ(std::vector<int32_t>({10, 11, 12, 0, 1, 2, 3, 4}), ports);
+  EXPECT_EQ(kArp, pkts[0].ethertype);
+  EXPECT_EQ(kIPv4, pkts[3].ethertype);
+}
+
+TEST(PcapBufferManagerTest, CursorSkipsEvictedPackets) {
+  PcapBufferManager manager;
+  for (int i = 0; i < 3; ++i) {
+    manager.addPkt(makePkt(kIPv4, i, kEpoch), kIPv4);
+  }
+  std::vector<PublishedPacket> page;
+  auto cursor = manager.dumpPackets(page, PacketDumpFilter(), {}, 2);
+  ASSERT_TRUE(cursor.hasValue());
+  EXPECT_EQ(2, cursor->seq);
+
+  // Push the packet the cursor points to out of the buffer, which holds 100
+  for (int i = 3; i < 103; ++i) {
+    manager.addPkt(makePkt(kIPv4, i, kEpoch), kIPv4);
+  }
+  page.clear();
+  cursor = manager.dumpPackets(page, PacketDumpFilter(), *cursor, 1000);
+  EXPECT_FALSE(cursor.hasValue());
+  // The dump carries on from the oldest packet left
+  ASSERT_EQ(100, page.size());
+  EXPECT_EQ(3, page.front().srcPort);
+  EXPECT_EQ(102, page.back().srcPort);
+}
+
+TEST(PcapBufferManagerTest, CursorAtEndOfBuffer) {
+  PcapBufferManager manager;
+  for (int i = 0; i < 2; ++i) {
+    manager.addPkt(makePkt(kIPv4, i, kEpoch), kIPv4);
+  }
+  std::vector<PublishedPacket> page;
+  // A page ending with the last packet completes the dump
+  EXPECT_FALSE(manager.dumpPackets(page, PacketDumpFilter(), {}, 2));
+  ASSERT_EQ(2, page.size());
+
+  // Packets added since are picked up from a cursor at the end of the
+  // IPv4 buffer
+  PacketDumpCursor end;
+  end.buffer = 3;
+  end.seq = 2;
+  manager.addPkt(makePkt(kIPv4, 2, kEpoch), kIPv4);
+  page.clear();
+  EXPECT_FALSE(manager.dumpPackets(page, PacketDumpFilter(), end, 2));
+  ASSERT_EQ(1, page.size());
+  EXPECT_EQ(2, page[0].srcPort);
+}
+
+TEST(PcapBufferManagerTest, Filter) {
+  PcapBufferManager manager;
+  for (int i = 0; i < 4; ++i) {
+    manager.addPkt(makePkt(kIPv4, i % 2, kEpoch + seconds(i)), kIPv4);
+    manager.addPkt(makePkt(kLacp, i % 2, kEpoch + seconds(i)), kLacp);
+  }
+
+  // Packets in the buffer of unknown ethertypes are matched by their own
+  PacketDumpFilter lacp;
+  lacp.ethertypes.push_back(static_cast<int16_t>(kLacp));
+  auto pkts = dumpAll(manager, lacp, 3);
+  ASSERT_EQ(4, pkts.size());
+  for (const auto& pkt : pkts) {
+    EXPECT_EQ(static_cast<int16_t>(kLacp), pkt.ethertype);
+  }
+
+  PacketDumpFilter port;
+  port.ethertypes.push_back(kIPv4);
+  port.srcPort_ref() = 1;
+  pkts = dumpAll(manager, port, 3);
+  ASSERT_EQ(2, pkts.size());
+  for (const auto& pkt : pkts) {
+    EXPECT_EQ(1, pkt.srcPort);
+  }
+
+  // [1s, 3s)
+  PacketDumpFilter time;
+  time.ethertypes.push_back(kIPv4);
+  time.sinceUs_ref() = 1000000;
+  time.untilUs_ref() = 3000000;
+  pkts = dumpAll(manager, time, 3);
+  ASSERT_EQ(2, pkts.size());
+  EXPECT_EQ(1000000, pkts[0].timestampUs_ref().value());
+  EXPECT_EQ(2000000, pkts[1].timestampUs_ref().value());
+
+  PacketDumpFilter tx;
+  tx.rx_ref() = false;
+  EXPECT_TRUE(dumpAll(manager, tx, 3).empty());
+}
@@ -8,6 +8,7 @@ import threading
 
 from fboss.thrift_clients import PcapPushSubClient
 from neteng.fboss.asyncio.pcap_pubsub import PcapSubscriber as ThriftSub
+from neteng.fboss.asyncio.pcap_pubsub.ttypes import RxPacketData, TxPacketData
 from thrift.server import TAsyncioServer
 
 
@@ -28,6 +29,22 @@ class PcapSubscriber(ThriftSub.Iface):
     # inherit this class and override the on receive functions
     # additionally, these functions need to be thread-safe
 
+    def receivePackets(self, packets):
+        # The distributor sends packets in batches. By default, hand each
+        # one to receiveRxPacket or receiveTxPacket.
+        for pkt in packets:
+            if pkt.rx:
+                self.receiveRxPacket(
+                    RxPacketData(
+                        srcPort=pkt.srcPort,
+                        srcVlan=pkt.srcVlan,
+                        packetData=pkt.packetData,
+                        reasons=pkt.reasons,
+                    )
+                )
+            else:
+                self.receiveTxPacket(TxPacketData(packetData=pkt.packetData))
+
 
 class PcapListener():
 